@@ -0,0 +1,157 @@
+#pragma once
+
+#include "core/http/http_response.hxx"
+#include "core/util.hxx"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace CxxServer::Core::Http {
+    class ResponseCache;
+
+    //! Response serialized once & shared by every connection sending it
+    /*!
+     * The key & the whole response are kept in a single buffer, the response is sent to connections straight from
+     * it. Immutable once cached.
+     *
+     * Thread safe
+     */
+    class CachedResponse {
+    public:
+        friend class ResponseCache;
+
+        //! Get cache key
+        std::string_view key() const noexcept { return std::string_view(*_data).substr(0, _key_size); }
+
+        //! Get status code
+        int statusCode() const noexcept { return _status; }
+
+        //! Does the response close the connection
+        bool isClose() const noexcept { return _close; }
+
+        //! Get status line & headers up to the blank line, Connection & Date headers are inserted after them
+        std::string_view head() const noexcept { return std::string_view(*_data).substr(_key_size, _head_size); }
+
+        //! Get blank line ending the headers & the body
+        std::string_view rest() const noexcept { return std::string_view(*_data).substr(_key_size + _head_size); }
+
+        //! Get whole serialized response
+        std::string_view data() const noexcept { return std::string_view(*_data).substr(_key_size); }
+
+        //! Get buffer holding the response, to keep it alive while it is sent
+        std::shared_ptr<const void> owner() const noexcept { return _data; }
+
+    private:
+        std::shared_ptr<std::string> _data;
+        size_t _key_size;
+        size_t _head_size;
+        int _status;
+        bool _close;
+
+        // position in the cache's LRU list
+        std::list<std::shared_ptr<CachedResponse>>::iterator _lru;
+    };
+
+    //! In memory cache of serialized HTTP responses
+    /*!
+     * Responses are looked up by a key, usually the request path, without allocating: the index is keyed by
+     * Utils::CacheView slices of the cached buffers & hashed transparently so a string_view finds them. Cached
+     * responses are sent zero copy with Connection::sendCached, the same buffer is queued on every connection.
+     *
+     * The least recently used responses are evicted once the cache holds more than its max # of bytes or entries.
+     * Evicted & invalidated responses stay valid for connections still sending them.
+     *
+     * Thread safe
+     */
+    class ResponseCache {
+    public:
+        //! Initialize cache
+        /*!
+         * \param max_bytes - Max # of bytes of cached keys & responses
+         * \param max_entries - Max # of cached responses, 0 for no limit
+         */
+        explicit ResponseCache(size_t max_bytes = 64 * 1024 * 1024, size_t max_entries = 0);
+        ResponseCache(const ResponseCache &) = delete;
+        ResponseCache(ResponseCache &&) = delete;
+        ~ResponseCache() = default;
+
+        ResponseCache &operator=(const ResponseCache &) = delete;
+        ResponseCache &operator=(ResponseCache &&) = delete;
+
+        //! Find a cached response, marking it most recently used
+        /*!
+         * \param key - Cache key
+         * \return Cached response, nullptr if not cached
+         */
+        std::shared_ptr<const CachedResponse> find(std::string_view key);
+
+        //! Cache a response, replacing the one cached with the same key
+        /*!
+         * Note: Chunked responses can't be cached
+         * \param key - Cache key
+         * \param response - Response
+         * \return Cached response, nullptr if it is chunked or larger than the cache
+         */
+        std::shared_ptr<const CachedResponse> insert(std::string_view key, const Response &response);
+
+        //! Invalidate the response cached with a key
+        /*!
+         * \return true iff a response was cached with the key
+         */
+        bool invalidate(std::string_view key);
+
+        //! Invalidate the responses whose keys start with a prefix
+        /*!
+         * \return # of responses invalidated
+         */
+        size_t invalidatePrefix(std::string_view prefix);
+
+        //! Invalidate every response
+        void clear();
+
+        //! Get # of cached responses
+        size_t size();
+
+        //! Get # of bytes of cached keys & responses
+        size_t bytes();
+
+        //! Get max # of bytes of cached keys & responses
+        size_t maxBytes() const noexcept { return _max_bytes; }
+
+        //! Get max # of cached responses, 0 if unlimited
+        size_t maxEntries() const noexcept { return _max_entries; }
+
+        //! Get # of lookups which found a response
+        uint64_t numHits() const noexcept { return _hits; }
+
+        //! Get # of lookups which found no response
+        uint64_t numMisses() const noexcept { return _misses; }
+
+        //! Get # of responses evicted to make room
+        uint64_t numEvictions() const noexcept { return _evictions; }
+
+    private:
+        const size_t _max_bytes;
+        const size_t _max_entries;
+
+        std::mutex _lock;
+        // most recently used first
+        std::list<std::shared_ptr<CachedResponse>> _lru;
+        std::unordered_map<Utils::CacheView, CachedResponse*, Utils::CacheViewSparseMapHash, Utils::CacheViewSparseMapHash> _index;
+        size_t _bytes;
+
+        std::atomic<uint64_t> _hits;
+        std::atomic<uint64_t> _misses;
+        std::atomic<uint64_t> _evictions;
+
+        //! Remove a response, the lock must be held
+        void remove(CachedResponse *response);
+    };
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "core/http/http_cache.hxx"
+#include "core/http/http_parser.hxx"
+#include "core/http/http_request.hxx"
+#include "core/http/http_response.hxx"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CxxServer::Core::Http {
+
+    //! HTTP/1.1 server side of a connection, independent of the transport
+    /*!
+     * Parses requests straight from the transport's receive buffer, only a request split over several reads is
+     * copied aside until it is complete. Pipelined requests are handed out one after another from the same buffer.
+     *
+     * Responses must be sent in the order requests were received, from onRequest or later. The connection is kept
+     * alive unless the request asks otherwise (or is HTTP/1.0 without keep-alive), the response to the last request
+     * then says Connection: close & the transport is drained & disconnected after it. Invalid requests are answered
+     * by onRequestError & close the connection.
+     *
+     * Thread safe
+     */
+    class Connection {
+    public:
+        Connection() : _stopped(false), _date(false), _requests(0) {}
+        virtual ~Connection() = default;
+
+        //! Act as getter & setter for the request size limits
+        RequestParser::Limits &requestLimits() noexcept { return _parser.limits(); }
+
+        //! Act as getter & setter for adding the cached Date header (see Date) to every response
+        bool &dateHeader() noexcept { return _date; }
+
+        //! Get # of requests received
+        uint64_t numRequests() const noexcept { return _requests; }
+
+        //! Send the response to the oldest request not answered yet
+        /*!
+         * Content-Length & the Connection header are added as needed. The response is gathered from its head, its
+         * header block & the headers added here without joining them first. For a chunked response send the chunks
+         * with sendChunk & end it with sendLastChunk.
+         * \param response - Response
+         * \return true iff the response was queued
+         */
+        bool sendResponse(const Response &response);
+
+        //! Send a cached response to the oldest request not answered yet
+        /*!
+         * The cached buffer is queued on the transport without copying it, only the Date header & a Connection
+         * header the request needs are copied in between.
+         * \param response - Cached response
+         * \return true iff the response was queued
+         */
+        bool sendCached(const std::shared_ptr<const CachedResponse> &response);
+
+        //! Send a response whose body is a shared buffer, without copying the body
+        /*!
+         * The body of the response itself is ignored, Content-Length is the size of the buffer. The buffer is queued
+         * on the transport as is, e.g. a file held in memory & sent by many connections.
+         * \param response - Response
+         * \param owner - Owner of the body, kept alive until it is sent
+         * \param body - Body
+         * \param size - Body size
+         * \return true iff the response was queued
+         */
+        bool sendResponseShared(const Response &response, std::shared_ptr<const void> owner, const void *body, size_t size);
+
+        //! Send a response whose body is a region of a file, without reading it
+        /*!
+         * The body of the response itself is ignored, Content-Length is the size of the region. The region is sent
+         * from the file by the transport, with sendfile over TCP.
+         * \param response - Response
+         * \param owner - Owner of the file descriptor, kept alive until the region is sent
+         * \param fd - File descriptor
+         * \param offset - Offset of the region in the file
+         * \param size - Region size
+         * \return true iff the response was queued
+         */
+        bool sendResponseFile(const Response &response, std::shared_ptr<const void> owner, int fd, uint64_t offset, size_t size);
+
+        //! Send a chunk of a chunked response
+        /*!
+         * \param data - Chunk data
+         * \param size - Chunk size, empty chunks are skipped as they would end the body
+         * \return true iff the chunk was queued
+         */
+        bool sendChunk(const void *data, size_t size);
+
+        //! End a chunked response
+        /*!
+         * \return true iff the end was queued
+         */
+        bool sendLastChunk();
+
+    protected:
+        //! Feed data received by the transport
+        /*!
+         * \param buffer - Received data
+         * \param size - Data size
+         */
+        void receiveRequests(const void *buffer, size_t size);
+
+        //! Handle a request
+        /*!
+         * Note: The request is only valid during the call, answers 404 Not Found by default
+         * \param request - Request
+         */
+        virtual void onRequest(const Request &request);
+
+        //! Handle an invalid request, the connection is closed after the response
+        /*!
+         * Note: Answers with the status & an empty body by default
+         * \param status - HTTP status for the error (400, 413, 431, 501 or 505)
+         */
+        virtual void onRequestError(int status);
+
+        //! Queue data on the transport
+        virtual bool transportSend(const void *buffer, size_t size) = 0;
+
+        //! Queue data gathered from several buffers on the transport, joins them unless overridden
+        virtual bool transportSendGather(std::initializer_list<std::string_view> buffers);
+
+        //! Queue data owned by a shared buffer on the transport, copies it unless overridden
+        virtual bool transportSendShared(std::shared_ptr<const void> owner, const void *buffer, size_t size) { return transportSend(buffer, size); }
+
+        //! Queue a region of a file on the transport, reads it unless overridden
+        virtual bool transportSendFile(std::shared_ptr<const void> owner, int fd, uint64_t offset, size_t size);
+
+        //! Disconnect the transport once the queued data is sent
+        virtual bool transportClose() = 0;
+
+    private:
+        // What the response to a request must say about the connection
+        enum ResponseFlags : uint8_t {
+            Close = 1,
+            KeepAlive = 2,
+            // the request is HEAD, the body is left out
+            Head = 4
+        };
+
+        RequestParser _parser;
+        Request _request;
+        // a request split over several reads, kept until it is complete
+        std::vector<char> _partial;
+        // no more requests are parsed after one which closes the connection
+        bool _stopped;
+        bool _date;
+
+        std::mutex _response_lock;
+        std::deque<uint8_t> _response_flags;
+        bool _chunk_close = false;
+        // the chunks of a response to HEAD aren't sent
+        bool _chunk_skip = false;
+        std::string _out;
+
+        std::atomic<uint64_t> _requests;
+
+        //! Queue the flags for the response to a request
+        void expectResponse(uint8_t flags);
+
+        //! Queue the head of a response & the body copied after it, the response lock must be held
+        /*!
+         * \param response - Response
+         * \param flags - Flags of the request
+         * \param length - Add Content-Length
+         * \param size - Body size for Content-Length
+         * \param body - Body to copy after the head
+         */
+        bool sendHead(const Response &response, uint8_t flags, bool length, uint64_t size, std::string_view body);
+
+        //! Are responses with a status always without a body
+        static bool bodyless(int status) noexcept { return status < 200 || status == 204 || status == 304; }
+
+        //! Get Connection header to add to a response
+        static std::string_view connectionHeader(uint8_t flags, bool response_close) noexcept;
+    };
+}
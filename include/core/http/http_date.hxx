@@ -0,0 +1,94 @@
+#pragma once
+
+#include "core/service.hxx"
+#include "core/timer.hxx"
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace CxxServer::Core::Http {
+
+    //! Date header of the responses sent in the current second
+    /*!
+     * Every thread keeps its own "Date: ...\r\n" header & formats it again only once the second changes, so
+     * responses add the header without formatting a date or taking a lock. While a DateTimer is ticking the
+     * current second is read from it instead of the clock.
+     *
+     * Thread safe
+     */
+    class Date {
+    public:
+        //! Size of an HTTP date (IMF-fixdate), e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+        static constexpr size_t size = 29;
+
+        //! Get Date header for the current second, including the trailing CRLF
+        /*!
+         * Note: The header is only valid on the calling thread until the next call
+         */
+        static std::string_view header() noexcept;
+
+        //! Format an HTTP date
+        /*!
+         * \param time - Time to format
+         * \param buf - Buffer of at least size chars to format into
+         * \return Formatted date, a view of buf
+         */
+        static std::string_view format(std::time_t time, char *buf) noexcept;
+
+        //! Get second Date headers are currently formatted for
+        static std::time_t now() noexcept;
+    };
+
+    //! Timer ticking the second Date headers are formatted for
+    /*!
+     * Reading the clock for every response is the last per response cost of the Date header, the timer
+     * publishes the current second once a second instead. Start one per process, e.g. along with the server.
+     *
+     * Date headers read the clock again as soon as the timer stops ticking: once stopped, destroyed, cancelled or
+     * failed, or once its service stops & the IO thread it ticked on exits.
+     *
+     * Thread safe
+     */
+    class DateTimer : public Timer {
+    public:
+        explicit DateTimer(const std::shared_ptr<Service> &service);
+        DateTimer(const DateTimer &) = delete;
+        DateTimer(DateTimer &&) = delete;
+        //! Stops ticking if started
+        virtual ~DateTimer();
+
+        DateTimer &operator=(const DateTimer &) = delete;
+        DateTimer &operator=(DateTimer &&) = delete;
+
+        //! Start ticking
+        /*!
+         * \return true if started, false if already started or for any error
+         */
+        bool start();
+
+        //! Stop ticking, Date headers read the clock again
+        /*!
+         * \return true if stopped, false if not started
+         */
+        bool stop();
+
+        //! Is the timer ticking
+        bool isStarted() const noexcept { return _started; }
+
+    protected:
+        void onTimer(bool canceled) override;
+        void onErr(int error, const std::string &category, const std::string &message) override;
+
+    private:
+        std::atomic<bool> _started;
+        // counted among the ticking timers, shared with the IO threads it ticked on
+        std::shared_ptr<std::atomic<bool>> _counted;
+
+        //! Publish the current second & wait for the next one
+        void tick();
+    };
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "core/http/http_connection.hxx"
+#include "core/http/http_request.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+namespace CxxServer::Core::Http {
+    class StaticFiles;
+
+    //! File opened by StaticFiles
+    /*!
+     * Holds the file open, & a copy of its contents if it is small, for as long as a connection sends it, so it
+     * stays valid once evicted or replaced in the cache. Immutable once opened.
+     *
+     * Thread safe
+     */
+    class StaticFile {
+    public:
+        friend class StaticFiles;
+
+        StaticFile() = default;
+        StaticFile(const StaticFile &) = delete;
+        StaticFile(StaticFile &&) = delete;
+        ~StaticFile();
+
+        StaticFile &operator=(const StaticFile &) = delete;
+        StaticFile &operator=(StaticFile &&) = delete;
+
+        //! Get path relative to the root
+        std::string_view path() const noexcept { return _path; }
+
+        //! Get file descriptor
+        int fd() const noexcept { return _fd; }
+
+        //! Get file size
+        uint64_t size() const noexcept { return _size; }
+
+        //! Are the file contents held in memory
+        bool isBuffered() const noexcept { return _data != nullptr; }
+
+        //! Get file contents if held in memory, nullptr otherwise
+        const void *data() const noexcept { return _data.get(); }
+
+        //! Get entity tag, quoted
+        std::string_view etag() const noexcept { return _etag; }
+
+        //! Get last modification time, formatted as an HTTP date
+        std::string_view lastModified() const noexcept { return _last_modified; }
+
+        //! Get content type guessed from the extension
+        std::string_view contentType() const noexcept { return _content_type; }
+
+    private:
+        std::string _path;
+        int _fd = -1;
+        uint64_t _size = 0;
+        std::unique_ptr<char[]> _data;
+        std::string _etag;
+        std::string _last_modified;
+        std::string_view _content_type;
+
+        // identity of the file on disk, to notice it was changed or replaced
+        dev_t _device = 0;
+        ino_t _inode = 0;
+        int64_t _modified = 0;
+
+        // steady clock time the file was last checked against the disk, guarded by the cache's lock
+        int64_t _checked = 0;
+        // position in the LRU list
+        std::list<std::shared_ptr<StaticFile>>::iterator _lru;
+    };
+
+    //! Static file handler
+    /*!
+     * Serves files below a root directory, answering GET & HEAD with ETag & Last-Modified validators, conditional
+     * requests with 304 Not Modified & single byte ranges with 206 Partial Content.
+     *
+     * Files stay open in an LRU cache with their metadata, checked again against the disk at most once per
+     * revalidation period. Small files are also read into memory once & sent straight from that copy by every
+     * connection, so a file truncated or rewritten in place keeps being served as it was until it is revalidated.
+     * Larger ones are sent with sendfile from the cached descriptor, which ends the connection early if the file
+     * shrinks under it. Over SSL the transport reads the file through its buffer instead.
+     *
+     * Paths are percent decoded, paths with ".." segments or which aren't regular files are not found.
+     *
+     * Thread safe
+     */
+    class StaticFiles {
+    public:
+        //! Initialize handler
+        /*!
+         * \param root - Root directory
+         * \param buffer_limit - Max size of a file held in memory, 0 to never hold one
+         * \param max_buffered - Max # of bytes held in memory by the cached files
+         * \param max_files - Max # of open files in the cache
+         * \param revalidate - Time a cached file is trusted before it is checked against the disk again
+         */
+        explicit StaticFiles(std::string root, size_t buffer_limit = 256 * 1024, size_t max_buffered = 64 * 1024 * 1024,
+                             size_t max_files = 1024, std::chrono::nanoseconds revalidate = std::chrono::seconds(1));
+        StaticFiles(const StaticFiles &) = delete;
+        StaticFiles(StaticFiles &&) = delete;
+        ~StaticFiles() = default;
+
+        StaticFiles &operator=(const StaticFiles &) = delete;
+        StaticFiles &operator=(StaticFiles &&) = delete;
+
+        //! Serve the file at the path of a request
+        /*!
+         * \param connection - Connection the request was received on
+         * \param request - Request
+         * \return true iff the file was found
+         */
+        bool serve(Connection &connection, const Request &request) { return serve(connection, request, request.path()); }
+
+        //! Serve a file, e.g. the rest of the path captured by a route
+        /*!
+         * Note: Answers 405 Method Not Allowed unless GET or HEAD, 404 Not Found if there is no such file & 416 Range
+         *       Not Satisfiable for a range past its end
+         * \param connection - Connection the request was received on
+         * \param request - Request
+         * \param path - Path relative to the root, percent encoded
+         * \return true iff the file was found
+         */
+        bool serve(Connection &connection, const Request &request, std::string_view path);
+
+        //! Open a file through the cache
+        /*!
+         * \param path - Path relative to the root, percent encoded
+         * \return File, nullptr if there is no such regular file
+         */
+        std::shared_ptr<const StaticFile> open(std::string_view path);
+
+        //! Close every cached file
+        void clear();
+
+        //! Get root directory
+        const std::string &root() const noexcept { return _root; }
+
+        //! Get # of cached files
+        size_t size();
+
+        //! Get # of bytes held in memory by the cached files
+        size_t bufferedBytes();
+
+        //! Get # of lookups which found a cached file
+        uint64_t numHits() const noexcept { return _hits; }
+
+        //! Get # of lookups which opened a file
+        uint64_t numMisses() const noexcept { return _misses; }
+
+    private:
+        const std::string _root;
+        const size_t _buffer_limit;
+        const size_t _max_buffered;
+        const size_t _max_files;
+        const std::chrono::nanoseconds _revalidate;
+
+        std::mutex _lock;
+        // most recently used first
+        std::list<std::shared_ptr<StaticFile>> _lru;
+        // keyed by views of the cached files' paths
+        std::unordered_map<std::string_view, StaticFile*> _index;
+        size_t _buffered;
+
+        std::atomic<uint64_t> _hits;
+        std::atomic<uint64_t> _misses;
+
+        //! Open a file from the disk
+        /*!
+         * \param path - Decoded path relative to the root
+         * \param buffered - # of bytes held in memory so far
+         */
+        std::shared_ptr<StaticFile> load(const std::string &path, size_t buffered) const;
+
+        //! Cache a file, replacing the one cached with the same path, the lock must be held
+        void insert(const std::shared_ptr<StaticFile> &file);
+
+        //! Remove a file, the lock must be held
+        void remove(StaticFile *file);
+    };
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "core/http/http_request.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace CxxServer::Core::Http {
+
+    //! Incremental HTTP/1.x request parser
+    /*!
+     * Parses the request at the start of the data it is handed. While a request is incomplete the caller keeps the
+     * data & hands it again with more appended, the parser resumes its scans where it stopped, so a request split
+     * over many reads is scanned about once. Dechunked bodies are the only data copied. Line ends, colons & tokens
+     * are found & validated with the vectorized scans of Http::Scan.
+     *
+     * Requests with both Content-Length & Transfer-Encoding, conflicting lengths or folded headers are rejected,
+     * they are how requests get smuggled past proxies.
+     *
+     * Not thread safe
+     */
+    class RequestParser {
+    public:
+        //! Result of a parse
+        enum class Result : uint8_t {
+            //! A whole request was parsed
+            Complete,
+            //! More data is needed
+            Incomplete,
+            //! The request is invalid, see errorStatus
+            Error
+        };
+
+        //! Request size limits
+        struct Limits {
+            //! Max size of the request line & headers
+            size_t max_header_size = 64 * 1024;
+            //! Max # of headers
+            size_t max_headers = 100;
+            //! Max size of the body
+            size_t max_body_size = 16 * 1024 * 1024;
+        };
+
+        RequestParser() { reset(); }
+
+        //! Act as getter & setter for the request size limits
+        Limits &limits() noexcept { return _limits; }
+
+        //! Parse the request at the start of the data
+        /*!
+         * \param data - Received data, the same start as the previous call while a request is incomplete
+         * \param size - Data size
+         * \param request - Request to fill, its views point into data (or the parser for chunked bodies)
+         * \param consumed - Size of the whole request once complete
+         * \return Result of the parse
+         */
+        Result parse(const char *data, size_t size, Request &request, size_t &consumed);
+
+        //! Get HTTP status to answer an invalid request with
+        int errorStatus() const noexcept { return _error_status; }
+
+        //! Reset to parse a new request
+        void reset() noexcept;
+
+    private:
+        enum class Body : uint8_t { None, Length, Chunked };
+
+        Limits _limits;
+
+        // bytes already searched for the end of the headers
+        size_t _scanned;
+        // size of the request line & headers, 0 until found
+        size_t _header_size;
+        Body _body_kind;
+        size_t _body_length;
+
+        // dechunking state, offsets are relative to the start of the request
+        size_t _chunk_offset;
+        size_t _chunk_remaining;
+        bool _chunk_crlf;
+        bool _chunk_trailers;
+        std::vector<char> _chunked_body;
+
+        int _error_status;
+
+        //! Find the end of the headers, resuming the search where the last call stopped
+        /*!
+         * \return Size of the request line & headers, 0 if not received yet
+         */
+        size_t findHeaderEnd(const char *data, size_t size);
+
+        //! Parse the request line & headers
+        bool parseHead(const char *data, Request &request);
+
+        //! Parse the request line
+        bool parseRequestLine(std::string_view line, Request &request);
+
+        //! Dechunk as much of the body as is available
+        Result parseChunks(const char *data, size_t size, size_t &consumed);
+
+        bool fail(int status) noexcept {
+            _error_status = status;
+            return false;
+        }
+    };
+}
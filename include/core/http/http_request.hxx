@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace CxxServer::Core::Http {
+    class RequestParser;
+
+    //! HTTP header
+    struct Header {
+        //! Header name as received
+        std::string_view name;
+        //! Header value without surrounding whitespace
+        std::string_view value;
+    };
+
+    //! Compare two header names or tokens ignoring ASCII case
+    bool equalsNoCase(std::string_view a, std::string_view b) noexcept;
+
+    //! HTTP request
+    /*!
+     * Every field is a view into the received data, nothing is copied. The views are only valid during the
+     * onRequest call which hands out the request, copy anything needed after it.
+     *
+     * Not thread safe
+     */
+    class Request {
+    public:
+        friend class RequestParser;
+
+        Request() = default;
+
+        //! Get request method
+        std::string_view method() const noexcept { return _method; }
+
+        //! Get request target as received
+        std::string_view target() const noexcept { return _target; }
+
+        //! Get path of the target
+        std::string_view path() const noexcept { return _path; }
+
+        //! Get query of the target, without the '?'
+        std::string_view query() const noexcept { return _query; }
+
+        //! Get minor HTTP version, 0 for HTTP/1.0 & 1 for HTTP/1.1
+        uint8_t minorVersion() const noexcept { return _minor_version; }
+
+        //! Get headers in the order received
+        const std::vector<Header> &headers() const noexcept { return _headers; }
+
+        //! Get value of the first header with a name, ignoring case
+        /*!
+         * \param name - Header name
+         * \return Header value, empty if there is no such header
+         */
+        std::string_view header(std::string_view name) const noexcept;
+
+        //! Get request body, dechunked for chunked requests
+        std::string_view body() const noexcept { return _body; }
+
+        //! Does the client keep the connection open after the response
+        bool keepAlive() const noexcept { return _keep_alive; }
+
+        //! Was the body sent chunked
+        bool isChunked() const noexcept { return _chunked; }
+
+        //! Clear request, keeping its storage
+        void clear() noexcept;
+
+    private:
+        std::string_view _method;
+        std::string_view _target;
+        std::string_view _path;
+        std::string_view _query;
+        uint8_t _minor_version = 1;
+        std::vector<Header> _headers;
+        std::string_view _body;
+        bool _keep_alive = true;
+        bool _chunked = false;
+    };
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace CxxServer::Core::Http {
+
+    //! Headers serialized once & sent with many responses
+    /*!
+     * Headers common to many responses, e.g. Server or Content-Type, are serialized into a block up front. A
+     * response refers to the block instead of copying its headers, the block is gathered into the response as it
+     * is sent.
+     *
+     * Not thread safe while headers are added, thread safe once built
+     */
+    class HeaderBlock {
+    public:
+        HeaderBlock() = default;
+
+        //! Add a header
+        /*!
+         * \param name - Header name
+         * \param value - Header value
+         */
+        HeaderBlock &header(std::string_view name, std::string_view value);
+
+        //! Get serialized headers
+        std::string_view data() const noexcept { return _data; }
+
+    private:
+        std::string _data;
+    };
+
+    //! HTTP response
+    /*!
+     * Builds the status line & headers as they are set, the body is kept apart so Content-Length is added when the
+     * response is sent. A response can be cleared & reused without giving back its storage.
+     *
+     * Not thread safe
+     */
+    class Response {
+    public:
+        //! Initialize a 200 OK response
+        Response() { clear(); }
+
+        //! Set status, clearing headers & body
+        /*!
+         * \param status - HTTP status code
+         * \param reason - Reason phrase, the standard phrase of the status if empty
+         */
+        Response &status(int status, std::string_view reason = std::string_view());
+
+        //! Add a header
+        /*!
+         * \param name - Header name
+         * \param value - Header value
+         */
+        Response &header(std::string_view name, std::string_view value);
+
+        //! Set body
+        /*!
+         * \param body - Body
+         */
+        Response &body(std::string_view body);
+
+        //! Set body
+        /*!
+         * \param body - Body
+         * \param size - Body size
+         */
+        Response &body(const void *body, size_t size) { return this->body(std::string_view(static_cast<const char*>(body), size)); }
+
+        //! Send the headers of a block after the headers added to the response
+        /*!
+         * Note: The block is referred to & not copied, it must outlive sending the response. Setting a block
+         *       replaces the one previously set
+         * \param block - Header block
+         */
+        Response &headers(const HeaderBlock &block) noexcept {
+            _block = &block;
+            return *this;
+        }
+
+        //! Send the body in chunks instead of with a length
+        /*!
+         * Note: The body set is ignored, send the chunks with sendChunk after the response
+         */
+        Response &chunked();
+
+        //! Get status code
+        int statusCode() const noexcept { return _status; }
+
+        //! Is the body sent in chunks
+        bool isChunked() const noexcept { return _chunked; }
+
+        //! Does the response close the connection
+        bool isClose() const noexcept { return _close; }
+
+        //! Get status line & headers, without the blank line ending them or the header block
+        std::string_view head() const noexcept { return _head; }
+
+        //! Get serialized headers of the header block, empty if none is set
+        std::string_view block() const noexcept { return _block == nullptr ? std::string_view() : _block->data(); }
+
+        //! Get body
+        std::string_view body() const noexcept { return _body; }
+
+        //! Reset to an empty 200 OK response, keeping storage
+        void clear();
+
+        //! Get standard reason phrase of a status
+        static std::string_view reason(int status) noexcept;
+
+        //! Get pre-serialized status line of a status with its standard reason phrase
+        /*!
+         * \param status - HTTP status code
+         * \return Status line including the trailing CRLF, empty if the status has no standard reason phrase
+         */
+        static std::string_view statusLine(int status) noexcept;
+
+    private:
+        std::string _head;
+        std::string _body;
+        const HeaderBlock *_block;
+        int _status;
+        bool _chunked;
+        bool _close;
+    };
+}
@@ -0,0 +1,380 @@
+#pragma once
+
+#include "core/http/http_connection.hxx"
+#include "core/http/http_request.hxx"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace CxxServer::Core::Http {
+    class Router;
+
+    template<size_t N, size_t Capacity>
+    class RouteTable;
+
+    //! Path parameters captured by a route
+    /*!
+     * Values are views of the request path, so they stay valid as long as the request, names are views of the
+     * route's pattern. Up to max_size parameters are captured without allocating.
+     *
+     * Not thread safe
+     */
+    class RouteParams {
+    public:
+        //! Max # of parameters of a route
+        static constexpr size_t max_size = 8;
+
+        //! Get # of parameters
+        constexpr size_t size() const noexcept { return _size; }
+
+        //! Are no parameters captured
+        constexpr bool empty() const noexcept { return _size == 0; }
+
+        //! Get name of a parameter
+        constexpr std::string_view name(size_t idx) const noexcept { return _params[idx].first; }
+
+        //! Get value of a parameter
+        constexpr std::string_view value(size_t idx) const noexcept { return _params[idx].second; }
+
+        //! Get value of a parameter by name, empty if not captured
+        constexpr std::string_view operator[](std::string_view name) const noexcept {
+            for (size_t i = 0; i < _size; ++i) {
+                if (_params[i].first == name)
+                    return _params[i].second;
+            }
+
+            return std::string_view();
+        }
+
+        //! Forget captured parameters
+        constexpr void clear() noexcept { _size = 0; }
+
+    private:
+        friend class Router;
+
+        template<size_t N, size_t Capacity>
+        friend class RouteTable;
+
+        std::array<std::pair<std::string_view, std::string_view>, max_size> _params{};
+        size_t _size = 0;
+
+        constexpr bool push(std::string_view name, std::string_view value) noexcept {
+            if (_size == max_size)
+                return false;
+
+            _params[_size++] = { name, value };
+            return true;
+        }
+
+        constexpr void pop() noexcept { --_size; }
+    };
+
+    //! HTTP request router
+    /*!
+     * Routes are kept in a compressed radix tree, lookups walk the path once & capture parameters as views of it
+     * without allocating. Routes without parameters are also indexed by their whole path, looked up with
+     * transparent string_view keys before walking the tree.
+     *
+     * Patterns are paths whose segments may be parameters: ":name" matches a non empty segment & "*name", only as
+     * the last segment, matches the rest of the path including slashes. Static segments are preferred over
+     * parameters & parameters over the rest, a lookup backtracks when a preferred branch leads nowhere.
+     *
+     * Not thread safe while routes are added, thread safe once built
+     */
+    class Router {
+    public:
+        //! Request handler
+        using Handler = std::function<void(Connection &connection, const Request &request, const RouteParams &params)>;
+
+        Router();
+        Router(const Router &) = delete;
+        Router(Router &&) = delete;
+        ~Router();
+
+        Router &operator=(const Router &) = delete;
+        Router &operator=(Router &&) = delete;
+
+        //! Add a route
+        /*!
+         * \param method - Request method
+         * \param pattern - Path pattern, e.g. "/users/:id/posts/:post"
+         * \param handler - Request handler
+         * \return true iff added, false if the pattern is invalid, has more than RouteParams::max_size parameters,
+         *         names a parameter differently from a route sharing its position, or the route already exists
+         */
+        bool add(std::string_view method, std::string_view pattern, Handler handler);
+
+        //! Find the handler of a request
+        /*!
+         * \param method - Request method
+         * \param path - Request path
+         * \param params - Parameters captured by the route
+         * \return Handler, nullptr if no route matches
+         */
+        const Handler *find(std::string_view method, std::string_view path, RouteParams &params) const noexcept;
+
+        //! Get methods accepted by the route matching a path, comma separated for an Allow header
+        /*!
+         * \return Methods, empty if no route matches the path
+         */
+        std::string allowed(std::string_view path) const;
+
+        //! Hand a request to its handler
+        /*!
+         * Answers 404 Not Found if no route matches the path, 405 Method Not Allowed if none matches the method
+         * \param connection - Connection the request was received on
+         * \param request - Request
+         * \return true iff a handler was called
+         */
+        bool route(Connection &connection, const Request &request) const;
+
+        //! Get # of routes
+        size_t size() const noexcept { return _routes; }
+
+    private:
+        struct Node;
+
+        struct PathHash {
+            using is_transparent = void;
+            size_t operator()(std::string_view path) const noexcept { return std::hash<std::string_view>()(path); }
+        };
+
+        std::unique_ptr<Node> _root;
+        // routes without parameters by their whole path
+        std::unordered_map<std::string, const Node*, PathHash, std::equal_to<>> _static;
+        size_t _routes;
+
+        //! Insert the rest of a pattern below a node
+        Node *insert(Node *node, std::string_view pattern);
+
+        //! Find the node matching the rest of a path below a node, with a route for a method or for any if empty
+        static const Node *lookup(const Node *node, std::string_view path, std::string_view method, RouteParams &params) noexcept;
+
+        //! Find a node's handler for a method
+        static const Handler *handlerOf(const Node *node, std::string_view method) noexcept;
+    };
+
+    //! Method & pattern of a route in a RouteTable
+    struct RouteSpec {
+        std::string_view method;
+        std::string_view pattern;
+    };
+
+    //! Route table built at compile time, for fixed APIs
+    /*!
+     * Patterns follow the Router's rules & are checked by the compiler, the routes are split by segment into a
+     * trie of static storage. A lookup yields the index of the route matched, to switch on, e.g.
+     *
+     *   constexpr RouteSpec routes[] = { { "GET", "/users/:id" }, { "DELETE", "/users/:id" } };
+     *   constexpr RouteTable table(routes);
+     *   switch (table.find(request.method(), request.path(), params)) {
+     *       case table.index("GET", "/users/:id"): ...
+     *
+     * Thread safe
+     */
+    template<size_t N, size_t Capacity = N * 8>
+    class RouteTable {
+    public:
+        //! Route not found
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        //! Build the table, an invalid pattern or duplicate route fails to compile
+        /*!
+         * \param routes - Routes
+         */
+        consteval RouteTable(const RouteSpec (&routes)[N]) {
+            _nodes[0] = Node{};
+            _size = 1;
+
+            for (size_t route = 0; route < N; ++route) {
+                _routes[route] = routes[route];
+                _next_route[route] = npos;
+
+                auto pattern = routes[route].pattern;
+                if (pattern.empty() || pattern[0] != '/')
+                    throw "Route pattern must start with /";
+
+                size_t node = 0;
+                size_t params = 0;
+                for (size_t pos = 1; ; ) {
+                    size_t end = pattern.find('/', pos);
+                    auto segment = pattern.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+
+                    Kind kind = Kind::Static;
+                    if (!segment.empty() && segment[0] == ':')
+                        kind = Kind::Param;
+                    else if (!segment.empty() && segment[0] == '*') {
+                        if (end != std::string_view::npos)
+                            throw "Route wildcard must be the last segment";
+                        kind = Kind::Wildcard;
+                    }
+
+                    if (kind != Kind::Static && (segment.size() == 1 || ++params > RouteParams::max_size))
+                        throw "Route parameter must be named & a route has at most RouteParams::max_size of them";
+                    if (kind == Kind::Static && segment.find_first_of(":*") != std::string_view::npos)
+                        throw "Route parameter must be a whole segment";
+
+                    node = child(node, kind, kind == Kind::Static ? segment : segment.substr(1));
+
+                    if (end == std::string_view::npos)
+                        break;
+                    pos = end + 1;
+                }
+
+                // routes ending at the node are chained, a method appears once
+                for (size_t other = _nodes[node].first_route; other != npos; other = _next_route[other]) {
+                    if (_routes[other].method == routes[route].method)
+                        throw "Duplicate route";
+                }
+
+                _next_route[route] = _nodes[node].first_route;
+                _nodes[node].first_route = route;
+            }
+        }
+
+        //! Find the route of a request
+        /*!
+         * \param method - Request method
+         * \param path - Request path
+         * \param params - Parameters captured by the route
+         * \return Index of the route, npos if no route matches
+         */
+        constexpr size_t find(std::string_view method, std::string_view path, RouteParams &params) const noexcept {
+            params.clear();
+            if (path.empty() || path[0] != '/')
+                return npos;
+
+            return lookup(0, path.substr(1), method, params);
+        }
+
+        //! Get index of a route
+        /*!
+         * \return Index of the route, npos if there is no such route
+         */
+        constexpr size_t index(std::string_view method, std::string_view pattern) const noexcept {
+            for (size_t route = 0; route < N; ++route) {
+                if (_routes[route].method == method && _routes[route].pattern == pattern)
+                    return route;
+            }
+
+            return npos;
+        }
+
+        //! Get a route
+        constexpr const RouteSpec &operator[](size_t idx) const noexcept { return _routes[idx]; }
+
+        //! Get # of routes
+        static constexpr size_t size() noexcept { return N; }
+
+    private:
+        enum class Kind : uint8_t {
+            Static,
+            Param,
+            Wildcard
+        };
+
+        struct Node {
+            // static segment, or parameter name
+            std::string_view segment{};
+            // static children are chained through their next sibling
+            size_t first_child = npos;
+            size_t next_sibling = npos;
+            size_t param = npos;
+            size_t wildcard = npos;
+            size_t first_route = npos;
+        };
+
+        std::array<RouteSpec, N> _routes{};
+        std::array<size_t, N> _next_route{};
+        std::array<Node, Capacity> _nodes{};
+        size_t _size = 0;
+
+        //! Find or add a child of a node
+        consteval size_t child(size_t node, Kind kind, std::string_view segment) {
+            if (kind == Kind::Static) {
+                for (size_t other = _nodes[node].first_child; other != npos; other = _nodes[other].next_sibling) {
+                    if (_nodes[other].segment == segment)
+                        return other;
+                }
+            }
+            else {
+                size_t other = kind == Kind::Param ? _nodes[node].param : _nodes[node].wildcard;
+                if (other != npos && _nodes[other].segment != segment)
+                    throw "Route parameters sharing a position must have the same name";
+                if (other != npos)
+                    return other;
+            }
+
+            if (_size == Capacity)
+                throw "Route table capacity exceeded, raise it";
+
+            _nodes[_size] = Node{};
+            _nodes[_size].segment = segment;
+            if (kind == Kind::Static) {
+                _nodes[_size].next_sibling = _nodes[node].first_child;
+                _nodes[node].first_child = _size;
+            }
+            else if (kind == Kind::Param)
+                _nodes[node].param = _size;
+            else
+                _nodes[node].wildcard = _size;
+
+            return _size++;
+        }
+
+        //! Find the route matching the rest of a path below a node
+        constexpr size_t lookup(size_t node, std::string_view path, std::string_view method, RouteParams &params) const noexcept {
+            size_t end = path.find('/');
+            auto segment = path.substr(0, end);
+            bool last = end == std::string_view::npos;
+            auto rest = last ? std::string_view() : path.substr(end + 1);
+
+            for (size_t other = _nodes[node].first_child; other != npos; other = _nodes[other].next_sibling) {
+                if (_nodes[other].segment != segment)
+                    continue;
+
+                size_t route = last ? routeOf(other, method) : lookup(other, rest, method, params);
+                if (route != npos)
+                    return route;
+
+                // static segments are unique among siblings
+                break;
+            }
+
+            size_t param = _nodes[node].param;
+            if (param != npos && !segment.empty() && params.push(_nodes[param].segment, segment)) {
+                size_t route = last ? routeOf(param, method) : lookup(param, rest, method, params);
+                if (route != npos)
+                    return route;
+
+                params.pop();
+            }
+
+            size_t wildcard = _nodes[node].wildcard;
+            if (wildcard != npos) {
+                size_t route = routeOf(wildcard, method);
+                if (route != npos && params.push(_nodes[wildcard].segment, path))
+                    return route;
+            }
+
+            return npos;
+        }
+
+        //! Find the route of a method ending at a node
+        constexpr size_t routeOf(size_t node, std::string_view method) const noexcept {
+            for (size_t route = _nodes[node].first_route; route != npos; route = _next_route[route]) {
+                if (_routes[route].method == method)
+                    return route;
+            }
+
+            return npos;
+        }
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+//! Vectorized scans used to parse HTTP
+/*!
+ * Each scan has a scalar, an SSE4.2 & an AVX2 version, the best one the CPU supports is picked at startup. Only the
+ * vector versions are compiled for their instruction set, so AVX2 code is never run on CPUs without it.
+ */
+namespace CxxServer::Core::Http::Scan {
+
+    //! Instruction sets scans are implemented with
+    enum class Isa : uint8_t {
+        Scalar,
+        SSE42,
+        AVX2
+    };
+
+    //! Get instruction set scans currently use
+    Isa isa() noexcept;
+
+    //! Get best instruction set the CPU supports
+    Isa bestIsa() noexcept;
+
+    //! Use an instruction set for scans
+    /*!
+     * Note: Meant for tests & benchmarks, call before any parsing starts
+     * \param isa - Instruction set
+     * \return true iff the CPU supports it
+     */
+    bool useIsa(Isa isa) noexcept;
+
+    //! Get name of an instruction set
+    std::string_view name(Isa isa) noexcept;
+
+    //! Find the blank line ending HTTP headers
+    /*!
+     * \param data - Data to search
+     * \param size - Data size
+     * \return Offset of the "\r\n\r\n", npos if not found
+     */
+    size_t findHeaderEnd(const char *data, size_t size) noexcept;
+
+    //! Find the first occurrence of a character
+    /*!
+     * \param data - Data to search
+     * \param size - Data size
+     * \param c - Character to find, usually '\r' or ':'
+     * \return Offset of the character, npos if not found
+     */
+    size_t findChar(const char *data, size_t size, char c) noexcept;
+
+    //! Get length of the HTTP token (tchar from RFC 9110) at the start of data, as methods & header names must be
+    /*!
+     * A header name is validated & its colon found in one pass, the colon is the first char after the token.
+     * \param data - Data to scan
+     * \param size - Data size
+     * \return Offset of the first char which is not a token char, size if there is none
+     */
+    size_t tokenLength(const char *data, size_t size) noexcept;
+
+    //! Check data is a non empty HTTP token
+    inline bool isToken(const char *data, size_t size) noexcept { return size > 0 && tokenLength(data, size) == size; }
+
+    inline bool isToken(std::string_view text) noexcept { return isToken(text.data(), text.size()); }
+
+    //! Not found
+    constexpr size_t npos = static_cast<size_t>(-1);
+}
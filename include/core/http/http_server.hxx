@@ -0,0 +1,24 @@
+#pragma once
+
+#include "core/http/http_session.hxx"
+#include "core/tcp/tcp_server.hxx"
+
+#include <memory>
+
+namespace CxxServer::Core::Http {
+
+    //! HTTP server
+    /*!
+     * TCP server whose sessions speak HTTP/1.1, override newSession to create sessions which handle requests.
+     *
+     * Thread safe
+     */
+    class Server : public Tcp::Server {
+    public:
+        using Tcp::Server::Server;
+        virtual ~Server() = default;
+
+    protected:
+        std::shared_ptr<Tcp::Session> newSession(const std::shared_ptr<Tcp::Server> &server) override { return std::make_shared<Session>(server); }
+    };
+}
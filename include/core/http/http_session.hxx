@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core/http/http_connection.hxx"
+#include "core/tcp/tcp_session.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+
+namespace CxxServer::Core::Http {
+
+    //! HTTP session over a transport session
+    /*!
+     * Feeds the transport's receive buffer to the HTTP connection & sends responses on the transport. Subclass to
+     * handle requests in onRequest.
+     *
+     * Note: Subclasses overriding onReceive must call the base implementation
+     *
+     * Thread safe
+     */
+    template<typename Base>
+    class BasicSession : public Base, public Connection {
+    public:
+        using Base::Base;
+        virtual ~BasicSession() = default;
+
+    protected:
+        void onReceive(const void *buffer, size_t size) override { receiveRequests(buffer, size); }
+
+        bool transportSend(const void *buffer, size_t size) override { return this->sendAsync(buffer, size); }
+        bool transportSendGather(std::initializer_list<std::string_view> buffers) override { return this->sendGather(buffers); }
+        bool transportSendShared(std::shared_ptr<const void> owner, const void *buffer, size_t size) override { return this->sendShared(std::move(owner), buffer, size); }
+        bool transportSendFile(std::shared_ptr<const void> owner, int fd, uint64_t offset, size_t size) override { return this->sendFile(std::move(owner), fd, offset, size); }
+        bool transportClose() override { return this->drain(); }
+    };
+
+    //! HTTP session over TCP
+    using Session = BasicSession<Tcp::Session>;
+}
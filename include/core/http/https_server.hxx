@@ -0,0 +1,25 @@
+#pragma once
+
+#include "core/http/https_session.hxx"
+#include "core/tcp/ssl_server.hxx"
+
+#include <memory>
+
+namespace CxxServer::Core::Https {
+
+    //! HTTPS server
+    /*!
+     * SSL server whose sessions speak HTTP/1.1 once handshaked, override newSession to create sessions which
+     * handle requests.
+     *
+     * Thread safe
+     */
+    class Server : public SSL::Server {
+    public:
+        using SSL::Server::Server;
+        virtual ~Server() = default;
+
+    protected:
+        std::shared_ptr<Tcp::Session> newSession(const std::shared_ptr<Tcp::Server> &server) override { return std::make_shared<Session>(server, context()); }
+    };
+}
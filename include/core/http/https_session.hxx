@@ -0,0 +1,10 @@
+#pragma once
+
+#include "core/http/http_session.hxx"
+#include "core/tcp/ssl_session.hxx"
+
+namespace CxxServer::Core::Https {
+
+    //! HTTP session over SSL
+    using Session = Http::BasicSession<SSL::Session>;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdlib>
 #include <type_traits>
@@ -151,4 +152,80 @@ private:
     HandlerMemory<> &_storage;
     T _handler;
 };
+
+//! Recycled storage for coroutine frames
+/*!
+ * Frames are rounded up to a size class & freed frames are kept on a per thread free list of their class, so a
+ * coroutine started over & over reuses the same few blocks instead of going to malloc / free each time. Frames
+ * larger than the biggest class always use malloc / free.
+ *
+ * Thread safe, a frame may be freed on another thread than the one it was allocated on
+ */
+class FrameMemory {
+public:
+    //! Size classes are multiples of this
+    static constexpr size_t granularity = 64;
+    //! # of size classes, frames up to granularity * classes bytes are recycled
+    static constexpr size_t classes = 64;
+    //! Max # of freed frames kept per size class & thread
+    static constexpr size_t depth = 32;
+
+    //! Allocate a frame
+    /*!
+     * \param size - Size of the frame
+     * \return Pointer to a memory region which is at least as big as the requested size
+     */
+    static void *alloc(size_t size) {
+        size_t index = (size + granularity - 1) / granularity;
+        if (index == 0 || index > classes)
+            return std::malloc(size);
+
+        auto &free_list = cache().lists[index - 1];
+        if (free_list.count > 0)
+            return free_list.blocks[--free_list.count];
+
+        return std::malloc(index * granularity);
+    }
+
+    //! Free a frame
+    /*!
+     * \param ptr - Pointer to the frame
+     * \param size - Size the frame was allocated with
+     */
+    static void free(void *ptr, size_t size) {
+        size_t index = (size + granularity - 1) / granularity;
+        if (index == 0 || index > classes) {
+            std::free(ptr);
+            return;
+        }
+
+        auto &free_list = cache().lists[index - 1];
+        if (free_list.count < depth)
+            free_list.blocks[free_list.count++] = ptr;
+        else
+            std::free(ptr);
+    }
+
+private:
+    struct FreeList {
+        std::array<void*, depth> blocks;
+        size_t count = 0;
+    };
+
+    struct Cache {
+        std::array<FreeList, classes> lists;
+
+        ~Cache() {
+            for (auto &free_list : lists) {
+                for (size_t i = 0; i < free_list.count; ++i)
+                    std::free(free_list.blocks[i]);
+            }
+        }
+    };
+
+    static Cache &cache() {
+        thread_local Cache thread_cache;
+        return thread_cache;
+    }
+};
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "core/io.hxx"
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -74,6 +75,22 @@ public:
      */
     virtual bool stop();
 
+    //! Stop the service, draining outstanding handlers first
+    /*!
+     * Each IO service is allowed to run until it has no more outstanding work (i.e. pending sends are flushed
+     * & sessions are closed) or until the timeout expires, whichever comes first. IO services still busy at the
+     * deadline are stopped forcefully.
+     *
+     * Note: Servers should be drained (Server::stop(timeout)) before the service is, otherwise their acceptors
+     *       keep the IO services busy until the deadline.
+     * \param timeout - Drain deadline relative to now, 0 stops immediately
+     * \return if the service stopped successfully
+     */
+    virtual bool stop(std::chrono::nanoseconds timeout);
+
+    //! Get # of IO services which were forcefully stopped with outstanding work during the last drain
+    std::size_t numDrainDropped() const noexcept { return _drain_dropped; }
+
     //! Restart the service
     /*!
      * \return if the service successfully restarted
@@ -149,6 +166,7 @@ protected:
 private:
     std::vector<std::shared_ptr<asio::io_service>> _services;
     std::vector<std::thread> _threads;
+    std::vector<std::shared_ptr<asio::io_service::work>> _works;
     std::shared_ptr<asio::io_service::strand> _strand;
 
     std::atomic<bool> _strand_needed;
@@ -156,6 +174,8 @@ private:
     std::atomic<bool> _started;
     // Round robin index
     std::atomic<std::size_t> _rr_idx;
+    // IO services forcefully stopped by the last drain
+    std::atomic<std::size_t> _drain_dropped;
 
     static void serviceThread(const std::shared_ptr<Service> &service, const std::shared_ptr<asio::io_service> &io);
 };
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "core/memory.hxx"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace CxxServer::Core {
+
+template<typename T>
+class Task;
+
+//! Promise parts shared by every task
+/*!
+ * Frames are allocated from FrameMemory, so tasks started over & over recycle their frames.
+ */
+class TaskPromiseBase {
+public:
+    static void *operator new(size_t size) { return FrameMemory::alloc(size); }
+    static void operator delete(void *ptr, size_t size) { FrameMemory::free(ptr, size); }
+
+    //! Tasks are lazy, they start once awaited or detached
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    //! Resume the awaiting coroutine, or free a detached task's frame
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            auto &promise = handle.promise();
+            if (promise._detached) {
+                handle.destroy();
+                return std::noop_coroutine();
+            }
+
+            return promise._continuation ? promise._continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept {
+        // nobody is left to rethrow to, same as an exception escaping a thread
+        if (_detached)
+            std::terminate();
+
+        _exception = std::current_exception();
+    }
+
+protected:
+    template<typename T>
+    friend class Task;
+
+    std::coroutine_handle<> _continuation;
+    std::exception_ptr _exception;
+    bool _detached = false;
+
+    void rethrow() const {
+        if (_exception)
+            std::rethrow_exception(_exception);
+    }
+};
+
+//! Promise of a task producing a value
+template<typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template<typename U>
+    void return_value(U &&value) { _value.emplace(std::forward<U>(value)); }
+
+    T result() {
+        rethrow();
+        return std::move(*_value);
+    }
+
+private:
+    std::optional<T> _value;
+};
+
+//! Promise of a task producing nothing
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() { rethrow(); }
+};
+
+//! Coroutine task
+/*!
+ * A lazily started coroutine which can be co_awaited by another coroutine or detached to run on its own. Awaiting
+ * a task starts it & resumes the awaiting coroutine once it finishes, with its value or rethrowing its exception.
+ * A detached task runs until its first suspension on the calling thread & frees itself once it finishes.
+ *
+ * Tasks resume wherever the operation they await completes, for IO that is the IO thread (& strand) which
+ * completed it, so a task on a session runs serialized with the session's own handlers.
+ *
+ * Not thread safe
+ */
+template<typename T = void>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) noexcept : _handle(handle) {}
+    Task(Task &&task) noexcept : _handle(std::exchange(task._handle, nullptr)) {}
+    ~Task() {
+        if (_handle)
+            _handle.destroy();
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    Task &operator=(Task &&task) noexcept {
+        if (this != &task) {
+            if (_handle)
+                _handle.destroy();
+
+            _handle = std::exchange(task._handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    //! Has the task finished
+    bool isDone() const noexcept { return !_handle || _handle.done(); }
+
+    //! Start the task without awaiting it, the task frees itself once it finishes
+    /*!
+     * Note: An exception escaping a detached task terminates
+     */
+    void detach() {
+        if (!_handle)
+            return;
+
+        auto handle = std::exchange(_handle, nullptr);
+        handle.promise()._detached = true;
+        handle.resume();
+    }
+
+    bool await_ready() const noexcept { return isDone(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        _handle.promise()._continuation = awaiting;
+        return _handle;
+    }
+
+    T await_resume() { return _handle.promise().result(); }
+
+private:
+    Handle _handle;
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept { return Task<T>(Task<T>::Handle::from_promise(*this)); }
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept { return Task<void>(Task<void>::Handle::from_promise(*this)); }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "core/io.hxx"
+#include "core/properties.hxx"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace CxxServer::Core::Tcp {
+
+//! Per remote address quotas
+/*!
+ * Tracks the # of connections & the receive rate of every remote address with connected sessions. Addresses are
+ * normalized to 16 bytes (IPv4 addresses are IPv4-mapped) & spread over a fixed set of independently locked shards
+ * so sessions on different IO threads rarely contend. Entries are dropped as soon as their last connection closes.
+ *
+ * Rates are enforced with token buckets, a session which overdraws its address' bucket is told how long to wait
+ * before it should read again.
+ *
+ * Thread safe
+ */
+class AddressTable : private noncopyable, private nonmovable {
+public:
+    //! Quotas applied to each remote address, 0 disables a quota
+    struct Limits {
+        //! Max # of concurrent connections
+        size_t max_connections = 0;
+        //! Received bytes per second
+        double bytes_rate = 0;
+        //! Max # of bytes which can be received at once (defaults to 1s worth of bytes_rate)
+        double bytes_burst = 0;
+        //! Received messages (reads) per second
+        double messages_rate = 0;
+        //! Max # of messages which can be received at once (defaults to 1s worth of messages_rate)
+        double messages_burst = 0;
+    };
+
+    AddressTable() = default;
+    ~AddressTable() = default;
+
+    //! Act as getter & setter for the address limits
+    /*!
+     * Note: Limits must not be changed while sessions are connected
+     */
+    Limits &limits() noexcept { return _limits; }
+
+    //! Is any quota enabled
+    bool enabled() const noexcept {
+        return _limits.max_connections > 0 || _limits.bytes_rate > 0 || _limits.messages_rate > 0;
+    }
+
+    //! Account for a new connection from an address
+    /*!
+     * \param addr - Remote address
+     * \return true iff the address is within its connection quota, the connection is then tracked until released
+     */
+    bool acquire(const asio::ip::address &addr);
+
+    //! Release a connection previously acquired
+    /*!
+     * \param addr - Remote address
+     */
+    void release(const asio::ip::address &addr);
+
+    //! Account for data received from an address
+    /*!
+     * \param addr - Remote address
+     * \param bytes - # of bytes received
+     * \return how long reading should be paused for the address to be back within its quota, 0 if it already is
+     */
+    std::chrono::nanoseconds consume(const asio::ip::address &addr, size_t bytes);
+
+    //! Get # of addresses being tracked
+    size_t size() const;
+
+private:
+    using Key = std::array<uint8_t, 16>;
+
+    struct KeyHash {
+        std::size_t operator()(const Key &key) const noexcept;
+    };
+
+    struct Entry {
+        size_t connections = 0;
+        double bytes = 0;
+        double messages = 0;
+        std::chrono::steady_clock::time_point refill;
+    };
+
+    // keep shards on separate cache lines so their locks don't false share
+    struct alignas(64) Shard {
+        mutable std::mutex lock;
+        std::unordered_map<Key, Entry, KeyHash> entries;
+    };
+
+    static constexpr size_t _num_shards = 32;
+
+    Limits _limits;
+    std::array<Shard, _num_shards> _shards;
+
+    //! Normalize an address to a table key
+    static Key key(const asio::ip::address &addr);
+
+    //! Get the shard owning a key
+    Shard &shard(const Key &key) noexcept { return _shards[KeyHash()(key) % _num_shards]; }
+};
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "core/task.hxx"
+#include "core/tcp/tcp_client.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace CxxServer::Core::Tcp {
+
+//! Coroutine operations for a session or client
+/*!
+ * Adds awaitable read, write & connect (connectAwait) to a Tcp / SSL session or client, so a multi step protocol can be written as
+ * one coroutine instead of a chain of callbacks:
+ *
+ *     Task<> run() {
+ *         uint8_t header[4];
+ *         while (co_await readExactly(header, sizeof(header)) == sizeof(header)) { ... }
+ *     }
+ *
+ * Received data is handed to a waiting read straight from the receive buffer & kept in an inbox otherwise, so
+ * nothing is lost between reads. Coroutines resume on the IO thread (& strand) which completed their operation,
+ * serialized with the rest of the session's handlers. Awaiting allocates nothing, the awaiters live in the
+ * coroutine frame & frames are recycled by Task.
+ *
+ * Note: Subclasses overriding onConnect, onDisconnect, onReceive or onEmpty must call the base implementation. Only
+ * one read & one write may be awaited at a time. The inbox isn't bounded, read what is received
+ *
+ * Thread safe
+ */
+template<typename Base>
+class Awaitable : public Base {
+public:
+    using Base::Base;
+    virtual ~Awaitable() = default;
+
+    //! Awaitable read
+    class ReadAwaiter {
+    public:
+        ReadAwaiter(Awaitable &stream, void *buffer, size_t size, bool exactly) noexcept : _stream(stream), _buffer(static_cast<uint8_t*>(buffer)), _size(size), _read(0), _exactly(exactly) {}
+
+        bool await_ready() const noexcept { return _size == 0; }
+        bool await_suspend(std::coroutine_handle<> handle) { return _stream.readSuspend(*this, handle); }
+        size_t await_resume() const noexcept { return _read; }
+
+    private:
+        friend class Awaitable;
+
+        Awaitable &_stream;
+        uint8_t *_buffer;
+        size_t _size;
+        size_t _read;
+        bool _exactly;
+        std::coroutine_handle<> _handle;
+
+        bool isDone() const noexcept { return _exactly ? _read == _size : _read > 0; }
+    };
+
+    //! Awaitable write
+    class WriteAwaiter {
+    public:
+        WriteAwaiter(Awaitable &stream, const void *buffer, size_t size) noexcept : _stream(stream), _buffer(buffer), _size(size), _sent(false) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) { return _stream.writeSuspend(*this, handle); }
+        bool await_resume() const noexcept { return _sent; }
+
+    private:
+        friend class Awaitable;
+
+        Awaitable &_stream;
+        const void *_buffer;
+        size_t _size;
+        bool _sent;
+        std::coroutine_handle<> _handle;
+    };
+
+    //! Awaitable connect
+    class ConnectAwaiter {
+    public:
+        explicit ConnectAwaiter(Awaitable &stream) noexcept : _stream(stream), _ready(false) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) { return _stream.connectSuspend(*this, handle); }
+        bool await_resume() const noexcept { return _ready; }
+
+    private:
+        friend class Awaitable;
+
+        Awaitable &_stream;
+        bool _ready;
+    };
+
+    //! Read whatever is available
+    /*!
+     * \param buffer - Buffer to read into
+     * \param size - Buffer size
+     * \return Awaitable producing the # of bytes read, 0 once disconnected
+     */
+    ReadAwaiter read(void *buffer, size_t size) noexcept { return ReadAwaiter(*this, buffer, size, false); }
+
+    //! Read until the buffer is full
+    /*!
+     * \param buffer - Buffer to read into
+     * \param size - Buffer size
+     * \return Awaitable producing the # of bytes read, less than size only once disconnected
+     */
+    ReadAwaiter readExactly(void *buffer, size_t size) noexcept { return ReadAwaiter(*this, buffer, size, true); }
+
+    //! Send data & wait until the send buffer drains
+    /*!
+     * Note: The buffer is copied before the coroutine suspends, waiting for the drain keeps a fast producer from
+     * queueing without bound
+     * \param buffer - Buffer to send
+     * \param size - Buffer size
+     * \return Awaitable producing true iff the data was queued & the send buffer drained
+     */
+    WriteAwaiter write(const void *buffer, size_t size) noexcept { return WriteAwaiter(*this, buffer, size); }
+
+    //! Connect a client & wait until it is ready (handshaked for SSL)
+    /*!
+     * Note: Named apart from the blocking connect
+     * \return Awaitable producing true iff the client is ready
+     */
+    ConnectAwaiter connectAwait() noexcept requires std::is_base_of_v<Client, Base> { return ConnectAwaiter(*this); }
+
+protected:
+    void onConnect() override {
+        {
+            std::scoped_lock locker(_await_lock);
+            _closed = false;
+            _inbox.clear();
+            _inbox_offset = 0;
+        }
+
+        Base::onConnect();
+    }
+
+    void onDisconnect() override {
+        ReadAwaiter *reader;
+        WriteAwaiter *writer;
+
+        {
+            std::scoped_lock locker(_await_lock);
+            _closed = true;
+            reader = std::exchange(_reader, nullptr);
+            writer = std::exchange(_writer, nullptr);
+        }
+
+        Base::onDisconnect();
+
+        if (reader != nullptr)
+            reader->_handle.resume();
+
+        if (writer != nullptr)
+            writer->_handle.resume();
+    }
+
+    void onReceive(const void *buffer, size_t size) override {
+        auto bytes = static_cast<const uint8_t*>(buffer);
+        ReadAwaiter *reader = nullptr;
+
+        {
+            std::scoped_lock locker(_await_lock);
+
+            // a waiting read takes what it wants straight from the receive buffer, only the rest is kept
+            if (_reader != nullptr) {
+                size_t length = std::min(size, _reader->_size - _reader->_read);
+                std::memcpy(_reader->_buffer + _reader->_read, bytes, length);
+                _reader->_read += length;
+                bytes += length;
+                size -= length;
+
+                if (_reader->isDone())
+                    reader = std::exchange(_reader, nullptr);
+            }
+
+            _inbox.insert(_inbox.end(), bytes, bytes + size);
+        }
+
+        if (reader != nullptr)
+            reader->_handle.resume();
+    }
+
+    void onEmpty() override {
+        WriteAwaiter *writer;
+
+        {
+            std::scoped_lock locker(_await_lock);
+            ++_drains;
+            writer = std::exchange(_writer, nullptr);
+        }
+
+        Base::onEmpty();
+
+        if (writer != nullptr) {
+            writer->_sent = true;
+            writer->_handle.resume();
+        }
+    }
+
+private:
+    std::mutex _await_lock;
+    bool _closed = false;
+    std::vector<uint8_t> _inbox;
+    size_t _inbox_offset = 0;
+    ReadAwaiter *_reader = nullptr;
+    WriteAwaiter *_writer = nullptr;
+    uint64_t _drains = 0;
+
+    //! Fill a read from the inbox & suspend it if it wants more
+    /*!
+     * \return true iff the coroutine was suspended
+     */
+    bool readSuspend(ReadAwaiter &reader, std::coroutine_handle<> handle) {
+        std::scoped_lock locker(_await_lock);
+
+        size_t length = std::min(_inbox.size() - _inbox_offset, reader._size - reader._read);
+        if (length > 0) {
+            std::memcpy(reader._buffer + reader._read, _inbox.data() + _inbox_offset, length);
+            reader._read += length;
+            _inbox_offset += length;
+        }
+
+        if (_inbox_offset == _inbox.size()) {
+            _inbox.clear();
+            _inbox_offset = 0;
+        }
+
+        if (reader.isDone() || _closed)
+            return false;
+
+        assert((_reader == nullptr) && "Only one read may be awaited at a time");
+        reader._handle = handle;
+        _reader = &reader;
+        return true;
+    }
+
+    //! Queue a write & suspend until the send buffer drains
+    /*!
+     * \return true iff the coroutine was suspended
+     */
+    bool writeSuspend(WriteAwaiter &writer, std::coroutine_handle<> handle) {
+        uint64_t drains;
+        {
+            std::scoped_lock locker(_await_lock);
+            if (_closed)
+                return false;
+
+            drains = _drains;
+        }
+
+        // queued before the awaiter is registered, so a drain can't resume the coroutine while the buffer is in use
+        bool queued = this->sendAsync(writer._buffer, writer._size);
+
+        std::scoped_lock locker(_await_lock);
+        if (!queued || _closed)
+            return false;
+
+        // drained while queueing, the data may already be written
+        if (_drains != drains) {
+            writer._sent = true;
+            return false;
+        }
+
+        assert((_writer == nullptr) && "Only one write may be awaited at a time");
+        writer._handle = handle;
+        _writer = &writer;
+        return true;
+    }
+
+    //! Connect & suspend until the client is ready
+    /*!
+     * \return true iff the coroutine was suspended
+     */
+    bool connectSuspend(ConnectAwaiter &connector, std::coroutine_handle<> handle) {
+        auto ready_handler = [&connector, handle](bool ready) {
+            connector._ready = ready;
+            handle.resume();
+        };
+
+        if (this->connectNotify(ready_handler))
+            return true;
+
+        connector._ready = true;
+        return false;
+    }
+};
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "core/properties.hxx"
+#include "core/service.hxx"
+#include "core/tcp/tcp_client.hxx"
+
+#include "core/io.hxx"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CxxServer::Core::Tcp {
+
+//! Client balancing requests across replicated endpoints
+/*!
+ * Holds a connected client per endpoint & picks one per request. Requests are bracketed with acquire & release
+ * so the group knows how many are outstanding on each client & which fail.
+ *
+ * An endpoint is ejected once its client stops being ready or fails failure_threshold requests in a row, ejected
+ * endpoints aren't picked & are reconnected after eject_time, an endpoint is restored once it connects again.
+ *
+ * Thread safe
+ */
+class ClientGroup : public std::enable_shared_from_this<ClientGroup>, private noncopyable, private nonmovable {
+public:
+    //! How a client is picked
+    enum class Balance : uint8_t {
+        //! Each endpoint in turn
+        RoundRobin,
+        //! The endpoint with the fewest outstanding requests
+        LeastOutstanding,
+        //! The endpoint a key hashes to, keys only move when their endpoint is ejected or restored
+        ConsistentHash
+    };
+
+    //! Endpoint of a replica
+    struct Endpoint {
+        //! Address to connect to
+        std::string addr;
+        //! Port to connect on
+        unsigned int port = 0;
+    };
+
+    //! Health check settings
+    struct Health {
+        //! # of failed requests in a row which eject an endpoint (0 to only eject disconnected endpoints)
+        size_t failure_threshold = 3;
+        //! Time an endpoint stays ejected before it is reconnected
+        std::chrono::nanoseconds eject_time = std::chrono::seconds(5);
+        //! Interval endpoints are checked at
+        std::chrono::nanoseconds check_interval = std::chrono::milliseconds(500);
+    };
+
+    //! Creates the client of an endpoint, unconnected
+    using Factory = std::function<std::shared_ptr<Client>(const Endpoint &endpoint)>;
+
+    //! Initialize group
+    /*!
+     * \param service - IO service used for health checks
+     * \param endpoints - Endpoints to balance across
+     * \param factory - Client factory
+     * \param balance - How clients are picked
+     */
+    ClientGroup(const std::shared_ptr<Service> &service, const std::vector<Endpoint> &endpoints, const Factory &factory, Balance balance = Balance::RoundRobin);
+    virtual ~ClientGroup() = default;
+
+    //! Get how clients are picked
+    Balance balance() const noexcept { return _balance; }
+
+    //! Act as getter & setter for the health check settings
+    /*!
+     * Note: Set before the group is started
+     */
+    Health &health() noexcept { return _health; }
+
+    //! Is the group started
+    bool isStarted() const noexcept { return _started; }
+
+    //! Connect every endpoint & start health checks
+    /*!
+     * \return true iff the group was started
+     */
+    bool start();
+
+    //! Stop health checks & disconnect every endpoint
+    /*!
+     * \return true iff the group was stopped
+     */
+    bool stop();
+
+    //! Pick a client for a request
+    /*!
+     * Note: Pair with release once the request finishes
+     * \return Ready client, null if every endpoint is ejected
+     */
+    std::shared_ptr<Client> acquire();
+
+    //! Pick the client a key maps to for a request
+    /*!
+     * Note: Only consistent hashing uses the key, pair with release once the request finishes
+     * \param key - Request key
+     * \return Ready client, null if every endpoint is ejected
+     */
+    std::shared_ptr<Client> acquire(std::string_view key);
+
+    //! Pick a client other than the given one for a request, e.g. to retry or duplicate a request elsewhere
+    /*!
+     * Note: Pair with release once the request finishes
+     * \param client - Client to avoid
+     * \return Ready client, null if no other endpoint is usable
+     */
+    std::shared_ptr<Client> acquireOther(const std::shared_ptr<Client> &client);
+
+    //! Finish a request
+    /*!
+     * \param client - Client the request was sent on
+     * \param success - Did the request succeed
+     */
+    void release(const std::shared_ptr<Client> &client, bool success = true);
+
+    //! Get the clients of every endpoint, in endpoint order
+    std::vector<std::shared_ptr<Client>> clients();
+
+    //! Get # of endpoints which aren't ejected
+    size_t numHealthy();
+
+    //! Get # of outstanding requests on a client
+    size_t numOutstanding(const std::shared_ptr<Client> &client);
+
+    //! Get # of ejections
+    uint64_t numEjected() const noexcept { return _ejected; }
+
+protected:
+    //! Callback when an endpoint is ejected
+    /*!
+     * \param client - Client of the endpoint
+     */
+    virtual void onEject(const std::shared_ptr<Client> &client) {}
+
+    //! Callback when an ejected endpoint is restored
+    /*!
+     * \param client - Client of the endpoint
+     */
+    virtual void onRestore(const std::shared_ptr<Client> &client) {}
+
+private:
+    struct Member {
+        Endpoint endpoint;
+        std::shared_ptr<Client> client;
+        size_t outstanding = 0;
+        size_t failures = 0;
+        bool healthy = false;
+        bool ejected = false;
+        bool connecting = false;
+        std::chrono::steady_clock::time_point ejected_until;
+    };
+
+    // # of points each endpoint has on the hash ring, more spreads keys more evenly
+    static constexpr size_t ring_points = 64;
+
+    std::shared_ptr<Service> _service;
+    std::shared_ptr<asio::io_service> _io;
+    Balance _balance;
+    Health _health;
+
+    std::atomic<bool> _started;
+    std::mutex _lock;
+    std::vector<Member> _members;
+    std::map<size_t, size_t> _ring;
+    size_t _cursor;
+    asio::system_timer _timer;
+
+    std::atomic<uint64_t> _ejected;
+
+    //! Pick a healthy member & count the request on it, called under the lock
+    /*!
+     * \param key - Request key, used by consistent hashing
+     * \param excluded - Index of a member not to pick, the # of members to pick any
+     * \return Index of the member, the # of members if none is healthy
+     */
+    size_t pick(std::string_view key, size_t excluded);
+
+    //! Find the member of a client, called under the lock
+    /*!
+     * \return Index of the member, the # of members if the client isn't in the group
+     */
+    size_t find(const std::shared_ptr<Client> &client) const;
+
+    //! Eject a member, called under the lock
+    /*!
+     * \return true iff the member was healthy
+     */
+    bool eject(Member &member);
+
+    //! Connect a member's client, restoring the member once it is ready
+    void connect(size_t index);
+
+    //! Eject disconnected members & reconnect members past their eject time
+    void check();
+
+    //! Schedule the next health check
+    void schedule();
+};
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "core/properties.hxx"
+#include "core/service.hxx"
+#include "core/tcp/tcp_client.hxx"
+
+#include "core/io.hxx"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <tuple>
+
+namespace CxxServer::Core::Tcp {
+
+//! Upstream connection pool
+/*!
+ * Keeps connected clients per upstream so requests reuse warm connections, including established TLS sessions,
+ * instead of reconnecting. Clients are checked out, used exclusively & returned, a returned client which is still
+ * ready is handed to the next waiter or kept idle.
+ *
+ * Idle clients are checked for liveness before they are handed out & periodically, idle clients past the idle
+ * timeout are closed as long as the upstream keeps its minimum, upstreams below their minimum are topped up.
+ *
+ * Thread safe
+ */
+class ClientPool : public std::enable_shared_from_this<ClientPool>, private noncopyable, private nonmovable {
+public:
+    //! Upstream a client connects to
+    struct Key {
+        //! Address to connect to
+        std::string addr;
+        //! Port to connect on
+        unsigned int port = 0;
+        //! Server name used with SNI, empty for plain TCP
+        std::string server_name;
+
+        bool operator<(const Key &other) const noexcept {
+            return std::tie(addr, port, server_name) < std::tie(other.addr, other.port, other.server_name);
+        }
+    };
+
+    //! Pool sizes & timeouts, applied to each upstream
+    struct Limits {
+        //! # of connections kept open even when idle
+        size_t min_connections = 0;
+        //! Max # of connections, checkouts wait for a returned client past this (0 for unlimited)
+        size_t max_connections = 0;
+        //! Idle time after which a connection above the minimum is closed
+        std::chrono::nanoseconds idle_timeout = std::chrono::seconds(60);
+        //! Interval idle connections are checked, evicted & topped up at
+        std::chrono::nanoseconds check_interval = std::chrono::seconds(1);
+    };
+
+    //! Creates an unconnected client for an upstream, e.g. a Tcp::Client or an SSL::Client with its server name set
+    using Factory = std::function<std::shared_ptr<Client>(const Key &key)>;
+
+    //! Checkout completion handler
+    /*!
+     * \param client - Ready client, null if no connection could be made
+     * \param err - Error if no connection could be made
+     */
+    using CheckoutHandler = std::function<void(std::shared_ptr<Client> client, std::error_code err)>;
+
+    //! Initialize pool
+    /*!
+     * \param service - IO service used for maintenance
+     * \param factory - Client factory
+     */
+    ClientPool(const std::shared_ptr<Service> &service, const Factory &factory);
+    virtual ~ClientPool() = default;
+
+    //! Act as getter & setter for the pool limits
+    /*!
+     * Note: Limits must be set before the pool is started
+     */
+    Limits &limits() noexcept { return _limits; }
+
+    //! Is the pool started
+    bool isStarted() const noexcept { return _started; }
+
+    //! Start periodic maintenance
+    /*!
+     * \return true iff the pool was started
+     */
+    bool start();
+
+    //! Stop the pool, closing idle clients & failing waiting checkouts
+    /*!
+     * Note: Clients checked out are closed when they are returned
+     * \return true iff the pool was stopped
+     */
+    bool stop();
+
+    //! Open the minimum # of connections to an upstream ahead of its first checkout
+    /*!
+     * \param key - Upstream
+     */
+    void reserve(const Key &key);
+
+    //! Checkout a ready client
+    /*!
+     * Hands out an idle client if one is alive, otherwise connects a new one if the upstream is below its max or
+     * waits for a client to be returned. The handler may be called before this returns.
+     * \param key - Upstream
+     * \param handler - Completion handler
+     * \return false iff the pool isn't started
+     */
+    bool checkout(const Key &key, CheckoutHandler handler);
+
+    //! Return a checked out client
+    /*!
+     * Note: A client which isn't ready anymore is dropped
+     * \param key - Upstream the client was checked out for
+     * \param client - Client to return
+     */
+    void release(const Key &key, const std::shared_ptr<Client> &client);
+
+    //! Get # of open connections (idle, checked out & connecting)
+    size_t numConnections();
+
+    //! Get # of idle connections
+    size_t numIdle();
+
+    //! Get # of connections made
+    uint64_t numCreated() const noexcept { return _created; }
+
+    //! Get # of checkouts served by an idle connection
+    uint64_t numReused() const noexcept { return _reused; }
+
+    //! Get # of idle connections closed as dead or idle for too long
+    uint64_t numEvicted() const noexcept { return _evicted; }
+
+private:
+    struct Idle {
+        std::shared_ptr<Client> client;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    struct Upstream {
+        std::deque<Idle> idle;
+        std::deque<CheckoutHandler> waiters;
+        size_t connections = 0;
+    };
+
+    std::shared_ptr<Service> _service;
+    std::shared_ptr<asio::io_service> _io;
+    Factory _factory;
+    Limits _limits;
+
+    std::atomic<bool> _started;
+    std::mutex _lock;
+    std::map<Key, Upstream> _upstreams;
+    asio::system_timer _timer;
+
+    std::atomic<uint64_t> _created;
+    std::atomic<uint64_t> _reused;
+    std::atomic<uint64_t> _evicted;
+
+    //! Connect a new client to an upstream, the connection must already be counted
+    /*!
+     * \param key - Upstream
+     * \param handler - Completion handler, null to keep the client idle once ready
+     */
+    void connect(const Key &key, CheckoutHandler handler);
+
+    //! Hand a ready client to a waiter or keep it idle
+    /*!
+     * \param key - Upstream
+     * \param client - Ready client
+     */
+    void recycle(const Key &key, const std::shared_ptr<Client> &client);
+
+    //! Drop a connection which closed or failed, a waiter gets a new connection in its place
+    /*!
+     * \param key - Upstream
+     */
+    void drop(const Key &key);
+
+    //! Is an idle client still usable
+    static bool isAlive(const std::shared_ptr<Client> &client);
+
+    //! Evict dead & expired idle connections & top up upstreams below their minimum
+    void maintain();
+
+    //! Schedule the next maintenance
+    void schedule();
+};
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "core/properties.hxx"
+
+#include "core/io.hxx"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace CxxServer::Core::Tcp {
+
+//! In process cache of resolved host names
+/*!
+ * Holds the endpoints a host & service resolved to so repeated connects don't resolve again. getaddrinfo doesn't
+ * report record TTLs so entries expire after a fixed TTL, failed resolutions aren't cached.
+ *
+ * Thread safe
+ */
+class DnsCache : private noncopyable, private nonmovable {
+public:
+    using Endpoints = std::vector<asio::ip::tcp::endpoint>;
+
+    //! Initialize cache
+    /*!
+     * \param ttl - Time entries are kept for
+     */
+    explicit DnsCache(const std::chrono::nanoseconds &ttl = std::chrono::seconds(30));
+    virtual ~DnsCache() = default;
+
+    //! Get the cache shared by clients which aren't given their own
+    static const std::shared_ptr<DnsCache> &global();
+
+    //! Act as getter & setter for the TTL of new entries
+    std::chrono::nanoseconds &ttl() noexcept { return _ttl; }
+
+    //! Find the endpoints a host & service resolved to
+    /*!
+     * \param host - Host name
+     * \param service - Service name or port #
+     * \param endpoints - Cached endpoints
+     * \return true iff a live entry was found
+     */
+    bool lookup(const std::string &host, const std::string &service, Endpoints &endpoints);
+
+    //! Cache the endpoints a host & service resolved to
+    /*!
+     * \param host - Host name
+     * \param service - Service name or port #
+     * \param endpoints - Resolved endpoints
+     */
+    void store(const std::string &host, const std::string &service, const Endpoints &endpoints);
+
+    //! Remove an entry, e.g. once none of its endpoints can be connected to
+    /*!
+     * \param host - Host name
+     * \param service - Service name or port #
+     */
+    void erase(const std::string &host, const std::string &service);
+
+    //! Remove all entries
+    void clear();
+
+    //! Get # of entries, including expired entries not yet removed
+    size_t size();
+
+    //! Get # of lookups answered from the cache
+    uint64_t numHits() const noexcept { return _hits; }
+
+    //! Get # of lookups which had to resolve
+    uint64_t numMisses() const noexcept { return _misses; }
+
+private:
+    struct Entry {
+        Endpoints endpoints;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    std::chrono::nanoseconds _ttl;
+    std::mutex _lock;
+    std::map<std::pair<std::string, std::string>, Entry> _entries;
+
+    std::atomic<uint64_t> _hits;
+    std::atomic<uint64_t> _misses;
+};
+}
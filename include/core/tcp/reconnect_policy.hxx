@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace CxxServer::Core::Tcp {
+    //! When & how often a client reconnects on its own
+    /*!
+     * Attempt n is delayed by min(initial_delay * multiplier^n, max_delay), less a random part of up to jitter of
+     * it so clients dropped together don't reconnect together. The attempt count resets once a connect succeeds.
+     */
+    struct ReconnectPolicy {
+        //! Reconnect after an async connect fails
+        bool on_connect_failure = false;
+        //! Reconnect after the connection is lost, disconnects asked for never reconnect
+        bool on_disconnect = false;
+        //! Delay before the first attempt
+        std::chrono::nanoseconds initial_delay = std::chrono::milliseconds(100);
+        //! Cap on the delay between attempts
+        std::chrono::nanoseconds max_delay = std::chrono::seconds(30);
+        //! Growth of the delay per attempt
+        double multiplier = 2.0;
+        //! Fraction of the delay randomized away (0 - 1)
+        double jitter = 0.5;
+        //! Max # of attempts in a row before giving up (0 for unlimited)
+        size_t max_attempts = 0;
+        //! Max # of bytes of async sends buffered while reconnecting & sent once connected (0 to not buffer)
+        size_t buffer_limit = 0;
+
+        //! Does the policy reconnect at all
+        bool enabled() const noexcept { return on_connect_failure || on_disconnect; }
+    };
+}
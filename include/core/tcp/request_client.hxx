@@ -0,0 +1,181 @@
+#pragma once
+
+#include "core/service.hxx"
+#include "core/tcp/tcp_client.hxx"
+
+#include "core/io.hxx"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace CxxServer::Core::Tcp {
+
+//! Pipelined request / response client
+/*!
+ * Sends requests without waiting for earlier responses & matches each response to its request, either by the
+ * request Id echoed in the response or by order when the server answers in order.
+ *
+ * Requests are framed by encodeRequest & responses by decodeResponse, by default a frame is a 4 byte little endian
+ * length of the rest of the frame, an 8 byte little endian request Id & the payload. Override both for other
+ * protocols.
+ *
+ * Each request can have a deadline, all deadlines share one timer armed for the earliest. A request completes
+ * exactly once: with its response, timed out, cancelled or aborted by a disconnect. Responses to requests which
+ * already completed are dropped.
+ *
+ * Note: Subclasses overriding onReceive or onDisconnect must call the base implementation
+ *
+ * Thread safe
+ */
+class RequestClient : public Client {
+public:
+    //! How responses are matched to requests
+    enum class Correlation : uint8_t {
+        //! By the request Id carried in the response
+        Id,
+        //! By order, the server answers requests in the order sent
+        Fifo
+    };
+
+    //! Response handler
+    /*!
+     * \param err - Error if the request didn't complete with a response: timed_out past its deadline, operation_aborted
+     *              if cancelled, connection_aborted if the client disconnected first
+     * \param response - Response payload
+     * \param size - Response payload size
+     */
+    using ResponseHandler = std::function<void(std::error_code err, const void *response, size_t size)>;
+
+    //! Initialize client with given IO service, address & port
+    /*!
+     * \param service - IO service
+     * \param addr - Address to connect to
+     * \param port - Port to connect on
+     * \param correlation - How responses are matched to requests
+     */
+    RequestClient(const std::shared_ptr<Service> &service, const std::string &addr, unsigned int port, Correlation correlation = Correlation::Id);
+    virtual ~RequestClient() = default;
+
+    //! Get how responses are matched to requests
+    Correlation correlation() const noexcept { return _correlation; }
+
+    //! Send a request
+    /*!
+     * \param request - Request payload
+     * \param size - Request payload size
+     * \param handler - Called once the request completes
+     * \param timeout - Time to wait for the response (0 to wait until disconnected)
+     * \return Id of the request, 0 if it couldn't be sent (the handler isn't called)
+     */
+    uint64_t request(const void *request, size_t size, const ResponseHandler &handler, std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0));
+
+    //! Send a request & get its response as a future
+    /*!
+     * Note: The future holds a std::system_error if the request doesn't complete with a response, with the handler's
+     *       error or not_connected if the request couldn't be sent
+     * \param request - Request payload
+     * \param size - Request payload size
+     * \param timeout - Time to wait for the response (0 to wait until disconnected)
+     * \return Future response payload
+     */
+    std::future<std::vector<uint8_t>> request(const void *request, size_t size, std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0));
+
+    //! Cancel a request, its handler is called with operation_aborted
+    /*!
+     * \param id - Id of the request
+     * \return true iff the request was still pending
+     */
+    bool cancel(uint64_t id);
+
+    //! Get # of requests waiting for a response
+    size_t numPending();
+
+    //! Get # of requests completed with a response
+    uint64_t numCompleted() const noexcept { return _completed; }
+
+    //! Get # of requests which timed out
+    uint64_t numTimedOut() const noexcept { return _timed_out; }
+
+    //! Get # of requests cancelled
+    uint64_t numCancelled() const noexcept { return _cancelled; }
+
+protected:
+    void onReceive(const void *buffer, size_t size) override;
+    void onDisconnect() override;
+
+    //! Frame a request
+    /*!
+     * \param id - Request Id
+     * \param request - Request payload
+     * \param size - Request payload size
+     * \param frame - Frame to append to
+     */
+    virtual void encodeRequest(uint64_t id, const void *request, size_t size, std::vector<uint8_t> &frame);
+
+    //! Decode the response at the start of the received data
+    /*!
+     * \param buffer - Received data
+     * \param size - Received data size
+     * \param id - Request Id of the response, unused when correlating by order
+     * \param offset - Offset of the payload in the frame
+     * \param length - Size of the payload
+     * \return Size of the whole frame, 0 if the frame isn't complete yet
+     */
+    virtual size_t decodeResponse(const void *buffer, size_t size, uint64_t &id, size_t &offset, size_t &length);
+
+private:
+    struct Pending {
+        ResponseHandler handler;
+        std::chrono::system_clock::time_point deadline;
+    };
+
+    Correlation _correlation;
+
+    std::mutex _requests_lock;
+    uint64_t _next_id;
+    std::unordered_map<uint64_t, Pending> _pending;
+    // Ids in the order sent, completed requests stay until their response arrives when correlating by order
+    std::deque<uint64_t> _order;
+    std::multimap<std::chrono::system_clock::time_point, uint64_t> _deadlines;
+    asio::system_timer _deadline_timer;
+    std::chrono::system_clock::time_point _deadline_armed;
+
+    std::vector<uint8_t> _response_buff;
+    std::vector<uint8_t> _frame;
+
+    std::atomic<uint64_t> _completed;
+    std::atomic<uint64_t> _timed_out;
+    std::atomic<uint64_t> _cancelled;
+
+    //! Complete requests from the responses in the received data
+    /*!
+     * \return # of bytes consumed
+     */
+    size_t dispatch(const uint8_t *buffer, size_t size);
+
+    //! Take a pending request out, called under the lock
+    /*!
+     * \param id - Id of the request
+     * \param pending - Request taken
+     * \return true iff the request was pending
+     */
+    bool take(uint64_t id, Pending &pending);
+
+    //! Arm the deadline timer for the earliest deadline if it isn't armed earlier, called under the lock
+    void armDeadline();
+
+    //! Time out requests past their deadline
+    void expire();
+};
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "core/properties.hxx"
+#include "core/service.hxx"
+#include "core/tcp/client_group.hxx"
+#include "core/tcp/request_client.hxx"
+
+#include "core/io.hxx"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+namespace CxxServer::Core::Tcp {
+
+//! Sends requests to replicated endpoints, duplicating the slow ones
+/*!
+ * Each request goes to a client acquired from a group of request clients. If no response arrives within the hedge
+ * delay, a duplicate is sent to a second client & whichever response arrives first completes the request, the
+ * other is dropped once it arrives. The hedge delay is a percentile of recent response latencies, so only about
+ * the slowest (1 - percentile) of requests are duplicated.
+ *
+ * Hedging is bounded by a budget: each request earns max_hedge_ratio of a hedge & each hedge spends one, so the
+ * extra load stays bounded when every endpoint slows down at once.
+ *
+ * Note: Only hedge idempotent requests, a hedged request may be handled by both endpoints. Clients should be no delay,
+ * otherwise a request sent behind a late response can wait on a delayed ack & inflate the hedge rate
+ *
+ * Thread safe
+ */
+class RequestHedger : public std::enable_shared_from_this<RequestHedger>, private noncopyable, private nonmovable {
+public:
+    //! Hedging settings
+    struct Settings {
+        //! Percentile of recent response latencies a request waits for before it is hedged (0 - 1)
+        double percentile = 0.95;
+        //! Floor on the hedge delay
+        std::chrono::nanoseconds min_delay = std::chrono::milliseconds(1);
+        //! # of recent latencies percentiles are taken over
+        size_t window = 1024;
+        //! # of latencies needed before requests are hedged
+        size_t warmup = 32;
+        //! Fraction of a hedge each request earns (0 - 1)
+        double max_hedge_ratio = 0.1;
+        //! Max # of hedges banked for bursts of slow requests
+        double hedge_burst = 10.0;
+    };
+
+    //! Initialize hedger
+    /*!
+     * \param service - IO service used for hedge timers
+     * \param group - Group of request clients to send to
+     */
+    RequestHedger(const std::shared_ptr<Service> &service, const std::shared_ptr<ClientGroup> &group);
+    virtual ~RequestHedger() = default;
+
+    //! Get the group requests are sent to
+    std::shared_ptr<ClientGroup> &group() noexcept { return _group; }
+
+    //! Act as getter & setter for the hedging settings
+    /*!
+     * Note: Set before the first request
+     */
+    Settings &settings() noexcept { return _settings; }
+
+    //! Send a request
+    /*!
+     * \param request - Request payload
+     * \param size - Request payload size
+     * \param handler - Called once with the first response, or the last error if no attempt gets a response
+     * \param timeout - Time to wait for the response (0 to wait until disconnected)
+     * \return true iff the request was sent (otherwise the handler isn't called)
+     */
+    bool request(const void *request, size_t size, const RequestClient::ResponseHandler &handler, std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0));
+
+    //! Get the current hedge delay, 0 while warming up
+    std::chrono::nanoseconds hedgeDelay();
+
+    //! Get a percentile of response latencies as seen by callers, hedges included
+    /*!
+     * \param percentile - Percentile (0 - 1)
+     */
+    std::chrono::nanoseconds latency(double percentile);
+
+    //! Get a percentile of response latencies of the first attempts alone, what callers would see without hedging
+    /*!
+     * \param percentile - Percentile (0 - 1)
+     */
+    std::chrono::nanoseconds primaryLatency(double percentile);
+
+    //! Get # of requests sent
+    uint64_t numRequests() const noexcept { return _requests; }
+
+    //! Get # of requests hedged
+    uint64_t numHedged() const noexcept { return _hedged; }
+
+    //! Get # of hedged requests completed by the hedge
+    uint64_t numHedgeWins() const noexcept { return _hedge_wins; }
+
+    //! Get fraction of requests hedged
+    double hedgeRate() const noexcept { return _requests == 0 ? 0.0 : static_cast<double>(_hedged) / static_cast<double>(_requests); }
+
+private:
+    struct Flight {
+        RequestClient::ResponseHandler handler;
+        // copy of the request, only kept while it may be hedged
+        std::vector<uint8_t> request;
+        std::chrono::nanoseconds timeout;
+        std::chrono::steady_clock::time_point start;
+        std::shared_ptr<Client> primary;
+        std::error_code err;
+        size_t outstanding = 0;
+        bool hedged = false;
+        bool done = false;
+    };
+
+    // Ring of recent latencies in ns
+    struct Window {
+        std::vector<int64_t> samples;
+        size_t next = 0;
+    };
+
+    std::shared_ptr<Service> _service;
+    std::shared_ptr<asio::io_service> _io;
+    std::shared_ptr<ClientGroup> _group;
+    Settings _settings;
+
+    std::mutex _lock;
+    Window _primary;
+    Window _observed;
+    std::chrono::nanoseconds _delay;
+    size_t _delay_age;
+    double _tokens;
+    std::multimap<std::chrono::system_clock::time_point, std::shared_ptr<Flight>> _hedges;
+    asio::system_timer _timer;
+    std::chrono::system_clock::time_point _timer_armed;
+
+    std::atomic<uint64_t> _requests;
+    std::atomic<uint64_t> _hedged;
+    std::atomic<uint64_t> _hedge_wins;
+
+    //! Send an attempt of a flight
+    /*!
+     * \return true iff the attempt was sent
+     */
+    bool send(const std::shared_ptr<Flight> &flight, const std::shared_ptr<Client> &client, bool hedge, const void *request, size_t size, std::chrono::nanoseconds timeout);
+
+    //! Handle the completion of an attempt
+    void complete(const std::shared_ptr<Flight> &flight, bool hedge, std::error_code err, const void *response, size_t size);
+
+    //! Record a latency, called under the lock
+    void record(Window &window, std::chrono::nanoseconds latency);
+
+    //! Get a percentile of a window, called under the lock
+    static std::chrono::nanoseconds percentileOf(const Window &window, double percentile);
+
+    //! Arm the timer for the earliest hedge if it isn't armed earlier, called under the lock
+    void arm();
+
+    //! Hedge flights past their hedge delay
+    void hedge();
+};
+}
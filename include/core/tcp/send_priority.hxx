@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CxxServer::Core::Tcp {
+    //! Priority of data queued for an async send
+    /*!
+     * High priority data is written before any normal priority data still queued, it can only overtake normal
+     * priority data at the boundary of a normal priority message so messages are never interleaved
+     */
+    enum class SendPriority : uint8_t {
+        //! Latency critical messages e.g. heartbeats & acks
+        High,
+        //! Everything else
+        Normal
+    };
+
+    //! # of normal priority bytes written between checks for queued high priority data
+    /*!
+     * Normal priority data is written in batches of whole messages, a batch ends at the first message boundary
+     * past this many bytes
+     */
+    constexpr size_t send_priority_quantum = 64 * 1024;
+}
@@ -7,6 +7,7 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
 #include <system_error>
 
 namespace CxxServer::Core::SSL {
@@ -51,6 +52,9 @@ namespace CxxServer::Core::SSL {
 
         bool hasHandshaked() const noexcept { return _handshaked; }
 
+        //! Act as getter & setter for the server name sent with SNI in the handshake (defaults to none)
+        std::string &serverName() noexcept { return _server_name; }
+
         //! Connect to endpoint
         /*! Note this will not start receiving data until receive(Async) is called
          * \return true iff connection is successful
@@ -94,6 +98,7 @@ namespace CxxServer::Core::SSL {
 
         const std::shared_ptr<Context> _context;
         asio::ssl::stream<asio::ip::tcp::socket> _stream;
+        std::string _server_name;
         HandlerMemory<> _connecting_storage;
 
         //! Async write some to IO
@@ -105,6 +110,9 @@ namespace CxxServer::Core::SSL {
         //! Async connect to an endpoint
         void connectEndpoint(const std::shared_ptr<Tcp::Client> &self, std::error_code err, const asio::ip::tcp::endpoint &endpoint);
 
+        //! Set the SNI server name on the stream before a handshake
+        void setServerName();
+
         //! Handle errors
         void err(std::error_code) override;
 
@@ -7,8 +7,10 @@
 #include "core/tcp/ssl_server.hxx"
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <system_error>
+#include <vector>
 
 namespace CxxServer::Core::SSL {
     class Server;
@@ -29,6 +31,9 @@ namespace CxxServer::Core::SSL {
         //! Get if the handshake has completed
         bool isHandshaked() const noexcept { return _handshaked; }
 
+        //! Receiving to a file isn't supported, the socket only carries encrypted records
+        bool receiveToFile(int fd, uint64_t budget, FileReceiveHandler handler) override { return false; }
+
     protected:
         using Tcp::Session::onConnect;
         using Tcp::Session::onDisconnect;
@@ -42,10 +47,15 @@ namespace CxxServer::Core::SSL {
     private:
         std::atomic<bool> _handshaked;
         asio::ssl::stream<asio::ip::tcp::socket> _stream;
+        // file regions are read here to be encrypted
+        std::vector<uint8_t> _file_buff;
 
         //! Async write some to IO
         virtual void asyncWriteSome(const void *buffer, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler) override;
 
+        //! Async write some of a file region to IO, read through a buffer as the socket carries encrypted records
+        virtual void asyncSendFile(int fd, uint64_t offset, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler) override;
+
         //! Async read some from IO to buffer
         virtual void asyncReadSome(void *buffer, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler) override;
 
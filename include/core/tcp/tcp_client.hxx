@@ -3,6 +3,9 @@
 #include "core/memory.hxx"
 #include "core/properties.hxx"
 #include "core/service.hxx"
+#include "core/tcp/dns_cache.hxx"
+#include "core/tcp/reconnect_policy.hxx"
+#include "core/tcp/send_priority.hxx"
 #include "core/uuid.hxx"
 
 #include "core/io.hxx"
@@ -11,6 +14,7 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -22,6 +26,14 @@ namespace CxxServer::Core::SSL {
 }
 
 namespace CxxServer::Core::Tcp {
+class ClientGroup;
+class ClientPool;
+class ProxySession;
+class RequestClient;
+
+template<typename Base>
+class Awaitable;
+
 //! TCP Client
 /*!
  * TCP client used to read / write from connected server
@@ -31,6 +43,13 @@ namespace CxxServer::Core::Tcp {
 class Client : public std::enable_shared_from_this<Client>, private noncopyable, private nonmovable {
 public:
     friend class SSL::Client;
+    friend class ClientGroup;
+    friend class ClientPool;
+    friend class ProxySession;
+    friend class RequestClient;
+
+    template<typename Base>
+    friend class Awaitable;
 
     //! Initialize client with given IO service, address & port
     /*!
@@ -83,6 +102,24 @@ public:
     //! Get client port
     unsigned int port() const noexcept { return _port; }
 
+    //! Act as getter & setter for the cache host names are resolved through (null to always resolve)
+    std::shared_ptr<DnsCache> &dnsCache() noexcept { return _dns_cache; }
+
+    //! Act as getter & setter for the delay before an async connect also tries the next resolved address (0 to try all at once)
+    std::chrono::nanoseconds &connectAttemptDelay() noexcept { return _connect_attempt_delay; }
+
+    //! Act as getter & setter for when the client reconnects on its own
+    /*!
+     * Note: Set before connecting
+     */
+    ReconnectPolicy &reconnectPolicy() noexcept { return _reconnect_policy; }
+
+    //! Is a reconnect scheduled or in progress
+    bool isReconnecting() const noexcept { return _reconnecting; }
+
+    //! Get # of reconnect attempts made since the last successful connect
+    size_t numReconnectAttempts() const noexcept { return _reconnect_attempts; }
+
     //! Get number of bytes remaining
     size_t numBytesPending() const noexcept { return _bytes_pending; }
 
@@ -155,7 +192,8 @@ public:
 
     //! Reconnect to endpoint async
     /*!
-     * \return true iff reconnect is successful
+     * Connects again once the disconnect finishes
+     * \return true iff the reconnect was started
      */
     virtual bool reconnectAsync();
 
@@ -182,7 +220,7 @@ public:
      * \param size - Buffer size
      * \return number of bytes sent
      */
-    virtual bool sendAsync(const void *buffer, size_t size);
+    virtual bool sendAsync(const void *buffer, size_t size) { return sendAsync(buffer, size, SendPriority::Normal); }
 
     //! Send text to server asynchronously
     /*!
@@ -191,6 +229,24 @@ public:
      */
     virtual bool sendAsync(std::string_view text) { return sendAsync(text.data(), text.size()); }
 
+    //! Send data to the server asynchronously with a priority
+    /*!
+     * Note: High priority data overtakes queued normal priority data at the next message boundary
+     * \param buffer - Buffer to send
+     * \param size - Buffer size
+     * \param priority - Send priority
+     * \return true iff the data was queued
+     */
+    virtual bool sendAsync(const void *buffer, size_t size, SendPriority priority);
+
+    //! Send text to server asynchronously with a priority
+    /*!
+     * \param text - Text to send
+     * \param priority - Send priority
+     * \return true iff the text was queued
+     */
+    virtual bool sendAsync(std::string_view text, SendPriority priority) { return sendAsync(text.data(), text.size(), priority); }
+
     //! Receive data from server
     /*!
      * \param buffer - Buffer to write received data to
@@ -236,6 +292,9 @@ protected:
     //! Callback when there is no data to send (idle)
     virtual void onEmpty() {}
 
+    //! Callback when reconnecting gives up after the policy's max attempts
+    virtual void onReconnectFailed() {}
+
     //! On error callback
     /*!
      * \param err - Error code
@@ -257,9 +316,14 @@ private:
 
     asio::ip::tcp::endpoint _endpoint;
     asio::ip::tcp::socket _socket;
+    asio::ip::tcp::resolver _resolver;
+    std::shared_ptr<DnsCache> _dns_cache;
+    std::chrono::nanoseconds _connect_attempt_delay;
 
     std::atomic<bool> _connecting;
     std::atomic<bool> _connected;
+    // Bumped as a disconnect starts, aborted IO of an older generation belongs to a connection gone away
+    std::atomic<uint64_t> _generation;
 
     uint64_t _bytes_pending;
     uint64_t _bytes_sending;
@@ -267,21 +331,55 @@ private:
     uint64_t _bytes_received;
 
     bool _receiving;
+    bool _external_receive;
     size_t _receive_buff_limit;
     std::vector<uint8_t> _receive_buff;
     HandlerMemory<> _receive_storage;
 
     bool _sending;
     std::mutex _send_lock;
+    // Sends are queued to the send buffer, set under the send lock before the client turns ready & cleared before
+    // it stops being, sends outside of it are buffered offline while reconnecting
+    bool _send_open;
     size_t _send_buff_limit;
     std::vector<uint8_t> _send_buff_main;
     std::vector<uint8_t> _send_buff_flush;
     size_t _send_flush_offset;
     HandlerMemory<> _send_storage;
 
+    // Priority lanes, normal priority data is queued in the main buffer & split into batches at the
+    // recorded message boundaries so high priority data can be written in between
+    std::vector<uint8_t> _send_buff_high;
+    std::vector<uint8_t> _send_buff_high_flush;
+    size_t _send_high_offset;
+    bool _send_high_active;
+    std::vector<size_t> _send_main_bounds;
+    std::vector<size_t> _send_flush_bounds;
+    size_t _send_flush_bound;
+
     bool _keep_alive;
     bool _no_delay;
 
+    // Why the client is disconnecting when it wasn't asked to, decides whether it reconnects
+    enum class Drop : uint8_t {
+        None,
+        Lost,
+        ConnectFailed
+    };
+
+    ReconnectPolicy _reconnect_policy;
+    std::mutex _reconnect_lock;
+    asio::system_timer _reconnect_timer;
+    std::atomic<bool> _reconnecting;
+    std::atomic<bool> _reconnect_requested;
+    std::atomic<Drop> _drop;
+    std::atomic<size_t> _reconnect_attempts;
+    std::vector<uint8_t> _send_buff_offline;
+
+    // Notified once an async connect is ready or has failed, each is called once
+    std::mutex _ready_lock;
+    std::vector<std::function<void(bool)>> _ready_handlers;
+
     //! Async write some to IO
     virtual void asyncWriteSome(const void *buffer, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler);
 
@@ -291,6 +389,88 @@ private:
     //! Clear buffers
     void clearBuffs();
 
+    //! Resolve the address to the endpoints to connect to, blocking if it isn't cached
+    /*!
+     * \param endpoints - Resolved endpoints
+     * \return Error if the address couldn't be resolved
+     */
+    std::error_code resolve(DnsCache::Endpoints &endpoints);
+
+    //! Resolve the address to the endpoints to connect to without blocking the IO thread
+    /*!
+     * Note: Must be called from the client's IO, the handler is called from it
+     * \param handler - Completion handler
+     */
+    void resolveAsync(const std::function<void(std::error_code, const DnsCache::Endpoints&)> &handler);
+
+    struct ConnectRace;
+
+    //! Connect to the first of the resolved endpoints to accept
+    /*!
+     * Attempts are staggered across the endpoints, alternating address families (RFC 8305), a failed attempt
+     * starts the next at once. The first connection wins & becomes the client's socket, the rest are closed.
+     * Note: Must be called from the client's IO, the handler is called from it
+     * \param endpoints - Resolved endpoints
+     * \param handler - Completion handler, given the endpoint connected to
+     */
+    void connectRace(const DnsCache::Endpoints &endpoints, const std::function<void(std::error_code, const asio::ip::tcp::endpoint&)> &handler);
+
+    //! Start the next attempt of a race
+    void raceNext(const std::shared_ptr<ConnectRace> &race);
+
+    //! Handle a finished attempt of a race
+    void raceAttemptDone(const std::shared_ptr<ConnectRace> &race, size_t attempt, std::error_code err);
+
+    //! Reconnect after a failed connect or a lost connection if the policy or a reconnect in progress asks for it
+    /*!
+     * \param connect_failed - true iff a connect failed, false if an established connection was lost
+     */
+    void reconnectOn(bool connect_failed);
+
+    //! Schedule the next reconnect attempt, giving up past the policy's max attempts
+    void scheduleReconnect();
+
+    //! Stop reconnecting & drop sends buffered while disconnected
+    void cancelReconnect();
+
+    //! Stop reconnecting if a disconnect was asked for
+    void disconnectRequested();
+
+    //! Open the send buffer to sends, ahead of what was buffered while disconnected
+    /*!
+     * Note: Must be called before the client turns ready, so data buffered offline is sent before any sent after
+     */
+    void openSends();
+
+    //! Close the send buffer to sends, must be called before the client stops being ready
+    void closeSends();
+
+    //! Reset the reconnect state & send what was buffered while disconnected once ready
+    void reconnected();
+
+    //! Buffer an async send while reconnecting
+    /*!
+     * Note: The send lock must be held
+     * \param buffer - Buffer to send
+     * \param size - Buffer size
+     * \return true iff the data was buffered
+     */
+    bool bufferOffline(const void *buffer, size_t size);
+
+    //! Connect async unless a connect is in progress already, notifying a handler once ready or failed
+    /*!
+     * Every caller waiting on the same connect is notified, from the client's IO
+     * \param handler - Ready handler
+     * \return false iff the client is ready already, the handler isn't called then
+     */
+    bool connectNotify(const std::function<void(bool)> &handler);
+
+    //! Notify the ready handlers of a connect
+    /*!
+     * \param ready - true iff the client is ready
+     */
+    void notifyReady(bool ready);
+
     //! Handle errors
     virtual void err(std::error_code);
 
@@ -303,6 +483,9 @@ private:
     //! Try to send data
     void trySend();
 
+    //! End the current batch of normal priority data if it is large enough, send lock must be held
+    void markBatch();
+
     //! Read some from IO to buffer synchronously
     virtual std::size_t readSome(void *buffer, std::size_t size, std::error_code &err) { return _socket.read_some(asio::buffer(buffer, size), err); }
 
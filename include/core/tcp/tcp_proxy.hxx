@@ -0,0 +1,139 @@
+#pragma once
+
+#include "core/service.hxx"
+#include "core/tcp/tcp_client.hxx"
+#include "core/tcp/tcp_server.hxx"
+#include "core/tcp/tcp_session.hxx"
+
+#include "core/io.hxx"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace CxxServer::Core::Tcp {
+    class ProxyServer;
+
+    //! Front session of an L4 TCP proxy
+    /*!
+     * Connects a client to the backend once the session connects & moves bytes between the two sockets with
+     * splice, through a pipe per direction, so proxied data never enters user space. onReceive isn't called for
+     * proxied data.
+     *
+     * Each direction only reads as much as its pipe holds & only reads again once the pipe is drained into the
+     * other socket, so a slow reader on either side pushes back on the writer on the other side. A FIN from
+     * either side is forwarded as a shutdown of the other side's write half, the session disconnects once both
+     * directions finish or either fails.
+     */
+    class ProxySession : public Session {
+        friend class ProxyServer;
+
+    public:
+        //! Init session with the backend to proxy to
+        /*!
+         * \param server - Server
+         * \param backend_addr - Address of the backend
+         * \param backend_port - Port of the backend
+         */
+        ProxySession(const std::shared_ptr<Server> &server, const std::string &backend_addr, unsigned int backend_port);
+        virtual ~ProxySession() = default;
+
+        //! Get the backend client (null until the session connects)
+        std::shared_ptr<Client> &backend() noexcept { return _backend; }
+
+        //! Get # of bytes forwarded from the peer to the backend
+        uint64_t bytesUpstream() const noexcept { return _upstream.bytes; }
+
+        //! Get # of bytes forwarded from the backend to the peer
+        uint64_t bytesDownstream() const noexcept { return _downstream.bytes; }
+
+    protected:
+        void onConnect() override;
+        void onDisconnect() override;
+
+    private:
+        class Backend;
+
+        // One direction of the proxy, only touched from the session's IO thread
+        struct Pump {
+            asio::ip::tcp::socket *from = nullptr;
+            asio::ip::tcp::socket *to = nullptr;
+            int pipe[2] = {-1, -1};
+            size_t buffered = 0;
+            bool eof = false;
+            bool done = false;
+            std::atomic<uint64_t> bytes = 0;
+        };
+
+        std::string _backend_addr;
+        unsigned int _backend_port;
+        std::shared_ptr<Client> _backend;
+        Pump _upstream;
+        Pump _downstream;
+
+        //! Start both directions once the backend is connected
+        void start();
+
+        //! Move data in a direction until either socket would block
+        /*!
+         * \param pump - Direction to move data in
+         */
+        void pump(Pump &pump);
+
+        //! Resume a direction once a socket is ready
+        /*!
+         * \param pump - Direction to resume
+         * \param socket - Socket to wait on
+         * \param type - Readiness to wait for
+         */
+        void wait(Pump &pump, asio::ip::tcp::socket &socket, asio::socket_base::wait_type type);
+
+        //! Account for bytes moved in a direction
+        /*!
+         * \param pump - Direction data was moved in
+         * \param size - # of bytes moved
+         */
+        void account(Pump &pump, size_t size);
+    };
+
+    //! L4 TCP proxy
+    /*!
+     * Accepts connections & forwards each to its own connection to the backend, see ProxySession
+     */
+    class ProxyServer : public Server {
+    public:
+        //! Init proxy with IO, port # & backend
+        /*!
+         * \param service - IO service
+         * \param port - Port # to listen on
+         * \param backend_addr - Address of the backend
+         * \param backend_port - Port of the backend
+         */
+        ProxyServer(const std::shared_ptr<Service> &service, unsigned int port, const std::string &backend_addr, unsigned int backend_port);
+
+        //! Init proxy with IO, address, port & backend
+        /*!
+         * \param service - IO service
+         * \param addr - Address to listen on
+         * \param port - Port to listen on
+         * \param backend_addr - Address of the backend
+         * \param backend_port - Port of the backend
+         */
+        ProxyServer(const std::shared_ptr<Service> &service, const std::string &addr, unsigned int port, const std::string &backend_addr, unsigned int backend_port);
+        virtual ~ProxyServer() = default;
+
+        //! Get backend address
+        const std::string &backendAddr() const noexcept { return _backend_addr; }
+
+        //! Get backend port
+        unsigned int backendPort() const noexcept { return _backend_port; }
+
+    protected:
+        std::shared_ptr<Session> newSession(const std::shared_ptr<Server> &server) override;
+
+    private:
+        std::string _backend_addr;
+        unsigned int _backend_port;
+    };
+}
@@ -1,22 +1,28 @@
+#pragma once
+
 #include "core/memory.hxx"
 #include "core/properties.hxx"
 #include "core/protocol.hxx"
 #include "core/uuid.hxx"
+#include "core/tcp/address_table.hxx"
 #include "core/tcp/tcp_session.hxx"
 
 #include "core/io.hxx"
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <map>
 #include <memory>
 #include <shared_mutex>
+#include <string>
 #include <string_view>
 #include <system_error>
 
 namespace CxxServer::Core::Tcp {
     class Server : public std::enable_shared_from_this<Server>, private noncopyable, private nonmovable {
         friend class Session;
+        friend class ProxySession;
         friend SSL::Session;
     
         public:
@@ -92,9 +98,61 @@ namespace CxxServer::Core::Tcp {
             //! Act as getter & setter for reuse port property
             bool &reusePort() noexcept { return _reuse_port; }
 
+            //! Act as getter & setter for the max # of connected sessions (defaults to 0 or unlimited)
+            size_t &maxConnections() noexcept { return _max_connections; }
+
+            //! Act as getter & setter for the max IO queue delay before new connections are shed (defaults to 0 or disabled)
+            /*!
+             * Note: The queue delay is sampled from the acceptor's IO thread while the server is running, this must be
+             *       set before the server is started
+             */
+            std::chrono::nanoseconds &maxQueueDelay() noexcept { return _max_queue_delay; }
+
+            //! Act as getter & setter for the response written to rejected connections before they are closed (defaults to none)
+            std::string &rejectResponse() noexcept { return _reject_response; }
+
+            //! Limit the rate new connections are accepted at
+            /*!
+             * Connections are admitted from a token bucket refilled at the given rate
+             * \param rate - Connections per second (0 disables the limit)
+             * \param burst - Max # of connections which can be accepted at once
+             */
+            void setAcceptRate(double rate, size_t burst);
+
+            //! Get the smoothed IO queue delay of the acceptor's thread
+            std::chrono::nanoseconds queueDelay() const noexcept { return std::chrono::nanoseconds(_queue_delay.load()); }
+
+            //! Get # of connections rejected by admission control
+            uint64_t numRejectedConnections() const noexcept { return _rejected_connections; }
+
+            //! Act as getter & setter for the connection & receive rate quotas applied to each remote address
+            /*!
+             * Note: Connections over their address' quota are rejected, sessions over their address' receive rate
+             *       stop reading until the address is back within its quota. This must be set before the server is started
+             */
+            AddressTable::Limits &addressLimits() noexcept { return _address_table.limits(); }
+
+            //! Get # of remote addresses currently tracked for quotas
+            size_t numTrackedAddresses() const { return _address_table.size(); }
+
+            //! Act as getter & setter for the slow consumer policy new sessions start with
+            SlowConsumerPolicy &slowConsumerPolicy() noexcept { return _slow_policy; }
+
+            //! Get # of times a session paused reading because its address exceeded its receive rate
+            uint64_t numThrottledReads() const noexcept { return _throttled_reads; }
+
             //! Has server started
             bool isStarted() const noexcept { return _started; }
 
+            //! Is the server draining its sessions before stopping
+            bool isDraining() const noexcept { return _draining; }
+
+            //! Get # of sessions which still had unsent data when the last drain deadline expired
+            uint64_t numDrainDroppedSessions() const noexcept { return _drain_dropped_sessions; }
+
+            //! Get # of unsent bytes discarded when the last drain deadline expired
+            uint64_t numDrainDroppedBytes() const noexcept { return _drain_dropped_bytes; }
+
             //! Start the server
             /*!
              * \return true iff server successfully started
@@ -107,11 +165,22 @@ namespace CxxServer::Core::Tcp {
              */
             virtual bool stop();
 
+            //! Gracefully stop the server
+            /*!
+             * Stop accepting new connections & let every session flush its send queue before disconnecting it.
+             * Sessions which are still flushing when the timeout expires are disconnected & their unsent data is
+             * reported through onDrained
+             * \param timeout - Drain deadline relative to now, 0 stops immediately
+             * \return true iff server drain successfully started
+             */
+            virtual bool stop(std::chrono::nanoseconds timeout);
+
             //! Restart the server
             /*!
+             * \param timeout - Drain deadline for the stop (defaults to 0 or stop immediately)
              * \return true iff server successfully restarted
              */
-            virtual bool restart();
+            virtual bool restart(std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0));
             
             //! Multicast data
             /*!
@@ -155,6 +224,13 @@ namespace CxxServer::Core::Tcp {
             //! On server stop
             virtual void onStop() {};
 
+            //! On server drain completion, called before onStop
+            /*!
+             * \param dropped_sessions - # of sessions disconnected with unsent data
+             * \param dropped_bytes - # of unsent bytes discarded
+             */
+            virtual void onDrained(uint64_t dropped_sessions, uint64_t dropped_bytes) {}
+
             //! On session connect
             /*!
              * \param session - Session which was connected
@@ -197,6 +273,12 @@ namespace CxxServer::Core::Tcp {
             std::atomic<bool> _started;
             HandlerMemory<> _acceptor_storage;
 
+            // Drain state
+            std::atomic<bool> _draining;
+            asio::system_timer _drain_timer;
+            std::atomic<uint64_t> _drain_dropped_sessions;
+            std::atomic<uint64_t> _drain_dropped_bytes;
+
             // Server stats
             uint64_t _bytes_pending;
             uint64_t _bytes_received;
@@ -208,9 +290,53 @@ namespace CxxServer::Core::Tcp {
             bool _reuse_addr;
             bool _reuse_port;
 
+            // Admission control
+            size_t _max_connections;
+            double _accept_rate;
+            double _accept_burst;
+            double _accept_tokens;
+            std::chrono::steady_clock::time_point _accept_refill;
+            std::chrono::nanoseconds _max_queue_delay;
+            std::atomic<int64_t> _queue_delay;
+            asio::system_timer _probe_timer;
+            asio::system_timer _accept_timer;
+            std::string _reject_response;
+            std::atomic<uint64_t> _rejected_connections;
+
+            SlowConsumerPolicy _slow_policy;
+
+            // Per remote address quotas
+            AddressTable _address_table;
+            std::atomic<uint64_t> _throttled_reads;
+
             //! Handle acceptance of new connections
             void accept();
 
+            //! Accept all connections pending on the acceptor
+            /*!
+             * \return false iff accepting failed for lack of resources & should back off
+             */
+            bool acceptPending();
+
+            //! Wait for the acceptor again after a back off
+            void acceptLater();
+
+            //! Should a new connection be admitted
+            /*!
+             * \param addr - Remote address of the connection
+             * \return true iff the connection is admitted, its address quota is then acquired
+             */
+            bool admit(const asio::ip::address &addr);
+
+            //! Reject a connection without creating a session for it
+            /*!
+             * \param fd - Accepted socket
+             */
+            void reject(int fd);
+
+            //! Sample the IO queue delay of the acceptor's thread
+            void probeQueueDelay();
+
             //! Register a new session
             void registerSession();
 
@@ -220,6 +346,9 @@ namespace CxxServer::Core::Tcp {
              */
             void unregisterSession(const Uuid &id);
 
+            //! Complete a drain & stop the server
+            void finishDrain();
+
             //! Clear multicast buffers
             void clearMulticastBuffs();
 
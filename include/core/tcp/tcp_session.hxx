@@ -4,17 +4,21 @@
 #include "core/memory.hxx"
 #include "core/properties.hxx"
 #include "core/service.hxx"
+#include "core/tcp/send_priority.hxx"
 #include "core/uuid.hxx"
 
 #include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
+#include <initializer_list>
 #include <memory>
 #include <mutex>
 #include <string_view>
 #include <system_error>
+#include <unordered_map>
 #include <vector>
 
 
@@ -25,12 +29,72 @@ namespace CxxServer::Core::SSL {
 
 namespace CxxServer::Core::Tcp {
     class Server;
+    class ProxySession;
+
+    //! Slow consumer policy
+    /*!
+     * Detects sessions whose peer doesn't read fast enough to keep up with the data queued for it, either because
+     * the oldest queued byte has waited too long or because the queue would take too long to drain at the measured
+     * send throughput. Checked whenever data is queued, 0 disables a check.
+     */
+    struct SlowConsumerPolicy {
+        //! Action taken against a slow consumer
+        enum class Action {
+            //! Drop the oldest queued messages until the session is within the policy
+            DropOldest,
+            //! Drop every queued message but the newest
+            Conflate,
+            //! Disconnect the session
+            Disconnect
+        };
+
+        //! Max age of the oldest queued byte
+        std::chrono::nanoseconds max_age = std::chrono::nanoseconds(0);
+        //! Max time the queued bytes may take to drain at the measured throughput
+        std::chrono::nanoseconds max_drain_time = std::chrono::nanoseconds(0);
+        //! Action when either check fires
+        Action action = Action::Disconnect;
+
+        //! Is any check enabled
+        bool enabled() const noexcept { return max_age.count() > 0 || max_drain_time.count() > 0; }
+    };
+
+    //! Slow consumer counters
+    struct SlowConsumerStats {
+        //! # of times the age check fired
+        uint64_t age_triggers = 0;
+        //! # of times the drain time check fired
+        uint64_t drain_time_triggers = 0;
+        //! # of queued messages dropped
+        uint64_t dropped_messages = 0;
+        //! # of queued bytes dropped
+        uint64_t dropped_bytes = 0;
+        //! # of sessions disconnected
+        uint64_t disconnects = 0;
+    };
 
     class Session : public std::enable_shared_from_this<Session>, private noncopyable, private nonmovable{
         friend class Server;
+        friend class ProxySession;
         friend class CxxServer::Core::SSL::Session;
 
     public:
+        //! Pull based source of data to stream
+        /*!
+         * Called on the session's IO thread to fill a buffer with the next chunk of the stream
+         * \param buffer - Buffer to fill
+         * \param size - Buffer size
+         * \return # of bytes written to the buffer, 0 ends the stream
+         */
+        using Producer = std::function<size_t(void *buffer, size_t size)>;
+
+        //! Completion handler of a receive to file
+        /*!
+         * \param err - Error which ended the receive, empty once the whole budget was received
+         * \param received - # of bytes written to the file
+         */
+        using FileReceiveHandler = std::function<void(std::error_code err, uint64_t received)>;
+
         Session(const std::shared_ptr<Server> &);
         virtual ~Session() = default;
 
@@ -49,6 +113,9 @@ namespace CxxServer::Core::Tcp {
         //! Get associated socket as a constant
         virtual const asio::ip::tcp::socket &socket() const noexcept { return _socket; }
 
+        //! Get the remote address of the session
+        const asio::ip::address &remoteAddress() const noexcept { return _remote_address; }
+
         //! Get # of bytes pending
         uint64_t bytesPending() const noexcept { return _bytes_pending; }
         //! Get # of bytes sent
@@ -68,12 +135,35 @@ namespace CxxServer::Core::Tcp {
         //! Is session connected?
         bool isConnected() const noexcept { return _connected; }
 
+        //! Act as getter & setter for the slow consumer policy (defaults to the server's policy)
+        /*!
+         * Note: This must be set before data is queued, i.e. in onConnect
+         */
+        SlowConsumerPolicy &slowConsumerPolicy() noexcept { return _slow_policy; }
+
+        //! Get slow consumer counters
+        SlowConsumerStats slowConsumerStats();
+
+        //! Get the measured send throughput in bytes per second (only measured with a slow consumer policy)
+        double sendRate() const noexcept { return _send_rate; }
+
         //! Disconnect the session
         /*!
          * \return true iff session disconnect is successful
          */
         virtual bool disconnect() { return this->disconnect(false); }
 
+        //! Disconnect the session once all queued data has been sent
+        /*!
+         * Note: Data which is still queued if the session is disconnected before the flush completes is
+         *       reported to the server as dropped
+         * \return true iff the session is connected & will drain
+         */
+        virtual bool drain();
+
+        //! Is session draining?
+        bool isDraining() const noexcept { return _draining; }
+
         //! Send data synchronously
         /*!
          * \param buffer - Buffer to send
@@ -97,7 +187,7 @@ namespace CxxServer::Core::Tcp {
          * \param size - Buffer size
          * \return true if sent successfully, false if not connected
          */
-        virtual bool sendAsync(const void *buffer, size_t size);
+        virtual bool sendAsync(const void *buffer, size_t size) { return sendAsync(buffer, size, SendPriority::Normal); }
         
         //! Async text send
         /*!
@@ -106,6 +196,114 @@ namespace CxxServer::Core::Tcp {
          */
         virtual bool sendAsync(std::string_view text) { return sendAsync(text.data(), text.size()); }
 
+        //! Async data send with a priority
+        /*!
+         * Note: High priority data overtakes queued normal priority data at the next message boundary
+         * \param buffer - Buffer to send
+         * \param size - Buffer size
+         * \param priority - Send priority
+         * \return true if sent successfully, false if not connected
+         */
+        virtual bool sendAsync(const void *buffer, size_t size, SendPriority priority);
+
+        //! Async text send with a priority
+        /*!
+         * \param text - text to send
+         * \param priority - Send priority
+         * \return true if sent successfully, false if not connected
+         */
+        virtual bool sendAsync(std::string_view text, SendPriority priority) { return sendAsync(text.data(), text.size(), priority); }
+
+        //! Async send of several buffers as one message
+        /*!
+         * The buffers are copied into the send buffer one after another, so a message assembled from pieces isn't
+         * joined in a buffer of its own first
+         * \param buffers - Buffers to send, in order
+         * \return true if sent successfully, false if not connected
+         */
+        virtual bool sendGather(std::initializer_list<std::string_view> buffers) { return sendGather(buffers, SendPriority::Normal); }
+
+        //! Async send of several buffers as one message with a priority
+        /*!
+         * \param buffers - Buffers to send, in order
+         * \param priority - Send priority
+         * \return true if sent successfully, false if not connected
+         */
+        virtual bool sendGather(std::initializer_list<std::string_view> buffers, SendPriority priority);
+
+        //! Async conflated data send
+        /*!
+         * Queue the latest value for a key, replacing the value previously queued for the key if it hasn't started
+         * sending yet. Memory used by conflated data is bounded by the # of keys, a slow peer always receives the
+         * newest value of each key.
+         *
+         * Note: Conflated values are sent after the data queued with sendAsync which is already pending, values of
+         *       different keys are sent in the order their keys were first queued
+         * \param key - Conflation key
+         * \param buffer - Buffer to send
+         * \param size - Buffer size
+         * \return true if queued successfully, false if not connected
+         */
+        virtual bool sendConflated(uint64_t key, const void *buffer, size_t size);
+
+        //! Async conflated text send
+        /*!
+         * \param key - Conflation key
+         * \param text - text to send
+         * \return true if queued successfully, false if not connected
+         */
+        virtual bool sendConflated(uint64_t key, std::string_view text) { return sendConflated(key, text.data(), text.size()); }
+
+        //! Get # of conflated values replaced before they were sent
+        uint64_t numConflated() const noexcept { return _conflated; }
+
+        //! Async send of shared data without copying it
+        /*!
+         * The data is written to the socket straight from the buffer, which its owner keeps alive until written, so
+         * one serialized message can be queued on many sessions at the cost of a reference each.
+         *
+         * Note: Sent in order with the normal priority data queued with sendAsync, the buffer must not change
+         *       until written
+         * \param owner - Owner of the buffer
+         * \param buffer - Buffer to send
+         * \param size - Buffer size
+         * \return true if queued successfully, false if not connected
+         */
+        virtual bool sendShared(std::shared_ptr<const void> owner, const void *buffer, size_t size);
+
+        //! Async send of a region of a file without copying it
+        /*!
+         * The region is written to the socket with sendfile once the data queued before it is written, so the file
+         * never enters user space. Sessions whose socket doesn't carry the data as is, e.g. SSL, read the region
+         * through a buffer instead.
+         *
+         * Note: Sent in order with the normal priority data queued with sendAsync like shared buffers, the owner
+         *       must keep the file open & the region must not shrink until written
+         * \param owner - Owner of the file descriptor
+         * \param fd - File descriptor to send from
+         * \param offset - Offset of the region in the file
+         * \param size - Region size
+         * \return true if queued successfully, false if not connected
+         */
+        virtual bool sendFile(std::shared_ptr<const void> owner, int fd, uint64_t offset, size_t size);
+
+        //! Stream data pulled from a producer
+        /*!
+         * The producer is asked for the next chunk whenever the data being written drops below the low watermark,
+         * so a payload of any size is sent with bounded memory & is only produced as fast as the peer reads it.
+         *
+         * Note: Data queued with sendAsync while streaming is interleaved with the stream at chunk boundaries,
+         *       onStreamEnd is called once the producer ends the stream
+         * \param producer - Producer of the stream
+         * \param chunk_size - Max # of bytes requested from the producer at once
+         * \param low_watermark - # of unsent bytes below which the next chunk is requested
+         * \return true iff the stream was started, false if not connected or already streaming
+         */
+        virtual bool sendStream(Producer producer, size_t chunk_size = 64 * 1024, size_t low_watermark = 64 * 1024);
+
+        //! Is a stream in progress?
+        bool isStreaming() const noexcept { return _streaming; }
+
         //! Receive data synchronously
         /*!
          * \param buffer - Buffer to receive
@@ -126,6 +324,25 @@ namespace CxxServer::Core::Tcp {
         //! Receive data asynchronously
         virtual void receiveAsync();
 
+        //! Receive data straight into a file
+        /*!
+         * Received bytes are spliced from the socket into the file through a pipe so they never enter user space
+         * & onReceive isn't called for them. Once the budget is received the session goes back to calling
+         * onReceive, the handler is called on the session's IO thread when the budget is received or the receive
+         * fails.
+         *
+         * Note: Bytes already delivered to onReceive aren't part of the budget, switch from onReceive so no read
+         *       is in flight. Data is written at the file's current offset.
+         * \param fd - File descriptor to write to
+         * \param budget - # of bytes to receive into the file
+         * \param handler - Completion handler
+         * \return true iff the receive was started, false if not connected or already receiving to a file
+         */
+        virtual bool receiveToFile(int fd, uint64_t budget, FileReceiveHandler handler);
+
+        //! Is the session receiving to a file?
+        bool isReceivingToFile() const noexcept { return _splicing; }
+
         //! Set receive buffer limit
         /*!
          * Note: The session will be disconnected if this limit is reached, the default is unlimited
@@ -172,6 +389,9 @@ namespace CxxServer::Core::Tcp {
         //! Callback when send buffer is empty and more data can be sent
         virtual void onEmpty() {}
 
+        //! Callback when the producer of a stream ends it, the last chunk may still be sending
+        virtual void onStreamEnd() {}
+
         //! Handle errors
         /*!
          * \param error - Error code
@@ -190,6 +410,10 @@ namespace CxxServer::Core::Tcp {
 
         asio::ip::tcp::socket _socket;
         std::atomic<bool> _connected;
+        std::atomic<bool> _draining;
+
+        asio::ip::address _remote_address;
+        bool _address_tracked;
 
         uint64_t _bytes_pending;
         uint64_t _bytes_sending;
@@ -197,9 +421,19 @@ namespace CxxServer::Core::Tcp {
         uint64_t _bytes_received;
 
         bool _receiving;
+        bool _external_receive;
         size_t _receive_limit = 0;
         std::vector<uint8_t> _receive_buff;
         HandlerMemory<> _receive_storage;
+        asio::system_timer _receive_timer;
+
+        // Receive to file
+        std::atomic<bool> _splicing;
+        int _splice_fd;
+        int _splice_pipe[2];
+        uint64_t _splice_remaining;
+        uint64_t _splice_received;
+        FileReceiveHandler _splice_handler;
 
         bool _sending;
         std::mutex _send_lock;
@@ -209,15 +443,84 @@ namespace CxxServer::Core::Tcp {
         size_t _send_flush_offset;
         HandlerMemory<> _send_storage;
 
+        // Priority lanes, normal priority data is queued in the main buffer & split into batches at the
+        // recorded message boundaries so high priority data can be written in between
+        std::vector<uint8_t> _send_buff_high;
+        std::vector<uint8_t> _send_buff_high_flush;
+        size_t _send_high_offset;
+        bool _send_high_active;
+        std::vector<size_t> _send_main_bounds;
+        std::vector<size_t> _send_flush_bounds;
+        size_t _send_flush_bound;
+
+        // Streaming, the producer appends straight to the flush buffer
+        std::atomic<bool> _streaming;
+        Producer _producer;
+        size_t _producer_chunk;
+        size_t _producer_low;
+
+        // Slow consumer tracking, guarded by the send lock
+        struct QueuedMessage {
+            size_t size;
+            std::chrono::steady_clock::time_point queued;
+        };
+
+        // Conflated values, guarded by the send lock
+        struct ConflatedValue {
+            std::vector<uint8_t> data;
+            bool queued = false;
+        };
+
+        // Shared buffers, guarded by the send lock until flushed. Each is written when the normal priority data
+        // before it, up to its position in the main/flush buffer, has been written. File regions are shared buffers
+        // read from a file descriptor at an offset instead of memory
+        struct SharedBuffer {
+            std::shared_ptr<const void> owner;
+            const uint8_t *data;
+            size_t size;
+            size_t position;
+            int fd = -1;
+            uint64_t offset = 0;
+        };
+
+        std::deque<SharedBuffer> _send_shared_main;
+        std::deque<SharedBuffer> _send_shared_flush;
+        size_t _send_shared_offset;
+        bool _send_shared_active;
+        size_t _shared_pending;
+
+        std::unordered_map<uint64_t, size_t> _conflate_index;
+        std::vector<ConflatedValue> _conflate_values;
+        std::vector<size_t> _conflate_order;
+        size_t _conflate_pending;
+        std::atomic<uint64_t> _conflated;
+
+        SlowConsumerPolicy _slow_policy;
+        SlowConsumerStats _slow_stats;
+        std::deque<QueuedMessage> _send_msgs;
+        std::chrono::steady_clock::time_point _send_flush_since;
+        std::chrono::steady_clock::time_point _send_rate_since;
+        uint64_t _send_rate_bytes;
+        std::atomic<double> _send_rate;
+
         //! Async write some to IO
         virtual void asyncWriteSome(const void *buffer, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler);
 
+        //! Async write some of a file region to IO
+        virtual void asyncSendFile(int fd, uint64_t offset, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler);
+
         //! Async read some from IO to buffer
         virtual void asyncReadSome(void *buffer, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler);
 
         //! Clear all associated buffers
         void clearBuffs();
 
+        //! Reset the flush buffer once it & the shared buffers spliced into it are written
+        void resetFlush();
+
+        //! Get # of queued bytes which have not yet been written to the socket
+        size_t unsentBytes();
+
         //! Close server
         virtual void close() { socket().close(); }
 
@@ -242,9 +545,68 @@ namespace CxxServer::Core::Tcp {
         //! Try receive data
         void tryReceive();
 
+        //! Try splice received data into the file
+        void trySplice();
+
+        //! End the receive to file
+        /*!
+         * \param err - Error which ended the receive
+         */
+        void finishSplice(std::error_code err);
+
+        //! Apply the slow consumer policy to the send queue, send lock must be held
+        /*!
+         * \param now - Current time
+         * \return false iff the session must be disconnected
+         */
+        bool checkSlowConsumer(std::chrono::steady_clock::time_point now);
+
+        //! Drop queued messages from the front of the send queue, send lock must be held
+        /*!
+         * \param count - # of messages to drop
+         */
+        void dropQueued(size_t count);
+
+        //! Update the measured send throughput, send lock must be held
+        /*!
+         * \param sent - # of bytes just sent
+         * \param now - Current time
+         */
+        void updateSendRate(size_t sent, std::chrono::steady_clock::time_point now);
+
+        //! Stop reading for a while
+        /*!
+         * \param wait - Time until reading resumes
+         */
+        void pauseReceive(std::chrono::nanoseconds wait);
+
         //! Try send data
         void trySend();
 
+        //! End the current batch of normal priority data if it is large enough, send lock must be held
+        void markBatch();
+
+        //! Queue a message made of pieces for sending
+        /*!
+         * \param pieces - Pieces of the message
+         * \param count - # of pieces
+         * \param size - Total size of the pieces, not 0
+         * \param priority - Send priority
+         */
+        bool queueSend(const std::string_view *pieces, size_t count, size_t size, SendPriority priority);
+
+        //! Queue a shared buffer or file region for sending
+        /*!
+         * \param shared - Buffer, its position is set here
+         */
+        bool queueShared(SharedBuffer shared);
+
+        //! Append pieces of a message to a send buffer
+        static void appendPieces(std::vector<uint8_t> &buffer, const std::string_view *pieces, size_t count);
+
+        //! Pull the next chunk from the producer if the data being written is below the low watermark
+        void produce();
+
         //! Reset the server
         void resetServer();
 
@@ -1,9 +1,11 @@
 #pragma once
 
+#include "core/memory.hxx"
 #include "core/service.hxx"
 #include "core/io.hxx"
 
 #include <chrono>
+#include <coroutine>
 #include <functional>
 #include <memory>
 #include <system_error>
@@ -17,6 +19,20 @@ namespace CxxServer::Core {
  */
 class Timer : public std::enable_shared_from_this<Timer> {
 public:
+    //! Awaitable wait for the timer
+    class WaitAwaiter {
+    public:
+        explicit WaitAwaiter(Timer &timer) noexcept : _timer(timer), _expired(false) {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { _timer.waitResume(handle, _expired); }
+        bool await_resume() const noexcept { return _expired; }
+
+    private:
+        Timer &_timer;
+        bool _expired;
+    };
+
     //! Init timer with a given service
     /*!
      * \param service - IO service
@@ -130,6 +146,16 @@ public:
      */
     virtual bool waitSync();
 
+    //! Await the timer from a coroutine
+    /*!
+     * Resumes the coroutine on the IO thread (& strand) once the timer expires or is cancelled, without calling
+     * the action or onTimer. The wait reuses the timer's handler storage so it doesn't allocate.
+     *
+     * Note: Only one awaited wait per timer at a time
+     * \return Awaitable producing true if the timer expired, false if cancelled or for any error
+     */
+    WaitAwaiter wait() noexcept { return WaitAwaiter(*this); }
+
     //! Cancel operations on the timer
     /*!
      * \return true if successful cancel, false otherwise
@@ -155,8 +181,12 @@ private:
     asio::system_timer _timer;
     // action function to be called
     std::function<void(bool)> _action;
+    HandlerMemory<> _wait_storage;
 
     void timerNotify(bool);
+
+    //! Start an awaited wait, resuming the coroutine once it completes
+    void waitResume(std::coroutine_handle<> handle, bool &expired);
     inline void err(std::error_code err) {
         // skip abort error
         if (err == asio::error::operation_aborted)
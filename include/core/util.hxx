@@ -1,8 +1,12 @@
 #pragma once
 
 #include "core/properties.hxx"
+#include <array>
+#include <bit>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
 #include <memory>
@@ -10,17 +14,285 @@
 #include <string_view>
 #include <type_traits>
 
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
 
 
 namespace CxxServer::Core::Utils {
+    //! Decimal digit pairs "00" to "99", the pair of a value below 100 starts at value * 2
+    inline constexpr std::array<char, 200> digit_pairs = [] {
+        std::array<char, 200> table{};
+        for (int i = 0; i < 100; ++i) {
+            table[i * 2] = static_cast<char>('0' + i / 10);
+            table[i * 2 + 1] = static_cast<char>('0' + i % 10);
+        }
+
+        return table;
+    }();
+
+    //! Lower case hex digits
+    inline constexpr char hex_digits[] = "0123456789abcdef";
+
+    //! Value of the hex digit of each char, -1 if it isn't one
+    inline constexpr std::array<int8_t, 256> hex_values = [] {
+        std::array<int8_t, 256> table{};
+        for (int c = 0; c < 256; ++c) {
+            if (c >= '0' && c <= '9')
+                table[c] = static_cast<int8_t>(c - '0');
+            else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+                table[c] = static_cast<int8_t>((c | 0x20) - 'a' + 10);
+            else
+                table[c] = -1;
+        }
+
+        return table;
+    }();
+
+    //! Powers of ten which fit in 64 bits, 10^i at index i
+    inline constexpr std::array<std::uint64_t, 20> powers_of_10 = [] {
+        std::array<std::uint64_t, 20> table{};
+        std::uint64_t power = 1;
+        for (auto &entry : table) {
+            entry = power;
+            power *= 10;
+        }
+
+        return table;
+    }();
+
+    //! Get # of decimal digits of a value
+    constexpr std::size_t decimalDigits(std::uint64_t val) noexcept {
+        // log10 estimated from log2 is the # of digits or one less
+        std::size_t digits = (static_cast<std::size_t>(std::bit_width(val | 1)) * 1233) >> 12;
+        return digits + (digits == 0 || val >= powers_of_10[digits]);
+    }
+
+    //! Format the lowest digits of a value right to left, two digits per step
+    /*!
+     * \param val - Value
+     * \param end - End of the digits
+     * \param digits - # of digits to format
+     */
+    inline void formatDigits(std::uint64_t val, char *end, std::size_t digits) noexcept {
+        while (digits >= 2) {
+            end -= 2;
+            std::memcpy(end, digit_pairs.data() + (val % 100) * 2, 2);
+            val /= 100;
+            digits -= 2;
+        }
+
+        if (digits > 0)
+            end[-1] = static_cast<char>('0' + val % 10);
+    }
+
+    //! Format a value in decimal
+    /*!
+     * \param val - Value
+     * \param out - Buffer of at least 20 chars
+     * \return End of the formatted value
+     */
+    inline char *formatDecimal(std::uint64_t val, char *out) noexcept {
+        std::size_t digits = decimalDigits(val);
+        formatDigits(val, out + digits, digits);
+        return out + digits;
+    }
+
+    //! Format a value in decimal zero padded to a width, e.g. for timestamps
+    /*!
+     * Note: Only the lowest width digits of larger values are formatted
+     * \param val - Value
+     * \param out - Buffer of at least width chars
+     * \param width - # of digits
+     * \return End of the formatted value
+     */
+    inline char *formatDecimal(std::uint64_t val, char *out, std::size_t width) noexcept {
+        formatDigits(val, out + width, width);
+        return out + width;
+    }
+
+    //! Format a value in decimal at the end of a buffer
+    /*!
+     * \param val - Value
+     * \param buf - Buffer
+     * \param buf_size - Buffer size, at least 20
+     * \return Formatted value
+     */
     inline std::string_view fastItoa(std::size_t val, char *buf, std::size_t buf_size) {
-        std::size_t idx = buf_size;
-        do {
-            buf[--idx] = '0' + (val % 10);
-            val /= 10;
-        } while(val > 0);
+        std::size_t digits = decimalDigits(val);
+        formatDigits(val, buf + buf_size, digits);
+        return {buf + buf_size - digits, digits};
+    }
+
+    //! Format a value as 16 lower case hex digits
+    /*!
+     * \param val - Value
+     * \param out - Buffer of at least 16 chars
+     * \return End of the formatted value
+     */
+    inline char *formatHex16(std::uint64_t val, char *out) noexcept {
+#if defined(__SSSE3__)
+        // a nibble per byte, most significant first, looked up in the digits with a shuffle
+        const __m128i bytes = _mm_cvtsi64_si128(static_cast<long long>(__builtin_bswap64(val)));
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        const __m128i nibbles = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask), _mm_and_si128(bytes, mask));
+        const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex_digits));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(digits, nibbles));
+#else
+        for (int i = 15; i >= 0; --i, val >>= 4)
+            out[i] = hex_digits[val & 0xf];
+#endif
+        return out + 16;
+    }
+
+    //! Format a value in lower case hex without leading zeros
+    /*!
+     * \param val - Value
+     * \param out - Buffer of at least 16 chars
+     * \return End of the formatted value
+     */
+    inline char *formatHex(std::uint64_t val, char *out) noexcept {
+        // the 16 bytes from the first digit are copied whole, past the digits it is only scratch
+        char buf[32];
+        formatHex16(val, buf);
+
+        std::size_t digits = (static_cast<std::size_t>(std::bit_width(val | 1)) + 3) / 4;
+        std::memcpy(out, buf + 16 - digits, 16);
+        return out + digits;
+    }
+
+    //! Size of a formatted timestamp, e.g. "2026-10-18T09:30:05.123456Z"
+    inline constexpr std::size_t timestamp_size = 27;
+
+    //! Format a UTC timestamp in ISO 8601 with microseconds
+    /*!
+     * \param time - Time, in years 0 to 9999
+     * \param out - Buffer of at least timestamp_size chars
+     * \return End of the formatted timestamp
+     */
+    inline char *formatTimestamp(std::chrono::system_clock::time_point time, char *out) noexcept {
+        auto days = std::chrono::floor<std::chrono::days>(time);
+        std::chrono::year_month_day date(days);
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(time - days).count();
+        auto seconds = micros / 1000000;
+
+        formatDecimal(static_cast<std::uint64_t>(static_cast<int>(date.year())), out, 4);
+        out[4] = '-';
+        formatDecimal(static_cast<unsigned int>(date.month()), out + 5, 2);
+        out[7] = '-';
+        formatDecimal(static_cast<unsigned int>(date.day()), out + 8, 2);
+        out[10] = 'T';
+        formatDecimal(static_cast<std::uint64_t>(seconds / 3600), out + 11, 2);
+        out[13] = ':';
+        formatDecimal(static_cast<std::uint64_t>(seconds / 60 % 60), out + 14, 2);
+        out[16] = ':';
+        formatDecimal(static_cast<std::uint64_t>(seconds % 60), out + 17, 2);
+        out[19] = '.';
+        formatDecimal(static_cast<std::uint64_t>(micros % 1000000), out + 20, 6);
+        out[26] = 'Z';
+
+        return out + timestamp_size;
+    }
+
+    //! Parse a decimal number, 8 digits per step
+    /*!
+     * \param text - Digits, without sign or spaces
+     * \param val - Parsed value
+     * \return true iff text is a non empty run of digits whose value fits in 64 bits
+     */
+    inline bool parseDecimal(std::string_view text, std::uint64_t &val) noexcept {
+        // value of 8 digits in a word, the first digit in the lowest byte, false if any byte isn't a digit
+        auto digits8 = [](std::uint64_t chunk, std::uint64_t &value) noexcept {
+            // every byte is 0x30 to 0x39, adding 6 doesn't carry out of the low nibble
+            if ((chunk & 0xf0f0f0f0f0f0f0f0ULL) != 0x3030303030303030ULL ||
+                ((chunk + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL) != 0x3030303030303030ULL)
+                return false;
+
+            // combine digits into pairs, pairs into fours & fours into the 8 digit value
+            chunk -= 0x3030303030303030ULL;
+            chunk = (chunk * 10 + (chunk >> 8)) & 0x00ff00ff00ff00ffULL;
+            chunk = (chunk * 100 + (chunk >> 16)) & 0x0000ffff0000ffffULL;
+            value = (chunk * 10000 + (chunk >> 32)) & 0x00000000ffffffffULL;
+            return true;
+        };
+
+        const char *data = text.data();
+        std::size_t size = text.size();
+
+        // leading zeros don't count towards the 20 digits which may fit
+        while (size > 1 && *data == '0') {
+            ++data;
+            --size;
+        }
+
+        if (size == 0 || size > 20)
+            return false;
+
+        std::uint64_t result = 0;
+        if (size < 8) {
+            for (std::size_t i = 0; i < size; ++i) {
+                unsigned int digit = static_cast<unsigned char>(data[i]) - '0';
+                if (digit > 9)
+                    return false;
+
+                result = result * 10 + digit;
+            }
+
+            val = result;
+            return true;
+        }
+
+        std::uint64_t chunk, value;
+        std::size_t pos = 0;
+        for (; pos + 8 <= size; pos += 8) {
+            std::memcpy(&chunk, data + pos, 8);
+            if (!digits8(chunk, value))
+                return false;
+
+            result = result * 100000000 + value;
+        }
+
+        // the last 8 bytes are loaded again, the digits already parsed are replaced by zeros
+        if (pos < size) {
+            std::size_t rest = size - pos;
+            std::uint64_t parsed = ~0ULL >> (rest * 8);
+            std::memcpy(&chunk, data + size - 8, 8);
+            if (!digits8((chunk & ~parsed) | (0x3030303030303030ULL & parsed), value))
+                return false;
+
+            result = result * powers_of_10[rest] + value;
+        }
+
+        // only 20 digits can overflow, their value wrapped around if they are above the max
+        if (size == 20 && std::string_view(data, size) > "18446744073709551615")
+            return false;
+
+        val = result;
+        return true;
+    }
+
+    //! Parse a hex number, of either case
+    /*!
+     * \param text - Hex digits, without prefix
+     * \param val - Parsed value
+     * \return true iff text is a non empty run of hex digits whose value fits in 64 bits
+     */
+    inline bool parseHex(std::string_view text, std::uint64_t &val) noexcept {
+        if (text.empty())
+            return false;
+
+        std::uint64_t result = 0;
+        for (char c : text) {
+            int digit = hex_values[static_cast<unsigned char>(c)];
+            if (digit < 0 || (result >> 60) != 0)
+                return false;
+
+            result = (result << 4) | static_cast<std::uint64_t>(digit);
+        }
 
-        return {buf + idx, buf_size - idx};
+        val = result;
+        return true;
     }
 
     class CacheView {
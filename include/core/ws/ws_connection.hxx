@@ -0,0 +1,217 @@
+#pragma once
+
+#include "core/http/http_parser.hxx"
+#include "core/http/http_request.hxx"
+#include "core/http/http_response.hxx"
+#include "core/ws/ws_frame.hxx"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CxxServer::Core::Ws {
+
+    //! WebSocket server side of a connection, independent of the transport
+    /*!
+     * Answers the HTTP upgrade request, then parses frames straight from the transport's receive buffer: payloads
+     * are unmasked as they arrive into the message being assembled, so a frame split over several reads isn't
+     * buffered first & fragments are joined without copying them again. Text messages are checked to be UTF-8 once
+     * complete.
+     *
+     * Pings are answered with a pong automatically. A close frame received is answered with one & the transport is
+     * drained & disconnected, a close started with sendClose waits for the peer's answer. Protocol errors close the
+     * connection with the matching close code.
+     *
+     * Thread safe
+     */
+    class Connection {
+    public:
+        Connection() : _open(false), _close_sent(false), _closed(false), _messages(0) {}
+        virtual ~Connection() = default;
+
+        //! Act as getter & setter for the max size of a received message (defaults to 16 MiB)
+        /*!
+         * Note: Messages which would grow past it close the connection with MessageTooBig
+         */
+        size_t &maxMessageSize() noexcept { return _max_message; }
+
+        //! Act as getter & setter for the request size limits of the upgrade request
+        Http::RequestParser::Limits &requestLimits() noexcept { return _parser.limits(); }
+
+        //! Is the handshake done & the connection not closing
+        bool isOpen() const noexcept { return _open && !_close_sent; }
+
+        //! Get # of messages received
+        uint64_t numMessages() const noexcept { return _messages; }
+
+        //! Send a text message
+        /*!
+         * \param text - UTF-8 text
+         * \return true iff the message was queued
+         */
+        bool sendText(std::string_view text) { return sendFrame(Opcode::Text, text.data(), text.size()); }
+
+        //! Send a binary message
+        /*!
+         * \param data - Data
+         * \param size - Data size
+         * \return true iff the message was queued
+         */
+        bool sendBinary(const void *data, size_t size) { return sendFrame(Opcode::Binary, data, size); }
+
+        //! Send a ping
+        /*!
+         * \param payload - Payload echoed by the pong, at most max_control_size bytes
+         * \return true iff the ping was queued
+         */
+        bool sendPing(std::string_view payload = std::string_view());
+
+        //! Send a pong, unsolicited pongs serve as heartbeats
+        /*!
+         * \param payload - Payload, at most max_control_size bytes
+         * \return true iff the pong was queued
+         */
+        bool sendPong(std::string_view payload = std::string_view());
+
+        //! Start the closing handshake, nothing more can be sent after it
+        /*!
+         * \param code - Close code
+         * \param reason - UTF-8 reason, cut to fit a control frame
+         * \return true iff the close was queued
+         */
+        bool sendClose(CloseCode code = CloseCode::Normal, std::string_view reason = std::string_view());
+
+    protected:
+        //! Feed data received by the transport
+        /*!
+         * \param buffer - Received data
+         * \param size - Data size
+         */
+        void receiveData(const void *buffer, size_t size);
+
+        //! The transport disconnected, reports an abnormal close unless closed already
+        void transportDisconnected();
+
+        //! Decide whether to accept an upgrade request
+        /*!
+         * Called once the request is checked to be a valid WebSocket upgrade, e.g. to check its path or origin or to
+         * pick a subprotocol. Accepts by default.
+         * \param request - Upgrade request, only valid during the call
+         * \param response - 101 Switching Protocols response, headers can be added to it
+         * \return true to accept, false to answer 403 Forbidden
+         */
+        virtual bool onUpgrade(const Http::Request &request, Http::Response &response) { return true; }
+
+        //! Handle the connection opening, once the handshake response is queued
+        virtual void onOpen() {}
+
+        //! Handle a message
+        /*!
+         * Note: The data is only valid during the call
+         * \param data - Message data
+         * \param size - Message size
+         * \param text - Is it a text message, valid UTF-8, or a binary one
+         */
+        virtual void onMessage(const void *data, size_t size, bool text) {}
+
+        //! Handle a ping, already answered
+        virtual void onPing(const void *data, size_t size) {}
+
+        //! Handle a pong
+        virtual void onPong(const void *data, size_t size) {}
+
+        //! Handle the connection closing, called once
+        /*!
+         * \param code - Close code received, ours if the connection failed, Abnormal if the transport disconnected
+         *               first
+         * \param reason - Reason received
+         */
+        virtual void onClose(uint16_t code, std::string_view reason) {}
+
+        //! Queue data on the transport
+        virtual bool transportSend(const void *buffer, size_t size) = 0;
+
+        //! Queue data gathered from several buffers on the transport, joins them unless overridden
+        virtual bool transportSendGather(std::initializer_list<std::string_view> buffers);
+
+        //! Disconnect the transport once the queued data is sent
+        virtual bool transportClose() = 0;
+
+    private:
+        // Upgrade
+        Http::RequestParser _parser;
+        Http::Request _request;
+        std::vector<char> _partial;
+
+        std::atomic<bool> _open;
+        // no more frames are sent after a close frame
+        std::atomic<bool> _close_sent;
+        std::atomic<bool> _closed;
+        std::mutex _send_lock;
+        std::string _out;
+
+        size_t _max_message = 16 * 1024 * 1024;
+
+        // Frame being received, its header is gathered first if it is split over several reads
+        uint8_t _header[max_header_size];
+        size_t _header_size = 0;
+        size_t _header_needed = 2;
+        bool _in_payload = false;
+        Opcode _opcode = Opcode::Continuation;
+        bool _fin = false;
+        uint8_t _mask[4] = {};
+        uint64_t _payload_size = 0;
+        uint64_t _payload_received = 0;
+
+        // Message being assembled, Continuation when none is
+        Opcode _message_opcode = Opcode::Continuation;
+        std::vector<char> _message;
+        std::vector<char> _control;
+
+        std::atomic<uint64_t> _messages;
+
+        //! Parse the upgrade request, answering it
+        /*!
+         * \return # of bytes consumed, 0 until the request is complete
+         */
+        size_t receiveUpgrade(const char *data, size_t size);
+
+        //! Answer an upgrade request
+        /*!
+         * \return true iff accepted
+         */
+        bool upgrade(const Http::Request &request);
+
+        //! Refuse an upgrade request & close
+        void refuse(int status, std::string_view headers = std::string_view());
+
+        //! Parse frames
+        void receiveFrames(const char *data, size_t size);
+
+        //! Check the header of a frame once complete
+        /*!
+         * \return false iff the connection failed
+         */
+        bool beginFrame();
+
+        //! Handle a frame once its payload is received
+        void endFrame();
+
+        //! Send a frame
+        bool sendFrame(Opcode opcode, const void *data, size_t size);
+
+        //! Send a close frame, the send lock must be held
+        bool sendCloseFrame(uint16_t code, std::string_view reason);
+
+        //! Fail the connection, sending a close frame with a code
+        void fail(CloseCode code);
+
+        //! Report the close once
+        void closed(uint16_t code, std::string_view reason);
+    };
+}
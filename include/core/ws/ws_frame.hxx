@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//! WebSocket framing (RFC 6455)
+/*!
+ * Masking & UTF-8 validation run over every payload byte received, both are vectorized with the AVX & SSE
+ * instructions the build enables.
+ */
+namespace CxxServer::Core::Ws {
+
+    //! Frame opcodes
+    enum class Opcode : uint8_t {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xa
+    };
+
+    //! Close status codes
+    enum class CloseCode : uint16_t {
+        Normal = 1000,
+        GoingAway = 1001,
+        ProtocolError = 1002,
+        UnsupportedData = 1003,
+        NoStatus = 1005,
+        Abnormal = 1006,
+        InvalidPayload = 1007,
+        PolicyViolation = 1008,
+        MessageTooBig = 1009,
+        InternalError = 1011
+    };
+
+    //! Max size of a frame header
+    constexpr size_t max_header_size = 14;
+
+    //! Max payload size of a control frame
+    constexpr size_t max_control_size = 125;
+
+    //! Is an opcode a control frame's
+    constexpr bool isControl(Opcode opcode) noexcept { return static_cast<uint8_t>(opcode) & 0x8; }
+
+    //! Is a close code valid on the wire
+    constexpr bool isValidCloseCode(uint16_t code) noexcept {
+        return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1014) || (code >= 3000 && code <= 4999);
+    }
+
+    //! Encode a frame header
+    /*!
+     * \param out - Buffer of at least max_header_size bytes
+     * \param opcode - Opcode
+     * \param fin - Is it the last frame of the message
+     * \param size - Payload size
+     * \param mask - Masking key in wire order, nullptr to leave the payload unmasked as servers do
+     * \return Header size
+     */
+    size_t encodeHeader(uint8_t *out, Opcode opcode, bool fin, uint64_t size, const uint8_t *mask = nullptr) noexcept;
+
+    //! Mask or unmask data
+    /*!
+     * XORs the data with the masking key, 32 bytes at a time.
+     * \param out - Output, may be the input
+     * \param data - Input
+     * \param size - Data size
+     * \param mask - Masking key in wire order
+     * \param offset - Offset of the data in the payload, so a payload can be unmasked piece by piece
+     */
+    void mask(void *out, const void *data, size_t size, const uint8_t *mask, uint64_t offset = 0) noexcept;
+
+    //! Check data is valid UTF-8
+    /*!
+     * Checks 16 bytes at a time with the lookup table algorithm of Keiser & Lemire, runs of ASCII are skipped 32
+     * bytes at a time. Overlong encodings, surrogates, code points past U+10FFFF & truncated sequences are invalid.
+     */
+    bool validUtf8(const void *data, size_t size) noexcept;
+
+    inline bool validUtf8(std::string_view text) noexcept { return validUtf8(text.data(), text.size()); }
+
+    //! Get Sec-WebSocket-Accept for a Sec-WebSocket-Key
+    std::string acceptKey(std::string_view key);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "core/tcp/tcp_server.hxx"
+#include "core/ws/ws_session.hxx"
+
+#include <memory>
+
+namespace CxxServer::Core::Ws {
+
+    //! WebSocket server
+    /*!
+     * TCP server whose sessions upgrade to WebSocket, override newSession to create sessions which handle messages.
+     *
+     * Thread safe
+     */
+    class Server : public Tcp::Server {
+    public:
+        using Tcp::Server::Server;
+        virtual ~Server() = default;
+
+    protected:
+        std::shared_ptr<Tcp::Session> newSession(const std::shared_ptr<Tcp::Server> &server) override { return std::make_shared<Session>(server); }
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "core/tcp/tcp_session.hxx"
+#include "core/ws/ws_connection.hxx"
+
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+
+namespace CxxServer::Core::Ws {
+
+    //! WebSocket session over a transport session
+    /*!
+     * Feeds the transport's receive buffer to the WebSocket connection & sends frames on the transport. Subclass to
+     * handle messages in onMessage.
+     *
+     * Note: Subclasses overriding onReceive or onDisconnect must call the base implementation
+     *
+     * Thread safe
+     */
+    template<typename Base>
+    class BasicSession : public Base, public Connection {
+    public:
+        using Base::Base;
+        virtual ~BasicSession() = default;
+
+    protected:
+        void onReceive(const void *buffer, size_t size) override { receiveData(buffer, size); }
+        void onDisconnect() override { transportDisconnected(); }
+
+        bool transportSend(const void *buffer, size_t size) override { return this->sendAsync(buffer, size); }
+        bool transportSendGather(std::initializer_list<std::string_view> buffers) override { return this->sendGather(buffers); }
+        bool transportClose() override { return this->drain(); }
+    };
+
+    //! WebSocket session over TCP
+    using Session = BasicSession<Tcp::Session>;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "core/tcp/ssl_server.hxx"
+#include "core/ws/wss_session.hxx"
+
+#include <memory>
+
+namespace CxxServer::Core::Wss {
+
+    //! Secure WebSocket server
+    /*!
+     * SSL server whose sessions upgrade to WebSocket once handshaked, override newSession to create sessions which
+     * handle messages.
+     *
+     * Thread safe
+     */
+    class Server : public SSL::Server {
+    public:
+        using SSL::Server::Server;
+        virtual ~Server() = default;
+
+    protected:
+        std::shared_ptr<Tcp::Session> newSession(const std::shared_ptr<Tcp::Server> &server) override { return std::make_shared<Session>(server, context()); }
+    };
+}
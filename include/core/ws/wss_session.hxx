@@ -0,0 +1,10 @@
+#pragma once
+
+#include "core/tcp/ssl_session.hxx"
+#include "core/ws/ws_session.hxx"
+
+namespace CxxServer::Core::Wss {
+
+    //! WebSocket session over SSL
+    using Session = Ws::BasicSession<SSL::Session>;
+}
@@ -0,0 +1,142 @@
+#include "cxxopts.hpp"
+#include <core/util.hxx>
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Utils = CxxServer::Core::Utils;
+
+// Formats a digit per step, as fastItoa used to
+std::string_view digitLoop(uint64_t val, char *buf, size_t buf_size) {
+    size_t idx = buf_size;
+    do {
+        buf[--idx] = '0' + (val % 10);
+        val /= 10;
+    } while (val > 0);
+
+    return {buf + idx, buf_size - idx};
+}
+
+// Runs a benchmark over every value, printing ns/op
+template<typename Op>
+void run(const std::string &name, const std::vector<uint64_t> &values, unsigned int rounds, Op op) {
+    size_t check = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int round = 0; round < rounds; ++round) {
+        for (uint64_t value : values)
+            check += op(value);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout<<name<<": "<<(static_cast<double>(elapsed) / (static_cast<double>(values.size()) * rounds))<<" ns/op (check "<<check<<")"<<std::endl;
+}
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("Format", "Number & timestamp formatting microbenchmark against std::to_chars");
+
+    options.add_options()
+        ("n,values", "Number of random values, defaults to 100000", cxxopts::value<unsigned int>()->default_value("100000"))
+        ("r,rounds", "Number of rounds over the values, defaults to 100", cxxopts::value<unsigned int>()->default_value("100"));
+
+    auto parser = options.parse(argc, argv);
+
+    if (parser.count("help")) {
+        std::cout<<options.help()<<std::endl;
+        exit(0);
+    }
+
+    unsigned int num_values = parser["values"].as<unsigned int>();
+    unsigned int rounds = parser["rounds"].as<unsigned int>();
+
+    std::cout<<"Values: "<<num_values<<std::endl;
+    std::cout<<"Rounds: "<<rounds<<std::endl;
+
+    std::cout<<std::endl;
+
+    // lengths & counters are mostly small, sizes spread over every magnitude
+    std::mt19937_64 random(42);
+    std::vector<uint64_t> small, mixed;
+    for (unsigned int i = 0; i < num_values; ++i) {
+        small.push_back(random() % 100000);
+        mixed.push_back(random() >> (random() % 64));
+    }
+
+    std::vector<std::string> decimals, hexes;
+    for (uint64_t value : mixed) {
+        char buf[32];
+        decimals.emplace_back(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);
+        hexes.emplace_back(buf, std::to_chars(buf, buf + sizeof(buf), value, 16).ptr);
+    }
+
+    char buf[64];
+
+    for (const auto &[set, values] : { std::make_pair("small", &small), std::make_pair("mixed", &mixed) }) {
+        std::string prefix = std::string("decimal ") + set;
+        run(prefix + " digit loop", *values, rounds, [&](uint64_t value) { return digitLoop(value, buf, sizeof(buf)).size(); });
+        run(prefix + " std::to_chars", *values, rounds, [&](uint64_t value) { return static_cast<size_t>(std::to_chars(buf, buf + sizeof(buf), value).ptr - buf); });
+        run(prefix + " formatDecimal", *values, rounds, [&](uint64_t value) { return static_cast<size_t>(Utils::formatDecimal(value, buf) - buf); });
+    }
+
+    std::cout<<std::endl;
+
+    run("hex std::to_chars", mixed, rounds, [&](uint64_t value) { return static_cast<size_t>(std::to_chars(buf, buf + sizeof(buf), value, 16).ptr - buf); });
+    run("hex formatHex", mixed, rounds, [&](uint64_t value) { return static_cast<size_t>(Utils::formatHex(value, buf) - buf); });
+    run("hex formatHex16", mixed, rounds, [&](uint64_t value) { return static_cast<size_t>(Utils::formatHex16(value, buf) - buf); });
+
+    std::cout<<std::endl;
+
+    std::vector<uint64_t> indexes(num_values);
+    for (unsigned int i = 0; i < num_values; ++i)
+        indexes[i] = i;
+
+    run("parse decimal std::from_chars", indexes, rounds, [&](uint64_t i) {
+        uint64_t value = 0;
+        std::from_chars(decimals[i].data(), decimals[i].data() + decimals[i].size(), value);
+        return static_cast<size_t>(value);
+    });
+    run("parse decimal parseDecimal", indexes, rounds, [&](uint64_t i) {
+        uint64_t value = 0;
+        Utils::parseDecimal(decimals[i], value);
+        return static_cast<size_t>(value);
+    });
+    run("parse hex std::from_chars", indexes, rounds, [&](uint64_t i) {
+        uint64_t value = 0;
+        std::from_chars(hexes[i].data(), hexes[i].data() + hexes[i].size(), value, 16);
+        return static_cast<size_t>(value);
+    });
+    run("parse hex parseHex", indexes, rounds, [&](uint64_t i) {
+        uint64_t value = 0;
+        Utils::parseHex(hexes[i], value);
+        return static_cast<size_t>(value);
+    });
+
+    std::cout<<std::endl;
+
+    // microsecond timestamps spread over a few years
+    std::vector<uint64_t> times;
+    for (unsigned int i = 0; i < num_values; ++i)
+        times.push_back(1700000000000000ULL + random() % 100000000000000ULL);
+
+    run("timestamp strftime", times, rounds, [&](uint64_t micros) {
+        std::time_t seconds = static_cast<std::time_t>(micros / 1000000);
+        std::tm tm{};
+        gmtime_r(&seconds, &tm);
+        size_t size = std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+        return size + static_cast<size_t>(std::snprintf(buf + size, sizeof(buf) - size, ".%06uZ", static_cast<unsigned int>(micros % 1000000)));
+    });
+    run("timestamp formatTimestamp", times, rounds, [&](uint64_t micros) {
+        auto time = std::chrono::system_clock::time_point(std::chrono::microseconds(micros));
+        return static_cast<size_t>(Utils::formatTimestamp(time, buf) - buf);
+    });
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "cxxopts.hpp"
+#include <core/tcp/tcp_client.hxx>
+#include <core/service.hxx>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+std::string to_send;
+
+std::atomic<uint64_t> completed = 0;
+std::atomic<uint64_t> latency_total = 0;
+std::atomic<uint64_t> num_errors = 0;
+std::atomic<bool> running = false;
+
+// Keeps a fixed # of keep-alive requests in flight, each response sends the next request like wrk
+class HttpClient : public CxxServer::Core::Tcp::Client {
+public:
+    using CxxServer::Core::Tcp::Client::Client;
+
+    void sendRequest() {
+        if (!running)
+            return;
+
+        {
+            std::scoped_lock lock(_lock);
+            _sent.push_back(std::chrono::high_resolution_clock::now());
+        }
+
+        sendAsync(to_send);
+    }
+
+    size_t numInFlight() {
+        std::scoped_lock lock(_lock);
+        return _sent.size();
+    }
+
+protected:
+    void onReceive(const void *buffer, size_t size) override {
+        _received.append(static_cast<const char*>(buffer), size);
+
+        // responses are framed by the end of their headers & Content-Length
+        size_t offset = 0;
+        while (true) {
+            std::string_view rest(_received.data() + offset, _received.size() - offset);
+            size_t end = rest.find("\r\n\r\n");
+            if (end == std::string_view::npos)
+                break;
+
+            size_t length = 0;
+            size_t header = rest.substr(0, end).find("Content-Length: ");
+            if (header != std::string_view::npos)
+                length = std::stoul(std::string(rest.substr(header + 16, 20)));
+
+            if (rest.size() < end + 4 + length)
+                break;
+
+            offset += end + 4 + length;
+            if (rest.substr(0, 12) != "HTTP/1.1 200")
+                ++num_errors;
+
+            std::chrono::high_resolution_clock::time_point sent;
+            {
+                std::scoped_lock lock(_lock);
+                sent = _sent.front();
+                _sent.pop_front();
+            }
+
+            latency_total += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - sent).count();
+            ++completed;
+            sendRequest();
+        }
+
+        _received.erase(0, offset);
+    }
+
+    void onErr(int error, const std::string &category, const std::string &message) override {
+        std::cerr<<"[x] "<<message<<"("<<category<<"): "<<error<<std::endl;
+        ++num_errors;
+    }
+
+private:
+    std::string _received;
+    std::mutex _lock;
+    std::deque<std::chrono::high_resolution_clock::time_point> _sent;
+};
+
+int main(int argc, char **argv) {
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    cxxopts::Options options("HTTP client", "Keep-alive HTTP load generator for benchmarking requests/s & latency");
+
+    options.add_options()
+        ("a,address", "Address of server, default to 127.0.0.1", cxxopts::value<std::string>()->default_value("127.0.0.1"))
+        ("p,port", "Port of server to connect to, defaults to 8080", cxxopts::value<unsigned int>()->default_value("8080"))
+        ("t,threads", "Number of working threads, defaults to number of physical cores", cxxopts::value<unsigned int>()->default_value(std::to_string(num_cores)))
+        ("c,connections", "Number of connections, defaults to 100", cxxopts::value<unsigned int>()->default_value("100"))
+        ("d,depth", "Requests in flight per connection, defaults to 1", cxxopts::value<unsigned int>()->default_value("1"))
+        ("u,path", "Path to request, defaults to /", cxxopts::value<std::string>()->default_value("/"))
+        ("z,seconds", "Number of seconds to run, defaults to 10 seconds", cxxopts::value<unsigned int>()->default_value("10"));
+
+    auto parser = options.parse(argc, argv);
+
+    if (parser.count("help")) {
+        std::cout<<options.help()<<std::endl;
+        exit(0);
+    }
+
+    std::string addr = parser["address"].as<std::string>();
+    unsigned int port = parser["port"].as<unsigned int>();
+    unsigned int threads = parser["threads"].as<unsigned int>();
+    unsigned int num_connections = parser["connections"].as<unsigned int>();
+    unsigned int depth = parser["depth"].as<unsigned int>();
+    std::string path = parser["path"].as<std::string>();
+    unsigned int seconds = parser["seconds"].as<unsigned int>();
+
+    std::cout<<"Server address: "<<addr<<std::endl;
+    std::cout<<"Server port: "<<port<<std::endl;
+    std::cout<<"Number of Threads: "<<threads<<std::endl;
+    std::cout<<"Number of Connections: "<<num_connections<<std::endl;
+    std::cout<<"Pipeline Depth: "<<depth<<std::endl;
+    std::cout<<"Path: "<<path<<std::endl;
+    std::cout<<"Seconds: "<<seconds<<std::endl;
+
+    std::cout<<std::endl;
+
+    to_send = "GET " + path + " HTTP/1.1\r\nHost: " + addr + "\r\nUser-Agent: CxxServer\r\nAccept: */*\r\n\r\n";
+
+    auto service = std::make_shared<CxxServer::Core::Service>(threads);
+
+    std::cout<<"Starting service... ";
+    service->start();
+    std::cout<<"done"<<std::endl;
+
+    std::vector<std::shared_ptr<HttpClient>> clients;
+    for (unsigned int i = 0; i < num_connections; ++i) {
+        clients.push_back(std::make_shared<HttpClient>(service, addr, port));
+        clients.back()->isNoDelay() = true;
+    }
+
+    std::cout<<"Connecting clients... ";
+    for (auto &c : clients)
+        c->connectAsync();
+
+    for (const auto &c : clients)
+        while (!c->isReady())
+            std::this_thread::yield();
+    std::cout<<"done"<<std::endl;
+
+    std::cout<<std::endl;
+
+    running = true;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto &c : clients)
+        for (unsigned int i = 0; i < depth; ++i)
+            c->sendRequest();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    uint64_t done = completed;
+    uint64_t latency = latency_total;
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    // let the requests still in flight drain before disconnecting
+    running = false;
+    for (const auto &c : clients)
+        while (c->numInFlight() > 0 && c->isConnected())
+            std::this_thread::yield();
+
+    std::cout<<"Requests: "<<done<<std::endl;
+    std::cout<<"Requests/s: "<<(done * 1000000000 / elapsed)<<std::endl;
+    if (done > 0)
+        std::cout<<"Average latency: "<<(latency / done)<<" ns"<<std::endl;
+
+    std::cout<<std::endl;
+
+    std::cout<<"Disconnecting clients... ";
+    for (auto &c : clients)
+        c->disconnectAsync();
+
+    for (const auto &c : clients)
+        while (c->isConnected())
+            std::this_thread::yield();
+    std::cout<<"done"<<std::endl;
+
+    std::cout << "Stopping IO service... ";
+    service->stop();
+    std::cout << "done" << std::endl;
+
+    std::cout << "Errors: " << num_errors << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "cxxopts.hpp"
+#include <core/http/http_router.hxx>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Http = CxxServer::Core::Http;
+
+// Allocations are counted to show lookups don't allocate
+std::atomic<uint64_t> allocations = 0;
+
+void *operator new(size_t size) {
+    ++allocations;
+    if (void *ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+// Matches a path against every pattern in turn, segment by segment
+size_t linearMatch(const std::vector<std::string> &patterns, std::string_view path, Http::RouteParams &params) {
+    for (size_t route = 0; route < patterns.size(); ++route) {
+        std::string_view pattern = patterns[route];
+        std::string_view rest = path;
+        bool matched = true;
+
+        while (matched && !pattern.empty() && !rest.empty()) {
+            auto segment = pattern.substr(0, pattern.find('/', 1));
+            auto value = rest.substr(0, rest.find('/', 1));
+
+            if (segment.size() > 1 && segment[1] == '*') {
+                rest = std::string_view();
+                pattern = std::string_view();
+                break;
+            }
+
+            matched = (segment.size() > 1 && segment[1] == ':') ? value.size() > 1 : segment == value;
+            pattern.remove_prefix(segment.size());
+            rest.remove_prefix(value.size());
+        }
+
+        if (matched && pattern.empty() && rest.empty())
+            return route;
+    }
+
+    return static_cast<size_t>(-1);
+}
+
+// Looks up every path, printing ns/lookup & allocations/lookup
+template<typename Lookup>
+void run(const std::string &name, const std::vector<std::string> &paths, unsigned int rounds, Lookup lookup) {
+    size_t found = 0;
+    uint64_t allocated = allocations;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int round = 0; round < rounds; ++round) {
+        for (const auto &path : paths)
+            found += lookup(path);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    double lookups = static_cast<double>(paths.size()) * rounds;
+    std::cout<<name<<": "<<(static_cast<double>(elapsed) / lookups)<<" ns/lookup, "
+             <<(static_cast<double>(allocations - allocated) / lookups)<<" allocations/lookup, "
+             <<found<<" found"<<std::endl;
+}
+
+// A fixed API known at compile time
+constexpr Http::RouteSpec api_routes[] = {
+    { "GET", "/health" },
+    { "GET", "/metrics" },
+    { "GET", "/users" },
+    { "POST", "/users" },
+    { "GET", "/users/:id" },
+    { "PUT", "/users/:id" },
+    { "DELETE", "/users/:id" },
+    { "GET", "/users/:id/orders" },
+    { "GET", "/users/:id/orders/:order" },
+    { "GET", "/orders/:order/items/:item" },
+    { "GET", "/static/*path" }
+};
+constexpr Http::RouteTable api_table(api_routes);
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("HTTP router", "HTTP router lookup microbenchmark over thousands of routes");
+
+    options.add_options()
+        ("r,routes", "Number of routes, defaults to 5000", cxxopts::value<unsigned int>()->default_value("5000"))
+        ("n,lookups", "Number of lookups per round, defaults to 100000", cxxopts::value<unsigned int>()->default_value("100000"))
+        ("i,rounds", "Number of rounds, defaults to 10", cxxopts::value<unsigned int>()->default_value("10"));
+
+    auto parser = options.parse(argc, argv);
+
+    if (parser.count("help")) {
+        std::cout<<options.help()<<std::endl;
+        exit(0);
+    }
+
+    unsigned int num_routes = parser["routes"].as<unsigned int>();
+    unsigned int num_lookups = parser["lookups"].as<unsigned int>();
+    unsigned int rounds = parser["rounds"].as<unsigned int>();
+
+    std::cout<<"Routes: "<<num_routes<<std::endl;
+    std::cout<<"Lookups: "<<num_lookups<<std::endl;
+    std::cout<<"Rounds: "<<rounds<<std::endl;
+
+    std::cout<<std::endl;
+
+    // REST style resources, each with a collection, an item, a nested item & static files
+    std::vector<std::string> patterns;
+    for (unsigned int i = 0; patterns.size() < num_routes; ++i) {
+        std::string resource = "/api/v" + std::to_string(i % 3 + 1) + "/resource" + std::to_string(i);
+        for (auto pattern : { resource, resource + "/:id", resource + "/:id/items/:item", "/static/resource" + std::to_string(i) + "/*path" }) {
+            if (patterns.size() < num_routes)
+                patterns.push_back(pattern);
+        }
+    }
+
+    Http::Router router;
+    for (const auto &pattern : patterns)
+        router.add("GET", pattern, [](Http::Connection &, const Http::Request &, const Http::RouteParams &) {});
+
+    // concrete paths of random routes
+    std::mt19937 random(42);
+    auto concrete = [&random](std::string pattern) {
+        for (size_t pos = pattern.find_first_of(":*"); pos != std::string::npos; pos = pattern.find_first_of(":*", pos)) {
+            size_t end = pattern.find('/', pos);
+            pattern.replace(pos, end == std::string::npos ? std::string::npos : end - pos, std::to_string(random() % 100000));
+        }
+
+        return pattern;
+    };
+
+    std::vector<std::string> paths;
+    for (unsigned int i = 0; i < num_lookups; ++i)
+        paths.push_back(concrete(patterns[random() % patterns.size()]));
+
+    Http::RouteParams params;
+    run("radix tree", paths, rounds, [&](const std::string &path) { return router.find("GET", path, params) != nullptr; });
+
+    // the linear baseline is slow, a fraction of the lookups is enough
+    std::vector<std::string> few(paths.begin(), paths.begin() + std::min<size_t>(paths.size(), 2000));
+    run("linear", few, 1, [&](const std::string &path) { return linearMatch(patterns, path, params) != static_cast<size_t>(-1); });
+
+    std::cout<<std::endl;
+
+    Http::Router api_router;
+    for (const auto &route : api_routes)
+        api_router.add(route.method, route.pattern, [](Http::Connection &, const Http::Request &, const Http::RouteParams &) {});
+
+    std::vector<std::pair<std::string, std::string>> requests;
+    for (unsigned int i = 0; i < num_lookups; ++i) {
+        const auto &route = api_routes[random() % api_table.size()];
+        requests.emplace_back(route.method, concrete(std::string(route.pattern)));
+    }
+
+    std::vector<std::string> indexes;
+    for (size_t i = 0; i < requests.size(); ++i)
+        indexes.push_back(std::to_string(i));
+
+    size_t idx = 0;
+    run("fixed API radix tree", indexes, rounds, [&](const std::string &) {
+        const auto &[method, path] = requests[idx++ % requests.size()];
+        return api_router.find(method, path, params) != nullptr;
+    });
+    run("fixed API compile time table", indexes, rounds, [&](const std::string &) {
+        const auto &[method, path] = requests[idx++ % requests.size()];
+        return api_table.find(method, path, params) != api_table.npos;
+    });
+
+    return 0;
+}
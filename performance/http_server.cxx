@@ -0,0 +1,117 @@
+#include "core/service.hxx"
+#include "core/http/http_date.hxx"
+#include "core/http/http_server.hxx"
+#include "core/http/http_session.hxx"
+
+#include <cstdlib>
+#include <cxxopts.hpp>
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+// Answers every request with a fixed body, the common headers pre-serialized
+class HelloSession : public CxxServer::Core::Http::Session {
+public:
+    HelloSession(const std::shared_ptr<CxxServer::Core::Tcp::Server> &server) : CxxServer::Core::Http::Session(server) { dateHeader() = true; }
+
+protected:
+    void onRequest(const CxxServer::Core::Http::Request &request) override {
+        static const auto headers = CxxServer::Core::Http::HeaderBlock().header("Server", "CxxServer").header("Content-Type", "text/plain");
+
+        _response.clear();
+        _response.headers(headers).body("Hello, World!");
+        sendResponse(_response);
+    }
+
+    void onErr(int error, const std::string &category, const std::string &message) override {
+        std::cerr<<"[x] "<<message<<"("<<category<<"): "<<error<<std::endl;
+    }
+
+private:
+    CxxServer::Core::Http::Response _response;
+};
+
+class HelloServer : public CxxServer::Core::Http::Server {
+public:
+    using CxxServer::Core::Http::Server::Server;
+
+protected:
+    std::shared_ptr<CxxServer::Core::Tcp::Session> newSession(const std::shared_ptr<CxxServer::Core::Tcp::Server> &server) override {
+        return std::make_shared<HelloSession>(server);
+    }
+
+    void onErr(int error, const std::string &category, const std::string &message) override {
+        std::cerr<<"[x] "<<message<<"("<<category<<"): "<<error<<std::endl;
+    }
+};
+
+int main(int argc, char **argv) {
+
+    long num_threads_default = sysconf(_SC_NPROCESSORS_ONLN);
+
+    cxxopts::Options options("HTTP Server", "Hello world HTTP server for request throughput benchmarking");
+
+    options.add_options()
+        ("p,port", "Port to bind to", cxxopts::value<unsigned int>()->default_value("8080"))
+        ("t,threads", "Number of work threads", cxxopts::value<unsigned int>()->default_value(std::to_string(num_threads_default)));
+
+    auto parsed = options.parse(argc, argv);
+
+    if (parsed.count("help")) {
+        std::cout<<options.help()<<std::endl;
+        exit(0);
+    }
+
+    unsigned int port = parsed["port"].as<unsigned int>();
+    unsigned int num_threads = parsed["threads"].as<unsigned int>();
+
+    std::cout<<"Port: "<<port<<std::endl;
+    std::cout<<"Num threads: "<<num_threads<<std::endl;
+
+    std::cout<<std::endl;
+
+    std::cout<<"Starting IO service... ";
+    auto service = std::make_shared<CxxServer::Core::Service>(num_threads);
+    service->start();
+    std::cout<<"done"<<std::endl;
+
+    auto date_timer = std::make_shared<CxxServer::Core::Http::DateTimer>(service);
+    date_timer->start();
+
+    std::cout<<"Starting server... ";
+    auto server = std::make_shared<HelloServer>(service, port);
+    server->reusePort() = true;
+    server->reuseAddress() = true;
+    server->noDelay() = true;
+    server->start();
+    std::cout<<"done"<<std::endl;
+
+    std::cout<<"Press enter to stop, or \"!\" to restart the server"<<std::endl;
+    std::string line;
+    while(std::getline(std::cin, line)) {
+        if (line.empty())
+            break;
+
+        if (line != "!")
+            continue;
+
+        std::cout<<"Restarting server... ";
+        server->restart();
+        std::cout<<"done"<<std::endl;
+    }
+
+    std::cout<<"Stopping server... ";
+    server->stop();
+    std::cout<<"done"<<std::endl;
+
+    date_timer->stop();
+
+    std::cout<<"Stopping service... ";
+    service->stop();
+    std::cout<<"done"<<std::endl;
+
+    return 0;
+}
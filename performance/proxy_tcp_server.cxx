@@ -0,0 +1,192 @@
+#include "core/service.hxx"
+#include "core/tcp/tcp_client.hxx"
+#include "core/tcp/tcp_proxy.hxx"
+#include "core/tcp/tcp_session.hxx"
+#include "core/tcp/tcp_server.hxx"
+
+#include <cstdlib>
+#include <cxxopts.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Naive proxy for comparison, every chunk is copied through user space into the other side's send buffer
+class CopySession;
+
+class CopyClient : public CxxServer::Core::Tcp::Client {
+public:
+    CopyClient(const std::shared_ptr<CxxServer::Core::Service> &service, const std::string &addr, unsigned int port, const std::shared_ptr<CopySession> &session)
+        : Client(service, addr, port), _session(session) {}
+
+protected:
+    void onConnect() override;
+    void onDisconnect() override;
+    void onReceive(const void *buffer, size_t size) override;
+    void onErr(int error, const std::string &category, const std::string &message) override {
+        std::cerr<<"[x] "<<message<<"("<<category<<"): "<<error<<std::endl;
+    }
+
+private:
+    std::weak_ptr<CopySession> _session;
+};
+
+class CopySession : public CxxServer::Core::Tcp::Session {
+public:
+    CopySession(const std::shared_ptr<CxxServer::Core::Tcp::Server> &server, const std::string &addr, unsigned int port)
+        : Session(server), _service(server->service()), _addr(addr), _port(port) {}
+
+    // forward data received before the backend connected
+    void flushPending() {
+        std::scoped_lock locker(_lock);
+        if (!_pending.empty())
+            _backend->sendAsync(_pending.data(), _pending.size());
+
+        _pending.clear();
+    }
+
+protected:
+    void onConnect() override {
+        auto self = std::static_pointer_cast<CopySession>(shared_from_this());
+        _backend = std::make_shared<CopyClient>(_service, _addr, _port, self);
+        _backend->connectAsync();
+    }
+
+    void onDisconnect() override { _backend->disconnectAsync(); }
+
+    void onReceive(const void *buffer, size_t size) override {
+        std::scoped_lock locker(_lock);
+        if (_backend->isReady() && _pending.empty()) {
+            _backend->sendAsync(buffer, size);
+            return;
+        }
+
+        auto bytes = static_cast<const uint8_t*>(buffer);
+        _pending.insert(_pending.end(), bytes, bytes + size);
+    }
+
+    void onErr(int error, const std::string &category, const std::string &message) override {
+        std::cerr<<"[x] "<<message<<"("<<category<<"): "<<error<<std::endl;
+    }
+
+private:
+    std::shared_ptr<CxxServer::Core::Service> _service;
+    std::string _addr;
+    unsigned int _port;
+
+    std::shared_ptr<CopyClient> _backend;
+    std::mutex _lock;
+    std::vector<uint8_t> _pending;
+};
+
+void CopyClient::onConnect() {
+    if (auto session = _session.lock())
+        session->flushPending();
+}
+
+void CopyClient::onDisconnect() {
+    if (auto session = _session.lock())
+        session->disconnect();
+}
+
+void CopyClient::onReceive(const void *buffer, size_t size) {
+    if (auto session = _session.lock())
+        session->sendAsync(buffer, size);
+}
+
+class CopyServer : public CxxServer::Core::Tcp::Server {
+public:
+    CopyServer(const std::shared_ptr<CxxServer::Core::Service> &service, unsigned int port, const std::string &addr, unsigned int backend_port)
+        : Server(service, port), _addr(addr), _port(backend_port) {}
+
+protected:
+    std::shared_ptr<CxxServer::Core::Tcp::Session> newSession(const std::shared_ptr<CxxServer::Core::Tcp::Server> &server) override {
+        return std::make_shared<CopySession>(server, _addr, _port);
+    }
+
+    void onErr(int error, const std::string &category, const std::string &message) override {
+        std::cerr<<"[x] "<<message<<"("<<category<<"): "<<error<<std::endl;
+    }
+
+private:
+    std::string _addr;
+    unsigned int _port;
+};
+
+int main(int argc, char **argv) {
+
+    long num_threads_default = sysconf(_SC_NPROCESSORS_ONLN);
+
+    cxxopts::Options options("Proxy Server", "TCP proxy for throughput benchmarking, run an echo server as the backend & an echo client against the proxy");
+
+    options.add_options()
+        ("p,port", "Port to bind to", cxxopts::value<unsigned int>()->default_value("1112"))
+        ("a,backend-address", "Address of the backend", cxxopts::value<std::string>()->default_value("127.0.0.1"))
+        ("b,backend-port", "Port of the backend", cxxopts::value<unsigned int>()->default_value("1111"))
+        ("m,mode", "Proxy mode, splice or copy", cxxopts::value<std::string>()->default_value("splice"))
+        ("t,threads", "Number of work threads", cxxopts::value<unsigned int>()->default_value(std::to_string(num_threads_default)));
+
+    auto parsed = options.parse(argc, argv);
+
+    if (parsed.count("help")) {
+        std::cout<<options.help()<<std::endl;
+        exit(0);
+    }
+
+    unsigned int port = parsed["port"].as<unsigned int>();
+    std::string backend_addr = parsed["backend-address"].as<std::string>();
+    unsigned int backend_port = parsed["backend-port"].as<unsigned int>();
+    std::string mode = parsed["mode"].as<std::string>();
+    unsigned int num_threads = parsed["threads"].as<unsigned int>();
+
+    if (mode != "splice" && mode != "copy") {
+        std::cerr<<"Unknown mode: "<<mode<<std::endl;
+        exit(1);
+    }
+
+    std::cout<<"Port: "<<port<<std::endl;
+    std::cout<<"Backend: "<<backend_addr<<":"<<backend_port<<std::endl;
+    std::cout<<"Mode: "<<mode<<std::endl;
+    std::cout<<"Num threads: "<<num_threads<<std::endl;
+
+    std::cout<<std::endl;
+
+    std::cout<<"Starting IO service... ";
+    auto service = std::make_shared<CxxServer::Core::Service>(num_threads);
+    service->start();
+    std::cout<<"done"<<std::endl;
+
+    std::cout<<"Starting proxy... ";
+    std::shared_ptr<CxxServer::Core::Tcp::Server> server;
+    if (mode == "splice")
+        server = std::make_shared<CxxServer::Core::Tcp::ProxyServer>(service, port, backend_addr, backend_port);
+    else
+        server = std::make_shared<CopyServer>(service, port, backend_addr, backend_port);
+
+    server->reusePort() = true;
+    server->reuseAddress() = true;
+    server->start();
+    std::cout<<"done"<<std::endl;
+
+    std::cout<<"Press enter to stop"<<std::endl;
+    std::string line;
+    std::getline(std::cin, line);
+
+    std::cout<<"Proxied to backend: "<<server->numBytesReceived()<<" bytes"<<std::endl;
+    std::cout<<"Proxied to clients: "<<server->numBytesSent()<<" bytes"<<std::endl;
+
+    std::cout<<"Stopping proxy... ";
+    server->stop();
+    std::cout<<"done"<<std::endl;
+
+    std::cout<<"Stopping service... ";
+    service->stop();
+    std::cout<<"done"<<std::endl;
+
+    return 0;
+}
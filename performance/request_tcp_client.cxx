@@ -0,0 +1,167 @@
+#include "cxxopts.hpp"
+#include <core/tcp/request_client.hxx>
+#include <core/service.hxx>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+std::vector<uint8_t> to_send;
+
+std::atomic<uint64_t> completed = 0;
+std::atomic<uint64_t> latency_total = 0;
+std::atomic<uint64_t> num_errors = 0;
+std::atomic<bool> running = false;
+
+// Keeps a fixed # of requests in flight, each response sends the next request
+class PipelinedClient : public CxxServer::Core::Tcp::RequestClient {
+public:
+    using RequestClient::RequestClient;
+
+    void sendRequest() {
+        if (!running)
+            return;
+
+        auto sent = std::chrono::high_resolution_clock::now();
+        auto self = std::static_pointer_cast<PipelinedClient>(shared_from_this());
+        request(to_send.data(), to_send.size(), [self, sent](std::error_code err, const void *response, size_t size) {
+            if (err) {
+                ++num_errors;
+                return;
+            }
+
+            latency_total += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - sent).count();
+            ++completed;
+            self->sendRequest();
+        });
+    }
+
+protected:
+    void onErr(int error, const std::string &category, const std::string &message) override {
+        std::cerr<<"[x] "<<message<<"("<<category<<"): "<<error<<std::endl;
+        ++num_errors;
+    }
+};
+
+int main(int argc, char **argv) {
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    cxxopts::Options options("Request client", "Pipelined request client for benchmarking requests/s at varying pipeline depths against an echo server");
+
+    options.add_options()
+        ("a,address", "Address of server, default to 127.0.0.1", cxxopts::value<std::string>()->default_value("127.0.0.1"))
+        ("p,port", "Port of server to connect to, defaults to 1111", cxxopts::value<unsigned int>()->default_value("1111"))
+        ("t,threads", "Number of working threads, defaults to number of physical cores", cxxopts::value<unsigned int>()->default_value(std::to_string(num_cores)))
+        ("c,clients", "Number of working clients, defaults to 1", cxxopts::value<unsigned int>()->default_value("1"))
+        ("d,depths", "Comma separated pipeline depths to run, defaults to 1,8,64,256", cxxopts::value<std::string>()->default_value("1,8,64,256"))
+        ("s,size", "Request payload size, defaults to 32 bytes", cxxopts::value<unsigned int>()->default_value("32"))
+        ("z,seconds", "Number of seconds to run each depth, defaults to 5 seconds", cxxopts::value<unsigned int>()->default_value("5"));
+
+    auto parser = options.parse(argc, argv);
+
+    if (parser.count("help")) {
+        std::cout<<options.help()<<std::endl;
+        exit(0);
+    }
+
+    std::string addr = parser["address"].as<std::string>();
+    unsigned int port = parser["port"].as<unsigned int>();
+    unsigned int threads = parser["threads"].as<unsigned int>();
+    unsigned int num_clients = parser["clients"].as<unsigned int>();
+    std::string depths_list = parser["depths"].as<std::string>();
+    unsigned int msg_size = parser["size"].as<unsigned int>();
+    unsigned int seconds = parser["seconds"].as<unsigned int>();
+
+    std::vector<unsigned int> depths;
+    std::istringstream depths_stream(depths_list);
+    for (std::string depth; std::getline(depths_stream, depth, ',');)
+        depths.push_back(std::stoul(depth));
+
+    std::cout<<"Server address: "<<addr<<std::endl;
+    std::cout<<"Server port: "<<port<<std::endl;
+    std::cout<<"Number of Threads: "<<threads<<std::endl;
+    std::cout<<"Number of Clients: "<<num_clients<<std::endl;
+    std::cout<<"Pipeline Depths: "<<depths_list<<std::endl;
+    std::cout<<"Request Size (bytes): "<<msg_size<<std::endl;
+    std::cout<<"Seconds per Depth: "<<seconds<<std::endl;
+
+    std::cout<<std::endl;
+
+    to_send.resize(msg_size, 0);
+
+    auto service = std::make_shared<CxxServer::Core::Service>(threads);
+
+    std::cout<<"Starting service... ";
+    service->start();
+    std::cout<<"done"<<std::endl;
+
+    std::vector<std::shared_ptr<PipelinedClient>> clients;
+    for (unsigned int i = 0; i < num_clients; ++i)
+        clients.push_back(std::make_shared<PipelinedClient>(service, addr, port));
+
+    std::cout<<"Connecting clients... ";
+    for (auto &c : clients)
+        c->connectAsync();
+
+    for (const auto &c : clients)
+        while (!c->isReady())
+            std::this_thread::yield();
+    std::cout<<"done"<<std::endl;
+
+    std::cout<<std::endl;
+
+    for (auto depth : depths) {
+        completed = 0;
+        latency_total = 0;
+        running = true;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto &c : clients)
+            for (unsigned int i = 0; i < depth; ++i)
+                c->sendRequest();
+
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+        uint64_t done = completed;
+        uint64_t latency = latency_total;
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // let the requests still in flight drain before the next depth
+        running = false;
+        for (const auto &c : clients)
+            while (c->numPending() > 0 && c->isReady())
+                std::this_thread::yield();
+
+        std::cout<<"Depth "<<depth<<": "<<(done * 1000000000 / elapsed)<<" requests/s";
+        if (done > 0)
+            std::cout<<", average latency "<<(latency / done)<<" ns";
+        std::cout<<std::endl;
+    }
+
+    std::cout<<std::endl;
+
+    std::cout<<"Disconnecting clients... ";
+    for (auto &c : clients)
+        c->disconnectAsync();
+
+    for (const auto &c : clients)
+        while (c->isConnected())
+            std::this_thread::yield();
+    std::cout<<"done"<<std::endl;
+
+    std::cout << "Stopping IO service... ";
+    service->stop();
+    std::cout << "done" << std::endl;
+
+    std::cout << "Errors: " << num_errors << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "cxxopts.hpp"
+#include <core/tcp/tcp_client.hxx>
+#include <core/service.hxx>
+#include <core/ws/ws_frame.hxx>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+std::string upgrade;
+std::string to_send;
+size_t message_size = 0;
+
+std::atomic<uint64_t> completed = 0;
+std::atomic<uint64_t> latency_total = 0;
+std::atomic<uint64_t> num_errors = 0;
+std::atomic<bool> running = false;
+
+// Keeps a fixed # of messages in flight, each echo sends the next message
+class WebSocketClient : public CxxServer::Core::Tcp::Client {
+public:
+    using CxxServer::Core::Tcp::Client::Client;
+
+    bool isOpen() const noexcept { return _open; }
+
+    void sendMessage() {
+        if (!running)
+            return;
+
+        {
+            std::scoped_lock lock(_lock);
+            _sent.push_back(std::chrono::high_resolution_clock::now());
+        }
+
+        sendAsync(to_send);
+    }
+
+    size_t numInFlight() {
+        std::scoped_lock lock(_lock);
+        return _sent.size();
+    }
+
+protected:
+    void onReceive(const void *buffer, size_t size) override {
+        _received.append(static_cast<const char*>(buffer), size);
+
+        size_t offset = 0;
+        if (!_open) {
+            size_t end = _received.find("\r\n\r\n");
+            if (end == std::string::npos)
+                return;
+
+            if (_received.compare(0, 12, "HTTP/1.1 101") != 0)
+                ++num_errors;
+
+            offset = end + 4;
+            _open = true;
+        }
+
+        // frames from the server are unmasked, only their header is parsed
+        while (true) {
+            std::string_view rest(_received.data() + offset, _received.size() - offset);
+            if (rest.size() < 2)
+                break;
+
+            uint64_t length = static_cast<uint8_t>(rest[1]) & 0x7f;
+            size_t header = 2;
+            if (length == 126)
+                header = 4;
+            else if (length == 127)
+                header = 10;
+
+            if (rest.size() < header)
+                break;
+
+            if (header > 2) {
+                length = 0;
+                for (size_t i = 2; i < header; ++i)
+                    length = (length << 8) | static_cast<uint8_t>(rest[i]);
+            }
+
+            if (rest.size() < header + length)
+                break;
+
+            offset += header + length;
+            if (length != message_size)
+                ++num_errors;
+
+            std::chrono::high_resolution_clock::time_point sent;
+            {
+                std::scoped_lock lock(_lock);
+                sent = _sent.front();
+                _sent.pop_front();
+            }
+
+            latency_total += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - sent).count();
+            ++completed;
+            sendMessage();
+        }
+
+        _received.erase(0, offset);
+    }
+
+    void onErr(int error, const std::string &category, const std::string &message) override {
+        std::cerr<<"[x] "<<message<<"("<<category<<"): "<<error<<std::endl;
+        ++num_errors;
+    }
+
+private:
+    std::atomic<bool> _open = false;
+    std::string _received;
+    std::mutex _lock;
+    std::deque<std::chrono::high_resolution_clock::time_point> _sent;
+};
+
+int main(int argc, char **argv) {
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    cxxopts::Options options("WebSocket client", "WebSocket echo load generator for benchmarking messages/s & latency");
+
+    options.add_options()
+        ("a,address", "Address of server, default to 127.0.0.1", cxxopts::value<std::string>()->default_value("127.0.0.1"))
+        ("p,port", "Port of server to connect to, defaults to 8080", cxxopts::value<unsigned int>()->default_value("8080"))
+        ("t,threads", "Number of working threads, defaults to number of physical cores", cxxopts::value<unsigned int>()->default_value(std::to_string(num_cores)))
+        ("c,connections", "Number of connections, defaults to 100", cxxopts::value<unsigned int>()->default_value("100"))
+        ("d,depth", "Messages in flight per connection, defaults to 1", cxxopts::value<unsigned int>()->default_value("1"))
+        ("s,size", "Message size, defaults to 32", cxxopts::value<size_t>()->default_value("32"))
+        ("b,binary", "Send binary messages instead of text", cxxopts::value<bool>()->default_value("false"))
+        ("z,seconds", "Number of seconds to run, defaults to 10 seconds", cxxopts::value<unsigned int>()->default_value("10"));
+
+    auto parser = options.parse(argc, argv);
+
+    if (parser.count("help")) {
+        std::cout<<options.help()<<std::endl;
+        exit(0);
+    }
+
+    std::string addr = parser["address"].as<std::string>();
+    unsigned int port = parser["port"].as<unsigned int>();
+    unsigned int threads = parser["threads"].as<unsigned int>();
+    unsigned int num_connections = parser["connections"].as<unsigned int>();
+    unsigned int depth = parser["depth"].as<unsigned int>();
+    message_size = parser["size"].as<size_t>();
+    bool binary = parser["binary"].as<bool>();
+    unsigned int seconds = parser["seconds"].as<unsigned int>();
+
+    std::cout<<"Server address: "<<addr<<std::endl;
+    std::cout<<"Server port: "<<port<<std::endl;
+    std::cout<<"Number of Threads: "<<threads<<std::endl;
+    std::cout<<"Number of Connections: "<<num_connections<<std::endl;
+    std::cout<<"Messages in flight: "<<depth<<std::endl;
+    std::cout<<"Message size: "<<message_size<<(binary ? " (binary)" : " (text)")<<std::endl;
+    std::cout<<"Seconds: "<<seconds<<std::endl;
+
+    std::cout<<std::endl;
+
+    upgrade = "GET / HTTP/1.1\r\nHost: " + addr + "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+              "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+
+    // the same masked frame is sent every time, the server still unmasks & validates each one
+    std::string payload(message_size, 'x');
+    for (size_t i = 0; i < payload.size(); ++i)
+        payload[i] = static_cast<char>(binary ? i * 131 : 'a' + i % 26);
+
+    const uint8_t key[4] = { 0x12, 0x34, 0x56, 0x78 };
+    uint8_t header[CxxServer::Core::Ws::max_header_size];
+    size_t header_size = CxxServer::Core::Ws::encodeHeader(header, binary ? CxxServer::Core::Ws::Opcode::Binary : CxxServer::Core::Ws::Opcode::Text, true, payload.size(), key);
+    to_send.assign(reinterpret_cast<const char*>(header), header_size);
+    to_send.resize(header_size + payload.size());
+    CxxServer::Core::Ws::mask(to_send.data() + header_size, payload.data(), payload.size(), key);
+
+    auto service = std::make_shared<CxxServer::Core::Service>(threads);
+
+    std::cout<<"Starting service... ";
+    service->start();
+    std::cout<<"done"<<std::endl;
+
+    std::vector<std::shared_ptr<WebSocketClient>> clients;
+    for (unsigned int i = 0; i < num_connections; ++i) {
+        clients.push_back(std::make_shared<WebSocketClient>(service, addr, port));
+        clients.back()->isNoDelay() = true;
+    }
+
+    std::cout<<"Connecting clients... ";
+    for (auto &c : clients)
+        c->connectAsync();
+
+    for (const auto &c : clients)
+        while (!c->isReady())
+            std::this_thread::yield();
+
+    for (auto &c : clients)
+        c->sendAsync(upgrade);
+
+    for (const auto &c : clients)
+        while (!c->isOpen() && c->isConnected())
+            std::this_thread::yield();
+    std::cout<<"done"<<std::endl;
+
+    std::cout<<std::endl;
+
+    running = true;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto &c : clients)
+        for (unsigned int i = 0; i < depth; ++i)
+            c->sendMessage();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    uint64_t done = completed;
+    uint64_t latency = latency_total;
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    // let the messages still in flight drain before disconnecting
+    running = false;
+    for (const auto &c : clients)
+        while (c->numInFlight() > 0 && c->isConnected())
+            std::this_thread::yield();
+
+    std::cout<<"Messages: "<<done<<std::endl;
+    std::cout<<"Messages/s: "<<(done * 1000000000 / elapsed)<<std::endl;
+    std::cout<<"Throughput: "<<(done * message_size * 1000 / elapsed)<<" MB/s"<<std::endl;
+    if (done > 0)
+        std::cout<<"Average latency: "<<(latency / done)<<" ns"<<std::endl;
+
+    std::cout<<std::endl;
+
+    std::cout<<"Disconnecting clients... ";
+    for (auto &c : clients)
+        c->disconnectAsync();
+
+    for (const auto &c : clients)
+        while (c->isConnected())
+            std::this_thread::yield();
+    std::cout<<"done"<<std::endl;
+
+    std::cout << "Stopping IO service... ";
+    service->stop();
+    std::cout << "done" << std::endl;
+
+    std::cout << "Errors: " << num_errors << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "core/http/http_cache.hxx"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace CxxServer::Core::Http {
+    ResponseCache::ResponseCache(size_t max_bytes, size_t max_entries) :
+        _max_bytes(max_bytes),
+        _max_entries(max_entries),
+        _bytes(0),
+        _hits(0),
+        _misses(0),
+        _evictions(0)
+    {
+        assert(max_bytes > 0 && "Cache must be able to hold something");
+        if (max_bytes == 0)
+            throw std::invalid_argument("Cache must be able to hold something");
+    }
+
+    std::shared_ptr<const CachedResponse> ResponseCache::find(std::string_view key) {
+        std::scoped_lock lock(_lock);
+
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            ++_misses;
+            return nullptr;
+        }
+
+        ++_hits;
+        _lru.splice(_lru.begin(), _lru, it->second->_lru);
+        return *it->second->_lru;
+    }
+
+    std::shared_ptr<const CachedResponse> ResponseCache::insert(std::string_view key, const Response &response) {
+        if (response.isChunked())
+            return nullptr;
+
+        // informational, 204 & 304 responses never have a body
+        int status = response.statusCode();
+        bool bodyless = status < 200 || status == 204 || status == 304;
+
+        char buf[20];
+        std::string_view length(buf, Utils::formatDecimal(response.body().size(), buf) - buf);
+
+        auto cached = std::make_shared<CachedResponse>();
+        cached->_status = status;
+        cached->_close = response.isClose();
+        cached->_key_size = key.size();
+
+        auto data = std::make_shared<std::string>();
+        data->reserve(key.size() + response.head().size() + response.block().size() + 20 + length.size() + 2 + response.body().size());
+        data->append(key);
+        data->append(response.head());
+        data->append(response.block());
+        if (!bodyless) {
+            data->append("Content-Length: ");
+            data->append(length);
+            data->append("\r\n");
+        }
+
+        cached->_head_size = data->size() - key.size();
+        data->append("\r\n");
+        if (!bodyless)
+            data->append(response.body());
+
+        cached->_data = std::move(data);
+
+        size_t size = cached->_data->size();
+        if (size > _max_bytes)
+            return nullptr;
+
+        std::scoped_lock lock(_lock);
+
+        auto it = _index.find(key);
+        if (it != _index.end())
+            remove(it->second);
+
+        _lru.push_front(cached);
+        cached->_lru = _lru.begin();
+        _index.emplace(Utils::CacheView(cached->_data, 0, key.size()), cached.get());
+        _bytes += size;
+
+        while (_bytes > _max_bytes || (_max_entries > 0 && _lru.size() > _max_entries)) {
+            remove(_lru.back().get());
+            ++_evictions;
+        }
+
+        return cached;
+    }
+
+    bool ResponseCache::invalidate(std::string_view key) {
+        std::scoped_lock lock(_lock);
+
+        auto it = _index.find(key);
+        if (it == _index.end())
+            return false;
+
+        remove(it->second);
+        return true;
+    }
+
+    size_t ResponseCache::invalidatePrefix(std::string_view prefix) {
+        std::scoped_lock lock(_lock);
+
+        size_t removed = 0;
+        for (auto it = _lru.begin(); it != _lru.end();) {
+            auto response = (it++)->get();
+            if (response->key().substr(0, prefix.size()) == prefix) {
+                remove(response);
+                ++removed;
+            }
+        }
+
+        return removed;
+    }
+
+    void ResponseCache::clear() {
+        std::scoped_lock lock(_lock);
+
+        _index.clear();
+        _lru.clear();
+        _bytes = 0;
+    }
+
+    size_t ResponseCache::size() {
+        std::scoped_lock lock(_lock);
+        return _lru.size();
+    }
+
+    size_t ResponseCache::bytes() {
+        std::scoped_lock lock(_lock);
+        return _bytes;
+    }
+
+    void ResponseCache::remove(CachedResponse *response) {
+        // the index key is a view of the response's buffer, so it is erased while the response is still alive
+        _index.erase(_index.find(response->key()));
+        _bytes -= response->_data->size();
+        _lru.erase(response->_lru);
+    }
+}
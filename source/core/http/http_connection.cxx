@@ -0,0 +1,275 @@
+#include "core/http/http_connection.hxx"
+#include "core/http/http_date.hxx"
+#include "core/util.hxx"
+
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace CxxServer::Core::Http {
+    void Connection::receiveRequests(const void *buffer, size_t size) {
+        if (_stopped)
+            return;
+
+        // parse straight from the receive buffer unless a request is already partially received
+        bool buffered = !_partial.empty();
+        if (buffered)
+            _partial.insert(_partial.end(), static_cast<const char*>(buffer), static_cast<const char*>(buffer) + size);
+
+        const char *data = buffered ? _partial.data() : static_cast<const char*>(buffer);
+        size_t total = buffered ? _partial.size() : size;
+        size_t offset = 0;
+
+        while (offset < total && !_stopped) {
+            size_t consumed = 0;
+            auto result = _parser.parse(data + offset, total - offset, _request, consumed);
+
+            if (result == RequestParser::Result::Incomplete)
+                break;
+
+            if (result == RequestParser::Result::Error) {
+                _stopped = true;
+                expectResponse(Close);
+                onRequestError(_parser.errorStatus());
+                break;
+            }
+
+            ++_requests;
+            uint8_t head = _request.method() == "HEAD" ? Head : 0;
+            if (!_request.keepAlive()) {
+                _stopped = true;
+                expectResponse(Close | head);
+            }
+            else
+                expectResponse((_request.minorVersion() == 0 ? KeepAlive : 0) | head);
+
+            onRequest(_request);
+
+            _request.clear();
+            _parser.reset();
+            offset += consumed;
+        }
+
+        if (_stopped) {
+            _partial.clear();
+            return;
+        }
+
+        if (buffered)
+            _partial.erase(_partial.begin(), _partial.begin() + offset);
+        else
+            _partial.assign(data + offset, data + total);
+    }
+
+    void Connection::onRequest(const Request &) {
+        Response response;
+        response.status(404);
+        sendResponse(response);
+    }
+
+    void Connection::onRequestError(int status) {
+        Response response;
+        response.status(status);
+        sendResponse(response);
+    }
+
+    bool Connection::sendResponse(const Response &response) {
+        std::scoped_lock lock(_response_lock);
+
+        if (_response_flags.empty())
+            return false;
+
+        uint8_t flags = _response_flags.front();
+        _response_flags.pop_front();
+
+        bool close = (flags & Close) || response.isClose();
+        bool chunked = response.isChunked() && !bodyless(response.statusCode());
+
+        if (!sendHead(response, flags, !response.isChunked(), response.body().size(), response.body()))
+            return false;
+
+        if (chunked) {
+            _chunk_close = close;
+            _chunk_skip = flags & Head;
+        }
+        else if (close)
+            transportClose();
+
+        return true;
+    }
+
+    bool Connection::sendResponseShared(const Response &response, std::shared_ptr<const void> owner, const void *body, size_t size) {
+        std::scoped_lock lock(_response_lock);
+
+        if (_response_flags.empty())
+            return false;
+
+        uint8_t flags = _response_flags.front();
+        _response_flags.pop_front();
+
+        if (!sendHead(response, flags, true, size, std::string_view()))
+            return false;
+
+        if (!(flags & Head) && !bodyless(response.statusCode()) && size > 0 && !transportSendShared(std::move(owner), body, size))
+            return false;
+
+        if ((flags & Close) || response.isClose())
+            transportClose();
+
+        return true;
+    }
+
+    bool Connection::sendResponseFile(const Response &response, std::shared_ptr<const void> owner, int fd, uint64_t offset, size_t size) {
+        std::scoped_lock lock(_response_lock);
+
+        if (_response_flags.empty())
+            return false;
+
+        uint8_t flags = _response_flags.front();
+        _response_flags.pop_front();
+
+        if (!sendHead(response, flags, true, size, std::string_view()))
+            return false;
+
+        if (!(flags & Head) && !bodyless(response.statusCode()) && size > 0 && !transportSendFile(std::move(owner), fd, offset, size))
+            return false;
+
+        if ((flags & Close) || response.isClose())
+            transportClose();
+
+        return true;
+    }
+
+    bool Connection::sendHead(const Response &response, uint8_t flags, bool length, uint64_t size, std::string_view body) {
+        char buf[16 + 20 + 4];
+        std::string_view end("\r\n", 2);
+
+        // a response to HEAD says how long the body would be without sending it
+        if (length && !bodyless(response.statusCode())) {
+            std::memcpy(buf, "Content-Length: ", 16);
+            char *last = Utils::formatDecimal(size, buf + 16);
+            std::memcpy(last, "\r\n\r\n", 4);
+            end = std::string_view(buf, last + 4 - buf);
+        }
+        else
+            body = std::string_view();
+
+        if (flags & Head)
+            body = std::string_view();
+
+        auto date = _date ? Date::header() : std::string_view();
+        return transportSendGather({ response.head(), response.block(), date, connectionHeader(flags, response.isClose()), end, body });
+    }
+
+    bool Connection::sendCached(const std::shared_ptr<const CachedResponse> &response) {
+        std::scoped_lock lock(_response_lock);
+
+        if (_response_flags.empty())
+            return false;
+
+        uint8_t flags = _response_flags.front();
+        _response_flags.pop_front();
+
+        bool close = (flags & Close) || response->isClose();
+        auto header = connectionHeader(flags, response->isClose());
+        auto date = _date ? Date::header() : std::string_view();
+
+        if (flags & Head) {
+            auto head = response->head();
+            if (!transportSendShared(response->owner(), head.data(), head.size()) || !transportSendGather({ date, header, "\r\n" }))
+                return false;
+        }
+        else if (header.empty() && date.empty()) {
+            auto data = response->data();
+            if (!transportSendShared(response->owner(), data.data(), data.size()))
+                return false;
+        }
+        else {
+            auto head = response->head();
+            auto rest = response->rest();
+            if (!transportSendShared(response->owner(), head.data(), head.size()) || !transportSendGather({ date, header }) ||
+                !transportSendShared(response->owner(), rest.data(), rest.size()))
+                return false;
+        }
+
+        if (close)
+            transportClose();
+
+        return true;
+    }
+
+    bool Connection::sendChunk(const void *data, size_t size) {
+        if (size == 0)
+            return true;
+
+        std::scoped_lock lock(_response_lock);
+
+        if (_chunk_skip)
+            return true;
+
+        char buf[16 + 2];
+        char *end = Utils::formatHex(size, buf);
+        std::memcpy(end, "\r\n", 2);
+
+        _out.assign(buf, end + 2 - buf);
+        _out.append(static_cast<const char*>(data), size);
+        _out.append("\r\n");
+
+        return transportSend(_out.data(), _out.size());
+    }
+
+    bool Connection::sendLastChunk() {
+        std::scoped_lock lock(_response_lock);
+
+        if (!_chunk_skip && !transportSend("0\r\n\r\n", 5))
+            return false;
+
+        _chunk_skip = false;
+
+        if (_chunk_close) {
+            _chunk_close = false;
+            transportClose();
+        }
+
+        return true;
+    }
+
+    bool Connection::transportSendGather(std::initializer_list<std::string_view> buffers) {
+        _out.clear();
+        for (auto &buffer : buffers)
+            _out.append(buffer);
+
+        return transportSend(_out.data(), _out.size());
+    }
+
+    bool Connection::transportSendFile(std::shared_ptr<const void>, int fd, uint64_t offset, size_t size) {
+        _out.resize(size);
+
+        for (size_t read = 0; read < size;) {
+            ssize_t chunk = ::pread(fd, _out.data() + read, size - read, static_cast<off_t>(offset + read));
+            if (chunk < 0 && errno == EINTR)
+                continue;
+            if (chunk <= 0)
+                return false;
+
+            read += static_cast<size_t>(chunk);
+        }
+
+        return transportSend(_out.data(), _out.size());
+    }
+
+    std::string_view Connection::connectionHeader(uint8_t flags, bool response_close) noexcept {
+        if ((flags & Close) && !response_close)
+            return "Connection: close\r\n";
+        if (flags & KeepAlive)
+            return "Connection: keep-alive\r\n";
+
+        return std::string_view();
+    }
+
+    void Connection::expectResponse(uint8_t flags) {
+        std::scoped_lock lock(_response_lock);
+        _response_flags.push_back(flags);
+    }
+}
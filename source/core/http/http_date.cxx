@@ -0,0 +1,166 @@
+#include "core/http/http_date.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace CxxServer::Core::Http {
+    namespace {
+        // second published by the ticking DateTimers, read instead of the clock while any is ticking
+        std::atomic<std::time_t> ticked_second{0};
+        std::atomic<unsigned int> running_timers{0};
+
+        struct ThreadDate {
+            std::time_t second = -1;
+            char header[6 + Date::size + 2];
+        };
+
+        thread_local ThreadDate thread_date;
+
+        void countTimer(std::atomic<bool> &counted) noexcept {
+            if (!counted.exchange(true))
+                ++running_timers;
+        }
+
+        void uncountTimer(std::atomic<bool> &counted) noexcept {
+            if (counted.exchange(false))
+                --running_timers;
+        }
+
+        // Timers which ticked on an IO thread, their waits never complete once it exits as its service stopped
+        struct ThreadTimers {
+            std::vector<std::shared_ptr<std::atomic<bool>>> counted;
+
+            ~ThreadTimers() {
+                for (auto &timer : counted)
+                    uncountTimer(*timer);
+            }
+        };
+
+        thread_local ThreadTimers thread_timers;
+
+        void twoDigits(char *buf, int value) noexcept {
+            buf[0] = static_cast<char>('0' + value / 10);
+            buf[1] = static_cast<char>('0' + value % 10);
+        }
+    }
+
+    std::time_t Date::now() noexcept {
+        // the second is published before the timer is counted
+        if (running_timers.load(std::memory_order_acquire) > 0)
+            return ticked_second.load(std::memory_order_relaxed);
+
+        return std::time(nullptr);
+    }
+
+    std::string_view Date::header() noexcept {
+        auto second = now();
+        if (second != thread_date.second) {
+            std::memcpy(thread_date.header, "Date: ", 6);
+            format(second, thread_date.header + 6);
+            std::memcpy(thread_date.header + 6 + size, "\r\n", 2);
+            thread_date.second = second;
+        }
+
+        return std::string_view(thread_date.header, sizeof(thread_date.header));
+    }
+
+    std::string_view Date::format(std::time_t time, char *buf) noexcept {
+        static constexpr const char days[] = "SunMonTueWedThuFriSat";
+        static constexpr const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+        std::tm tm{};
+        gmtime_r(&time, &tm);
+
+        // Sun, 06 Nov 1994 08:49:37 GMT
+        std::memcpy(buf, days + tm.tm_wday * 3, 3);
+        std::memcpy(buf + 3, ", ", 2);
+        twoDigits(buf + 5, tm.tm_mday);
+        buf[7] = ' ';
+        std::memcpy(buf + 8, months + tm.tm_mon * 3, 3);
+        buf[11] = ' ';
+        int year = tm.tm_year + 1900;
+        twoDigits(buf + 12, year / 100 % 100);
+        twoDigits(buf + 14, year % 100);
+        buf[16] = ' ';
+        twoDigits(buf + 17, tm.tm_hour);
+        buf[19] = ':';
+        twoDigits(buf + 20, tm.tm_min);
+        buf[22] = ':';
+        twoDigits(buf + 23, tm.tm_sec);
+        std::memcpy(buf + 25, " GMT", 4);
+
+        return std::string_view(buf, size);
+    }
+
+    DateTimer::DateTimer(const std::shared_ptr<Service> &service) :
+        Timer(service),
+        _started(false),
+        _counted(std::make_shared<std::atomic<bool>>(false))
+    {}
+
+    DateTimer::~DateTimer() {
+        _started = false;
+        uncountTimer(*_counted);
+    }
+
+    bool DateTimer::start() {
+        if (_started.exchange(true))
+            return false;
+
+        // the first tick runs on the IO thread, so a timer on a service which isn't running is never counted
+        if (!setup(std::chrono::system_clock::now()) || !waitAsync()) {
+            _started = false;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool DateTimer::stop() {
+        if (!_started.exchange(false))
+            return false;
+
+        uncountTimer(*_counted);
+        cancel();
+        return true;
+    }
+
+    void DateTimer::onTimer(bool canceled) {
+        if (canceled || !_started) {
+            uncountTimer(*_counted);
+            return;
+        }
+
+        tick();
+    }
+
+    void DateTimer::onErr(int error, const std::string &category, const std::string &message) {
+        uncountTimer(*_counted);
+    }
+
+    void DateTimer::tick() {
+        auto second = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+        ticked_second.store(std::chrono::system_clock::to_time_t(second), std::memory_order_relaxed);
+        countTimer(*_counted);
+
+        auto &counted = thread_timers.counted;
+        if (std::find(counted.begin(), counted.end(), _counted) == counted.end()) {
+            // forget the timers destroyed since
+            std::erase_if(counted, [](const std::shared_ptr<std::atomic<bool>> &timer) { return timer.use_count() == 1; });
+            counted.push_back(_counted);
+        }
+
+        // stopped while ticking
+        if (!_started) {
+            uncountTimer(*_counted);
+            return;
+        }
+
+        // wake up as the next second starts
+        if (!setup(second + std::chrono::seconds(1)) || !waitAsync())
+            uncountTimer(*_counted);
+    }
+}
@@ -0,0 +1,432 @@
+#include "core/http/http_files.hxx"
+#include "core/http/http_date.hxx"
+#include "core/http/http_response.hxx"
+#include "core/util.hxx"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace CxxServer::Core::Http {
+    namespace {
+        // Result of parsing a Range header
+        enum class Range {
+            // no range or one which is ignored, the whole file is sent
+            None,
+            Satisfiable,
+            Unsatisfiable
+        };
+
+        int64_t steadyNow() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        int64_t modifiedOf(const struct stat &st) noexcept {
+            return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        }
+
+        int hexValue(char c) noexcept {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+
+            return -1;
+        }
+
+        // Percent decode a path relative to the root, refusing to leave it
+        bool decodePath(std::string_view path, std::string &decoded) {
+            while (!path.empty() && path[0] == '/')
+                path.remove_prefix(1);
+
+            decoded.clear();
+            decoded.reserve(path.size());
+            for (size_t pos = 0; pos < path.size(); ++pos) {
+                char c = path[pos];
+                if (c == '%') {
+                    int high = pos + 2 < path.size() ? hexValue(path[pos + 1]) : -1;
+                    int low = high < 0 ? -1 : hexValue(path[pos + 2]);
+                    if (low < 0)
+                        return false;
+
+                    c = static_cast<char>(high * 16 + low);
+                    pos += 2;
+                }
+
+                if (c == '\0')
+                    return false;
+
+                decoded.push_back(c);
+            }
+
+            if (decoded.empty())
+                return false;
+
+            for (size_t start = 0; start <= decoded.size();) {
+                size_t end = decoded.find('/', start);
+                if (end == std::string::npos)
+                    end = decoded.size();
+
+                if (std::string_view(decoded).substr(start, end - start) == "..")
+                    return false;
+
+                start = end + 1;
+            }
+
+            return true;
+        }
+
+        std::string_view contentTypeOf(std::string_view path) noexcept {
+            static constexpr std::pair<std::string_view, std::string_view> types[] = {
+                { "html", "text/html; charset=utf-8" },
+                { "htm", "text/html; charset=utf-8" },
+                { "css", "text/css; charset=utf-8" },
+                { "js", "text/javascript; charset=utf-8" },
+                { "mjs", "text/javascript; charset=utf-8" },
+                { "json", "application/json" },
+                { "txt", "text/plain; charset=utf-8" },
+                { "xml", "application/xml" },
+                { "svg", "image/svg+xml" },
+                { "png", "image/png" },
+                { "jpg", "image/jpeg" },
+                { "jpeg", "image/jpeg" },
+                { "gif", "image/gif" },
+                { "webp", "image/webp" },
+                { "ico", "image/x-icon" },
+                { "woff", "font/woff" },
+                { "woff2", "font/woff2" },
+                { "wasm", "application/wasm" },
+                { "pdf", "application/pdf" },
+                { "mp4", "video/mp4" },
+                { "webm", "video/webm" }
+            };
+
+            size_t dot = path.rfind('.');
+            if (dot != std::string_view::npos && path.find('/', dot) == std::string_view::npos) {
+                auto extension = path.substr(dot + 1);
+                for (const auto &[name, type] : types) {
+                    if (equalsNoCase(name, extension))
+                        return type;
+                }
+            }
+
+            return "application/octet-stream";
+        }
+
+        // Does a list of entity tags, e.g. If-None-Match, match a tag, weakly
+        bool matchesTag(std::string_view list, std::string_view etag) noexcept {
+            while (!list.empty()) {
+                size_t comma = list.find(',');
+                auto tag = list.substr(0, comma);
+                list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+                while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t'))
+                    tag.remove_prefix(1);
+                while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+                    tag.remove_suffix(1);
+
+                if (tag.substr(0, 2) == "W/")
+                    tag.remove_prefix(2);
+
+                if (tag == "*" || tag == etag)
+                    return true;
+            }
+
+            return false;
+        }
+
+        // Parse a single byte range, multiple ranges are ignored & the whole file sent
+        Range parseRange(std::string_view header, uint64_t size, uint64_t &first, uint64_t &length) noexcept {
+            if (header.size() < 6 || !equalsNoCase(header.substr(0, 6), "bytes="))
+                return Range::None;
+
+            header.remove_prefix(6);
+            size_t dash = header.find('-');
+            if (dash == std::string_view::npos || header.find(',') != std::string_view::npos)
+                return Range::None;
+
+            auto start = header.substr(0, dash);
+            auto end = header.substr(dash + 1);
+            uint64_t from = 0;
+            uint64_t to = 0;
+
+            // the last bytes of the file
+            if (start.empty()) {
+                if (!Utils::parseDecimal(end, to))
+                    return Range::None;
+                if (to == 0 || size == 0)
+                    return Range::Unsatisfiable;
+
+                length = std::min(to, size);
+                first = size - length;
+                return Range::Satisfiable;
+            }
+
+            if (!Utils::parseDecimal(start, from) || (!end.empty() && (!Utils::parseDecimal(end, to) || to < from)))
+                return Range::None;
+            if (from >= size)
+                return Range::Unsatisfiable;
+
+            first = from;
+            length = (end.empty() || to >= size ? size - 1 : to) - from + 1;
+            return Range::Satisfiable;
+        }
+    }
+
+    StaticFile::~StaticFile() {
+        if (_fd >= 0)
+            ::close(_fd);
+    }
+
+    StaticFiles::StaticFiles(std::string root, size_t buffer_limit, size_t max_buffered, size_t max_files, std::chrono::nanoseconds revalidate) :
+        _root(std::move(root)),
+        _buffer_limit(buffer_limit),
+        _max_buffered(max_buffered),
+        _max_files(max_files),
+        _revalidate(revalidate),
+        _buffered(0),
+        _hits(0),
+        _misses(0)
+    {
+        assert(!_root.empty() && "Root directory must be set");
+        if (_root.empty())
+            throw std::invalid_argument("Root directory must be set");
+
+        assert(max_files > 0 && "Cache must be able to hold a file");
+        if (max_files == 0)
+            throw std::invalid_argument("Cache must be able to hold a file");
+    }
+
+    bool StaticFiles::serve(Connection &connection, const Request &request, std::string_view path) {
+        Response response;
+
+        auto method = request.method();
+        if (method != "GET" && method != "HEAD") {
+            response.status(405).header("Allow", "GET, HEAD");
+            connection.sendResponse(response);
+            return false;
+        }
+
+        auto file = open(path);
+        if (!file) {
+            response.status(404);
+            connection.sendResponse(response);
+            return false;
+        }
+
+        // If-None-Match takes precedence over If-Modified-Since, which is only compared to Last-Modified as is
+        auto none_match = request.header("If-None-Match");
+        bool not_modified = none_match.empty() ? request.header("If-Modified-Since") == file->lastModified() : matchesTag(none_match, file->etag());
+        if (not_modified) {
+            response.status(304).header("ETag", file->etag()).header("Last-Modified", file->lastModified());
+            connection.sendResponse(response);
+            return true;
+        }
+
+        uint64_t first = 0;
+        uint64_t length = file->size();
+        auto range = Range::None;
+
+        // a range is only sent if the file is still the one If-Range names
+        auto range_header = request.header("Range");
+        auto if_range = request.header("If-Range");
+        if (!range_header.empty() && (if_range.empty() || if_range == file->etag() || if_range == file->lastModified()))
+            range = parseRange(range_header, file->size(), first, length);
+
+        char buf[6 + 20 + 1 + 20 + 1 + 20];
+        char *end = buf;
+        std::memcpy(end, "bytes ", 6);
+        end += 6;
+
+        if (range == Range::Unsatisfiable) {
+            *end++ = '*';
+            *end++ = '/';
+            end = Utils::formatDecimal(file->size(), end);
+
+            response.status(416).header("Content-Range", std::string_view(buf, end - buf));
+            connection.sendResponse(response);
+            return true;
+        }
+
+        response.status(range == Range::Satisfiable ? 206 : 200)
+            .header("Content-Type", file->contentType())
+            .header("ETag", file->etag())
+            .header("Last-Modified", file->lastModified())
+            .header("Accept-Ranges", "bytes");
+
+        if (range == Range::Satisfiable) {
+            end = Utils::formatDecimal(first, end);
+            *end++ = '-';
+            end = Utils::formatDecimal(first + length - 1, end);
+            *end++ = '/';
+            end = Utils::formatDecimal(file->size(), end);
+            response.header("Content-Range", std::string_view(buf, end - buf));
+        }
+
+        if (file->isBuffered())
+            connection.sendResponseShared(response, file, static_cast<const char*>(file->data()) + first, length);
+        else
+            connection.sendResponseFile(response, file, file->fd(), first, length);
+
+        return true;
+    }
+
+    std::shared_ptr<const StaticFile> StaticFiles::open(std::string_view path) {
+        std::string decoded;
+        if (!decodePath(path, decoded))
+            return nullptr;
+
+        auto now = steadyNow();
+        std::shared_ptr<StaticFile> cached;
+        size_t buffered;
+
+        {
+            std::scoped_lock lock(_lock);
+
+            auto it = _index.find(decoded);
+            if (it != _index.end()) {
+                _lru.splice(_lru.begin(), _lru, it->second->_lru);
+                cached = *it->second->_lru;
+
+                if (now - cached->_checked < _revalidate.count()) {
+                    ++_hits;
+                    return cached;
+                }
+            }
+
+            buffered = _buffered;
+        }
+
+        // the cached file is kept unless it was changed or replaced on the disk
+        if (cached) {
+            struct stat st;
+            if (::stat((_root + '/' + decoded).c_str(), &st) == 0 && st.st_dev == cached->_device && st.st_ino == cached->_inode &&
+                modifiedOf(st) == cached->_modified && static_cast<uint64_t>(st.st_size) == cached->_size) {
+                std::scoped_lock lock(_lock);
+                cached->_checked = now;
+                ++_hits;
+                return cached;
+            }
+        }
+
+        ++_misses;
+        auto file = load(decoded, buffered);
+
+        std::scoped_lock lock(_lock);
+
+        if (!file) {
+            auto it = _index.find(decoded);
+            if (it != _index.end())
+                remove(it->second);
+
+            return nullptr;
+        }
+
+        file->_checked = now;
+        insert(file);
+        return file;
+    }
+
+    std::shared_ptr<StaticFile> StaticFiles::load(const std::string &path, size_t buffered) const {
+        int fd = ::open((_root + '/' + path).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return nullptr;
+
+        auto file = std::make_shared<StaticFile>();
+        file->_fd = fd;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+            return nullptr;
+
+        file->_path = path;
+        file->_size = static_cast<uint64_t>(st.st_size);
+        file->_device = st.st_dev;
+        file->_inode = st.st_ino;
+        file->_modified = modifiedOf(st);
+        file->_content_type = contentTypeOf(path);
+
+        // small files are copied while they fit, the rest is sent from the descriptor. A copy rather than a mapping,
+        // which would fault once the file is truncated under it
+        if (file->_size > 0 && file->_size <= _buffer_limit && buffered + file->_size <= _max_buffered) {
+            auto data = std::make_unique_for_overwrite<char[]>(file->_size);
+
+            size_t read = 0;
+            while (read < file->_size) {
+                ssize_t count = ::pread(fd, data.get() + read, file->_size - read, static_cast<off_t>(read));
+                if (count < 0 && errno == EINTR)
+                    continue;
+                if (count <= 0)
+                    break;
+
+                read += static_cast<size_t>(count);
+            }
+
+            // changed while read, sent from the descriptor until it is revalidated
+            if (read == file->_size)
+                file->_data = std::move(data);
+        }
+
+        char buf[2 + 16 + 1 + 16];
+        char *end = buf;
+        *end++ = '"';
+        end = Utils::formatHex(file->_size, end);
+        *end++ = '-';
+        end = Utils::formatHex(static_cast<uint64_t>(file->_modified), end);
+        *end++ = '"';
+        file->_etag.assign(buf, end - buf);
+
+        char date[Date::size];
+        file->_last_modified = Date::format(st.st_mtim.tv_sec, date);
+
+        return file;
+    }
+
+    void StaticFiles::clear() {
+        std::scoped_lock lock(_lock);
+
+        _index.clear();
+        _lru.clear();
+        _buffered = 0;
+    }
+
+    size_t StaticFiles::size() {
+        std::scoped_lock lock(_lock);
+        return _lru.size();
+    }
+
+    size_t StaticFiles::bufferedBytes() {
+        std::scoped_lock lock(_lock);
+        return _buffered;
+    }
+
+    void StaticFiles::insert(const std::shared_ptr<StaticFile> &file) {
+        auto it = _index.find(file->path());
+        if (it != _index.end())
+            remove(it->second);
+
+        _lru.push_front(file);
+        file->_lru = _lru.begin();
+        _index.emplace(file->path(), file.get());
+        if (file->isBuffered())
+            _buffered += file->size();
+
+        while (_lru.size() > _max_files || _buffered > _max_buffered)
+            remove(_lru.back().get());
+    }
+
+    void StaticFiles::remove(StaticFile *file) {
+        if (file->isBuffered())
+            _buffered -= file->size();
+
+        _index.erase(file->path());
+        _lru.erase(file->_lru);
+    }
+}
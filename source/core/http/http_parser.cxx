@@ -0,0 +1,301 @@
+#include "core/http/http_parser.hxx"
+#include "core/http/http_scan.hxx"
+#include "core/util.hxx"
+
+#include <limits>
+
+namespace CxxServer::Core::Http {
+    namespace {
+        std::string_view trim(std::string_view text) noexcept {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+                text.remove_prefix(1);
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+                text.remove_suffix(1);
+
+            return text;
+        }
+
+        bool parseLength(std::string_view text, size_t &length) noexcept {
+            uint64_t value;
+            if (!Utils::parseDecimal(text, value) || value > std::numeric_limits<size_t>::max())
+                return false;
+
+            length = static_cast<size_t>(value);
+            return true;
+        }
+    }
+
+    void RequestParser::reset() noexcept {
+        _scanned = 0;
+        _header_size = 0;
+        _body_kind = Body::None;
+        _body_length = 0;
+        _chunk_offset = 0;
+        _chunk_remaining = 0;
+        _chunk_crlf = false;
+        _chunk_trailers = false;
+        _chunked_body.clear();
+        _error_status = 0;
+    }
+
+    RequestParser::Result RequestParser::parse(const char *data, size_t size, Request &request, size_t &consumed) {
+        if (_error_status != 0)
+            return Result::Error;
+
+        if (_header_size == 0) {
+            size_t end = findHeaderEnd(data, size);
+            if ((end == 0 && size > _limits.max_header_size) || end > _limits.max_header_size) {
+                fail(431);
+                return Result::Error;
+            }
+
+            if (end == 0)
+                return Result::Incomplete;
+
+            _header_size = end;
+        }
+
+        // the head is parsed again on every call, the data may have moved since the last one
+        if (!parseHead(data, request))
+            return Result::Error;
+
+        switch (_body_kind) {
+            case Body::None:
+                request._body = std::string_view();
+                consumed = _header_size;
+                return Result::Complete;
+
+            case Body::Length:
+                if (size - _header_size < _body_length)
+                    return Result::Incomplete;
+
+                request._body = std::string_view(data + _header_size, _body_length);
+                consumed = _header_size + _body_length;
+                return Result::Complete;
+
+            case Body::Chunked: {
+                auto result = parseChunks(data, size, consumed);
+                if (result == Result::Complete)
+                    request._body = std::string_view(_chunked_body.data(), _chunked_body.size());
+
+                return result;
+            }
+        }
+
+        return Result::Incomplete;
+    }
+
+    size_t RequestParser::findHeaderEnd(const char *data, size_t size) {
+        // step back so a terminator split across calls is found
+        size_t pos = _scanned > 3 ? _scanned - 3 : 0;
+
+        size_t found = pos < size ? Scan::findHeaderEnd(data + pos, size - pos) : Scan::npos;
+        if (found != Scan::npos)
+            return pos + found + 4;
+
+        _scanned = size;
+        return 0;
+    }
+
+    bool RequestParser::parseHead(const char *data, Request &request) {
+        request._headers.clear();
+
+        // every line of the head ends with CRLF, the blank line ending it is left out
+        std::string_view head(data, _header_size - 2);
+
+        // a CR not followed by LF is invalid anywhere in the head
+        auto lineEnd = [&head](size_t pos) {
+            size_t cr = Scan::findChar(head.data() + pos, head.size() - pos, '\r');
+            return (cr != Scan::npos && head[pos + cr + 1] == '\n') ? pos + cr : Scan::npos;
+        };
+
+        size_t line_end = lineEnd(0);
+        if (line_end == Scan::npos)
+            return fail(400);
+
+        if (!parseRequestLine(head.substr(0, line_end), request))
+            return false;
+
+        bool has_length = false;
+        bool chunked = false;
+        bool close = false;
+        bool keep_alive = false;
+        size_t length = 0;
+
+        for (size_t pos = line_end + 2; pos < head.size();) {
+            // the name is validated & its colon found in one pass over the rest of the head. Folded lines start
+            // with whitespace & fail it, they are obsolete & a smuggling vector
+            size_t colon = pos + Scan::tokenLength(head.data() + pos, head.size() - pos);
+            if (colon == pos || head[colon] != ':')
+                return fail(400);
+
+            size_t eol = lineEnd(colon + 1);
+            if (eol == Scan::npos)
+                return fail(400);
+
+            if (request._headers.size() == _limits.max_headers)
+                return fail(431);
+
+            Header header{head.substr(pos, colon - pos), trim(head.substr(colon + 1, eol - colon - 1))};
+            pos = eol + 2;
+            request._headers.push_back(header);
+
+            if (equalsNoCase(header.name, "Content-Length")) {
+                size_t value;
+                if (!parseLength(header.value, value) || (has_length && value != length))
+                    return fail(400);
+
+                has_length = true;
+                length = value;
+            }
+            else if (equalsNoCase(header.name, "Transfer-Encoding")) {
+                // no other transfer codings are supported
+                if (!equalsNoCase(header.value, "chunked"))
+                    return fail(501);
+
+                chunked = true;
+            }
+            else if (equalsNoCase(header.name, "Connection")) {
+                std::string_view options = header.value;
+                while (!options.empty()) {
+                    size_t comma = options.find(',');
+                    auto option = trim(options.substr(0, comma));
+                    close |= equalsNoCase(option, "close");
+                    keep_alive |= equalsNoCase(option, "keep-alive");
+                    options.remove_prefix(comma == std::string_view::npos ? options.size() : comma + 1);
+                }
+            }
+        }
+
+        if (has_length && chunked)
+            return fail(400);
+
+        if (has_length && length > _limits.max_body_size)
+            return fail(413);
+
+        request._keep_alive = !close && (request._minor_version == 1 || keep_alive);
+        request._chunked = chunked;
+
+        _body_kind = chunked ? Body::Chunked : (has_length && length > 0 ? Body::Length : Body::None);
+        _body_length = length;
+
+        return true;
+    }
+
+    bool RequestParser::parseRequestLine(std::string_view line, Request &request) {
+        size_t method_end = Scan::tokenLength(line.data(), line.size());
+        if (method_end == 0 || method_end == line.size() || line[method_end] != ' ')
+            return fail(400);
+
+        size_t target_end = line.find(' ', method_end + 1);
+        if (target_end == std::string_view::npos || target_end == method_end + 1)
+            return fail(400);
+
+        auto target = line.substr(method_end + 1, target_end - method_end - 1);
+        for (char c : target) {
+            if (static_cast<unsigned char>(c) <= ' ' || c == 0x7f)
+                return fail(400);
+        }
+
+        auto version = line.substr(target_end + 1);
+        if (version.size() != 8 || version.substr(0, 5) != "HTTP/")
+            return fail(400);
+
+        if (version[5] != '1' || version[6] != '.' || (version[7] != '0' && version[7] != '1'))
+            return fail(505);
+
+        request._method = line.substr(0, method_end);
+        request._target = target;
+
+        size_t question = target.find('?');
+        request._path = target.substr(0, question);
+        request._query = question == std::string_view::npos ? std::string_view() : target.substr(question + 1);
+        request._minor_version = static_cast<uint8_t>(version[7] - '0');
+
+        return true;
+    }
+
+    RequestParser::Result RequestParser::parseChunks(const char *data, size_t size, size_t &consumed) {
+        // size lines & trailers are short, a longer one without its CRLF is an attack or garbage
+        constexpr size_t max_line = 4096;
+
+        if (_chunk_offset == 0)
+            _chunk_offset = _header_size;
+
+        while (true) {
+            if (_chunk_remaining > 0) {
+                size_t available = std::min(_chunk_remaining, size - _chunk_offset);
+                if (available == 0)
+                    return Result::Incomplete;
+
+                _chunked_body.insert(_chunked_body.end(), data + _chunk_offset, data + _chunk_offset + available);
+                _chunk_offset += available;
+                _chunk_remaining -= available;
+                if (_chunk_remaining > 0)
+                    return Result::Incomplete;
+
+                _chunk_crlf = true;
+            }
+
+            if (_chunk_crlf) {
+                if (size - _chunk_offset < 2)
+                    return Result::Incomplete;
+
+                if (data[_chunk_offset] != '\r' || data[_chunk_offset + 1] != '\n') {
+                    fail(400);
+                    return Result::Error;
+                }
+
+                _chunk_offset += 2;
+                _chunk_crlf = false;
+            }
+
+            std::string_view rest(data + _chunk_offset, size - _chunk_offset);
+            size_t eol = rest.find("\r\n");
+            if (eol == std::string_view::npos) {
+                if (rest.size() > max_line) {
+                    fail(400);
+                    return Result::Error;
+                }
+
+                return Result::Incomplete;
+            }
+
+            auto line = rest.substr(0, eol);
+            _chunk_offset += eol + 2;
+
+            // trailer fields are skipped up to the blank line ending the request
+            if (_chunk_trailers) {
+                if (line.empty()) {
+                    consumed = _chunk_offset;
+                    return Result::Complete;
+                }
+
+                continue;
+            }
+
+            // chunk extensions are ignored
+            auto digits = trim(line.substr(0, line.find(';')));
+            if (digits.empty() || digits.size() > 15) {
+                fail(400);
+                return Result::Error;
+            }
+
+            uint64_t chunk_size = 0;
+            if (!Utils::parseHex(digits, chunk_size)) {
+                fail(400);
+                return Result::Error;
+            }
+
+            if (chunk_size > _limits.max_body_size - _chunked_body.size()) {
+                fail(413);
+                return Result::Error;
+            }
+
+            if (chunk_size == 0)
+                _chunk_trailers = true;
+            else
+                _chunk_remaining = chunk_size;
+        }
+    }
+}
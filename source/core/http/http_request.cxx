@@ -0,0 +1,38 @@
+#include "core/http/http_request.hxx"
+
+namespace CxxServer::Core::Http {
+    bool equalsNoCase(std::string_view a, std::string_view b) noexcept {
+        if (a.size() != b.size())
+            return false;
+
+        for (size_t i = 0; i < a.size(); ++i) {
+            // ASCII only, folding the case bit is enough for letters & leaves the rest unequal
+            char x = a[i];
+            char y = b[i];
+            if (x == y)
+                continue;
+
+            if ((x | 0x20) != (y | 0x20) || (x | 0x20) < 'a' || (x | 0x20) > 'z')
+                return false;
+        }
+
+        return true;
+    }
+
+    std::string_view Request::header(std::string_view name) const noexcept {
+        for (const auto &header : _headers) {
+            if (equalsNoCase(header.name, name))
+                return header.value;
+        }
+
+        return std::string_view();
+    }
+
+    void Request::clear() noexcept {
+        _method = _target = _path = _query = _body = std::string_view();
+        _minor_version = 1;
+        _headers.clear();
+        _keep_alive = true;
+        _chunked = false;
+    }
+}
@@ -0,0 +1,139 @@
+#include "core/http/http_response.hxx"
+#include "core/http/http_request.hxx"
+#include "core/util.hxx"
+
+#include <array>
+#include <string>
+
+namespace CxxServer::Core::Http {
+    namespace {
+        constexpr int max_status = 600;
+    }
+
+    HeaderBlock &HeaderBlock::header(std::string_view name, std::string_view value) {
+        _data.append(name);
+        _data.append(": ");
+        _data.append(value);
+        _data.append("\r\n");
+        return *this;
+    }
+
+    Response &Response::status(int status, std::string_view reason) {
+        char buf[20];
+
+        _head.clear();
+        _body.clear();
+        _block = nullptr;
+        _status = status;
+        _chunked = false;
+        _close = false;
+
+        // standard status lines are copied whole instead of formatting them
+        if (reason.empty()) {
+            auto line = statusLine(status);
+            if (!line.empty()) {
+                _head.assign(line);
+                return *this;
+            }
+        }
+
+        _head.append("HTTP/1.1 ");
+        _head.append(Utils::fastItoa(static_cast<size_t>(status), buf, sizeof(buf)));
+        _head.push_back(' ');
+        _head.append(reason.empty() ? Response::reason(status) : reason);
+        _head.append("\r\n");
+
+        return *this;
+    }
+
+    Response &Response::header(std::string_view name, std::string_view value) {
+        _head.append(name);
+        _head.append(": ");
+        _head.append(value);
+        _head.append("\r\n");
+
+        if (equalsNoCase(name, "Connection")) {
+            // close is one of a comma separated list of options
+            for (size_t pos = 0; pos + 5 <= value.size(); ++pos) {
+                if (equalsNoCase(value.substr(pos, 5), "close"))
+                    _close = true;
+            }
+        }
+
+        return *this;
+    }
+
+    Response &Response::body(std::string_view body) {
+        _body.assign(body);
+        return *this;
+    }
+
+    Response &Response::chunked() {
+        _chunked = true;
+        _head.append("Transfer-Encoding: chunked\r\n");
+        return *this;
+    }
+
+    void Response::clear() {
+        status(200);
+    }
+
+    std::string_view Response::statusLine(int status) noexcept {
+        static const auto lines = [] {
+            std::array<std::string, max_status> table;
+            for (int code = 100; code < max_status; ++code) {
+                auto phrase = reason(code);
+                if (phrase != "Unknown")
+                    table[code] = "HTTP/1.1 " + std::to_string(code) + " " + std::string(phrase) + "\r\n";
+            }
+
+            return table;
+        }();
+
+        if (status < 0 || status >= max_status)
+            return std::string_view();
+
+        return lines[status];
+    }
+
+    std::string_view Response::reason(int status) noexcept {
+        switch (status) {
+            case 100: return "Continue";
+            case 101: return "Switching Protocols";
+            case 200: return "OK";
+            case 201: return "Created";
+            case 202: return "Accepted";
+            case 204: return "No Content";
+            case 206: return "Partial Content";
+            case 301: return "Moved Permanently";
+            case 302: return "Found";
+            case 303: return "See Other";
+            case 304: return "Not Modified";
+            case 307: return "Temporary Redirect";
+            case 308: return "Permanent Redirect";
+            case 400: return "Bad Request";
+            case 401: return "Unauthorized";
+            case 403: return "Forbidden";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 408: return "Request Timeout";
+            case 409: return "Conflict";
+            case 411: return "Length Required";
+            case 412: return "Precondition Failed";
+            case 413: return "Content Too Large";
+            case 414: return "URI Too Long";
+            case 415: return "Unsupported Media Type";
+            case 416: return "Range Not Satisfiable";
+            case 426: return "Upgrade Required";
+            case 429: return "Too Many Requests";
+            case 431: return "Request Header Fields Too Large";
+            case 500: return "Internal Server Error";
+            case 501: return "Not Implemented";
+            case 502: return "Bad Gateway";
+            case 503: return "Service Unavailable";
+            case 504: return "Gateway Timeout";
+            case 505: return "HTTP Version Not Supported";
+            default: return "Unknown";
+        }
+    }
+}
@@ -0,0 +1,252 @@
+#include "core/http/http_router.hxx"
+#include "core/http/http_response.hxx"
+
+#include <cstring>
+#include <vector>
+
+namespace CxxServer::Core::Http {
+    struct Router::Node {
+        // static part of the path matched by the node, empty for parameters
+        std::string prefix;
+        // first char of each static child's prefix, in the order of children
+        std::string indices;
+        std::vector<std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> param;
+        std::unique_ptr<Node> wildcard;
+        // parameter name
+        std::string name;
+        std::vector<std::pair<std::string, Handler>> handlers;
+    };
+
+    namespace {
+        // Check the segments of a pattern & count its parameters
+        bool validPattern(std::string_view pattern, size_t &params) noexcept {
+            if (pattern.empty() || pattern[0] != '/')
+                return false;
+
+            params = 0;
+            for (size_t pos = 1; pos < pattern.size(); ++pos) {
+                char c = pattern[pos];
+                if (c != ':' && c != '*')
+                    continue;
+
+                // parameters are whole segments with a name, the rest only as the last one
+                size_t end = pattern.find('/', pos);
+                auto name = pattern.substr(pos + 1, end == std::string_view::npos ? std::string_view::npos : end - pos - 1);
+                if (pattern[pos - 1] != '/' || name.empty() || name.find_first_of(":*") != std::string_view::npos)
+                    return false;
+                if (c == '*' && end != std::string_view::npos)
+                    return false;
+
+                ++params;
+                pos += name.size();
+            }
+
+            return params <= RouteParams::max_size;
+        }
+    }
+
+    Router::Router() :
+        _root(std::make_unique<Node>()),
+        _routes(0)
+    {}
+
+    Router::~Router() = default;
+
+    bool Router::add(std::string_view method, std::string_view pattern, Handler handler) {
+        size_t params = 0;
+        if (method.empty() || !handler || !validPattern(pattern, params))
+            return false;
+
+        Node *node = insert(_root.get(), pattern);
+        if (node == nullptr || handlerOf(node, method) != nullptr)
+            return false;
+
+        node->handlers.emplace_back(std::string(method), std::move(handler));
+        if (params == 0)
+            _static.emplace(std::string(pattern), node);
+
+        ++_routes;
+        return true;
+    }
+
+    Router::Node *Router::insert(Node *node, std::string_view pattern) {
+        if (pattern.empty())
+            return node;
+
+        if (pattern[0] == ':' || pattern[0] == '*') {
+            size_t end = pattern.find('/');
+            auto name = pattern.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1);
+
+            auto &child = pattern[0] == ':' ? node->param : node->wildcard;
+            if (!child) {
+                child = std::make_unique<Node>();
+                child->name = name;
+            }
+            else if (child->name != name)
+                return nullptr;
+
+            return insert(child.get(), pattern.substr(1 + name.size()));
+        }
+
+        auto segment = pattern.substr(0, pattern.find_first_of(":*"));
+
+        size_t idx = node->indices.find(segment[0]);
+        if (idx == std::string::npos) {
+            auto child = std::make_unique<Node>();
+            child->prefix = segment;
+            node->indices.push_back(segment[0]);
+            node->children.push_back(std::move(child));
+            return insert(node->children.back().get(), pattern.substr(segment.size()));
+        }
+
+        Node *child = node->children[idx].get();
+        size_t common = 0;
+        while (common < segment.size() && common < child->prefix.size() && segment[common] == child->prefix[common])
+            ++common;
+
+        // the child keeps what it shares with the segment, the rest of it moves to a node of its own below
+        if (common < child->prefix.size()) {
+            auto split = std::make_unique<Node>();
+            split->prefix = child->prefix.substr(common);
+            split->indices = std::move(child->indices);
+            split->children = std::move(child->children);
+            split->param = std::move(child->param);
+            split->wildcard = std::move(child->wildcard);
+            split->handlers = std::move(child->handlers);
+
+            // routes without parameters point at the node holding their handlers
+            for (auto &entry : _static) {
+                if (entry.second == child)
+                    entry.second = split.get();
+            }
+
+            child->prefix.resize(common);
+            child->indices.assign(1, split->prefix[0]);
+            child->children.clear();
+            child->children.push_back(std::move(split));
+            child->param.reset();
+            child->wildcard.reset();
+            child->handlers.clear();
+        }
+
+        return insert(child, pattern.substr(common));
+    }
+
+    const Router::Handler *Router::find(std::string_view method, std::string_view path, RouteParams &params) const noexcept {
+        params.clear();
+
+        auto it = _static.find(path);
+        if (it != _static.end()) {
+            if (auto handler = handlerOf(it->second, method))
+                return handler;
+        }
+
+        const Node *node = lookup(_root.get(), path, method, params);
+        return node == nullptr ? nullptr : handlerOf(node, method);
+    }
+
+    std::string Router::allowed(std::string_view path) const {
+        RouteParams params;
+        const Node *node = lookup(_root.get(), path, std::string_view(), params);
+
+        std::string methods;
+        if (node == nullptr)
+            return methods;
+
+        for (auto &[method, handler] : node->handlers) {
+            if (!methods.empty())
+                methods.append(", ");
+            methods.append(method);
+        }
+
+        return methods;
+    }
+
+    bool Router::route(Connection &connection, const Request &request) const {
+        RouteParams params;
+        if (auto handler = find(request.method(), request.path(), params)) {
+            (*handler)(connection, request, params);
+            return true;
+        }
+
+        Response response;
+        auto methods = allowed(request.path());
+        if (methods.empty())
+            response.status(404);
+        else
+            response.status(405).header("Allow", methods);
+
+        connection.sendResponse(response);
+        return false;
+    }
+
+    const Router::Node *Router::lookup(const Node *node, std::string_view path, std::string_view method, RouteParams &params) noexcept {
+        auto matches = [&method](const Node *found) {
+            return !found->handlers.empty() && (method.empty() || handlerOf(found, method) != nullptr);
+        };
+
+        for (;;) {
+            if (path.empty()) {
+                if (matches(node))
+                    return node;
+
+                // the rest may be empty
+                if (node->wildcard && matches(node->wildcard.get()) && params.push(node->wildcard->name, path))
+                    return node->wildcard.get();
+
+                return nullptr;
+            }
+
+            const Node *child = nullptr;
+            for (size_t idx = 0; idx < node->indices.size(); ++idx) {
+                if (node->indices[idx] == path[0]) {
+                    child = node->children[idx].get();
+                    break;
+                }
+            }
+
+            if (child != nullptr && (child->prefix.size() > path.size() || std::memcmp(child->prefix.data(), path.data(), child->prefix.size()) != 0))
+                child = nullptr;
+
+            // without parameters there is nothing to backtrack to, the static child is followed in place
+            if (!node->param && !node->wildcard) {
+                if (child == nullptr)
+                    return nullptr;
+
+                path.remove_prefix(child->prefix.size());
+                node = child;
+                continue;
+            }
+
+            if (child != nullptr) {
+                if (auto found = lookup(child, path.substr(child->prefix.size()), method, params))
+                    return found;
+            }
+
+            if (node->param) {
+                auto segment = path.substr(0, path.find('/'));
+                if (!segment.empty() && params.push(node->param->name, segment)) {
+                    if (auto found = lookup(node->param.get(), path.substr(segment.size()), method, params))
+                        return found;
+
+                    params.pop();
+                }
+            }
+
+            if (node->wildcard && matches(node->wildcard.get()) && params.push(node->wildcard->name, path))
+                return node->wildcard.get();
+
+            return nullptr;
+        }
+    }
+
+    const Router::Handler *Router::handlerOf(const Node *node, std::string_view method) noexcept {
+        for (auto &[name, handler] : node->handlers) {
+            if (name == method)
+                return &handler;
+        }
+
+        return nullptr;
+    }
+}
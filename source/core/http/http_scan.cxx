@@ -0,0 +1,258 @@
+#include "core/http/http_scan.hxx"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#include <immintrin.h>
+
+namespace CxxServer::Core::Http::Scan {
+    namespace {
+        constexpr bool isTokenChar(int c) noexcept {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                std::string_view("!#$%&'*+-.^_`|~").find(static_cast<char>(c)) != std::string_view::npos;
+        }
+
+        constexpr std::array<bool, 256> token_chars = [] {
+            std::array<bool, 256> table{};
+            for (int c = 0; c < 256; ++c)
+                table[c] = isTokenChar(c);
+
+            return table;
+        }();
+
+        // Token chars as a bitmap split by nibble, c is a token char iff low[c & 0xf] & high[c >> 4] != 0. Low nibble
+        // entries hold a bit per high nibble with that low nibble allowed, high nibble entries select the bit so
+        // bytes >= 0x80 select none
+        constexpr std::array<uint8_t, 16> token_low = [] {
+            std::array<uint8_t, 16> table{};
+            for (int c = 0; c < 128; ++c) {
+                if (isTokenChar(c))
+                    table[c & 0xf] |= static_cast<uint8_t>(1 << (c >> 4));
+            }
+
+            return table;
+        }();
+
+        constexpr std::array<uint8_t, 16> token_high = { 1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+        size_t scalarFindHeaderEnd(const char *data, size_t size) noexcept {
+            for (size_t pos = 0; size >= 4 && pos <= size - 4; ++pos) {
+                auto cr = static_cast<const char*>(std::memchr(data + pos, '\r', size - 3 - pos));
+                if (cr == nullptr)
+                    break;
+
+                pos = cr - data;
+                if (cr[1] == '\n' && cr[2] == '\r' && cr[3] == '\n')
+                    return pos;
+            }
+
+            return npos;
+        }
+
+        size_t scalarFindChar(const char *data, size_t size, char c) noexcept {
+            auto found = static_cast<const char*>(std::memchr(data, c, size));
+            return found == nullptr ? npos : found - data;
+        }
+
+        size_t scalarTokenLength(const char *data, size_t size) noexcept {
+            size_t i = 0;
+            while (i < size && token_chars[static_cast<unsigned char>(data[i])])
+                ++i;
+
+            return i;
+        }
+
+        __attribute__((target("sse4.2")))
+        size_t sseFindHeaderEnd(const char *data, size_t size) noexcept {
+            const __m128i cr = _mm_set1_epi8('\r');
+            const __m128i lf = _mm_set1_epi8('\n');
+
+            size_t pos = 0;
+            // every byte of a block is checked as the start of the terminator
+            for (; pos + 16 + 3 <= size; pos += 16) {
+                __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1));
+                __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 2));
+                __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 3));
+                __m128i match = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, cr), _mm_cmpeq_epi8(b1, lf)),
+                                              _mm_and_si128(_mm_cmpeq_epi8(b2, cr), _mm_cmpeq_epi8(b3, lf)));
+
+                int mask = _mm_movemask_epi8(match);
+                if (mask != 0)
+                    return pos + __builtin_ctz(mask);
+            }
+
+            size_t tail = scalarFindHeaderEnd(data + pos, size - pos);
+            return tail == npos ? npos : pos + tail;
+        }
+
+        __attribute__((target("sse4.2")))
+        size_t sseFindChar(const char *data, size_t size, char c) noexcept {
+            const __m128i needle = _mm_set1_epi8(c);
+
+            size_t pos = 0;
+            for (; pos + 16 <= size; pos += 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+                if (mask != 0)
+                    return pos + __builtin_ctz(mask);
+            }
+
+            size_t tail = scalarFindChar(data + pos, size - pos, c);
+            return tail == npos ? npos : pos + tail;
+        }
+
+        __attribute__((target("sse4.2")))
+        size_t sseTokenLength(const char *data, size_t size) noexcept {
+            const __m128i low_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(token_low.data()));
+            const __m128i high_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(token_high.data()));
+            const __m128i nibble = _mm_set1_epi8(0x0f);
+
+            size_t pos = 0;
+            for (; pos + 16 <= size; pos += 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                __m128i low = _mm_shuffle_epi8(low_table, _mm_and_si128(block, nibble));
+                __m128i high = _mm_shuffle_epi8(high_table, _mm_and_si128(_mm_srli_epi16(block, 4), nibble));
+                __m128i bad = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+                int mask = _mm_movemask_epi8(bad);
+                if (mask != 0)
+                    return pos + __builtin_ctz(mask);
+            }
+
+            return pos + scalarTokenLength(data + pos, size - pos);
+        }
+
+        __attribute__((target("avx2")))
+        size_t avxFindHeaderEnd(const char *data, size_t size) noexcept {
+            const __m256i cr = _mm256_set1_epi8('\r');
+            const __m256i lf = _mm256_set1_epi8('\n');
+
+            size_t pos = 0;
+            for (; pos + 32 + 3 <= size; pos += 32) {
+                __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+                // most blocks have no CR at all, skip them after a single compare
+                __m256i first = _mm256_cmpeq_epi8(b0, cr);
+                if (_mm256_testz_si256(first, first))
+                    continue;
+
+                __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 1));
+                __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 2));
+                __m256i b3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 3));
+                __m256i match = _mm256_and_si256(_mm256_and_si256(first, _mm256_cmpeq_epi8(b1, lf)),
+                                                 _mm256_and_si256(_mm256_cmpeq_epi8(b2, cr), _mm256_cmpeq_epi8(b3, lf)));
+
+                uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+                if (mask != 0)
+                    return pos + __builtin_ctz(mask);
+            }
+
+            size_t tail = scalarFindHeaderEnd(data + pos, size - pos);
+            return tail == npos ? npos : pos + tail;
+        }
+
+        __attribute__((target("avx2")))
+        size_t avxFindChar(const char *data, size_t size, char c) noexcept {
+            const __m256i needle = _mm256_set1_epi8(c);
+
+            size_t pos = 0;
+            for (; pos + 32 <= size; pos += 32) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+                uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+                if (mask != 0)
+                    return pos + __builtin_ctz(mask);
+            }
+
+            size_t tail = scalarFindChar(data + pos, size - pos, c);
+            return tail == npos ? npos : pos + tail;
+        }
+
+        __attribute__((target("avx2")))
+        size_t avxTokenLength(const char *data, size_t size) noexcept {
+            const __m256i low_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(token_low.data())));
+            const __m256i high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(token_high.data())));
+            const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+            size_t pos = 0;
+            for (; pos + 32 <= size; pos += 32) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+                __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(block, nibble));
+                __m256i high = _mm256_shuffle_epi8(high_table, _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble));
+                __m256i bad = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+                uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(bad));
+                if (mask != 0)
+                    return pos + __builtin_ctz(mask);
+            }
+
+            return pos + scalarTokenLength(data + pos, size - pos);
+        }
+
+        struct Kernels {
+            Isa isa;
+            size_t (*find_header_end)(const char*, size_t) noexcept;
+            size_t (*find_char)(const char*, size_t, char) noexcept;
+            size_t (*token_length)(const char*, size_t) noexcept;
+        };
+
+        constexpr Kernels scalar_kernels{ Isa::Scalar, scalarFindHeaderEnd, scalarFindChar, scalarTokenLength };
+        constexpr Kernels sse_kernels{ Isa::SSE42, sseFindHeaderEnd, sseFindChar, sseTokenLength };
+        constexpr Kernels avx_kernels{ Isa::AVX2, avxFindHeaderEnd, avxFindChar, avxTokenLength };
+
+        const Kernels *kernelsOf(Isa isa) noexcept {
+            switch (isa) {
+                case Isa::AVX2: return &avx_kernels;
+                case Isa::SSE42: return &sse_kernels;
+                default: return &scalar_kernels;
+            }
+        }
+
+        Isa detectIsa() noexcept {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return Isa::AVX2;
+            if (__builtin_cpu_supports("sse4.2"))
+                return Isa::SSE42;
+
+            return Isa::Scalar;
+        }
+
+        const Isa best_isa = detectIsa();
+        std::atomic<const Kernels*> kernels = kernelsOf(best_isa);
+    }
+
+    Isa isa() noexcept {
+        return kernels.load(std::memory_order_relaxed)->isa;
+    }
+
+    Isa bestIsa() noexcept {
+        return best_isa;
+    }
+
+    bool useIsa(Isa isa) noexcept {
+        if (static_cast<uint8_t>(isa) > static_cast<uint8_t>(best_isa))
+            return false;
+
+        kernels.store(kernelsOf(isa), std::memory_order_relaxed);
+        return true;
+    }
+
+    std::string_view name(Isa isa) noexcept {
+        switch (isa) {
+            case Isa::AVX2: return "AVX2";
+            case Isa::SSE42: return "SSE4.2";
+            default: return "Scalar";
+        }
+    }
+
+    size_t findHeaderEnd(const char *data, size_t size) noexcept {
+        return kernels.load(std::memory_order_relaxed)->find_header_end(data, size);
+    }
+
+    size_t findChar(const char *data, size_t size, char c) noexcept {
+        return kernels.load(std::memory_order_relaxed)->find_char(data, size, c);
+    }
+
+    size_t tokenLength(const char *data, size_t size) noexcept {
+        return kernels.load(std::memory_order_relaxed)->token_length(data, size);
+    }
+}
@@ -2,6 +2,7 @@
 #include "core/service.hxx"
 
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <exception>
 #include <memory>
@@ -15,7 +16,7 @@ namespace CxxServer::Core {
         service->onThreadInit();
 
         try {
-            asio::io_service::work work(*io);
+            // the service holds the IO work guard so a drain can release it & let run() return once idle
             do {
                 try {
                     if (polling) {
@@ -52,7 +53,7 @@ namespace CxxServer::Core {
 #endif
     }
 
-    Service::Service(std::size_t num_threads, bool own_io) : _strand_needed(false), _polling(false), _started(false), _rr_idx(0) {
+    Service::Service(std::size_t num_threads, bool own_io) : _strand_needed(false), _polling(false), _started(false), _rr_idx(0), _drain_dropped(0) {
         if (num_threads == 0)
         {
             // no threads => single IO service
@@ -79,7 +80,7 @@ namespace CxxServer::Core {
         }
     }
 
-    Service::Service(const std::shared_ptr<asio::io_service> &service, bool strands) : _strand_needed(strands), _polling(false), _started(false), _rr_idx(0) {
+    Service::Service(const std::shared_ptr<asio::io_service> &service, bool strands) : _strand_needed(strands), _polling(false), _started(false), _rr_idx(0), _drain_dropped(0) {
         assert((service != nullptr) && "IO service is invalid");
         if (service == nullptr)
             throw std::invalid_argument("IO service is invalid");
@@ -108,6 +109,10 @@ namespace CxxServer::Core {
 
         this->post(start_handler);
 
+        _works.clear();
+        for (auto &service : _services)
+            _works.emplace_back(std::make_shared<asio::io_service::work>(*service));
+
         for (std::size_t i = 0; i < _threads.size(); ++i) {
             _threads[i] = std::thread([this, self, i]() {
                 serviceThread(self, _services[i % _services.size()]);
@@ -145,6 +150,7 @@ namespace CxxServer::Core {
         for (auto &thread : _threads)
             thread.join();
         
+        _works.clear();
         _polling = false;
 
         while (isStarted())
@@ -153,6 +159,40 @@ namespace CxxServer::Core {
         return true;
     }
 
+    bool Service::stop(std::chrono::nanoseconds timeout) {
+        if (timeout.count() == 0)
+            return stop();
+
+        assert(isStarted() && "Service is not started");
+        if (!isStarted())
+            return false;
+
+        // release the work guards, IO services now return from run() once they have nothing left to do
+        _works.clear();
+        _drain_dropped = 0;
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (auto &service : _services) {
+            while (!service->stopped() && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            if (!service->stopped()) {
+                service->stop();
+                ++_drain_dropped;
+            }
+        }
+
+        _started = false;
+        onStopped();
+
+        for (auto &thread : _threads)
+            thread.join();
+
+        _polling = false;
+
+        return true;
+    }
+
     bool Service::restart() {
         bool polling = isPolling();
 
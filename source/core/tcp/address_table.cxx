@@ -0,0 +1,103 @@
+#include "core/tcp/address_table.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+
+namespace CxxServer::Core::Tcp {
+    std::size_t AddressTable::KeyHash::operator()(const Key &key) const noexcept {
+        return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(key.data()), key.size()));
+    }
+
+    AddressTable::Key AddressTable::key(const asio::ip::address &addr) {
+        if (addr.is_v6())
+            return addr.to_v6().to_bytes();
+
+        return asio::ip::make_address_v6(asio::ip::v4_mapped, addr.to_v4()).to_bytes();
+    }
+
+    bool AddressTable::acquire(const asio::ip::address &addr) {
+        auto k = key(addr);
+        auto &s = shard(k);
+
+        std::scoped_lock locker(s.lock);
+
+        auto [it, inserted] = s.entries.try_emplace(k);
+        auto &entry = it->second;
+
+        if (_limits.max_connections > 0 && entry.connections >= _limits.max_connections)
+            return false;
+
+        if (inserted) {
+            entry.bytes = _limits.bytes_burst > 0 ? _limits.bytes_burst : _limits.bytes_rate;
+            entry.messages = _limits.messages_burst > 0 ? _limits.messages_burst : _limits.messages_rate;
+            entry.refill = std::chrono::steady_clock::now();
+        }
+
+        ++entry.connections;
+        return true;
+    }
+
+    void AddressTable::release(const asio::ip::address &addr) {
+        auto k = key(addr);
+        auto &s = shard(k);
+
+        std::scoped_lock locker(s.lock);
+
+        auto it = s.entries.find(k);
+        if (it == s.entries.end())
+            return;
+
+        if (--it->second.connections == 0)
+            s.entries.erase(it);
+    }
+
+    std::chrono::nanoseconds AddressTable::consume(const asio::ip::address &addr, size_t bytes) {
+        if (_limits.bytes_rate <= 0 && _limits.messages_rate <= 0)
+            return std::chrono::nanoseconds(0);
+
+        auto k = key(addr);
+        auto &s = shard(k);
+
+        std::scoped_lock locker(s.lock);
+
+        auto it = s.entries.find(k);
+        if (it == s.entries.end())
+            return std::chrono::nanoseconds(0);
+
+        auto &entry = it->second;
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - entry.refill).count();
+        entry.refill = now;
+
+        // buckets may go negative as the data has already been read, the deficit is paid back by waiting
+        double wait = 0;
+        if (_limits.bytes_rate > 0) {
+            double burst = _limits.bytes_burst > 0 ? _limits.bytes_burst : _limits.bytes_rate;
+            entry.bytes = std::min(burst, entry.bytes + elapsed * _limits.bytes_rate) - bytes;
+            if (entry.bytes < 0)
+                wait = -entry.bytes / _limits.bytes_rate;
+        }
+
+        if (_limits.messages_rate > 0) {
+            double burst = _limits.messages_burst > 0 ? _limits.messages_burst : _limits.messages_rate;
+            entry.messages = std::min(burst, entry.messages + elapsed * _limits.messages_rate) - 1;
+            if (entry.messages < 0)
+                wait = std::max(wait, -entry.messages / _limits.messages_rate);
+        }
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(wait));
+    }
+
+    size_t AddressTable::size() const {
+        size_t total = 0;
+        for (auto &s : _shards) {
+            std::scoped_lock locker(s.lock);
+            total += s.entries.size();
+        }
+
+        return total;
+    }
+}
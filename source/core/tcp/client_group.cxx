@@ -0,0 +1,341 @@
+#include "core/tcp/client_group.hxx"
+
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+namespace CxxServer::Core::Tcp {
+
+ClientGroup::ClientGroup(const std::shared_ptr<Service> &service, const std::vector<Endpoint> &endpoints, const Factory &factory, Balance balance) :
+    _service(service),
+    _io(service->getIoService()),
+    _balance(balance),
+    _started(false),
+    _cursor(0),
+    _timer(*_io),
+    _ejected(0)
+{
+    assert((service != nullptr) && "IO service is invalid");
+    if (service == nullptr)
+        throw std::invalid_argument("IO service is invalid");
+
+    assert((factory != nullptr) && "Client factory is invalid");
+    if (factory == nullptr)
+        throw std::invalid_argument("Client factory is invalid");
+
+    assert(!endpoints.empty() && "Endpoints should not be empty");
+    if (endpoints.empty())
+        throw std::invalid_argument("Endpoints should not be empty");
+
+    _members.resize(endpoints.size());
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        _members[i].endpoint = endpoints[i];
+        _members[i].client = factory(endpoints[i]);
+        if (_members[i].client == nullptr)
+            throw std::invalid_argument("Client factory returned no client");
+
+        std::string name = endpoints[i].addr + ":" + std::to_string(endpoints[i].port) + "#";
+        for (size_t point = 0; point < ring_points; ++point)
+            _ring[std::hash<std::string>{}(name + std::to_string(point))] = i;
+    }
+}
+
+bool ClientGroup::start() {
+    if (_started.exchange(true))
+        return false;
+
+    for (size_t i = 0; i < _members.size(); ++i)
+        connect(i);
+
+    std::scoped_lock locker(_lock);
+    schedule();
+
+    return true;
+}
+
+bool ClientGroup::stop() {
+    if (!_started.exchange(false))
+        return false;
+
+    std::vector<std::shared_ptr<Client>> clients;
+    {
+        std::scoped_lock locker(_lock);
+        _timer.cancel();
+
+        for (auto &member : _members) {
+            member.healthy = false;
+            clients.push_back(member.client);
+        }
+    }
+
+    for (auto &client : clients)
+        client->disconnectAsync();
+
+    return true;
+}
+
+std::shared_ptr<Client> ClientGroup::acquire() {
+    return acquire(std::string_view());
+}
+
+std::shared_ptr<Client> ClientGroup::acquire(std::string_view key) {
+    std::scoped_lock locker(_lock);
+
+    size_t index = pick(key, _members.size());
+    if (index == _members.size())
+        return nullptr;
+
+    return _members[index].client;
+}
+
+std::shared_ptr<Client> ClientGroup::acquireOther(const std::shared_ptr<Client> &client) {
+    std::scoped_lock locker(_lock);
+
+    size_t index = pick(std::string_view(), find(client));
+    if (index == _members.size())
+        return nullptr;
+
+    return _members[index].client;
+}
+
+void ClientGroup::release(const std::shared_ptr<Client> &client, bool success) {
+    bool ejected = false;
+
+    {
+        std::scoped_lock locker(_lock);
+        size_t index = find(client);
+        if (index == _members.size())
+            return;
+
+        auto &member = _members[index];
+        if (member.outstanding > 0)
+            --member.outstanding;
+
+        if (success)
+            member.failures = 0;
+        else if (++member.failures >= _health.failure_threshold && _health.failure_threshold > 0)
+            ejected = eject(member);
+    }
+
+    if (!ejected)
+        return;
+
+    // the endpoint gets a fresh connection once it is reconnected
+    client->disconnectAsync();
+    onEject(client);
+}
+
+std::vector<std::shared_ptr<Client>> ClientGroup::clients() {
+    std::scoped_lock locker(_lock);
+
+    std::vector<std::shared_ptr<Client>> clients;
+    for (auto &member : _members)
+        clients.push_back(member.client);
+
+    return clients;
+}
+
+size_t ClientGroup::numHealthy() {
+    std::scoped_lock locker(_lock);
+
+    size_t healthy = 0;
+    for (auto &member : _members)
+        healthy += member.healthy;
+
+    return healthy;
+}
+
+size_t ClientGroup::numOutstanding(const std::shared_ptr<Client> &client) {
+    std::scoped_lock locker(_lock);
+
+    size_t index = find(client);
+    return index == _members.size() ? 0 : _members[index].outstanding;
+}
+
+size_t ClientGroup::pick(std::string_view key, size_t excluded) {
+    size_t count = _members.size();
+    size_t picked = count;
+
+    auto usable = [this, excluded](size_t index) { return index != excluded && _members[index].healthy && _members[index].client->isReady(); };
+
+    switch (_balance) {
+        case Balance::RoundRobin:
+            for (size_t i = 0; i < count && picked == count; ++i) {
+                if (usable((_cursor + i) % count))
+                    picked = (_cursor + i) % count;
+            }
+
+            if (picked != count)
+                _cursor = picked + 1;
+
+            break;
+
+        case Balance::LeastOutstanding:
+            // start from the cursor so ties are spread round robin
+            for (size_t i = 0; i < count; ++i) {
+                size_t index = (_cursor + i) % count;
+                if (usable(index) && (picked == count || _members[index].outstanding < _members[picked].outstanding))
+                    picked = index;
+            }
+
+            ++_cursor;
+            break;
+
+        case Balance::ConsistentHash: {
+            // walk the ring from the key's point to the first usable endpoint
+            auto it = _ring.lower_bound(std::hash<std::string_view>{}(key));
+            for (size_t i = 0; i < _ring.size() && picked == count; ++i, ++it) {
+                if (it == _ring.end())
+                    it = _ring.begin();
+
+                if (usable(it->second))
+                    picked = it->second;
+            }
+
+            break;
+        }
+    }
+
+    if (picked != count)
+        ++_members[picked].outstanding;
+
+    return picked;
+}
+
+size_t ClientGroup::find(const std::shared_ptr<Client> &client) const {
+    for (size_t i = 0; i < _members.size(); ++i) {
+        if (_members[i].client == client)
+            return i;
+    }
+
+    return _members.size();
+}
+
+bool ClientGroup::eject(Member &member) {
+    if (!member.healthy)
+        return false;
+
+    member.healthy = false;
+    member.ejected = true;
+    member.failures = 0;
+    member.ejected_until = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(_health.eject_time);
+    ++_ejected;
+
+    return true;
+}
+
+void ClientGroup::connect(size_t index) {
+    std::shared_ptr<Client> client;
+
+    {
+        std::scoped_lock locker(_lock);
+        auto &member = _members[index];
+        if (member.connecting || !isStarted())
+            return;
+
+        member.connecting = true;
+        client = member.client;
+    }
+
+    std::weak_ptr<ClientGroup> weak_self(this->shared_from_this());
+    auto ready_handler = [weak_self, index](bool ready) {
+        auto self = weak_self.lock();
+        if (!self)
+            return;
+
+        std::shared_ptr<Client> restored;
+        std::shared_ptr<Client> stopped;
+
+        {
+            std::scoped_lock locker(self->_lock);
+            auto &member = self->_members[index];
+            member.connecting = false;
+
+            if (!ready) {
+                // failed connects wait out the eject time before they are tried again
+                member.ejected_until = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(self->_health.eject_time);
+            }
+            else if (!self->isStarted())
+                stopped = member.client;
+            else {
+                member.healthy = true;
+                member.failures = 0;
+                if (member.ejected)
+                    restored = member.client;
+
+                member.ejected = false;
+            }
+        }
+
+        if (stopped)
+            stopped->disconnectAsync();
+
+        if (restored)
+            self->onRestore(restored);
+    };
+
+    // a connect already in progress, e.g. by the client's reconnect policy, is waited on rather than failed
+    if (!client->connectNotify(ready_handler))
+        ready_handler(true);
+}
+
+void ClientGroup::check() {
+    std::vector<std::shared_ptr<Client>> ejected;
+    std::vector<std::shared_ptr<Client>> restored;
+    std::vector<size_t> reconnect;
+
+    {
+        std::scoped_lock locker(_lock);
+        auto now = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < _members.size(); ++i) {
+            auto &member = _members[i];
+            if (member.connecting)
+                continue;
+
+            if (member.healthy && !member.client->isReady()) {
+                if (eject(member))
+                    ejected.push_back(member.client);
+            }
+            else if (!member.healthy && now >= member.ejected_until) {
+                // the client may have reconnected on its own
+                if (member.client->isReady()) {
+                    member.healthy = true;
+                    if (member.ejected)
+                        restored.push_back(member.client);
+
+                    member.ejected = false;
+                }
+                else if (!member.client->isConnected())
+                    reconnect.push_back(i);
+            }
+        }
+    }
+
+    for (auto &client : ejected)
+        onEject(client);
+
+    for (auto &client : restored)
+        onRestore(client);
+
+    for (auto index : reconnect)
+        connect(index);
+}
+
+void ClientGroup::schedule() {
+    std::weak_ptr<ClientGroup> weak_self(this->shared_from_this());
+
+    _timer.expires_after(std::chrono::duration_cast<asio::system_timer::duration>(_health.check_interval));
+    _timer.async_wait([weak_self](std::error_code error) {
+        auto self = weak_self.lock();
+        if (error || !self || !self->isStarted())
+            return;
+
+        self->check();
+
+        std::scoped_lock locker(self->_lock);
+        if (self->isStarted())
+            self->schedule();
+    });
+}
+}
@@ -0,0 +1,340 @@
+#include "core/tcp/client_pool.hxx"
+#include "core/tcp/ssl_client.hxx"
+
+#include <cassert>
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace CxxServer::Core::Tcp {
+
+ClientPool::ClientPool(const std::shared_ptr<Service> &service, const Factory &factory) :
+    _service(service),
+    _io(service->getIoService()),
+    _factory(factory),
+    _started(false),
+    _timer(*_io),
+    _created(0),
+    _reused(0),
+    _evicted(0)
+{
+    assert((service != nullptr) && "IO service is invalid");
+    if (service == nullptr)
+        throw std::invalid_argument("IO service is invalid");
+
+    assert((factory != nullptr) && "Client factory is invalid");
+    if (factory == nullptr)
+        throw std::invalid_argument("Client factory is invalid");
+}
+
+bool ClientPool::start() {
+    if (_started.exchange(true))
+        return false;
+
+    std::scoped_lock locker(_lock);
+    schedule();
+
+    return true;
+}
+
+bool ClientPool::stop() {
+    if (!_started.exchange(false))
+        return false;
+
+    std::vector<std::shared_ptr<Client>> idle;
+    std::vector<CheckoutHandler> waiters;
+
+    {
+        std::scoped_lock locker(_lock);
+        _timer.cancel();
+
+        for (auto &[key, upstream] : _upstreams) {
+            for (auto &entry : upstream.idle)
+                idle.push_back(std::move(entry.client));
+
+            for (auto &waiter : upstream.waiters)
+                waiters.push_back(std::move(waiter));
+
+            upstream.connections -= upstream.idle.size();
+            upstream.idle.clear();
+            upstream.waiters.clear();
+        }
+    }
+
+    for (auto &client : idle)
+        client->disconnectAsync();
+
+    for (auto &waiter : waiters)
+        waiter(nullptr, asio::error::make_error_code(asio::error::operation_aborted));
+
+    return true;
+}
+
+void ClientPool::reserve(const Key &key) {
+    if (!isStarted())
+        return;
+
+    size_t needed = 0;
+    {
+        std::scoped_lock locker(_lock);
+        auto &upstream = _upstreams[key];
+        if (upstream.connections < _limits.min_connections) {
+            needed = _limits.min_connections - upstream.connections;
+            upstream.connections += needed;
+        }
+    }
+
+    for (size_t i = 0; i < needed; ++i)
+        connect(key, nullptr);
+}
+
+bool ClientPool::checkout(const Key &key, CheckoutHandler handler) {
+    if (!isStarted())
+        return false;
+
+    std::vector<std::shared_ptr<Client>> dead;
+    std::shared_ptr<Client> client;
+    bool create = false;
+
+    {
+        std::scoped_lock locker(_lock);
+        auto &upstream = _upstreams[key];
+
+        // most recently used first, it is the least likely to have been closed by the upstream
+        while (!upstream.idle.empty()) {
+            auto candidate = std::move(upstream.idle.back().client);
+            upstream.idle.pop_back();
+
+            if (isAlive(candidate)) {
+                client = std::move(candidate);
+                break;
+            }
+
+            --upstream.connections;
+            dead.push_back(std::move(candidate));
+        }
+
+        if (!client) {
+            if (_limits.max_connections == 0 || upstream.connections < _limits.max_connections) {
+                ++upstream.connections;
+                create = true;
+            }
+            else
+                upstream.waiters.push_back(std::move(handler));
+        }
+    }
+
+    _evicted += dead.size();
+    for (auto &closed : dead)
+        closed->disconnectAsync();
+
+    if (client) {
+        ++_reused;
+        handler(client, std::error_code());
+    }
+    else if (create)
+        connect(key, std::move(handler));
+
+    return true;
+}
+
+void ClientPool::release(const Key &key, const std::shared_ptr<Client> &client) {
+    if (!client)
+        return;
+
+    if (client->isReady() && isAlive(client)) {
+        recycle(key, client);
+        return;
+    }
+
+    client->disconnectAsync();
+    drop(key);
+}
+
+size_t ClientPool::numConnections() {
+    std::scoped_lock locker(_lock);
+
+    size_t total = 0;
+    for (auto &[key, upstream] : _upstreams)
+        total += upstream.connections;
+
+    return total;
+}
+
+size_t ClientPool::numIdle() {
+    std::scoped_lock locker(_lock);
+
+    size_t total = 0;
+    for (auto &[key, upstream] : _upstreams)
+        total += upstream.idle.size();
+
+    return total;
+}
+
+void ClientPool::connect(const Key &key, CheckoutHandler handler) {
+    auto client = _factory(key);
+    if (!client) {
+        drop(key);
+        if (handler)
+            handler(nullptr, asio::error::make_error_code(asio::error::not_connected));
+
+        return;
+    }
+
+    if (!key.server_name.empty()) {
+        if (auto ssl = std::dynamic_pointer_cast<SSL::Client>(client); ssl && ssl->serverName().empty())
+            ssl->serverName() = key.server_name;
+    }
+
+    std::weak_ptr<ClientPool> weak_self(this->shared_from_this());
+    std::weak_ptr<Client> weak_client(client);
+
+    auto ready_handler = [weak_self, weak_client, key, handler](bool ready) {
+        auto self = weak_self.lock();
+        auto connected = weak_client.lock();
+
+        if (self && connected && ready && self->isStarted()) {
+            ++self->_created;
+            if (handler)
+                handler(connected, std::error_code());
+            else
+                self->recycle(key, connected);
+
+            return;
+        }
+
+        if (connected && ready)
+            connected->disconnectAsync();
+
+        if (self)
+            self->drop(key);
+
+        if (handler)
+            handler(nullptr, asio::error::make_error_code(ready ? asio::error::operation_aborted : asio::error::not_connected));
+    };
+
+    if (!client->connectNotify(ready_handler))
+        ready_handler(true);
+}
+
+void ClientPool::recycle(const Key &key, const std::shared_ptr<Client> &client) {
+    CheckoutHandler waiter;
+
+    {
+        std::scoped_lock locker(_lock);
+        auto &upstream = _upstreams[key];
+
+        if (isStarted()) {
+            if (upstream.waiters.empty()) {
+                upstream.idle.push_back({client, std::chrono::steady_clock::now()});
+                return;
+            }
+
+            waiter = std::move(upstream.waiters.front());
+            upstream.waiters.pop_front();
+        }
+        else
+            --upstream.connections;
+    }
+
+    if (!waiter) {
+        client->disconnectAsync();
+        return;
+    }
+
+    ++_reused;
+    waiter(client, std::error_code());
+}
+
+void ClientPool::drop(const Key &key) {
+    CheckoutHandler waiter;
+
+    {
+        std::scoped_lock locker(_lock);
+        auto &upstream = _upstreams[key];
+        --upstream.connections;
+
+        // the freed slot goes to the first waiter
+        if (isStarted() && !upstream.waiters.empty()) {
+            waiter = std::move(upstream.waiters.front());
+            upstream.waiters.pop_front();
+            ++upstream.connections;
+        }
+    }
+
+    if (waiter)
+        connect(key, std::move(waiter));
+}
+
+bool ClientPool::isAlive(const std::shared_ptr<Client> &client) {
+    if (!client->isReady())
+        return false;
+
+    // a closed connection reads as EOF, anything else (including pending data) leaves the socket to the client
+    char byte;
+    ssize_t peeked = ::recv(client->socket().native_handle(), &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT);
+    if (peeked == 0)
+        return false;
+
+    return peeked > 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+void ClientPool::maintain() {
+    std::vector<std::shared_ptr<Client>> evicted;
+    std::vector<std::pair<Key, size_t>> top_ups;
+
+    {
+        std::scoped_lock locker(_lock);
+        auto now = std::chrono::steady_clock::now();
+
+        for (auto &[key, upstream] : _upstreams) {
+            // idle clients are pushed to the back, the oldest are at the front
+            for (auto it = upstream.idle.begin(); it != upstream.idle.end();) {
+                bool expired = (now - it->since >= _limits.idle_timeout) && upstream.connections > _limits.min_connections;
+                if (!expired && isAlive(it->client)) {
+                    ++it;
+                    continue;
+                }
+
+                evicted.push_back(std::move(it->client));
+                it = upstream.idle.erase(it);
+                --upstream.connections;
+            }
+
+            if (upstream.connections < _limits.min_connections) {
+                top_ups.emplace_back(key, _limits.min_connections - upstream.connections);
+                upstream.connections = _limits.min_connections;
+            }
+        }
+    }
+
+    _evicted += evicted.size();
+    for (auto &client : evicted)
+        client->disconnectAsync();
+
+    for (auto &[key, needed] : top_ups) {
+        for (size_t i = 0; i < needed; ++i)
+            connect(key, nullptr);
+    }
+}
+
+void ClientPool::schedule() {
+    std::weak_ptr<ClientPool> weak_self(this->shared_from_this());
+
+    _timer.expires_after(std::chrono::duration_cast<asio::system_timer::duration>(_limits.check_interval));
+    _timer.async_wait([weak_self](std::error_code error) {
+        auto self = weak_self.lock();
+        if (error || !self || !self->isStarted())
+            return;
+
+        self->maintain();
+
+        std::scoped_lock locker(self->_lock);
+        if (self->isStarted())
+            self->schedule();
+    });
+}
+}
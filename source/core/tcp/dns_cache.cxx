@@ -0,0 +1,56 @@
+#include "core/tcp/dns_cache.hxx"
+
+namespace CxxServer::Core::Tcp {
+
+DnsCache::DnsCache(const std::chrono::nanoseconds &ttl) :
+    _ttl(ttl),
+    _hits(0),
+    _misses(0)
+{}
+
+const std::shared_ptr<DnsCache> &DnsCache::global() {
+    static const std::shared_ptr<DnsCache> cache = std::make_shared<DnsCache>();
+    return cache;
+}
+
+bool DnsCache::lookup(const std::string &host, const std::string &service, Endpoints &endpoints) {
+    std::scoped_lock locker(_lock);
+
+    auto it = _entries.find({host, service});
+    if (it == _entries.end() || it->second.expires <= std::chrono::steady_clock::now()) {
+        if (it != _entries.end())
+            _entries.erase(it);
+
+        ++_misses;
+        return false;
+    }
+
+    ++_hits;
+    endpoints = it->second.endpoints;
+    return true;
+}
+
+void DnsCache::store(const std::string &host, const std::string &service, const Endpoints &endpoints) {
+    if (endpoints.empty())
+        return;
+
+    std::scoped_lock locker(_lock);
+    auto expires = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(_ttl);
+    _entries[{host, service}] = {endpoints, expires};
+}
+
+void DnsCache::erase(const std::string &host, const std::string &service) {
+    std::scoped_lock locker(_lock);
+    _entries.erase({host, service});
+}
+
+void DnsCache::clear() {
+    std::scoped_lock locker(_lock);
+    _entries.clear();
+}
+
+size_t DnsCache::size() {
+    std::scoped_lock locker(_lock);
+    return _entries.size();
+}
+}
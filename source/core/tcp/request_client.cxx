@@ -0,0 +1,273 @@
+#include "core/tcp/request_client.hxx"
+
+#include <utility>
+
+namespace CxxServer::Core::Tcp {
+
+RequestClient::RequestClient(const std::shared_ptr<Service> &service, const std::string &addr, unsigned int port, Correlation correlation) :
+    Client(service, addr, port),
+    _correlation(correlation),
+    _next_id(0),
+    _deadline_timer(*io()),
+    _deadline_armed(std::chrono::system_clock::time_point::max()),
+    _completed(0),
+    _timed_out(0),
+    _cancelled(0)
+{}
+
+uint64_t RequestClient::request(const void *request, size_t size, const ResponseHandler &handler, std::chrono::nanoseconds timeout) {
+    if (!isReady() || handler == nullptr)
+        return 0;
+
+    // sent under the lock so requests go out in Id order, which correlating by order relies on
+    std::scoped_lock locker(_requests_lock);
+
+    uint64_t id = ++_next_id;
+    Pending pending{handler, std::chrono::system_clock::time_point::max()};
+    if (timeout.count() > 0)
+        pending.deadline = std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(timeout);
+
+    _frame.clear();
+    encodeRequest(id, request, size, _frame);
+    if (!sendAsync(_frame.data(), _frame.size()))
+        return 0;
+
+    if (timeout.count() > 0) {
+        _deadlines.emplace(pending.deadline, id);
+        armDeadline();
+    }
+
+    _pending.emplace(id, std::move(pending));
+    if (_correlation == Correlation::Fifo)
+        _order.push_back(id);
+
+    return id;
+}
+
+std::future<std::vector<uint8_t>> RequestClient::request(const void *request, size_t size, std::chrono::nanoseconds timeout) {
+    auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+    auto future = promise->get_future();
+
+    auto handler = [promise](std::error_code err, const void *response, size_t length) {
+        if (err) {
+            promise->set_exception(std::make_exception_ptr(std::system_error(err)));
+            return;
+        }
+
+        auto bytes = static_cast<const uint8_t*>(response);
+        promise->set_value(std::vector<uint8_t>(bytes, bytes + length));
+    };
+
+    if (this->request(request, size, handler, timeout) == 0)
+        promise->set_exception(std::make_exception_ptr(std::system_error(asio::error::make_error_code(asio::error::not_connected))));
+
+    return future;
+}
+
+bool RequestClient::cancel(uint64_t id) {
+    Pending pending;
+
+    {
+        std::scoped_lock locker(_requests_lock);
+        if (!take(id, pending))
+            return false;
+    }
+
+    ++_cancelled;
+    pending.handler(asio::error::make_error_code(asio::error::operation_aborted), nullptr, 0);
+    return true;
+}
+
+size_t RequestClient::numPending() {
+    std::scoped_lock locker(_requests_lock);
+    return _pending.size();
+}
+
+void RequestClient::onReceive(const void *buffer, size_t size) {
+    auto bytes = static_cast<const uint8_t*>(buffer);
+
+    // whole responses are handled straight from the receive buffer, only a partial response is kept
+    if (_response_buff.empty()) {
+        size_t consumed = dispatch(bytes, size);
+        if (consumed < size)
+            _response_buff.assign(bytes + consumed, bytes + size);
+
+        return;
+    }
+
+    _response_buff.insert(_response_buff.end(), bytes, bytes + size);
+    size_t consumed = dispatch(_response_buff.data(), _response_buff.size());
+    _response_buff.erase(_response_buff.begin(), _response_buff.begin() + consumed);
+}
+
+void RequestClient::onDisconnect() {
+    std::vector<Pending> aborted;
+
+    {
+        std::scoped_lock locker(_requests_lock);
+        for (auto &[id, pending] : _pending)
+            aborted.push_back(std::move(pending));
+
+        _pending.clear();
+        _order.clear();
+        _deadlines.clear();
+        _deadline_armed = std::chrono::system_clock::time_point::max();
+
+        asio::error_code err;
+        _deadline_timer.cancel(err);
+    }
+
+    _response_buff.clear();
+
+    for (auto &pending : aborted)
+        pending.handler(asio::error::make_error_code(asio::error::connection_aborted), nullptr, 0);
+}
+
+void RequestClient::encodeRequest(uint64_t id, const void *request, size_t size, std::vector<uint8_t> &frame) {
+    uint32_t length = static_cast<uint32_t>(sizeof(id) + size);
+
+    for (size_t i = 0; i < sizeof(length); ++i)
+        frame.push_back(static_cast<uint8_t>(length >> (8 * i)));
+
+    for (size_t i = 0; i < sizeof(id); ++i)
+        frame.push_back(static_cast<uint8_t>(id >> (8 * i)));
+
+    auto bytes = static_cast<const uint8_t*>(request);
+    frame.insert(frame.end(), bytes, bytes + size);
+}
+
+size_t RequestClient::decodeResponse(const void *buffer, size_t size, uint64_t &id, size_t &offset, size_t &length) {
+    constexpr size_t header_size = sizeof(uint32_t) + sizeof(uint64_t);
+
+    auto bytes = static_cast<const uint8_t*>(buffer);
+    if (size < sizeof(uint32_t))
+        return 0;
+
+    uint32_t frame_length = 0;
+    for (size_t i = 0; i < sizeof(frame_length); ++i)
+        frame_length |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+
+    if (size < sizeof(uint32_t) + frame_length)
+        return 0;
+
+    // a frame too short for an Id matches no request
+    if (frame_length < sizeof(uint64_t)) {
+        id = 0;
+        offset = sizeof(uint32_t);
+        length = 0;
+        return sizeof(uint32_t) + frame_length;
+    }
+
+    id = 0;
+    for (size_t i = 0; i < sizeof(id); ++i)
+        id |= static_cast<uint64_t>(bytes[sizeof(uint32_t) + i]) << (8 * i);
+
+    offset = header_size;
+    length = frame_length - sizeof(uint64_t);
+    return sizeof(uint32_t) + frame_length;
+}
+
+size_t RequestClient::dispatch(const uint8_t *buffer, size_t size) {
+    size_t consumed = 0;
+
+    while (consumed < size) {
+        uint64_t id = 0;
+        size_t offset = 0;
+        size_t length = 0;
+
+        size_t frame = decodeResponse(buffer + consumed, size - consumed, id, offset, length);
+        if (frame == 0)
+            break;
+
+        Pending pending;
+        bool found;
+        {
+            std::scoped_lock locker(_requests_lock);
+            if (_correlation == Correlation::Fifo) {
+                id = _order.empty() ? 0 : _order.front();
+                if (!_order.empty())
+                    _order.pop_front();
+            }
+
+            found = take(id, pending);
+        }
+
+        if (found) {
+            ++_completed;
+            pending.handler(std::error_code(), buffer + consumed + offset, length);
+        }
+
+        consumed += frame;
+    }
+
+    return consumed;
+}
+
+bool RequestClient::take(uint64_t id, Pending &pending) {
+    auto it = _pending.find(id);
+    if (it == _pending.end())
+        return false;
+
+    pending = std::move(it->second);
+    _pending.erase(it);
+
+    if (pending.deadline != std::chrono::system_clock::time_point::max()) {
+        auto [first, last] = _deadlines.equal_range(pending.deadline);
+        for (auto deadline = first; deadline != last; ++deadline) {
+            if (deadline->second == id) {
+                _deadlines.erase(deadline);
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void RequestClient::armDeadline() {
+    if (_deadlines.empty() || _deadlines.begin()->first >= _deadline_armed)
+        return;
+
+    _deadline_armed = _deadlines.begin()->first;
+
+    std::weak_ptr<Client> weak_self(this->shared_from_this());
+    auto deadline_handler = [weak_self](std::error_code err) {
+        auto self = std::static_pointer_cast<RequestClient>(weak_self.lock());
+        if (err || !self)
+            return;
+
+        self->expire();
+    };
+
+    // timeouts are serialized with the responses dispatched by the client's other handlers
+    _deadline_timer.expires_at(_deadline_armed);
+    if (_strand_needed)
+        _deadline_timer.async_wait(asio::bind_executor(_strand, deadline_handler));
+    else
+        _deadline_timer.async_wait(deadline_handler);
+}
+
+void RequestClient::expire() {
+    std::vector<Pending> expired;
+
+    {
+        std::scoped_lock locker(_requests_lock);
+        _deadline_armed = std::chrono::system_clock::time_point::max();
+
+        auto now = std::chrono::system_clock::now();
+        while (!_deadlines.empty() && _deadlines.begin()->first <= now) {
+            Pending pending;
+            if (take(_deadlines.begin()->second, pending))
+                expired.push_back(std::move(pending));
+            else
+                _deadlines.erase(_deadlines.begin());
+        }
+
+        armDeadline();
+    }
+
+    _timed_out += expired.size();
+    for (auto &pending : expired)
+        pending.handler(asio::error::make_error_code(asio::error::timed_out), nullptr, 0);
+}
+}
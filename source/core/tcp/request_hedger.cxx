@@ -0,0 +1,232 @@
+#include "core/tcp/request_hedger.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+namespace CxxServer::Core::Tcp {
+
+RequestHedger::RequestHedger(const std::shared_ptr<Service> &service, const std::shared_ptr<ClientGroup> &group) :
+    _service(service),
+    _io(service->getIoService()),
+    _group(group),
+    _delay(0),
+    _delay_age(0),
+    _tokens(0.0),
+    _timer(*_io),
+    _timer_armed(std::chrono::system_clock::time_point::max()),
+    _requests(0),
+    _hedged(0),
+    _hedge_wins(0)
+{
+    assert((service != nullptr) && "IO service is invalid");
+    if (service == nullptr)
+        throw std::invalid_argument("IO service is invalid");
+
+    assert((group != nullptr) && "Client group is invalid");
+    if (group == nullptr)
+        throw std::invalid_argument("Client group is invalid");
+}
+
+bool RequestHedger::request(const void *request, size_t size, const RequestClient::ResponseHandler &handler, std::chrono::nanoseconds timeout) {
+    if (handler == nullptr)
+        return false;
+
+    auto client = _group->acquire();
+    if (client == nullptr)
+        return false;
+
+    auto flight = std::make_shared<Flight>();
+    flight->handler = handler;
+    flight->timeout = timeout;
+    flight->start = std::chrono::steady_clock::now();
+    flight->primary = client;
+    flight->outstanding = 1;
+
+    if (!send(flight, client, false, request, size, timeout)) {
+        _group->release(client, false);
+        return false;
+    }
+
+    ++_requests;
+
+    std::scoped_lock locker(_lock);
+    _tokens = std::min(_tokens + _settings.max_hedge_ratio, _settings.hedge_burst);
+
+    // no hedging until enough latencies are known to pick a delay
+    if (_delay.count() > 0 && !flight->done) {
+        auto bytes = static_cast<const uint8_t*>(request);
+        flight->request.assign(bytes, bytes + size);
+
+        _hedges.emplace(std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(_delay), flight);
+        arm();
+    }
+
+    return true;
+}
+
+std::chrono::nanoseconds RequestHedger::hedgeDelay() {
+    std::scoped_lock locker(_lock);
+    return _delay;
+}
+
+std::chrono::nanoseconds RequestHedger::latency(double percentile) {
+    std::scoped_lock locker(_lock);
+    return percentileOf(_observed, percentile);
+}
+
+std::chrono::nanoseconds RequestHedger::primaryLatency(double percentile) {
+    std::scoped_lock locker(_lock);
+    return percentileOf(_primary, percentile);
+}
+
+bool RequestHedger::send(const std::shared_ptr<Flight> &flight, const std::shared_ptr<Client> &client, bool hedge, const void *request, size_t size, std::chrono::nanoseconds timeout) {
+    auto requests = std::dynamic_pointer_cast<RequestClient>(client);
+    if (requests == nullptr)
+        return false;
+
+    auto self = this->shared_from_this();
+    return requests->request(request, size, [self, flight, client, hedge](std::error_code err, const void *response, size_t length) {
+        self->_group->release(client, !err || err == asio::error::operation_aborted);
+        self->complete(flight, hedge, err, response, length);
+    }, timeout) != 0;
+}
+
+void RequestHedger::complete(const std::shared_ptr<Flight> &flight, bool hedge, std::error_code err, const void *response, size_t size) {
+    {
+        std::scoped_lock locker(_lock);
+        auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - flight->start);
+
+        // late primaries are still recorded, they are what a caller would have waited for without the hedge
+        if (!hedge && !err)
+            record(_primary, latency);
+
+        --flight->outstanding;
+        if (flight->done)
+            return;
+
+        // an error only completes the request once no other attempt can answer it
+        if (err) {
+            flight->err = err;
+            if (flight->outstanding > 0)
+                return;
+        }
+
+        flight->done = true;
+        if (!err)
+            record(_observed, latency);
+    }
+
+    if (hedge && !err)
+        ++_hedge_wins;
+
+    flight->handler(err, response, size);
+}
+
+void RequestHedger::record(Window &window, std::chrono::nanoseconds latency) {
+    size_t limit = std::max<size_t>(_settings.window, 1);
+    if (window.samples.size() < limit)
+        window.samples.push_back(latency.count());
+    else
+        window.samples[window.next] = latency.count();
+
+    window.next = (window.next + 1) % limit;
+
+    if (&window != &_primary)
+        return;
+
+    // the delay only drifts slowly, recompute it every 1/16 of a window rather than on every response
+    if (_primary.samples.size() < _settings.warmup || (++_delay_age < std::max<size_t>(limit / 16, 1) && _delay.count() > 0))
+        return;
+
+    _delay_age = 0;
+    _delay = std::max(_settings.min_delay, percentileOf(_primary, _settings.percentile));
+}
+
+std::chrono::nanoseconds RequestHedger::percentileOf(const Window &window, double percentile) {
+    if (window.samples.empty())
+        return std::chrono::nanoseconds(0);
+
+    auto samples = window.samples;
+    size_t index = std::min(static_cast<size_t>(std::clamp(percentile, 0.0, 1.0) * samples.size()), samples.size() - 1);
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+
+    return std::chrono::nanoseconds(samples[index]);
+}
+
+void RequestHedger::arm() {
+    if (_hedges.empty() || _hedges.begin()->first >= _timer_armed)
+        return;
+
+    _timer_armed = _hedges.begin()->first;
+
+    std::weak_ptr<RequestHedger> weak_self(this->shared_from_this());
+    _timer.expires_at(_timer_armed);
+    _timer.async_wait([weak_self](std::error_code err) {
+        auto self = weak_self.lock();
+        if (err || !self)
+            return;
+
+        self->hedge();
+    });
+}
+
+void RequestHedger::hedge() {
+    std::vector<std::pair<std::shared_ptr<Flight>, std::chrono::nanoseconds>> due;
+
+    {
+        std::scoped_lock locker(_lock);
+        _timer_armed = std::chrono::system_clock::time_point::max();
+
+        auto now = std::chrono::system_clock::now();
+        auto elapsed_now = std::chrono::steady_clock::now();
+        while (!_hedges.empty() && _hedges.begin()->first <= now) {
+            auto flight = std::move(_hedges.begin()->second);
+            _hedges.erase(_hedges.begin());
+
+            if (flight->done || flight->hedged || _tokens < 1.0)
+                continue;
+
+            // the hedge gets whatever is left of the request's timeout
+            auto timeout = flight->timeout;
+            if (timeout.count() > 0) {
+                timeout -= std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed_now - flight->start);
+                if (timeout.count() <= 0)
+                    continue;
+            }
+
+            flight->hedged = true;
+            ++flight->outstanding;
+            _tokens -= 1.0;
+            due.emplace_back(std::move(flight), timeout);
+        }
+
+        arm();
+    }
+
+    for (auto &[flight, timeout] : due) {
+        auto client = _group->acquireOther(flight->primary);
+        if (client != nullptr && send(flight, client, true, flight->request.data(), flight->request.size(), timeout)) {
+            ++_hedged;
+            continue;
+        }
+
+        if (client != nullptr)
+            _group->release(client, false);
+
+        bool failed = false;
+        {
+            std::scoped_lock locker(_lock);
+            // the primary may have failed while the hedge was being sent, then nothing is left to answer
+            if (--flight->outstanding == 0 && !flight->done) {
+                flight->done = true;
+                failed = true;
+            }
+        }
+
+        if (failed)
+            flight->handler(flight->err, nullptr, 0);
+    }
+}
+}
@@ -54,9 +54,14 @@ namespace CxxServer::Core::SSL {
         }
 
         bool Client::disconnect() {
-            if (!isConnected() || _connecting || _handshaking)
+            disconnectRequested();
+
+            if (!isConnected() || _connecting || _handshaking) {
+                _drop = Drop::None;
                 return false;
+            }
 
+            closeSends();
             _handshaked = false;
             _handshaking = false;
 
@@ -66,13 +71,21 @@ namespace CxxServer::Core::SSL {
         }
 
         bool Client::disconnectAsync(bool dispatch) {
-            if (!isConnected() || _connecting || _handshaking)
+            disconnectRequested();
+
+            if (!isConnected() || _connecting || _handshaking) {
+                _drop = Drop::None;
                 return false;
+            }
 
             auto self = this->shared_from_this();
             auto disconnect_handler = HandlerFastMem(_connecting_storage, [this, self]() {
-                if (!isConnected() || _connecting || _handshaking)
+                if (!isConnected() || _connecting || _handshaking) {
+                    _drop = Drop::None;
                     return;
+                }
+
+                ++_generation;
 
                 std::error_code err;
                 socket().cancel(err);
@@ -111,7 +124,10 @@ namespace CxxServer::Core::SSL {
             // make a new stream as if we try to reconnect with the old one it will die
             _stream = asio::ssl::stream<asio::ip::tcp::socket>(*_io, *_context);
 
-            socket().connect(_endpoint, err);
+            Tcp::DnsCache::Endpoints endpoints;
+            err = resolve(endpoints);
+            if (!err)
+                _endpoint = asio::connect(socket(), endpoints, err);
 
             if (err) {
                 this->err(err);
@@ -131,6 +147,7 @@ namespace CxxServer::Core::SSL {
 
             onConnect();
 
+            setServerName();
             _stream.handshake(asio::ssl::stream_base::client, err);
             if (err) {
                 this->err(err);
@@ -138,12 +155,16 @@ namespace CxxServer::Core::SSL {
                 return false;
             }
 
+            openSends();
             _handshaked = true;
             onHandshaked();
 
+            reconnected();
+
             if (_send_buff_main.empty())
                 onEmpty();
 
+            notifyReady(true);
             return true;
         }
 
@@ -157,6 +178,8 @@ namespace CxxServer::Core::SSL {
             if (err) {
                 this->err(err);
                 onDisconnect();
+                notifyReady(false);
+                reconnectOn(true);
                 return;
             }
 
@@ -183,19 +206,28 @@ namespace CxxServer::Core::SSL {
 
                 if (handshake_err) {
                     this->err(handshake_err);
+                    _drop = Drop::ConnectFailed;
                     disconnectAsync(true);
+                    notifyReady(false);
                     return;
                 }
 
+                openSends();
                 _handshaked = true;
                 onHandshaked();
 
                 tryReceive();
 
+                reconnected();
+
                 if (_send_buff_main.empty())
                     onEmpty();
+
+                notifyReady(true);
             });
 
+            setServerName();
+
             if (_strand_needed)
                 _stream.async_handshake(asio::ssl::stream_base::client, asio::bind_executor(_strand, handshake_handler));
             else
@@ -215,14 +247,16 @@ namespace CxxServer::Core::SSL {
                     return;
 
                 _connecting = true;
-                auto connect_callback_handler = HandlerFastMem(_connecting_storage, [this, self](std::error_code err) { 
-                    connectEndpoint(self, err,  _endpoint); 
+                resolveAsync([this, self](std::error_code err, const Tcp::DnsCache::Endpoints &endpoints) {
+                    if (err) {
+                        connectEndpoint(self, err, _endpoint);
+                        return;
+                    }
+
+                    connectRace(endpoints, [this, self](std::error_code connect_err, const asio::ip::tcp::endpoint &endpoint) {
+                        connectEndpoint(self, connect_err, endpoint);
+                    });
                 });
-                _endpoint = asio::ip::tcp::endpoint(asio::ip::make_address(_addr), _port);
-                if (_strand_needed)
-                    socket().async_connect(_endpoint, asio::bind_executor(_strand, connect_callback_handler));
-                else
-                    socket().async_connect(_endpoint, connect_callback_handler);
             });
 
             if (_strand_needed)
@@ -233,6 +267,11 @@ namespace CxxServer::Core::SSL {
             return true;            
         }
 
+        void Client::setServerName() {
+            if (!_server_name.empty())
+                SSL_set_tlsext_host_name(_stream.native_handle(), _server_name.c_str());
+        }
+
         void Client::err(std::error_code err) {
             // ignore disconnect errors
             if (err == asio::error::connection_aborted ||
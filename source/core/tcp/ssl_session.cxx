@@ -1,7 +1,11 @@
 #include "core/tcp/ssl_session.hxx"
 #include "core/tcp/ssl_context.hxx"
+#include <algorithm>
+#include <cerrno>
 #include <memory>
 
+#include <unistd.h>
+
 namespace CxxServer::Core::SSL {
     Session::Session(const std::shared_ptr<Tcp::Server> &server, const std::shared_ptr<SSL::Context> &context) : 
         CxxServer::Core::Tcp::Session::Session(server),
@@ -17,6 +21,34 @@ namespace CxxServer::Core::SSL {
             _stream.async_write_some(asio::buffer(buffer, size), handler);
     }
 
+    void Session::asyncSendFile(int fd, uint64_t offset, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler) {
+        // about a TLS record at a time, what isn't written is read again on the next call
+        constexpr size_t chunk = 64 * 1024;
+
+        _file_buff.resize(chunk);
+
+        ssize_t read;
+        do {
+            read = ::pread(fd, _file_buff.data(), std::min(size, chunk), static_cast<off_t>(offset));
+        } while (read < 0 && errno == EINTR);
+
+        if (read <= 0) {
+            auto error = read < 0 ? std::error_code(errno, std::system_category()) : std::error_code(asio::error::eof);
+            auto complete = [handler, error]() mutable {
+                handler(error, 0);
+            };
+
+            if (_strand_needed)
+                _strand.post(complete);
+            else
+                _io->post(complete);
+
+            return;
+        }
+
+        asyncWriteSome(_file_buff.data(), static_cast<size_t>(read), handler);
+    }
+
     void Session::asyncReadSome(void *buffer, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler) {
         if (_strand_needed)
             _stream.async_read_some(asio::buffer(buffer, size), asio::bind_executor(_strand, handler));
@@ -1,13 +1,18 @@
 #include "core/tcp/tcp_client.hxx"
 #include "core/memory.hxx"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <mutex>
+#include <random>
 #include <thread>
+#include <vector>
 
 namespace CxxServer::Core::Tcp {
 
@@ -23,19 +28,33 @@ Client::Client(const std::shared_ptr<Service> &service, const std::string &addr,
                 any adverse effects, same with SSL::Session?
     */
     _socket(*_io),
+    _resolver(*_io),
+    _dns_cache(DnsCache::global()),
+    _connect_attempt_delay(std::chrono::milliseconds(250)),
     _connecting(false),
     _connected(false),
+    _generation(0),
     _bytes_pending(0),
     _bytes_sending(0),
     _bytes_sent(0),
     _bytes_received(0),
     _receiving(false),
+    _external_receive(false),
     _receive_buff_limit(0),
     _sending(false),
+    _send_open(false),
     _send_buff_limit(0),
     _send_flush_offset(0),
+    _send_high_offset(0),
+    _send_high_active(false),
+    _send_flush_bound(0),
     _keep_alive(false),
-    _no_delay(false) 
+    _no_delay(false),
+    _reconnect_timer(*_io),
+    _reconnecting(false),
+    _reconnect_requested(false),
+    _drop(Drop::None),
+    _reconnect_attempts(0)
 {
     assert((service != nullptr) && "IO service is invalid");
     if (service == nullptr)
@@ -92,11 +111,10 @@ bool Client::connect() {
     if (isConnected())
         return false;
 
-    asio::error_code err;
-
-    _endpoint = asio::ip::tcp::endpoint(asio::ip::make_address(_addr), _port);
-
-    socket().connect(_endpoint, err);
+    DnsCache::Endpoints endpoints;
+    asio::error_code err = resolve(endpoints);
+    if (!err)
+        _endpoint = asio::connect(socket(), endpoints, err);
 
     if (err) {
         this->err(err);
@@ -112,13 +130,17 @@ bool Client::connect() {
     _send_buff_flush.reserve(sendBuffSize());
 
     _bytes_pending = _bytes_sending = _bytes_received = _bytes_sent = 0;
+    openSends();
     _connected = true;
 
     onConnect();
 
+    reconnected();
+
     if (_send_buff_main.empty())
         onEmpty();
 
+    notifyReady(true);
     return true;
 }
 
@@ -147,28 +169,41 @@ bool Client::connectAsync() {
                 _send_buff_flush.reserve(sendBuffSize());
 
                 _bytes_pending = _bytes_sending = _bytes_received = _bytes_sent = 0;
+                openSends();
                 _connected = true;
 
                 onConnect();
 
                 tryReceive();
 
-                onConnect();
+                reconnected();
 
                 if (_send_buff_main.empty())
                     onEmpty();
+
+                notifyReady(true);
             }
             else {
                 this->err(err);
                 onDisconnect();
+                notifyReady(false);
+                reconnectOn(true);
             }
         };
 
-        _endpoint = asio::ip::tcp::endpoint(asio::ip::make_address(_addr), _port);
-        if (_strand_needed)
-            socket().async_connect(_endpoint, bind_executor(_strand, connected_handler));
-        else
-            socket().async_connect(_endpoint, connected_handler);
+        resolveAsync([this, self, connected_handler](std::error_code err, const DnsCache::Endpoints &endpoints) {
+            if (err) {
+                connected_handler(err);
+                return;
+            }
+
+            auto endpoint_handler = [this, connected_handler](std::error_code connect_err, const asio::ip::tcp::endpoint &endpoint) {
+                _endpoint = endpoint;
+                connected_handler(connect_err);
+            };
+
+            connectRace(endpoints, endpoint_handler);
+        });
     };
 
 
@@ -181,9 +216,16 @@ bool Client::connectAsync() {
 }
 
 bool Client::disconnect() {
+    disconnectRequested();
+
+    auto drop = _drop.exchange(Drop::None);
+    bool requested = _reconnect_requested.exchange(false);
+
     if (!isConnected())
         return false;
 
+    closeSends();
+    ++_generation;
     socket().close();
 
     _connecting = false;
@@ -195,12 +237,31 @@ bool Client::disconnect() {
     clearBuffs();
     onDisconnect();
 
+    if (requested) {
+        auto self(this->shared_from_this());
+        auto handler = [self]() { self->connectAsync(); };
+        if (_strand_needed)
+            _strand.post(handler);
+        else
+            _io->post(handler);
+    }
+    else if (drop != Drop::None)
+        reconnectOn(drop == Drop::ConnectFailed);
+
     return true;
 }
 
 bool Client::disconnectAsync(bool dispatch) {
-    if (!isConnected() || _connecting)
+    disconnectRequested();
+
+    if (!isConnected() || _connecting) {
+        // nothing left to disconnect, a stale reason would reconnect a later disconnect
+        _drop = Drop::None;
         return false;
+    }
+
+    // the reads & writes it aborts belong to the connection going away
+    ++_generation;
 
     asio::error_code err;
     socket().cancel(err);
@@ -231,13 +292,14 @@ bool Client::reconnect() {
 }
 
 bool Client::reconnectAsync() {
-    if (!disconnectAsync())
+    // the disconnect connects again once it is done
+    _reconnect_requested = true;
+    if (!disconnectAsync()) {
+        _reconnect_requested = false;
         return false;
+    }
 
-    while (isConnected())
-        std::this_thread::yield();
-
-    return connectAsync();
+    return true;
 }
 
 size_t Client::send(const void *buffer, size_t size, std::chrono::nanoseconds timeout) {
@@ -255,7 +317,7 @@ size_t Client::send(const void *buffer, size_t size, std::chrono::nanoseconds ti
         sent = writeSome(buffer, size, err);
     }
     else {
-        int done;
+        int done = 0;
         std::mutex mtx;
         std::condition_variable cv;
         HandlerMemory mem;
@@ -290,6 +352,7 @@ size_t Client::send(const void *buffer, size_t size, std::chrono::nanoseconds ti
 
     if (err && err != asio::error::timed_out) {
         this->err(err);
+        _drop = Drop::Lost;
         disconnect();
     }
 
@@ -311,7 +374,7 @@ size_t Client::receive(void *buffer, size_t size, std::chrono::nanoseconds timeo
         received = readSome(buffer, size, err);
     }
     else {
-        int done;
+        int done = 0;
         std::mutex mtx;
         std::condition_variable cv;
         HandlerMemory mem;
@@ -348,6 +411,7 @@ size_t Client::receive(void *buffer, size_t size, std::chrono::nanoseconds timeo
 
     if (err && err != asio::error::timed_out) {
         this->err(err);
+        _drop = Drop::Lost;
         disconnect();
     }
 
@@ -361,13 +425,23 @@ std::string Client::receive(size_t size, std::chrono::nanoseconds timeout) {
 }
 
 void Client::tryReceive() {
-    if (_receiving || !isReady())
+    if (_receiving || _external_receive || !isReady())
         return;
 
     _receiving = true;
     auto self(this->shared_from_this());
+    uint64_t generation = _generation;
+
+    auto handler = HandlerFastMem<std::function<void(std::error_code, std::size_t)>>(_receive_storage, [this, self, generation](std::error_code err, size_t size) {
+        if (err == asio::error::operation_aborted) {
+            // aborted by a disconnect, which reset the client, it may already be connected again
+            if (generation != _generation)
+                return;
+
+            // aborted by a timed send or receive cancelling the socket, keep receiving
+            err = std::error_code();
+        }
 
-    auto handler = HandlerFastMem<std::function<void(std::error_code, std::size_t)>>(_receive_storage, [this, self](std::error_code err, size_t size) {
         _receiving = false;
 
         if (!isReady())
@@ -380,6 +454,7 @@ void Client::tryReceive() {
             if (_receive_buff.size() == size) {
                 if (size * 2 > _receive_buff_limit && _receive_buff_limit > 0) {
                     this->err(asio::error::no_buffer_space);
+                    _drop = Drop::Lost;
                     disconnectAsync(true);
                     return;
                 }
@@ -394,6 +469,7 @@ void Client::tryReceive() {
         }
         else {
             this->err(err);
+            _drop = Drop::Lost;
             disconnectAsync(true);
         }
     });
@@ -401,24 +477,35 @@ void Client::tryReceive() {
     asyncReadSome(_receive_buff.data(), _receive_buff.size(), handler);
 }
 
-bool Client::sendAsync(const void *buffer, size_t size) {\
+bool Client::sendAsync(const void *buffer, size_t size, SendPriority priority) {
     assert(buffer != nullptr && "Pointer to buffer should not be null");
-    if (!isReady() || size == 0 || buffer == nullptr)
+    if (size == 0 || buffer == nullptr)
         return false;
 
     {
         std::scoped_lock lock(_send_lock);
-        if (_send_buff_main.size() + size > _send_buff_limit && _send_buff_limit > 0) {
+        if (!_send_open)
+            return bufferOffline(buffer, size);
+
+        if (_send_buff_main.size() + _send_buff_high.size() + size > _send_buff_limit && _send_buff_limit > 0) {
             err(asio::error::no_buffer_space);
             return false;
         }
 
-        bool multiple_send_required = _send_buff_main.empty() || _send_buff_flush.empty();
-
         const uint8_t *buff8 = reinterpret_cast<const uint8_t*>(buffer);
-        _send_buff_main.insert(_send_buff_main.end(), buff8, buff8 + size);
+        bool multiple_send_required;
 
-        _bytes_pending = _send_buff_main.size();
+        if (priority == SendPriority::High) {
+            multiple_send_required = _send_buff_high.empty();
+            _send_buff_high.insert(_send_buff_high.end(), buff8, buff8 + size);
+        }
+        else {
+            multiple_send_required = _send_buff_main.empty() || _send_buff_flush.empty();
+            _send_buff_main.insert(_send_buff_main.end(), buff8, buff8 + size);
+            markBatch();
+        }
+
+        _bytes_pending = _send_buff_main.size() + _send_buff_high.size();
 
         if (!multiple_send_required)
             return true;
@@ -437,6 +524,12 @@ bool Client::sendAsync(const void *buffer, size_t size) {\
     return true;
 }
 
+void Client::markBatch() {
+    size_t batch_start = _send_main_bounds.empty() ? 0 : _send_main_bounds.back();
+    if (_send_buff_main.size() - batch_start >= send_priority_quantum)
+        _send_main_bounds.push_back(_send_buff_main.size());
+}
+
 void Client::receiveAsync() {
     tryReceive();
 }
@@ -445,25 +538,68 @@ void Client::trySend() {
     if (_sending || !isReady())
         return;
 
-    if (_send_buff_flush.empty()) {
+    // high priority data may only be written in between batches of normal priority data
+    bool batch_done = _send_flush_offset == (_send_flush_bound == 0 ? 0 : _send_flush_bounds[_send_flush_bound - 1]);
+    bool high_idle = _send_buff_high_flush.empty() && batch_done;
+
+    if (high_idle || _send_buff_flush.empty()) {
         std::scoped_lock lock(_send_lock);
 
-        _send_buff_flush.swap(_send_buff_main);
-        _send_flush_offset = 0;
+        if (high_idle && !_send_buff_high.empty()) {
+            _send_buff_high_flush.swap(_send_buff_high);
+            _send_high_offset = 0;
+
+            _bytes_sending += _send_buff_high_flush.size();
+        }
+
+        if (_send_buff_flush.empty()) {
+            _send_buff_flush.swap(_send_buff_main);
+            _send_flush_offset = 0;
+
+            _send_flush_bounds.swap(_send_main_bounds);
+            _send_main_bounds.clear();
+            _send_flush_bound = 0;
+
+            _bytes_sending += _send_buff_flush.size();
+        }
+
+        _bytes_pending = _send_buff_main.size() + _send_buff_high.size();
+    }
 
-        _bytes_pending = 0;
-        _bytes_sending += _send_buff_flush.size();
+    const uint8_t *buffer;
+    size_t length;
+
+    if (!_send_buff_high_flush.empty()) {
+        _send_high_active = true;
+        buffer = _send_buff_high_flush.data() + _send_high_offset;
+        length = _send_buff_high_flush.size() - _send_high_offset;
     }
+    else if (!_send_buff_flush.empty()) {
+        size_t batch_end = _send_flush_bound < _send_flush_bounds.size() ? _send_flush_bounds[_send_flush_bound] : _send_buff_flush.size();
 
-    if (_send_buff_flush.empty()) {
+        _send_high_active = false;
+        buffer = _send_buff_flush.data() + _send_flush_offset;
+        length = batch_end - _send_flush_offset;
+    }
+    else {
         onEmpty();
         return;
     }
 
     _sending = true;
     auto self(this->shared_from_this());
+    uint64_t generation = _generation;
+
+    auto handler = HandlerFastMem<std::function<void(std::error_code, std::size_t)>>(_send_storage, [this, self, generation](std::error_code err, size_t size) {
+        if (err == asio::error::operation_aborted) {
+            // aborted by a disconnect, which reset the client, it may already be connected again
+            if (generation != _generation)
+                return;
+
+            // aborted by a timed send or receive cancelling the socket, keep sending
+            err = std::error_code();
+        }
 
-    auto handler = HandlerFastMem<std::function<void(std::error_code, std::size_t)>>(_send_storage, [this, self](std::error_code err, size_t size) {
         _sending = false;
         if (!isReady())
             return;
@@ -472,11 +608,27 @@ void Client::trySend() {
             _bytes_sending -= size;
             _bytes_sent += size;
 
-            _send_flush_offset += size;
+            if (_send_high_active) {
+                _send_high_offset += size;
 
-            if (_send_flush_offset == _send_buff_flush.size()) {
-                _send_buff_flush.clear();
-                _send_flush_offset = 0;
+                if (_send_high_offset == _send_buff_high_flush.size()) {
+                    _send_buff_high_flush.clear();
+                    _send_high_offset = 0;
+                }
+            }
+            else {
+                _send_flush_offset += size;
+
+                if (_send_flush_offset == _send_buff_flush.size()) {
+                    _send_buff_flush.clear();
+                    _send_flush_offset = 0;
+
+                    _send_flush_bounds.clear();
+                    _send_flush_bound = 0;
+                }
+                else if (_send_flush_bound < _send_flush_bounds.size() && _send_flush_offset == _send_flush_bounds[_send_flush_bound]) {
+                    ++_send_flush_bound;
+                }
             }
 
             onSend(size, _bytes_pending);
@@ -487,11 +639,329 @@ void Client::trySend() {
         }
         else {
             this->err(err);
+            _drop = Drop::Lost;
             disconnectAsync(true);
         }
     });
 
-    asyncWriteSome(_send_buff_flush.data(), _send_buff_flush.size(), handler);
+    asyncWriteSome(buffer, length, handler);
+}
+
+std::error_code Client::resolve(DnsCache::Endpoints &endpoints) {
+    std::error_code err;
+    auto address = asio::ip::make_address(_addr, err);
+    if (!err) {
+        endpoints = {asio::ip::tcp::endpoint(address, _port)};
+        return err;
+    }
+
+    auto service = _port != 0 ? std::to_string(_port) : _scheme;
+    if (_dns_cache && _dns_cache->lookup(_addr, service, endpoints))
+        return std::error_code();
+
+    auto results = _resolver.resolve(_addr, service, err);
+    if (err)
+        return err;
+
+    endpoints.clear();
+    for (auto &entry : results)
+        endpoints.push_back(entry.endpoint());
+
+    if (_dns_cache)
+        _dns_cache->store(_addr, service, endpoints);
+
+    return err;
+}
+
+void Client::resolveAsync(const std::function<void(std::error_code, const DnsCache::Endpoints&)> &handler) {
+    std::error_code parse_err;
+    auto address = asio::ip::make_address(_addr, parse_err);
+    if (!parse_err) {
+        handler(parse_err, {asio::ip::tcp::endpoint(address, _port)});
+        return;
+    }
+
+    auto service = _port != 0 ? std::to_string(_port) : _scheme;
+
+    DnsCache::Endpoints cached;
+    if (_dns_cache && _dns_cache->lookup(_addr, service, cached)) {
+        handler(std::error_code(), cached);
+        return;
+    }
+
+    // the resolver runs getaddrinfo on its own thread, IO threads aren't blocked
+    auto self(this->shared_from_this());
+    auto resolved_handler = [this, self, service, handler](std::error_code err, asio::ip::tcp::resolver::results_type results) {
+        DnsCache::Endpoints endpoints;
+        for (auto &entry : results)
+            endpoints.push_back(entry.endpoint());
+
+        if (!err && _dns_cache)
+            _dns_cache->store(_addr, service, endpoints);
+
+        handler(err, endpoints);
+    };
+
+    if (_strand_needed)
+        _resolver.async_resolve(_addr, service, asio::bind_executor(_strand, resolved_handler));
+    else
+        _resolver.async_resolve(_addr, service, resolved_handler);
+}
+
+// Connect attempts racing across the resolved endpoints, only touched from the client's IO
+struct Client::ConnectRace {
+    explicit ConnectRace(asio::io_service &io) : timer(io) {}
+
+    DnsCache::Endpoints endpoints;
+    std::vector<std::unique_ptr<asio::ip::tcp::socket>> attempts;
+    asio::system_timer timer;
+    size_t pending = 0;
+    bool done = false;
+    std::error_code last_err;
+    std::function<void(std::error_code, const asio::ip::tcp::endpoint&)> handler;
+};
+
+void Client::connectRace(const DnsCache::Endpoints &endpoints, const std::function<void(std::error_code, const asio::ip::tcp::endpoint&)> &handler) {
+    if (endpoints.empty()) {
+        handler(asio::error::make_error_code(asio::error::host_not_found), _endpoint);
+        return;
+    }
+
+    auto race = std::make_shared<ConnectRace>(*_io);
+    race->handler = handler;
+
+    // alternate address families starting with the resolver's preferred one, so a broken family costs one delay
+    std::vector<asio::ip::tcp::endpoint> preferred, other;
+    for (auto &endpoint : endpoints)
+        (endpoint.protocol() == endpoints.front().protocol() ? preferred : other).push_back(endpoint);
+
+    for (size_t i = 0; i < preferred.size() || i < other.size(); ++i) {
+        if (i < preferred.size())
+            race->endpoints.push_back(preferred[i]);
+
+        if (i < other.size())
+            race->endpoints.push_back(other[i]);
+    }
+
+    raceNext(race);
+}
+
+void Client::raceNext(const std::shared_ptr<ConnectRace> &race) {
+    size_t attempt = race->attempts.size();
+    if (race->done || attempt >= race->endpoints.size())
+        return;
+
+    race->attempts.push_back(std::make_unique<asio::ip::tcp::socket>(*_io));
+    ++race->pending;
+
+    auto connected_handler = [this, race, attempt](std::error_code err) { raceAttemptDone(race, attempt, err); };
+    if (_strand_needed)
+        race->attempts.back()->async_connect(race->endpoints[attempt], asio::bind_executor(_strand, connected_handler));
+    else
+        race->attempts.back()->async_connect(race->endpoints[attempt], connected_handler);
+
+    if (attempt + 1 >= race->endpoints.size())
+        return;
+
+    // give the attempt a head start before racing the next endpoint against it
+    race->timer.expires_after(std::chrono::duration_cast<asio::system_timer::duration>(_connect_attempt_delay));
+    auto delay_handler = [this, race](std::error_code err) {
+        if (!err)
+            raceNext(race);
+    };
+
+    if (_strand_needed)
+        race->timer.async_wait(asio::bind_executor(_strand, delay_handler));
+    else
+        race->timer.async_wait(delay_handler);
+}
+
+void Client::raceAttemptDone(const std::shared_ptr<ConnectRace> &race, size_t attempt, std::error_code err) {
+    --race->pending;
+    if (race->done)
+        return;
+
+    asio::error_code ignored;
+    if (err) {
+        race->last_err = err;
+        race->attempts[attempt]->close(ignored);
+
+        if (race->attempts.size() < race->endpoints.size()) {
+            // no point waiting out the delay after a failure
+            race->timer.cancel();
+            raceNext(race);
+        }
+        else if (race->pending == 0) {
+            race->done = true;
+            race->handler(race->last_err, race->endpoints[attempt]);
+        }
+
+        return;
+    }
+
+    race->done = true;
+    race->timer.cancel();
+    for (size_t i = 0; i < race->attempts.size(); ++i) {
+        if (i != attempt)
+            race->attempts[i]->close(ignored);
+    }
+
+    socket() = std::move(*race->attempts[attempt]);
+    race->handler(err, race->endpoints[attempt]);
+}
+
+void Client::reconnectOn(bool connect_failed) {
+    bool wanted = connect_failed ? _reconnect_policy.on_connect_failure : _reconnect_policy.on_disconnect;
+    if (wanted || _reconnecting)
+        scheduleReconnect();
+}
+
+void Client::scheduleReconnect() {
+    std::unique_lock locker(_reconnect_lock);
+
+    if (_reconnect_policy.max_attempts > 0 && _reconnect_attempts >= _reconnect_policy.max_attempts) {
+        locker.unlock();
+        cancelReconnect();
+        onReconnectFailed();
+        return;
+    }
+
+    // exponential backoff, part of it randomized so clients dropped together spread out their attempts
+    static thread_local std::minstd_rand random(std::random_device{}());
+    std::uniform_real_distribution<double> jitter(0.0, std::clamp(_reconnect_policy.jitter, 0.0, 1.0));
+
+    double delay = std::chrono::duration<double, std::nano>(_reconnect_policy.initial_delay).count() * std::pow(_reconnect_policy.multiplier, static_cast<double>(_reconnect_attempts));
+    delay = std::min(delay, std::chrono::duration<double, std::nano>(_reconnect_policy.max_delay).count());
+    delay *= 1.0 - jitter(random);
+
+    ++_reconnect_attempts;
+    _reconnecting = true;
+
+    // the timer runs on the client's IO, so the reconnect is serialized with the client's other handlers
+    _reconnect_timer.expires_after(std::chrono::duration_cast<asio::system_timer::duration>(std::chrono::nanoseconds(static_cast<int64_t>(delay))));
+
+    std::weak_ptr<Client> weak_self(this->shared_from_this());
+    auto handler = [weak_self](std::error_code err) {
+        auto self = weak_self.lock();
+        if (err || !self || !self->_reconnecting)
+            return;
+
+        // a connect already under way, e.g. started by hand, keeps the reconnect going through its outcome
+        self->connectAsync();
+    };
+
+    if (_strand_needed)
+        _reconnect_timer.async_wait(asio::bind_executor(_strand, handler));
+    else
+        _reconnect_timer.async_wait(handler);
+}
+
+void Client::cancelReconnect() {
+    {
+        std::scoped_lock locker(_reconnect_lock);
+        _reconnecting = false;
+        _reconnect_attempts = 0;
+
+        asio::error_code err;
+        _reconnect_timer.cancel(err);
+    }
+
+    std::scoped_lock locker(_send_lock);
+    _send_buff_offline.clear();
+    _send_buff_offline.shrink_to_fit();
+}
+
+void Client::disconnectRequested() {
+    if (_drop == Drop::None && !_reconnect_requested)
+        cancelReconnect();
+}
+
+void Client::openSends() {
+    std::scoped_lock locker(_send_lock);
+    _send_open = true;
+
+    if (_send_buff_offline.empty())
+        return;
+
+    // data sent from other threads can only be queued behind it from now on
+    _send_buff_main.insert(_send_buff_main.begin(), _send_buff_offline.begin(), _send_buff_offline.end());
+    for (auto &bound : _send_main_bounds)
+        bound += _send_buff_offline.size();
+    _send_buff_offline.clear();
+
+    markBatch();
+    _bytes_pending = _send_buff_main.size() + _send_buff_high.size();
+}
+
+void Client::closeSends() {
+    std::scoped_lock locker(_send_lock);
+    _send_open = false;
+}
+
+void Client::reconnected() {
+    {
+        std::scoped_lock locker(_reconnect_lock);
+        _reconnecting = false;
+        _reconnect_attempts = 0;
+    }
+
+    bool pending;
+    {
+        std::scoped_lock locker(_send_lock);
+        pending = !_send_buff_main.empty();
+    }
+
+    if (!pending)
+        return;
+
+    auto self = this->shared_from_this();
+    auto handler = [this, self]() { trySend(); };
+    if (_strand_needed)
+        _strand.dispatch(handler);
+    else
+        _io->dispatch(handler);
+}
+
+bool Client::bufferOffline(const void *buffer, size_t size) {
+    if (!_reconnecting || _reconnect_policy.buffer_limit == 0)
+        return false;
+
+    if (_send_buff_offline.size() + size > _reconnect_policy.buffer_limit) {
+        err(asio::error::no_buffer_space);
+        return false;
+    }
+
+    const uint8_t *buff8 = reinterpret_cast<const uint8_t*>(buffer);
+    _send_buff_offline.insert(_send_buff_offline.end(), buff8, buff8 + size);
+    return true;
+}
+
+bool Client::connectNotify(const std::function<void(bool)> &handler) {
+    {
+        std::scoped_lock locker(_ready_lock);
+
+        // the client turns ready before it notifies, so a handler added while it isn't is always notified
+        if (isReady())
+            return false;
+
+        _ready_handlers.push_back(handler);
+    }
+
+    // fails if a connect is in progress, which notifies the handler once done
+    connectAsync();
+    return true;
+}
+
+void Client::notifyReady(bool ready) {
+    std::vector<std::function<void(bool)>> handlers;
+
+    {
+        std::scoped_lock locker(_ready_lock);
+        handlers.swap(_ready_handlers);
+    }
+
+    for (auto &handler : handlers)
+        handler(ready);
 }
 
 void Client::clearBuffs() {
@@ -501,6 +971,15 @@ void Client::clearBuffs() {
     _send_buff_flush.clear();
 
     _bytes_sending = _bytes_pending = _send_flush_offset = 0;
+
+    _send_buff_high.clear();
+    _send_buff_high_flush.clear();
+    _send_high_offset = 0;
+    _send_high_active = false;
+
+    _send_main_bounds.clear();
+    _send_flush_bounds.clear();
+    _send_flush_bound = 0;
 }
 
 void Client::err(std::error_code err) {
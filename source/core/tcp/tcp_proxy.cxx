@@ -0,0 +1,244 @@
+#include "core/tcp/tcp_proxy.hxx"
+
+#include "core/io.hxx"
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace CxxServer::Core::Tcp {
+    // Client to the backend, reports its connection back to the front session
+    class ProxySession::Backend : public Client {
+    public:
+        Backend(const std::shared_ptr<Service> &service, const std::string &addr, unsigned int port, const std::shared_ptr<ProxySession> &session) :
+            Client(service, addr, port),
+            _session(session)
+        {}
+
+    protected:
+        void onConnect() override {
+            auto session = _session.lock();
+            if (!session || !session->isConnected()) {
+                disconnectAsync(true);
+                return;
+            }
+
+            auto handler = [session]() { session->start(); };
+            if (session->_strand_needed)
+                session->_strand.post(handler);
+            else
+                session->_io->post(handler);
+        }
+
+        void onDisconnect() override {
+            if (auto session = _session.lock())
+                session->disconnect();
+        }
+
+        void onErr(int err, const std::string &category, const std::string &message) override {
+            if (auto session = _session.lock())
+                session->onErr(err, category, message);
+        }
+
+    private:
+        std::weak_ptr<ProxySession> _session;
+    };
+
+    ProxySession::ProxySession(const std::shared_ptr<Server> &server, const std::string &backend_addr, unsigned int backend_port) :
+        Session(server),
+        _backend_addr(backend_addr),
+        _backend_port(backend_port)
+    {
+        // proxied data is spliced, it is never read through the session
+        _external_receive = true;
+    }
+
+    void ProxySession::onConnect() {
+        auto self = std::static_pointer_cast<ProxySession>(this->shared_from_this());
+
+        _backend = std::make_shared<Backend>(_server->service(), _backend_addr, _backend_port, self);
+        _backend->_external_receive = true;
+        _backend->isNoDelay() = _server->noDelay();
+        _backend->isKeepAlive() = _server->keepAlive();
+        _backend->connectAsync();
+    }
+
+    void ProxySession::onDisconnect() {
+        for (auto pump : {&_upstream, &_downstream}) {
+            for (auto &fd : pump->pipe) {
+                if (fd >= 0)
+                    ::close(fd);
+
+                fd = -1;
+            }
+        }
+
+        if (_backend)
+            _backend->disconnectAsync();
+    }
+
+    void ProxySession::start() {
+        if (!isConnected())
+            return;
+
+        _upstream.from = &socket();
+        _upstream.to = &_backend->socket();
+        _downstream.from = &_backend->socket();
+        _downstream.to = &socket();
+
+        for (auto pump : {&_upstream, &_downstream}) {
+            if (::pipe2(pump->pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+                err(std::error_code(errno, std::system_category()));
+                disconnect();
+                return;
+            }
+
+            // a bigger pipe moves more per splice, this is best effort as the size may be capped by the system
+            ::fcntl(pump->pipe[1], F_SETPIPE_SZ, 1024 * 1024);
+        }
+
+        asio::error_code error;
+        socket().native_non_blocking(true, error);
+        if (!error)
+            _backend->socket().native_non_blocking(true, error);
+
+        if (error) {
+            err(error);
+            disconnect();
+            return;
+        }
+
+        pump(_upstream);
+        pump(_downstream);
+    }
+
+    void ProxySession::pump(Pump &pump) {
+        // # of splices before yielding to the other sessions on the IO thread
+        constexpr size_t max_rounds = 32;
+
+        if (!isConnected() || pump.done)
+            return;
+
+        int from = pump.from->native_handle();
+        int to = pump.to->native_handle();
+
+        for (size_t round = 0; round < max_rounds; ++round) {
+            if (pump.buffered > 0) {
+                ssize_t out = ::splice(pump.pipe[0], nullptr, to, nullptr, pump.buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (out < 0) {
+                    if (errno == EINTR)
+                        continue;
+
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        wait(pump, *pump.to, asio::socket_base::wait_write);
+                        return;
+                    }
+
+                    err(std::error_code(errno, std::system_category()));
+                    disconnect();
+                    return;
+                }
+
+                pump.buffered -= out;
+                account(pump, out);
+                continue;
+            }
+
+            if (pump.eof) {
+                // forward the half close, the other direction keeps going
+                ::shutdown(to, SHUT_WR);
+                pump.done = true;
+
+                if (_upstream.done && _downstream.done)
+                    disconnect();
+
+                return;
+            }
+
+            ssize_t in = ::splice(from, nullptr, pump.pipe[1], nullptr, 1024 * 1024, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (in == 0) {
+                pump.eof = true;
+                continue;
+            }
+
+            if (in < 0) {
+                if (errno == EINTR)
+                    continue;
+
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    wait(pump, *pump.from, asio::socket_base::wait_read);
+                    return;
+                }
+
+                err(std::error_code(errno, std::system_category()));
+                disconnect();
+                return;
+            }
+
+            pump.buffered += in;
+        }
+
+        auto self(this->shared_from_this());
+        auto handler = [this, self, &pump]() { this->pump(pump); };
+
+        if (_strand_needed)
+            _strand.post(handler);
+        else
+            _io->post(handler);
+    }
+
+    void ProxySession::wait(Pump &pump, asio::ip::tcp::socket &socket, asio::socket_base::wait_type type) {
+        auto self(this->shared_from_this());
+        auto handler = [this, self, &pump](std::error_code error) {
+            if (!isConnected())
+                return;
+
+            if (error) {
+                this->err(error);
+                disconnect();
+                return;
+            }
+
+            this->pump(pump);
+        };
+
+        // the backend socket may belong to another IO service, its completions are brought back to this session
+        if (_strand_needed)
+            socket.async_wait(type, asio::bind_executor(_strand, handler));
+        else
+            socket.async_wait(type, asio::bind_executor(*_io, handler));
+    }
+
+    void ProxySession::account(Pump &pump, size_t size) {
+        pump.bytes += size;
+
+        if (&pump == &_upstream) {
+            _bytes_received += size;
+            _server->_bytes_received += size;
+        }
+        else {
+            _bytes_sent += size;
+            _server->_bytes_sent += size;
+        }
+    }
+
+    ProxyServer::ProxyServer(const std::shared_ptr<Service> &service, unsigned int port, const std::string &backend_addr, unsigned int backend_port) :
+        Server(service, port),
+        _backend_addr(backend_addr),
+        _backend_port(backend_port)
+    {}
+
+    ProxyServer::ProxyServer(const std::shared_ptr<Service> &service, const std::string &addr, unsigned int port, const std::string &backend_addr, unsigned int backend_port) :
+        Server(service, addr, port),
+        _backend_addr(backend_addr),
+        _backend_port(backend_port)
+    {}
+
+    std::shared_ptr<Session> ProxyServer::newSession(const std::shared_ptr<Server> &server) {
+        return std::make_shared<ProxySession>(server, _backend_addr, _backend_port);
+    }
+}
@@ -7,14 +7,20 @@
 #include "core/memory.hxx"
 #include "core/uuid.hxx"
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <stdexcept>
 #include <system_error>
 #include <thread>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 namespace CxxServer::Core::Tcp {
     Server::Server(const std::shared_ptr<Service> &service, unsigned int port, InternetProtocol proto) :
@@ -26,13 +32,27 @@ namespace CxxServer::Core::Tcp {
         _port(port),
         _acceptor(*_io),
         _started(false),
+        _draining(false),
+        _drain_timer(*_io),
+        _drain_dropped_sessions(0),
+        _drain_dropped_bytes(0),
         _bytes_pending(0),
         _bytes_received(0),
         _bytes_sent(0),
         _keep_alive(false),
         _no_delay(false),
         _reuse_addr(false),
-        _reuse_port(false)
+        _reuse_port(false),
+        _max_connections(0),
+        _accept_rate(0),
+        _accept_burst(0),
+        _accept_tokens(0),
+        _max_queue_delay(0),
+        _queue_delay(0),
+        _probe_timer(*_io),
+        _accept_timer(*_io),
+        _rejected_connections(0),
+        _throttled_reads(0)
     {
         assert((service) && "Invalid IO service");
         if (service == nullptr)
@@ -58,13 +78,27 @@ namespace CxxServer::Core::Tcp {
         _port(port),
         _acceptor(*_io),
         _started(false),
+        _draining(false),
+        _drain_timer(*_io),
+        _drain_dropped_sessions(0),
+        _drain_dropped_bytes(0),
         _bytes_pending(0),
         _bytes_received(0),
         _bytes_sent(0),
         _keep_alive(false),
         _no_delay(false),
         _reuse_addr(false),
-        _reuse_port(false)
+        _reuse_port(false),
+        _max_connections(0),
+        _accept_rate(0),
+        _accept_burst(0),
+        _accept_tokens(0),
+        _max_queue_delay(0),
+        _queue_delay(0),
+        _probe_timer(*_io),
+        _accept_timer(*_io),
+        _rejected_connections(0),
+        _throttled_reads(0)
     {
         assert((service) && "Invalid IO service");
         if (service == nullptr)
@@ -83,13 +117,27 @@ namespace CxxServer::Core::Tcp {
         _port(endpoint.port()),
         _acceptor(*_io),
         _started(false),
+        _draining(false),
+        _drain_timer(*_io),
+        _drain_dropped_sessions(0),
+        _drain_dropped_bytes(0),
         _bytes_pending(0),
         _bytes_received(0),
         _bytes_sent(0),
         _keep_alive(false),
         _no_delay(false),
         _reuse_addr(false),
-        _reuse_port(false)
+        _reuse_port(false),
+        _max_connections(0),
+        _accept_rate(0),
+        _accept_burst(0),
+        _accept_tokens(0),
+        _max_queue_delay(0),
+        _queue_delay(0),
+        _probe_timer(*_io),
+        _accept_timer(*_io),
+        _rejected_connections(0),
+        _throttled_reads(0)
     {
         assert((service) && "Invalid IO service");
         if (service == nullptr)
@@ -119,12 +167,20 @@ namespace CxxServer::Core::Tcp {
 
             _acceptor.bind(_endpoint);
             _acceptor.listen();
+            // connections are accepted by hand once the acceptor is readable
+            _acceptor.native_non_blocking(true);
             
             _bytes_pending = _bytes_received = _bytes_sent = 0;
+            _rejected_connections = _throttled_reads = 0;
+            _queue_delay = 0;
+            _accept_tokens = _accept_burst;
+            _accept_refill = std::chrono::steady_clock::now();
             _started = true;
 
             onStart();
 
+            probeQueueDelay();
+
             // perform first server accept
             accept();
         };
@@ -149,6 +205,17 @@ namespace CxxServer::Core::Tcp {
             _acceptor.close();
             _session.reset();
 
+            asio::error_code probe_err;
+            _probe_timer.cancel(probe_err);
+            _accept_timer.cancel(probe_err);
+
+            // an immediate stop overrides any drain in progress
+            if (_draining) {
+                asio::error_code err;
+                _drain_timer.cancel(err);
+                _draining = false;
+            }
+
             disconnectAll();
 
             _started = false;
@@ -166,43 +233,129 @@ namespace CxxServer::Core::Tcp {
         return true;
     }
 
-    bool Server::restart() {
-        if (!stop())
+    bool Server::stop(std::chrono::nanoseconds timeout) {
+        if (timeout.count() == 0)
+            return stop();
+
+        if (!isStarted() || _draining)
             return false;
 
-        while (!isStarted())
+        auto self(this->shared_from_this());
+        auto handler = [this, self, timeout] {
+            if (!isStarted() || _draining)
+                return;
+
+            _draining = true;
+            _drain_dropped_sessions = _drain_dropped_bytes = 0;
+
+            _acceptor.close();
+            _session.reset();
+
+            asio::error_code probe_err;
+            _probe_timer.cancel(probe_err);
+            _accept_timer.cancel(probe_err);
+
+            {
+                std::shared_lock<std::shared_mutex> locker(_sessions_lock);
+                if (_sessions.empty()) {
+                    locker.unlock();
+                    finishDrain();
+                    return;
+                }
+
+                for (auto &s : _sessions)
+                    s.second->drain();
+            }
+
+            // sessions still flushing at the deadline are cut off, the last one to unregister finishes the drain
+            auto expired = [this, self](std::error_code err) {
+                if (err || !_draining)
+                    return;
+
+                std::shared_lock<std::shared_mutex> locker(_sessions_lock);
+                for (auto &s : _sessions)
+                    s.second->disconnect();
+            };
+
+            _drain_timer.expires_from_now(timeout);
+            if (_strand_needed)
+                _drain_timer.async_wait(asio::bind_executor(_strand, expired));
+            else
+                _drain_timer.async_wait(expired);
+        };
+
+        if (_strand_needed)
+            _strand.post(handler);
+        else
+            _io->post(handler);
+
+        return true;
+    }
+
+    bool Server::restart(std::chrono::nanoseconds timeout) {
+        if (!stop(timeout))
+            return false;
+
+        while (isStarted())
             std::this_thread::yield();
 
         return start();
     }
 
+    void Server::finishDrain() {
+        if (!_draining)
+            return;
+
+        asio::error_code err;
+        _drain_timer.cancel(err);
+
+        _draining = false;
+        _started = false;
+
+        clearMulticastBuffs();
+
+        onDrained(_drain_dropped_sessions, _drain_dropped_bytes);
+        onStop();
+    }
+
+    void Server::setAcceptRate(double rate, size_t burst) {
+        auto self(this->shared_from_this());
+        auto handler = [this, self, rate, burst]() {
+            _accept_rate = rate;
+            _accept_burst = static_cast<double>(std::max<size_t>(burst, 1));
+            _accept_tokens = _accept_burst;
+            _accept_refill = std::chrono::steady_clock::now();
+        };
+
+        if (_strand_needed)
+            _strand.dispatch(handler);
+        else
+            _io->dispatch(handler);
+    }
+
     void Server::accept() {
-        if (!isStarted())
+        if (!isStarted() || _draining)
             return;
 
         auto self(this->shared_from_this());
         auto handler = HandlerFastMem(_acceptor_storage, [this, self] {
-            if (!isStarted())
+            if (!isStarted() || _draining)
                 return;
 
-            _session = newSession(self);
-
             auto async_handler = HandlerFastMem(_acceptor_storage, [this, self](std::error_code err) {
-                if (!err) {
-                    registerSession();
-                    _session->connect();
-                }
-                else {
+                if (err)
                     this->err(err);
-                }
 
-                accept();
+                if (!err && acceptPending())
+                    accept();
+                else
+                    acceptLater();
             });
 
             if (_strand_needed)
-                _acceptor.async_accept(_session->socket(), asio::bind_executor(_strand, async_handler));
+                _acceptor.async_wait(asio::ip::tcp::acceptor::wait_read, asio::bind_executor(_strand, async_handler));
             else
-                _acceptor.async_accept(_session->socket(), async_handler);
+                _acceptor.async_wait(asio::ip::tcp::acceptor::wait_read, async_handler);
         });
 
         if (_strand_needed)
@@ -211,6 +364,147 @@ namespace CxxServer::Core::Tcp {
             _io->dispatch(handler);
     }
 
+    void Server::acceptLater() {
+        // pause to let descriptors or buffers free up, the listener stays readable so waiting on it would spin
+        constexpr std::chrono::milliseconds accept_backoff(50);
+
+        if (!isStarted() || _draining)
+            return;
+
+        _accept_timer.expires_from_now(accept_backoff);
+
+        auto self(this->shared_from_this());
+        auto handler = [this, self](std::error_code err) {
+            if (!err)
+                accept();
+        };
+
+        if (_strand_needed)
+            _accept_timer.async_wait(asio::bind_executor(_strand, handler));
+        else
+            _accept_timer.async_wait(handler);
+    }
+
+    bool Server::acceptPending() {
+        // bound the batch so a connection storm can't starve the other handlers on this thread
+        constexpr size_t max_batch = 64;
+
+        auto self(this->shared_from_this());
+        for (size_t i = 0; i < max_batch && isStarted() && !_draining; ++i) {
+            sockaddr_storage peer;
+            socklen_t peer_size = sizeof(peer);
+            int fd = ::accept4(_acceptor.native_handle(), reinterpret_cast<sockaddr*>(&peer), &peer_size, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                    return true;
+
+                // out of descriptors or buffers (EMFILE, ENFILE, ENOBUFS, ENOMEM...), the connection stays queued
+                err(asio::error_code(errno, asio::error::get_system_category()));
+                return false;
+            }
+
+            asio::ip::address addr;
+            if (peer.ss_family == AF_INET6) {
+                asio::ip::address_v6::bytes_type bytes;
+                std::memcpy(bytes.data(), &reinterpret_cast<sockaddr_in6*>(&peer)->sin6_addr, bytes.size());
+                addr = asio::ip::address_v6(bytes);
+            }
+            else {
+                addr = asio::ip::address_v4(ntohl(reinterpret_cast<sockaddr_in*>(&peer)->sin_addr.s_addr));
+            }
+
+            // reject before a session is ever allocated for the connection
+            if (!admit(addr)) {
+                reject(fd);
+                continue;
+            }
+
+            _session = newSession(self);
+            _session->_remote_address = addr;
+            _session->_address_tracked = _address_table.enabled();
+
+            asio::error_code assign_err;
+            _session->socket().assign(_endpoint.protocol(), fd, assign_err);
+            if (assign_err) {
+                ::close(fd);
+                if (_session->_address_tracked)
+                    _address_table.release(addr);
+                _session.reset();
+                err(assign_err);
+                continue;
+            }
+
+            registerSession();
+            _session->connect();
+        }
+
+        return true;
+    }
+
+    bool Server::admit(const asio::ip::address &addr) {
+        if (_max_connections > 0 && static_cast<size_t>(numConnectedSessions()) >= _max_connections)
+            return false;
+
+        if (_max_queue_delay.count() > 0 && _queue_delay > _max_queue_delay.count())
+            return false;
+
+        // check the bucket without spending a token, the address quota may still turn the connection away
+        if (_accept_rate > 0) {
+            auto now = std::chrono::steady_clock::now();
+            std::chrono::duration<double> elapsed = now - _accept_refill;
+            _accept_refill = now;
+
+            _accept_tokens = std::min(_accept_burst, _accept_tokens + elapsed.count() * _accept_rate);
+            if (_accept_tokens < 1)
+                return false;
+        }
+
+        if (_address_table.enabled() && !_address_table.acquire(addr))
+            return false;
+
+        if (_accept_rate > 0)
+            _accept_tokens -= 1;
+
+        return true;
+    }
+
+    void Server::reject(int fd) {
+        ++_rejected_connections;
+
+        // best effort, a rejected peer which isn't reading doesn't get to hold up the acceptor
+        if (!_reject_response.empty())
+            ::send(fd, _reject_response.data(), _reject_response.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        ::close(fd);
+    }
+
+    void Server::probeQueueDelay() {
+        // sampling interval of the IO queue delay
+        constexpr std::chrono::milliseconds probe_interval(100);
+
+        if (!isStarted() || _draining || _max_queue_delay.count() == 0)
+            return;
+
+        _probe_timer.expires_from_now(probe_interval);
+
+        auto self(this->shared_from_this());
+        auto handler = [this, self](std::error_code err) {
+            if (err)
+                return;
+
+            // how late the timer handler ran is how long work sat in the IO queue
+            auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now() - _probe_timer.expires_at());
+            _queue_delay = (_queue_delay * 7 + std::max<int64_t>(late.count(), 0)) / 8;
+
+            probeQueueDelay();
+        };
+
+        if (_strand_needed)
+            _probe_timer.async_wait(asio::bind_executor(_strand, handler));
+        else
+            _probe_timer.async_wait(handler);
+    }
+
     bool Server::multicast(const void *buffer, size_t size) {
         if (!isStarted())
             return false;
@@ -266,9 +560,16 @@ namespace CxxServer::Core::Tcp {
     }
 
     void Server::unregisterSession(const Uuid &id) {
+        std::unique_lock<std::shared_mutex> locker(_sessions_lock);
+
         auto it = _sessions.find(id);
         if (it != _sessions.end())
             _sessions.erase(it);
+
+        if (_draining && _sessions.empty()) {
+            locker.unlock();
+            finishDrain();
+        }
     }
 
     void Server::clearMulticastBuffs() {
@@ -4,13 +4,19 @@
 #include "core/uuid.hxx"
 
 #include "core/io.hxx"
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <mutex>
 #include <system_error>
 
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
 namespace CxxServer::Core::Tcp {
     Session::Session(const std::shared_ptr<Server> &server) :
         _id(CxxServer::Core::GenUuid()),
@@ -20,13 +26,36 @@ namespace CxxServer::Core::Tcp {
         _strand_needed(server->_strand_needed),
         _socket(*_io),
         _connected(false),
+        _draining(false),
+        _address_tracked(false),
         _bytes_pending(0),
         _bytes_sending(0),
         _bytes_sent(0),
         _bytes_received(0),
         _receiving(false),
+        _external_receive(false),
+        _receive_timer(*_io),
+        _splicing(false),
+        _splice_fd(-1),
+        _splice_pipe{-1, -1},
+        _splice_remaining(0),
+        _splice_received(0),
         _sending(false),
-        _send_flush_offset(0)
+        _send_flush_offset(0),
+        _send_high_offset(0),
+        _send_high_active(false),
+        _send_flush_bound(0),
+        _streaming(false),
+        _producer_chunk(0),
+        _producer_low(0),
+        _send_shared_offset(0),
+        _send_shared_active(false),
+        _shared_pending(0),
+        _conflate_pending(0),
+        _conflated(0),
+        _slow_policy(server->_slow_policy),
+        _send_rate_bytes(0),
+        _send_rate(0)
     {}
 
     void Session::asyncWriteSome(const void *buffer, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler) {
@@ -75,6 +104,7 @@ namespace CxxServer::Core::Tcp {
 
         _bytes_sending = _bytes_sent = _bytes_pending = _bytes_received = 0;
 
+        _draining = false;
         _connected = true;
 
         tryReceive();
@@ -100,6 +130,28 @@ namespace CxxServer::Core::Tcp {
 
             _connected = _receiving = _sending = false;
 
+            asio::error_code timer_err;
+            _receive_timer.cancel(timer_err);
+
+            if (_splicing)
+                finishSplice(asio::error::connection_aborted);
+
+            if (_address_tracked) {
+                _server->_address_table.release(_remote_address);
+                _address_tracked = false;
+            }
+
+            if (_draining) {
+                // the drain deadline passed before everything was flushed
+                size_t unsent = unsentBytes();
+                if (unsent > 0) {
+                    ++_server->_drain_dropped_sessions;
+                    _server->_drain_dropped_bytes += unsent;
+                }
+
+                _draining = false;
+            }
+
             clearBuffs();
             onDisconnect();
 
@@ -132,6 +184,34 @@ namespace CxxServer::Core::Tcp {
         return true;
     }
 
+    bool Session::drain() {
+        if (!isConnected())
+            return false;
+
+        _draining = true;
+
+        auto self(this->shared_from_this());
+        auto handler = [this, self]() {
+            if (!isConnected())
+                return;
+
+            // a session which never completed its connection has nothing to flush
+            if (!isConnectionComplete()) {
+                disconnect(true);
+                return;
+            }
+
+            trySend();
+        };
+
+        if (_strand_needed)
+            _strand.post(handler);
+        else
+            _io->post(handler);
+
+        return true;
+    }
+
     size_t Session::send(const void *buffer, size_t size, std::chrono::nanoseconds timeout) {
         if (!isConnectionComplete())
             return 0;
@@ -199,7 +279,7 @@ namespace CxxServer::Core::Tcp {
         return num_bytes_sent;
     }
 
-    bool Session::sendAsync(const void *buffer, size_t size) {
+    bool Session::sendAsync(const void *buffer, size_t size, SendPriority priority) {
         if (!isConnectionComplete())
             return false;
 
@@ -210,20 +290,257 @@ namespace CxxServer::Core::Tcp {
         if (buffer == nullptr)
             return false;
 
+        std::string_view piece(static_cast<const char*>(buffer), size);
+        return queueSend(&piece, 1, size, priority);
+    }
+
+    bool Session::sendGather(std::initializer_list<std::string_view> buffers, SendPriority priority) {
+        if (!isConnectionComplete())
+            return false;
+
+        size_t size = 0;
+        for (auto &buffer : buffers)
+            size += buffer.size();
+
+        if (size == 0)
+            return true;
+
+        return queueSend(buffers.begin(), buffers.size(), size, priority);
+    }
+
+    void Session::appendPieces(std::vector<uint8_t> &buffer, const std::string_view *pieces, size_t count) {
+        for (size_t i = 0; i < count; ++i)
+            buffer.insert(buffer.end(), pieces[i].begin(), pieces[i].end());
+    }
+
+    bool Session::queueSend(const std::string_view *pieces, size_t count, size_t size, SendPriority priority) {
+        bool slow_consumer = false;
         {
             std::scoped_lock locker(_send_lock);
 
             bool multiple_sends = _send_buff_main.empty() || _send_buff_flush.empty();
 
-            if ((_send_buff_main.size() + size) > _send_limit && _send_limit > 0) {
+            if ((_send_buff_main.size() + _send_buff_high.size() + size) > _send_limit && _send_limit > 0) {
+                err(asio::error::no_buffer_space);
+                return false;
+            }
+
+            if (priority == SendPriority::High) {
+                // high priority data isn't subject to the slow consumer policy
+                multiple_sends = _send_buff_high.empty();
+                appendPieces(_send_buff_high, pieces, count);
+            }
+            else if (_slow_policy.enabled()) {
+                auto now = std::chrono::steady_clock::now();
+
+                // throughput is only sampled while there is something to send
+                if (_send_buff_main.empty() && _send_flush_since == std::chrono::steady_clock::time_point()) {
+                    _send_rate_since = now;
+                    _send_rate_bytes = 0;
+                }
+
+                appendPieces(_send_buff_main, pieces, count);
+                _send_msgs.push_back({size, now});
+                markBatch();
+
+                slow_consumer = !checkSlowConsumer(now);
+            }
+            else {
+                appendPieces(_send_buff_main, pieces, count);
+                markBatch();
+            }
+
+            _bytes_pending = _send_buff_main.size() + _conflate_pending + _send_buff_high.size() + _shared_pending;
+
+            if (!multiple_sends && !slow_consumer)
+                return true;
+        }
+
+        if (slow_consumer) {
+            disconnect();
+            return false;
+        }
+
+        auto self(this->shared_from_this());
+        auto handler = [this, self]() {
+            trySend();
+        };
+
+        if (_strand_needed)
+            _strand.dispatch(handler);
+        else
+            _io->dispatch(handler);
+
+        return true;
+    }
+
+    void Session::markBatch() {
+        size_t batch_start = _send_main_bounds.empty() ? 0 : _send_main_bounds.back();
+        if (_send_buff_main.size() - batch_start >= send_priority_quantum)
+            _send_main_bounds.push_back(_send_buff_main.size());
+    }
+
+    void Session::produce() {
+        if (_send_buff_flush.size() - _send_flush_offset >= _producer_low)
+            return;
+
+        // data queued with sendAsync goes first, it is swapped in once the flush buffer is written
+        {
+            std::scoped_lock locker(_send_lock);
+
+            if (!_send_buff_flush.empty() && (!_send_buff_main.empty() || !_send_shared_main.empty() || !_conflate_order.empty()))
+                return;
+        }
+
+        // drop the batches already written so the flush buffer stays bounded, the batch being written is kept whole
+        size_t batch_start = _send_flush_bound == 0 ? 0 : _send_flush_bounds[_send_flush_bound - 1];
+        if (batch_start > 0) {
+            _send_buff_flush.erase(_send_buff_flush.begin(), _send_buff_flush.begin() + batch_start);
+            _send_flush_bounds.erase(_send_flush_bounds.begin(), _send_flush_bounds.begin() + _send_flush_bound);
+            for (auto &bound : _send_flush_bounds)
+                bound -= batch_start;
+
+            // shared buffers not yet written are all at or after the batch being written
+            for (auto &shared : _send_shared_flush)
+                shared.position -= batch_start;
+
+            _send_flush_offset -= batch_start;
+            _send_flush_bound = 0;
+        }
+
+        // every chunk is its own batch so high priority data can be written in between chunks
+        size_t start = _send_buff_flush.size();
+        if (start > 0 && (_send_flush_bounds.empty() || _send_flush_bounds.back() < start))
+            _send_flush_bounds.push_back(start);
+
+        _send_buff_flush.resize(start + _producer_chunk);
+        size_t produced = _producer(_send_buff_flush.data() + start, _producer_chunk);
+        _send_buff_flush.resize(start + std::min(produced, _producer_chunk));
+
+        if (produced == 0) {
+            if (!_send_flush_bounds.empty() && _send_flush_bounds.back() == start)
+                _send_flush_bounds.pop_back();
+
+            _producer = nullptr;
+            _streaming = false;
+
+            onStreamEnd();
+            return;
+        }
+
+        _bytes_sending += _send_buff_flush.size() - start;
+
+        if (_slow_policy.enabled()) {
+            std::scoped_lock locker(_send_lock);
+
+            if (_send_flush_since == std::chrono::steady_clock::time_point())
+                _send_flush_since = std::chrono::steady_clock::now();
+        }
+    }
+
+    bool Session::sendConflated(uint64_t key, const void *buffer, size_t size) {
+        if (!isConnectionComplete())
+            return false;
+
+        if (size == 0)
+            return true;
+
+        assert(buffer != nullptr && "Pointer to send must not be null");
+        if (buffer == nullptr)
+            return false;
+
+        {
+            std::scoped_lock locker(_send_lock);
+
+            bool multiple_sends = (_send_buff_main.empty() && _conflate_order.empty()) || _send_buff_flush.empty();
+
+            auto [it, inserted] = _conflate_index.try_emplace(key, _conflate_values.size());
+            if (inserted)
+                _conflate_values.emplace_back();
+
+            auto &value = _conflate_values[it->second];
+            size_t replaced = value.queued ? value.data.size() : 0;
+
+            if ((_send_buff_main.size() + _send_buff_high.size() + _conflate_pending - replaced + size) > _send_limit && _send_limit > 0) {
                 err(asio::error::no_buffer_space);
                 return false;
             }
 
+            if (value.queued) {
+                ++_conflated;
+            }
+            else {
+                value.queued = true;
+                _conflate_order.push_back(it->second);
+            }
+
+            // the value's buffer is reused, so replacing a value in place doesn't allocate once it has grown
             auto bytes = reinterpret_cast<const uint8_t*>(buffer);
-            _send_buff_main.insert(_send_buff_main.end(), bytes, bytes + size);
+            value.data.assign(bytes, bytes + size);
+
+            _conflate_pending = _conflate_pending - replaced + size;
+            _bytes_pending = _send_buff_main.size() + _conflate_pending + _send_buff_high.size() + _shared_pending;
+
+            if (!multiple_sends)
+                return true;
+        }
+
+        auto self(this->shared_from_this());
+        auto handler = [this, self]() {
+            trySend();
+        };
+
+        if (_strand_needed)
+            _strand.dispatch(handler);
+        else
+            _io->dispatch(handler);
+
+        return true;
+    }
+
+    bool Session::sendShared(std::shared_ptr<const void> owner, const void *buffer, size_t size) {
+        if (!isConnectionComplete())
+            return false;
+
+        if (size == 0)
+            return true;
 
-            _bytes_pending = _send_buff_main.size();
+        assert(buffer != nullptr && "Pointer to send must not be null");
+        if (buffer == nullptr)
+            return false;
+
+        return queueShared({std::move(owner), reinterpret_cast<const uint8_t*>(buffer), size, 0});
+    }
+
+    bool Session::sendFile(std::shared_ptr<const void> owner, int fd, uint64_t offset, size_t size) {
+        if (!isConnectionComplete())
+            return false;
+
+        if (size == 0)
+            return true;
+
+        assert(fd >= 0 && "File descriptor must be valid");
+        if (fd < 0)
+            return false;
+
+        return queueShared({std::move(owner), nullptr, size, 0, fd, offset});
+    }
+
+    bool Session::queueShared(SharedBuffer shared) {
+        {
+            std::scoped_lock locker(_send_lock);
+
+            bool multiple_sends = (_send_buff_main.empty() && _send_shared_main.empty()) || (_send_buff_flush.empty() && _send_shared_flush.empty());
+
+            if ((_send_buff_main.size() + _send_buff_high.size() + _shared_pending + shared.size) > _send_limit && _send_limit > 0) {
+                err(asio::error::no_buffer_space);
+                return false;
+            }
+
+            shared.position = _send_buff_main.size();
+            _shared_pending += shared.size;
+            _send_shared_main.push_back(std::move(shared));
+            _bytes_pending = _send_buff_main.size() + _conflate_pending + _send_buff_high.size() + _shared_pending;
 
             if (!multiple_sends)
                 return true;
@@ -242,6 +559,39 @@ namespace CxxServer::Core::Tcp {
         return true;
     }
 
+    bool Session::sendStream(Producer producer, size_t chunk_size, size_t low_watermark) {
+        if (!isConnectionComplete())
+            return false;
+
+        assert(producer && "Producer must not be empty");
+        if (!producer || chunk_size == 0)
+            return false;
+
+        if (_streaming.exchange(true))
+            return false;
+
+        auto self(this->shared_from_this());
+        auto handler = [this, self, producer = std::move(producer), chunk_size, low_watermark]() mutable {
+            if (!isConnectionComplete()) {
+                _streaming = false;
+                return;
+            }
+
+            _producer = std::move(producer);
+            _producer_chunk = chunk_size;
+            _producer_low = low_watermark;
+
+            trySend();
+        };
+
+        if (_strand_needed)
+            _strand.post(handler);
+        else
+            _io->post(handler);
+
+        return true;
+    }
+
     size_t Session::receive(void *buffer, size_t size, std::chrono::nanoseconds timeout) {
         if (!isConnectionComplete())
             return 0;
@@ -319,8 +669,13 @@ namespace CxxServer::Core::Tcp {
     }
 
     void Session::tryReceive() {
-        if (_receiving || !isConnectionComplete())
+        if (_receiving || _external_receive || !isConnectionComplete())
+            return;
+
+        if (_splicing) {
+            trySplice();
             return;
+        }
 
         _receiving = true;
         auto self(this->shared_from_this());
@@ -345,6 +700,15 @@ namespace CxxServer::Core::Tcp {
 
                     _receive_buff.resize(size * 2);
                 }
+
+                if (_address_tracked && !err) {
+                    auto wait = _server->_address_table.consume(_remote_address, size);
+                    if (wait.count() > 0) {
+                        ++_server->_throttled_reads;
+                        pauseReceive(wait);
+                        return;
+                    }
+                }
             }
 
             if (!err) {
@@ -359,22 +723,276 @@ namespace CxxServer::Core::Tcp {
         asyncReadSome(_receive_buff.data(), _receive_buff.size(), handler);
     }
 
+    bool Session::receiveToFile(int fd, uint64_t budget, FileReceiveHandler handler) {
+        if (!isConnectionComplete() || _splicing)
+            return false;
+
+        assert(fd >= 0 && "File descriptor must be valid");
+        if (fd < 0 || budget == 0)
+            return false;
+
+        if (::pipe2(_splice_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+            err(std::error_code(errno, std::system_category()));
+            return false;
+        }
+
+        // a bigger pipe moves more per splice, this is best effort as the size may be capped by the system
+        ::fcntl(_splice_pipe[1], F_SETPIPE_SZ, 1024 * 1024);
+
+        _splice_fd = fd;
+        _splice_remaining = budget;
+        _splice_received = 0;
+        _splice_handler = std::move(handler);
+        _splicing = true;
+
+        // reading restarts as a splice unless a read is already in flight
+        auto self(this->shared_from_this());
+        auto start = [this, self]() {
+            tryReceive();
+        };
+
+        if (_strand_needed)
+            _strand.post(start);
+        else
+            _io->post(start);
+
+        return true;
+    }
+
+    void Session::trySplice() {
+        // # of pipe loads moved before yielding to the other sessions on the IO thread
+        constexpr size_t max_rounds = 16;
+
+        std::error_code error;
+        bool eof = false;
+        uint64_t received = 0;
+
+        int sock = socket().native_handle();
+        if (!socket().native_non_blocking())
+            socket().native_non_blocking(true, error);
+
+        for (size_t round = 0; !error && _splice_remaining > 0; ++round) {
+            if (round == max_rounds)
+                break;
+
+            ssize_t in = ::splice(sock, nullptr, _splice_pipe[1], nullptr, _splice_remaining, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (in == 0) {
+                eof = true;
+                break;
+            }
+
+            if (in < 0) {
+                if (errno == EINTR)
+                    continue;
+
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    error = std::error_code(errno, std::system_category());
+
+                break;
+            }
+
+            // the pipe is drained every round so the socket is the only thing which can block the next splice
+            for (ssize_t left = in; left > 0;) {
+                ssize_t out = ::splice(_splice_pipe[0], nullptr, _splice_fd, nullptr, left, SPLICE_F_MOVE);
+                if (out < 0 && errno == EINTR)
+                    continue;
+
+                if (out <= 0) {
+                    error = out < 0 ? std::error_code(errno, std::system_category()) : asio::error::broken_pipe;
+                    break;
+                }
+
+                left -= out;
+            }
+
+            _splice_remaining -= in;
+            _splice_received += in;
+            received += in;
+        }
+
+        if (received > 0) {
+            _bytes_received += received;
+            _server->_bytes_received += received;
+        }
+
+        if (error || eof) {
+            finishSplice(error ? error : asio::error::eof);
+            if (error)
+                this->err(error);
+
+            disconnect(true);
+            return;
+        }
+
+        if (_splice_remaining == 0) {
+            finishSplice(std::error_code());
+            tryReceive();
+            return;
+        }
+
+        if (_address_tracked && received > 0) {
+            auto wait = _server->_address_table.consume(_remote_address, received);
+            if (wait.count() > 0) {
+                ++_server->_throttled_reads;
+                pauseReceive(wait);
+                return;
+            }
+        }
+
+        _receiving = true;
+        auto self(this->shared_from_this());
+        auto handler = [this, self](std::error_code wait_err) {
+            _receiving = false;
+
+            if (!isConnectionComplete())
+                return;
+
+            if (wait_err) {
+                this->err(wait_err);
+                disconnect(true);
+                return;
+            }
+
+            tryReceive();
+        };
+
+        if (_strand_needed)
+            socket().async_wait(asio::ip::tcp::socket::wait_read, asio::bind_executor(_strand, handler));
+        else
+            socket().async_wait(asio::ip::tcp::socket::wait_read, handler);
+    }
+
+    void Session::finishSplice(std::error_code error) {
+        ::close(_splice_pipe[0]);
+        ::close(_splice_pipe[1]);
+        _splice_pipe[0] = _splice_pipe[1] = -1;
+        _splice_fd = -1;
+
+        auto handler = std::move(_splice_handler);
+        _splice_handler = nullptr;
+        _splicing = false;
+
+        if (handler)
+            handler(error, _splice_received);
+    }
+
+    void Session::pauseReceive(std::chrono::nanoseconds wait) {
+        // hold the receiving flag so nothing else restarts reading during the pause
+        _receiving = true;
+
+        auto self(this->shared_from_this());
+        auto handler = [this, self](std::error_code err) {
+            _receiving = false;
+
+            if (err || !isConnectionComplete())
+                return;
+
+            tryReceive();
+        };
+
+        _receive_timer.expires_from_now(wait);
+        if (_strand_needed)
+            _receive_timer.async_wait(asio::bind_executor(_strand, handler));
+        else
+            _receive_timer.async_wait(handler);
+    }
+
     void Session::trySend() {
         if (_sending || !isConnectionComplete())
             return;
 
-        if (_send_buff_flush.empty()) {
+        // high priority data may only be written in between batches of normal priority data
+        bool batch_done = _send_flush_offset == (_send_flush_bound == 0 ? 0 : _send_flush_bounds[_send_flush_bound - 1]) && _send_shared_offset == 0;
+        bool high_idle = _send_buff_high_flush.empty() && batch_done;
+        bool flush_idle = _send_buff_flush.empty() && _send_shared_flush.empty();
+
+        if (high_idle || flush_idle) {
             std::scoped_lock locker(_send_lock);
 
-            _send_buff_flush.swap(_send_buff_main);
-            _send_flush_offset = 0;
+            if (high_idle && !_send_buff_high.empty()) {
+                _send_buff_high_flush.swap(_send_buff_high);
+                _send_high_offset = 0;
+
+                _bytes_sending += _send_buff_high_flush.size();
+            }
+
+            if (flush_idle) {
+                _send_buff_flush.swap(_send_buff_main);
+                _send_flush_offset = 0;
+
+                _send_shared_flush.swap(_send_shared_main);
+                _bytes_sending += _shared_pending;
+                _shared_pending = 0;
+
+                _send_flush_bounds.swap(_send_main_bounds);
+                _send_main_bounds.clear();
+                _send_flush_bound = 0;
+
+                // conflated values stop being replaceable once they are moved to the flush buffer
+                for (auto idx : _conflate_order) {
+                    auto &value = _conflate_values[idx];
+                    _send_buff_flush.insert(_send_buff_flush.end(), value.data.begin(), value.data.end());
+                    value.queued = false;
+                }
+
+                _conflate_order.clear();
+                _conflate_pending = 0;
+
+                _bytes_sending += _send_buff_flush.size();
+
+                if (_slow_policy.enabled()) {
+                    if (_send_buff_flush.empty())
+                        _send_flush_since = std::chrono::steady_clock::time_point();
+                    else
+                        _send_flush_since = _send_msgs.empty() ? std::chrono::steady_clock::now() : _send_msgs.front().queued;
 
-            _bytes_pending = 0;
-            _bytes_sending += _send_buff_flush.size();
+                    _send_msgs.clear();
+                }
+            }
+
+            _bytes_pending = _send_buff_main.size() + _conflate_pending + _send_buff_high.size() + _shared_pending;
         }
 
-        if (_send_buff_flush.empty()) {
+        if (_producer)
+            produce();
+
+        const uint8_t *buffer;
+        size_t length;
+        int file = -1;
+        uint64_t file_offset = 0;
+
+        if (!_send_buff_high_flush.empty()) {
+            _send_high_active = true;
+            buffer = _send_buff_high_flush.data() + _send_high_offset;
+            length = _send_buff_high_flush.size() - _send_high_offset;
+        }
+        else if (!_send_shared_flush.empty() && _send_shared_flush.front().position == _send_flush_offset) {
+            auto &shared = _send_shared_flush.front();
+
+            _send_high_active = false;
+            _send_shared_active = true;
+            buffer = shared.data == nullptr ? nullptr : shared.data + _send_shared_offset;
+            length = shared.size - _send_shared_offset;
+            file = shared.fd;
+            file_offset = shared.offset + _send_shared_offset;
+        }
+        else if (!_send_buff_flush.empty()) {
+            size_t batch_end = _send_flush_bound < _send_flush_bounds.size() ? _send_flush_bounds[_send_flush_bound] : _send_buff_flush.size();
+            if (!_send_shared_flush.empty())
+                batch_end = std::min(batch_end, _send_shared_flush.front().position);
+
+            _send_high_active = false;
+            _send_shared_active = false;
+            buffer = _send_buff_flush.data() + _send_flush_offset;
+            length = batch_end - _send_flush_offset;
+        }
+        else {
             onEmpty();
+
+            // onEmpty may have queued more data, otherwise the drain is complete
+            if (_draining && !_sending && _bytes_pending == 0)
+                disconnect(true);
+
             return;
         }
 
@@ -392,11 +1010,42 @@ namespace CxxServer::Core::Tcp {
 
                 _server->_bytes_sent += size;
 
-                _send_flush_offset += size;
+                if (_send_high_active) {
+                    _send_high_offset += size;
 
-                if (_send_flush_offset == _send_buff_flush.size()) {
-                    _send_buff_flush.clear();
-                    _send_flush_offset = 0;
+                    if (_send_high_offset == _send_buff_high_flush.size()) {
+                        _send_buff_high_flush.clear();
+                        _send_high_offset = 0;
+                    }
+                }
+                else if (_send_shared_active) {
+                    _send_shared_offset += size;
+
+                    if (_send_shared_offset == _send_shared_flush.front().size) {
+                        _send_shared_flush.pop_front();
+                        _send_shared_offset = 0;
+                        _send_shared_active = false;
+
+                        if (_send_flush_offset == _send_buff_flush.size() && _send_shared_flush.empty())
+                            resetFlush();
+                    }
+                }
+                else {
+                    _send_flush_offset += size;
+
+                    if (_send_flush_offset == _send_buff_flush.size() && _send_shared_flush.empty())
+                        resetFlush();
+                    else if (_send_flush_bound < _send_flush_bounds.size() && _send_flush_offset == _send_flush_bounds[_send_flush_bound]) {
+                        ++_send_flush_bound;
+                    }
+                }
+
+                if (_slow_policy.enabled()) {
+                    std::scoped_lock locker(_send_lock);
+
+                    updateSendRate(size, std::chrono::steady_clock::now());
+                    if (_send_buff_flush.empty())
+                        _send_flush_since = std::chrono::steady_clock::time_point();
                 }
 
                 onSend(size, _bytes_pending);
@@ -411,7 +1060,67 @@ namespace CxxServer::Core::Tcp {
             }
         });
 
-        asyncWriteSome(_send_buff_flush.data() + _send_flush_offset, _send_buff_flush.size() - _send_flush_offset, handler);
+        if (file >= 0)
+            asyncSendFile(file, file_offset, length, handler);
+        else
+            asyncWriteSome(buffer, length, handler);
+    }
+
+    void Session::asyncSendFile(int fd, uint64_t offset, std::size_t size, HandlerFastMem<std::function<void(std::error_code, std::size_t)>> &handler) {
+        // bounded so a large file doesn't hold up the other sessions on the IO thread
+        constexpr size_t max_chunk = 4 * 1024 * 1024;
+
+        std::error_code error;
+        if (!socket().native_non_blocking())
+            socket().native_non_blocking(true, error);
+
+        ssize_t sent = -1;
+        if (!error) {
+            off_t position = static_cast<off_t>(offset);
+            do {
+                sent = ::sendfile(socket().native_handle(), fd, &position, std::min(size, max_chunk));
+            } while (sent < 0 && errno == EINTR);
+
+            if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                error = std::error_code(errno, std::system_category());
+            else if (sent == 0)
+                error = asio::error::eof;
+        }
+
+        // the socket is full, retry once it is writable
+        if (!error && sent < 0) {
+            auto wait = [this, fd, offset, size, handler](std::error_code wait_err) mutable {
+                if (wait_err)
+                    handler(wait_err, 0);
+                else
+                    asyncSendFile(fd, offset, size, handler);
+            };
+
+            if (_strand_needed)
+                socket().async_wait(asio::ip::tcp::socket::wait_write, asio::bind_executor(_strand, wait));
+            else
+                socket().async_wait(asio::ip::tcp::socket::wait_write, wait);
+
+            return;
+        }
+
+        // completions are always posted, as asio does, so a large file isn't sent by recursing
+        auto complete = [handler, error, sent]() mutable {
+            handler(error, sent > 0 ? static_cast<size_t>(sent) : 0);
+        };
+
+        if (_strand_needed)
+            _strand.post(complete);
+        else
+            _io->post(complete);
+    }
+
+    void Session::resetFlush() {
+        _send_buff_flush.clear();
+        _send_flush_offset = 0;
+
+        _send_flush_bounds.clear();
+        _send_flush_bound = 0;
     }
 
     void Session::clearBuffs() {
@@ -421,6 +1130,151 @@ namespace CxxServer::Core::Tcp {
         _send_buff_flush.clear();
 
         _send_flush_offset = _bytes_pending = _bytes_sending = 0;
+
+        _send_buff_high.clear();
+        _send_buff_high_flush.clear();
+        _send_high_offset = 0;
+        _send_high_active = false;
+
+        _send_main_bounds.clear();
+        _send_flush_bounds.clear();
+        _send_flush_bound = 0;
+
+        _send_shared_main.clear();
+        _send_shared_flush.clear();
+        _send_shared_offset = _shared_pending = 0;
+        _send_shared_active = false;
+
+        _send_msgs.clear();
+        _send_flush_since = std::chrono::steady_clock::time_point();
+
+        for (auto idx : _conflate_order)
+            _conflate_values[idx].queued = false;
+
+        _conflate_order.clear();
+        _conflate_pending = 0;
+
+        _producer = nullptr;
+        _streaming = false;
+    }
+
+    SlowConsumerStats Session::slowConsumerStats() {
+        std::scoped_lock locker(_send_lock);
+
+        return _slow_stats;
+    }
+
+    bool Session::checkSlowConsumer(std::chrono::steady_clock::time_point now) {
+        // the throughput needs at least a sampling window of backlog before it says anything about the peer
+        constexpr std::chrono::milliseconds rate_window(100);
+
+        auto oldest = [&]() {
+            if (_send_flush_since != std::chrono::steady_clock::time_point())
+                return _send_flush_since;
+
+            return _send_msgs.empty() ? now : _send_msgs.front().queued;
+        };
+
+        auto too_old = [&]() {
+            return _slow_policy.max_age.count() > 0 && now - oldest() > _slow_policy.max_age;
+        };
+
+        auto too_slow = [&]() {
+            if (_slow_policy.max_drain_time.count() == 0 || now - oldest() < rate_window)
+                return false;
+
+            updateSendRate(0, now);
+
+            double queued = static_cast<double>(_send_buff_main.size() + _bytes_sending);
+            return queued / std::max<double>(_send_rate, 1.0) > std::chrono::duration<double>(_slow_policy.max_drain_time).count();
+        };
+
+        bool old = too_old();
+        bool slow = too_slow();
+
+        if (!old && !slow)
+            return true;
+
+        if (old)
+            ++_slow_stats.age_triggers;
+        if (slow)
+            ++_slow_stats.drain_time_triggers;
+
+        switch (_slow_policy.action) {
+            case SlowConsumerPolicy::Action::Disconnect:
+                ++_slow_stats.disconnects;
+                return false;
+
+            case SlowConsumerPolicy::Action::Conflate:
+                dropQueued(_send_msgs.size() - 1);
+                break;
+
+            case SlowConsumerPolicy::Action::DropOldest:
+                // data already being written can't be recalled, only queued messages are dropped & the newest is kept
+                while (_send_msgs.size() > 1) {
+                    bool stale = _slow_policy.max_age.count() > 0 && now - _send_msgs.front().queued > _slow_policy.max_age;
+                    if (!stale && !too_slow())
+                        break;
+
+                    dropQueued(1);
+                }
+                break;
+        }
+
+        return true;
+    }
+
+    void Session::dropQueued(size_t count) {
+        size_t bytes = 0;
+        for (size_t i = 0; i < count; ++i) {
+            bytes += _send_msgs.front().size;
+            _send_msgs.pop_front();
+        }
+
+        _send_buff_main.erase(_send_buff_main.begin(), _send_buff_main.begin() + bytes);
+
+        // the remaining batches keep ending at the same messages
+        auto first = std::find_if(_send_main_bounds.begin(), _send_main_bounds.end(), [bytes](size_t bound) { return bound > bytes; });
+        _send_main_bounds.erase(_send_main_bounds.begin(), first);
+        for (auto &bound : _send_main_bounds)
+            bound -= bytes;
+
+        // shared buffers queued among the dropped messages stay in order before the remaining ones
+        for (auto &shared : _send_shared_main)
+            shared.position = shared.position > bytes ? shared.position - bytes : 0;
+
+        _slow_stats.dropped_messages += count;
+        _slow_stats.dropped_bytes += bytes;
+    }
+
+    void Session::updateSendRate(size_t sent, std::chrono::steady_clock::time_point now) {
+        // sampling window & weight of the newest sample in the throughput average
+        constexpr std::chrono::milliseconds rate_window(100);
+        constexpr double rate_weight = 0.25;
+
+        _send_rate_bytes += sent;
+
+        auto elapsed = now - _send_rate_since;
+        if (elapsed < rate_window)
+            return;
+
+        double sample = _send_rate_bytes / std::chrono::duration<double>(elapsed).count();
+        _send_rate = _send_rate == 0 ? sample : _send_rate * (1 - rate_weight) + sample * rate_weight;
+
+        _send_rate_since = now;
+        _send_rate_bytes = 0;
+    }
+
+    size_t Session::unsentBytes() {
+        std::scoped_lock locker(_send_lock);
+
+        size_t shared = _shared_pending;
+        for (const auto &buffer : _send_shared_flush)
+            shared += buffer.size;
+        shared -= _send_shared_flush.empty() ? 0 : _send_shared_offset;
+
+        return _send_buff_main.size() + _conflate_pending + _send_buff_flush.size() - _send_flush_offset
+            + _send_buff_high.size() + _send_buff_high_flush.size() - _send_high_offset + shared;
     }
 
     void Session::resetServer() {
@@ -175,6 +175,22 @@ namespace CxxServer::Core {
         return true;
     }
 
+    void Timer::waitResume(std::coroutine_handle<> handle, bool &expired) {
+        auto self = this->shared_from_this();
+        auto handler = HandlerFastMem(_wait_storage, [this, self, handle, &expired](const std::error_code &err) {
+            expired = !err;
+            if (err)
+                this->err(err);
+
+            handle.resume();
+        });
+
+        if (_strand_needed)
+            _timer.async_wait(asio::bind_executor(_strand, handler));
+        else
+            _timer.async_wait(handler);
+    }
+
     bool Timer::cancel() {
         asio::error_code err;
         _timer.cancel(err);
@@ -186,4 +202,11 @@ namespace CxxServer::Core {
 
         return true;
     }
-}
\ No newline at end of file
+
+    void Timer::timerNotify(bool canceled) {
+        onTimer(canceled);
+
+        if (_action)
+            _action(canceled);
+    }
+}
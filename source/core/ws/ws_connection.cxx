@@ -0,0 +1,406 @@
+#include "core/ws/ws_connection.hxx"
+
+#include <algorithm>
+#include <cstring>
+
+namespace CxxServer::Core::Ws {
+    namespace {
+        // Does a comma separated header list hold a token, case insensitively
+        bool hasToken(std::string_view list, std::string_view token) noexcept {
+            while (!list.empty()) {
+                size_t comma = list.find(',');
+                auto item = list.substr(0, comma);
+                list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+                while (!item.empty() && (item.front() == ' ' || item.front() == '\t'))
+                    item.remove_prefix(1);
+                while (!item.empty() && (item.back() == ' ' || item.back() == '\t'))
+                    item.remove_suffix(1);
+
+                if (Http::equalsNoCase(item, token))
+                    return true;
+            }
+
+            return false;
+        }
+    }
+
+    bool Connection::sendPing(std::string_view payload) {
+        if (payload.size() > max_control_size)
+            return false;
+
+        return sendFrame(Opcode::Ping, payload.data(), payload.size());
+    }
+
+    bool Connection::sendPong(std::string_view payload) {
+        if (payload.size() > max_control_size)
+            return false;
+
+        return sendFrame(Opcode::Pong, payload.data(), payload.size());
+    }
+
+    bool Connection::sendClose(CloseCode code, std::string_view reason) {
+        std::scoped_lock lock(_send_lock);
+
+        if (!_open || _close_sent)
+            return false;
+
+        _close_sent = true;
+        return sendCloseFrame(static_cast<uint16_t>(code), reason);
+    }
+
+    void Connection::receiveData(const void *buffer, size_t size) {
+        auto data = static_cast<const char*>(buffer);
+
+        if (_open) {
+            receiveFrames(data, size);
+            return;
+        }
+
+        if (_closed)
+            return;
+
+        // parse straight from the receive buffer unless the request is already partially received
+        bool buffered = !_partial.empty();
+        if (buffered)
+            _partial.insert(_partial.end(), data, data + size);
+
+        const char *input = buffered ? _partial.data() : data;
+        size_t total = buffered ? _partial.size() : size;
+
+        size_t consumed = receiveUpgrade(input, total);
+        if (consumed == 0) {
+            if (!buffered)
+                _partial.assign(data, data + size);
+            return;
+        }
+
+        if (!_open) {
+            _partial.clear();
+            return;
+        }
+
+        // frames sent right behind the upgrade request
+        if (buffered) {
+            std::vector<char> rest(_partial.begin() + consumed, _partial.end());
+            _partial.clear();
+            receiveFrames(rest.data(), rest.size());
+        }
+        else
+            receiveFrames(data + consumed, size - consumed);
+    }
+
+    void Connection::transportDisconnected() {
+        if (_open)
+            closed(static_cast<uint16_t>(CloseCode::Abnormal), std::string_view());
+    }
+
+    size_t Connection::receiveUpgrade(const char *data, size_t size) {
+        size_t consumed = 0;
+        auto result = _parser.parse(data, size, _request, consumed);
+
+        if (result == Http::RequestParser::Result::Incomplete)
+            return 0;
+
+        if (result == Http::RequestParser::Result::Error) {
+            refuse(_parser.errorStatus());
+            return size;
+        }
+
+        upgrade(_request);
+        _request.clear();
+        _parser.reset();
+        return consumed;
+    }
+
+    bool Connection::upgrade(const Http::Request &request) {
+        auto key = request.header("Sec-WebSocket-Key");
+        if (request.method() != "GET" || request.minorVersion() != 1 || !hasToken(request.header("Upgrade"), "websocket") ||
+            !hasToken(request.header("Connection"), "upgrade") || key.size() != 24) {
+            refuse(400);
+            return false;
+        }
+
+        if (request.header("Sec-WebSocket-Version") != "13") {
+            refuse(426, "Sec-WebSocket-Version: 13\r\n");
+            return false;
+        }
+
+        Http::Response response;
+        response.status(101).header("Upgrade", "websocket").header("Connection", "Upgrade").header("Sec-WebSocket-Accept", acceptKey(key));
+
+        if (!onUpgrade(request, response)) {
+            refuse(403);
+            return false;
+        }
+
+        {
+            std::scoped_lock lock(_send_lock);
+
+            if (!transportSendGather({ response.head(), response.block(), "\r\n" }))
+                return false;
+
+            _open = true;
+        }
+
+        onOpen();
+        return true;
+    }
+
+    void Connection::refuse(int status, std::string_view headers) {
+        _closed = true;
+
+        Http::Response response;
+        response.status(status);
+
+        {
+            std::scoped_lock lock(_send_lock);
+            transportSendGather({ response.head(), headers, "Connection: close\r\nContent-Length: 0\r\n\r\n" });
+        }
+
+        transportClose();
+    }
+
+    void Connection::receiveFrames(const char *data, size_t size) {
+        size_t pos = 0;
+
+        while (pos < size && !_closed) {
+            if (!_in_payload) {
+                size_t count = std::min(_header_needed - _header_size, size - pos);
+                std::memcpy(_header + _header_size, data + pos, count);
+                _header_size += count;
+                pos += count;
+
+                if (_header_size < _header_needed)
+                    break;
+
+                // the first 2 bytes tell the size of the rest of the header, frames from clients must be masked
+                if (_header_needed == 2) {
+                    if (!(_header[1] & 0x80)) {
+                        fail(CloseCode::ProtocolError);
+                        return;
+                    }
+
+                    uint8_t length = _header[1] & 0x7f;
+                    _header_needed = 2 + (length == 126 ? 2 : (length == 127 ? 8 : 0)) + 4;
+                    continue;
+                }
+
+                if (!beginFrame())
+                    return;
+
+                if (_payload_size == 0)
+                    endFrame();
+
+                continue;
+            }
+
+            // the payload is unmasked straight into the message or control frame being assembled, which only grows by
+            // what arrived so a large declared size costs nothing until it is sent
+            auto &target = isControl(_opcode) ? _control : _message;
+            size_t count = static_cast<size_t>(std::min<uint64_t>(_payload_size - _payload_received, size - pos));
+            size_t start = target.size();
+            target.resize(start + count);
+            mask(target.data() + start, data + pos, count, _mask, _payload_received);
+
+            _payload_received += count;
+            pos += count;
+
+            if (_payload_received == _payload_size)
+                endFrame();
+        }
+    }
+
+    bool Connection::beginFrame() {
+        _fin = _header[0] & 0x80;
+        _opcode = static_cast<Opcode>(_header[0] & 0x0f);
+
+        uint64_t size = _header[1] & 0x7f;
+        size_t pos = 2;
+        if (size == 126) {
+            size = (static_cast<uint64_t>(_header[2]) << 8) | _header[3];
+            pos = 4;
+        }
+        else if (size == 127) {
+            size = 0;
+            for (size_t i = 0; i < 8; ++i)
+                size = (size << 8) | _header[2 + i];
+            pos = 10;
+        }
+
+        std::memcpy(_mask, _header + pos, 4);
+        _header_size = 0;
+        _header_needed = 2;
+
+        // no extension is negotiated, so no reserved bit may be set
+        bool valid = !(_header[0] & 0x70);
+        switch (_opcode) {
+            case Opcode::Text:
+            case Opcode::Binary:
+                valid = valid && _message_opcode == Opcode::Continuation;
+                break;
+            case Opcode::Continuation:
+                valid = valid && _message_opcode != Opcode::Continuation;
+                break;
+            case Opcode::Close:
+            case Opcode::Ping:
+            case Opcode::Pong:
+                valid = valid && _fin && size <= max_control_size;
+                break;
+            default:
+                valid = false;
+        }
+
+        if (!valid) {
+            fail(CloseCode::ProtocolError);
+            return false;
+        }
+
+        if (isControl(_opcode)) {
+            _control.clear();
+        }
+        else {
+            if (size > _max_message - _message.size()) {
+                fail(CloseCode::MessageTooBig);
+                return false;
+            }
+
+            if (_opcode != Opcode::Continuation)
+                _message_opcode = _opcode;
+        }
+
+        _in_payload = true;
+        _payload_size = size;
+        _payload_received = 0;
+        return true;
+    }
+
+    void Connection::endFrame() {
+        _in_payload = false;
+
+        if (_opcode == Opcode::Ping) {
+            sendPong(std::string_view(_control.data(), _control.size()));
+            onPing(_control.data(), _control.size());
+            _control.clear();
+            return;
+        }
+
+        if (_opcode == Opcode::Pong) {
+            onPong(_control.data(), _control.size());
+            _control.clear();
+            return;
+        }
+
+        if (_opcode == Opcode::Close) {
+            uint16_t code = static_cast<uint16_t>(CloseCode::NoStatus);
+            std::string_view reason;
+
+            if (_control.size() == 1) {
+                fail(CloseCode::ProtocolError);
+                return;
+            }
+
+            if (_control.size() >= 2) {
+                code = static_cast<uint16_t>((static_cast<uint8_t>(_control[0]) << 8) | static_cast<uint8_t>(_control[1]));
+                reason = std::string_view(_control.data() + 2, _control.size() - 2);
+
+                if (!isValidCloseCode(code)) {
+                    fail(CloseCode::ProtocolError);
+                    return;
+                }
+
+                if (!validUtf8(reason)) {
+                    fail(CloseCode::InvalidPayload);
+                    return;
+                }
+            }
+
+            // answered with the same code unless the close was ours
+            {
+                std::scoped_lock lock(_send_lock);
+
+                if (!_close_sent.exchange(true))
+                    sendCloseFrame(code, std::string_view());
+            }
+
+            closed(code, reason);
+            transportClose();
+            return;
+        }
+
+        if (!_fin)
+            return;
+
+        bool text = _message_opcode == Opcode::Text;
+        _message_opcode = Opcode::Continuation;
+
+        if (text && !validUtf8(_message.data(), _message.size())) {
+            fail(CloseCode::InvalidPayload);
+            return;
+        }
+
+        ++_messages;
+        onMessage(_message.data(), _message.size(), text);
+        _message.clear();
+    }
+
+    bool Connection::sendFrame(Opcode opcode, const void *data, size_t size) {
+        uint8_t header[max_header_size];
+        size_t header_size = encodeHeader(header, opcode, true, size);
+
+        std::scoped_lock lock(_send_lock);
+
+        if (!_open || _close_sent)
+            return false;
+
+        return transportSendGather({ std::string_view(reinterpret_cast<const char*>(header), header_size), std::string_view(static_cast<const char*>(data), size) });
+    }
+
+    bool Connection::sendCloseFrame(uint16_t code, std::string_view reason) {
+        char payload[max_control_size];
+        size_t size = 0;
+
+        // without a status the close frame is empty
+        if (code != static_cast<uint16_t>(CloseCode::NoStatus)) {
+            payload[0] = static_cast<char>(code >> 8);
+            payload[1] = static_cast<char>(code);
+
+            // cut at a character boundary
+            size_t length = std::min(reason.size(), max_control_size - 2);
+            while (length < reason.size() && length > 0 && (static_cast<uint8_t>(reason[length]) & 0xc0) == 0x80)
+                --length;
+
+            std::memcpy(payload + 2, reason.data(), length);
+            size = 2 + length;
+        }
+
+        uint8_t header[max_header_size];
+        size_t header_size = encodeHeader(header, Opcode::Close, true, size);
+        return transportSendGather({ std::string_view(reinterpret_cast<const char*>(header), header_size), std::string_view(payload, size) });
+    }
+
+    void Connection::fail(CloseCode code) {
+        {
+            std::scoped_lock lock(_send_lock);
+
+            if (!_close_sent.exchange(true))
+                sendCloseFrame(static_cast<uint16_t>(code), std::string_view());
+        }
+
+        closed(static_cast<uint16_t>(code), std::string_view());
+        transportClose();
+    }
+
+    void Connection::closed(uint16_t code, std::string_view reason) {
+        if (!_closed.exchange(true))
+            onClose(code, reason);
+    }
+
+    bool Connection::transportSendGather(std::initializer_list<std::string_view> buffers) {
+        _out.clear();
+        for (auto &buffer : buffers)
+            _out.append(buffer);
+
+        return transportSend(_out.data(), _out.size());
+    }
+}
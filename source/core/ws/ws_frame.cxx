@@ -0,0 +1,268 @@
+#include "core/ws/ws_frame.hxx"
+
+#include <cstring>
+
+#include <immintrin.h>
+#include <openssl/evp.h>
+
+namespace CxxServer::Core::Ws {
+    namespace {
+        // Error classes of a pair of bytes, the first byte's high & low nibble & the second byte's high nibble each
+        // select the classes they may be part of, a pair is invalid if all three agree on one
+        constexpr uint8_t too_short = 1 << 0;  // 11______ 0_______ or 11______ 11______
+        constexpr uint8_t too_long = 1 << 1;   // 0_______ 10______
+        constexpr uint8_t overlong_3 = 1 << 2; // 11100000 100_____
+        constexpr uint8_t too_large = 1 << 3;  // 11110100 1001____ to 1111____ 10______ past U+10FFFF
+        constexpr uint8_t surrogate = 1 << 4;  // 11101101 101_____
+        constexpr uint8_t overlong_2 = 1 << 5; // 1100000_ 10______
+        constexpr uint8_t too_large_1000 = 1 << 6; // 11110101 1000____ to 1111____ 1000____
+        constexpr uint8_t overlong_4 = 1 << 6; // 11110000 1000____
+        constexpr uint8_t two_conts = 1 << 7;  // 10______ 10______, fine only as the 3rd or 4th byte
+        constexpr uint8_t carry = too_short | too_long | two_conts;
+
+        inline __m128i table(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t b4, uint8_t b5, uint8_t b6, uint8_t b7,
+                             uint8_t b8, uint8_t b9, uint8_t b10, uint8_t b11, uint8_t b12, uint8_t b13, uint8_t b14, uint8_t b15) noexcept {
+            return _mm_setr_epi8(static_cast<char>(b0), static_cast<char>(b1), static_cast<char>(b2), static_cast<char>(b3),
+                                 static_cast<char>(b4), static_cast<char>(b5), static_cast<char>(b6), static_cast<char>(b7),
+                                 static_cast<char>(b8), static_cast<char>(b9), static_cast<char>(b10), static_cast<char>(b11),
+                                 static_cast<char>(b12), static_cast<char>(b13), static_cast<char>(b14), static_cast<char>(b15));
+        }
+
+        // Validation state carried from one block to the next
+        struct Utf8Checker {
+            __m128i error = _mm_setzero_si128();
+            __m128i prev = _mm_setzero_si128();
+            __m128i prev_incomplete = _mm_setzero_si128();
+
+            const __m128i nibble = _mm_set1_epi8(0x0f);
+
+            const __m128i byte_1_high = table(
+                // 0_______ ________ ASCII first
+                too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                // 10______ ________ continuation first
+                two_conts, two_conts, two_conts, two_conts,
+                // 1100____ ________ two byte lead
+                too_short | overlong_2,
+                // 1101____ ________ two byte lead
+                too_short,
+                // 1110____ ________ three byte lead
+                too_short | overlong_3 | surrogate,
+                // 1111____ ________ four byte lead
+                too_short | too_large | too_large_1000 | overlong_4);
+
+            const __m128i byte_1_low = table(
+                // ____0000 ________
+                carry | overlong_3 | overlong_2 | overlong_4,
+                // ____0001 ________
+                carry | overlong_2,
+                // ____001_ ________
+                carry, carry,
+                // ____0100 ________
+                carry | too_large,
+                // ____0101 ________ & up
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                // ____1101 ________
+                carry | too_large | too_large_1000 | surrogate,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000);
+
+            const __m128i byte_2_high = table(
+                // ________ 0_______ ASCII second
+                too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                // ________ 1000____
+                too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+                // ________ 1001____
+                too_long | overlong_2 | two_conts | overlong_3 | too_large,
+                // ________ 101_____
+                too_long | overlong_2 | two_conts | surrogate | too_large,
+                too_long | overlong_2 | two_conts | surrogate | too_large,
+                // ________ 11______ lead second
+                too_short, too_short, too_short, too_short);
+
+            // bytes at the end of a block which start a sequence it doesn't hold
+            const __m128i incomplete = table(255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+                                             0xf0 - 1, 0xe0 - 1, 0xc0 - 1);
+
+            static __m128i high(__m128i bytes, __m128i mask) noexcept { return _mm_and_si128(_mm_srli_epi16(bytes, 4), mask); }
+
+            void check(__m128i input) noexcept {
+                // ASCII only blocks can only be wrong by cutting short the previous block's last sequence
+                if (_mm_movemask_epi8(input) == 0) {
+                    error = _mm_or_si128(error, prev_incomplete);
+                    prev = input;
+                    prev_incomplete = _mm_setzero_si128();
+                    return;
+                }
+
+                __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+                __m128i special = _mm_and_si128(_mm_and_si128(_mm_shuffle_epi8(byte_1_high, high(prev1, nibble)),
+                                                              _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+                                                _mm_shuffle_epi8(byte_2_high, high(input, nibble)));
+
+                // continuations following a continuation must be the 3rd or 4th byte of a sequence
+                __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+                __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+                __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xe0 - 0x80))),
+                                              _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xf0 - 0x80))));
+                __m128i must23_80 = _mm_and_si128(must23, _mm_set1_epi8(static_cast<char>(0x80)));
+
+                error = _mm_or_si128(error, _mm_xor_si128(must23_80, special));
+                prev = input;
+                prev_incomplete = _mm_subs_epu8(input, incomplete);
+            }
+
+            bool valid() const noexcept {
+                __m128i all = _mm_or_si128(error, prev_incomplete);
+                return _mm_testz_si128(all, all);
+            }
+        };
+
+        void base64(const uint8_t *data, size_t size, std::string &out) {
+            static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+            for (size_t pos = 0; pos < size; pos += 3) {
+                uint32_t group = static_cast<uint32_t>(data[pos]) << 16;
+                if (pos + 1 < size)
+                    group |= static_cast<uint32_t>(data[pos + 1]) << 8;
+                if (pos + 2 < size)
+                    group |= data[pos + 2];
+
+                out.push_back(alphabet[(group >> 18) & 0x3f]);
+                out.push_back(alphabet[(group >> 12) & 0x3f]);
+                out.push_back(pos + 1 < size ? alphabet[(group >> 6) & 0x3f] : '=');
+                out.push_back(pos + 2 < size ? alphabet[group & 0x3f] : '=');
+            }
+        }
+    }
+
+    size_t encodeHeader(uint8_t *out, Opcode opcode, bool fin, uint64_t size, const uint8_t *mask) noexcept {
+        out[0] = static_cast<uint8_t>((fin ? 0x80 : 0) | static_cast<uint8_t>(opcode));
+        uint8_t masked = mask != nullptr ? 0x80 : 0;
+
+        size_t header_size;
+        if (size < 126) {
+            out[1] = static_cast<uint8_t>(masked | size);
+            header_size = 2;
+        }
+        else if (size <= 0xffff) {
+            out[1] = masked | 126;
+            out[2] = static_cast<uint8_t>(size >> 8);
+            out[3] = static_cast<uint8_t>(size);
+            header_size = 4;
+        }
+        else {
+            out[1] = masked | 127;
+            for (size_t i = 0; i < 8; ++i)
+                out[2 + i] = static_cast<uint8_t>(size >> (56 - 8 * i));
+            header_size = 10;
+        }
+
+        if (mask != nullptr) {
+            std::memcpy(out + header_size, mask, 4);
+            header_size += 4;
+        }
+
+        return header_size;
+    }
+
+    void mask(void *out, const void *data, size_t size, const uint8_t *mask, uint64_t offset) noexcept {
+        auto dst = static_cast<uint8_t*>(out);
+        auto src = static_cast<const uint8_t*>(data);
+
+        // the key rotated so it starts at the first byte of the data
+        uint8_t key[8];
+        for (size_t i = 0; i < 8; ++i)
+            key[i] = mask[(offset + i) & 3];
+
+        uint32_t key32;
+        uint64_t key64;
+        std::memcpy(&key32, key, 4);
+        std::memcpy(&key64, key, 8);
+
+        size_t pos = 0;
+
+#if defined(__AVX__)
+        // AVX only has 256 bit XOR for floats, as bits they're the same
+        const __m256 key256 = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(key32)));
+        for (; pos + 64 <= size; pos += 64) {
+            __m256 b0 = _mm256_loadu_ps(reinterpret_cast<const float*>(src + pos));
+            __m256 b1 = _mm256_loadu_ps(reinterpret_cast<const float*>(src + pos + 32));
+            _mm256_storeu_ps(reinterpret_cast<float*>(dst + pos), _mm256_xor_ps(b0, key256));
+            _mm256_storeu_ps(reinterpret_cast<float*>(dst + pos + 32), _mm256_xor_ps(b1, key256));
+        }
+
+        for (; pos + 32 <= size; pos += 32) {
+            __m256 block = _mm256_loadu_ps(reinterpret_cast<const float*>(src + pos));
+            _mm256_storeu_ps(reinterpret_cast<float*>(dst + pos), _mm256_xor_ps(block, key256));
+        }
+#endif
+
+        const __m128i key128 = _mm_set1_epi32(static_cast<int>(key32));
+        for (; pos + 16 <= size; pos += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + pos), _mm_xor_si128(block, key128));
+        }
+
+        if (pos + 8 <= size) {
+            uint64_t block;
+            std::memcpy(&block, src + pos, 8);
+            block ^= key64;
+            std::memcpy(dst + pos, &block, 8);
+            pos += 8;
+        }
+
+        for (; pos < size; ++pos)
+            dst[pos] = src[pos] ^ key[pos & 3];
+    }
+
+    bool validUtf8(const void *data, size_t size) noexcept {
+        auto bytes = static_cast<const uint8_t*>(data);
+        Utf8Checker checker;
+
+        size_t pos = 0;
+        for (; pos + 32 <= size; pos += 32) {
+            __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos));
+            __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos + 16));
+
+            // runs of ASCII are skipped whole
+            if (_mm_movemask_epi8(_mm_or_si128(b0, b1)) == 0) {
+                checker.error = _mm_or_si128(checker.error, checker.prev_incomplete);
+                checker.prev = b1;
+                checker.prev_incomplete = _mm_setzero_si128();
+                continue;
+            }
+
+            checker.check(b0);
+            checker.check(b1);
+        }
+
+        for (; pos + 16 <= size; pos += 16)
+            checker.check(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos)));
+
+        // the tail is padded with ASCII
+        if (pos < size) {
+            uint8_t tail[16] = {};
+            std::memcpy(tail, bytes + pos, size - pos);
+            checker.check(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tail)));
+        }
+
+        return checker.valid();
+    }
+
+    std::string acceptKey(std::string_view key) {
+        static constexpr std::string_view guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+        std::string input;
+        input.reserve(key.size() + guid.size());
+        input.append(key).append(guid);
+
+        uint8_t digest[EVP_MAX_MD_SIZE];
+        unsigned int digest_size = 0;
+        EVP_Digest(input.data(), input.size(), digest, &digest_size, EVP_sha1(), nullptr);
+
+        std::string accept;
+        base64(digest, digest_size, accept);
+        return accept;
+    }
+}
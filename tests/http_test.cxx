@@ -0,0 +1,1109 @@
+#include "catch2/catch.hpp"
+
+#include "core/service.hxx"
+#include "core/http/http_cache.hxx"
+#include "core/http/http_date.hxx"
+#include "core/http/http_files.hxx"
+#include "core/http/http_parser.hxx"
+#include "core/http/http_router.hxx"
+#include "core/http/http_scan.hxx"
+#include "core/http/http_server.hxx"
+#include "core/http/http_session.hxx"
+#include "core/http/https_server.hxx"
+#include "core/http/https_session.hxx"
+#include "core/tcp/ssl_client.hxx"
+#include "core/tcp/ssl_context.hxx"
+#include "core/tcp/tcp_client.hxx"
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Request = CxxServer::Core::Http::Request;
+    using RequestParser = CxxServer::Core::Http::RequestParser;
+    using Response = CxxServer::Core::Http::Response;
+    using ResponseCache = CxxServer::Core::Http::ResponseCache;
+    using HeaderBlock = CxxServer::Core::Http::HeaderBlock;
+    using Date = CxxServer::Core::Http::Date;
+    using DateTimer = CxxServer::Core::Http::DateTimer;
+    using Router = CxxServer::Core::Http::Router;
+    using RouteParams = CxxServer::Core::Http::RouteParams;
+    using RouteSpec = CxxServer::Core::Http::RouteSpec;
+    template<size_t N, size_t Capacity = N * 8>
+    using RouteTable = CxxServer::Core::Http::RouteTable<N, Capacity>;
+    using StaticFiles = CxxServer::Core::Http::StaticFiles;
+
+    using TcpSession = CxxServer::Core::Tcp::Session;
+    using TcpServer = CxxServer::Core::Tcp::Server;
+    using TcpClient = CxxServer::Core::Tcp::Client;
+    using SslClient = CxxServer::Core::SSL::Client;
+    using SslContext = CxxServer::Core::SSL::Context;
+
+    // Answers with the request path, /chunked in two chunks
+    template<typename Base>
+    class HelloSession : public Base {
+    public:
+        using Base::Base;
+
+    protected:
+        void onRequest(const Request &request) override {
+            Response response;
+            if (request.path() == "/chunked") {
+                response.header("Content-Type", "text/plain").chunked();
+                this->sendResponse(response);
+                this->sendChunk("hello ", 6);
+                this->sendChunk("world", 5);
+                this->sendLastChunk();
+                return;
+            }
+
+            response.header("Content-Type", "text/plain").body(std::string(request.path()) + ":" + std::string(request.body()));
+            this->sendResponse(response);
+        }
+    };
+
+    class HelloServer : public CxxServer::Core::Http::Server {
+    public:
+        using CxxServer::Core::Http::Server::Server;
+        std::atomic<size_t> connections = 0;
+
+    protected:
+        std::shared_ptr<TcpSession> newSession(const std::shared_ptr<TcpServer> &server) override { return std::make_shared<HelloSession<CxxServer::Core::Http::Session>>(server); }
+
+        void onConnect(std::shared_ptr<TcpSession> &) override { ++connections; }
+        void onDisconnect(std::shared_ptr<TcpSession> &) override { --connections; }
+    };
+
+    // Answers from a response cache, caching the response to a miss
+    class CachedSession : public CxxServer::Core::Http::Session {
+    public:
+        using CxxServer::Core::Http::Session::Session;
+        static inline ResponseCache cache{1024 * 1024};
+
+    protected:
+        void onRequest(const Request &request) override {
+            auto cached = cache.find(request.path());
+            if (!cached) {
+                Response response;
+                response.header("Content-Type", "text/plain").body("cached " + std::string(request.path()));
+                cached = cache.insert(request.path(), response);
+            }
+
+            sendCached(cached);
+        }
+    };
+
+    class CachedServer : public HelloServer {
+    public:
+        using HelloServer::HelloServer;
+
+    protected:
+        std::shared_ptr<TcpSession> newSession(const std::shared_ptr<TcpServer> &server) override { return std::make_shared<CachedSession>(server); }
+    };
+
+    // Answers with a header block & the Date header, /cached from a response cache
+    class DatedSession : public CxxServer::Core::Http::Session {
+    public:
+        DatedSession(const std::shared_ptr<TcpServer> &server) : CxxServer::Core::Http::Session(server) { dateHeader() = true; }
+        static inline HeaderBlock block = HeaderBlock().header("Server", "CxxServer").header("Content-Type", "text/plain");
+        static inline ResponseCache cache{1024 * 1024};
+
+    protected:
+        void onRequest(const Request &request) override {
+            Response response;
+            response.headers(block).body("dated");
+
+            if (request.path() != "/cached") {
+                sendResponse(response);
+                return;
+            }
+
+            auto cached = cache.find(request.path());
+            sendCached(cached ? cached : cache.insert(request.path(), response));
+        }
+    };
+
+    class DatedServer : public HelloServer {
+    public:
+        using HelloServer::HelloServer;
+
+    protected:
+        std::shared_ptr<TcpSession> newSession(const std::shared_ptr<TcpServer> &server) override { return std::make_shared<DatedSession>(server); }
+    };
+
+    class HelloSslServer : public CxxServer::Core::Https::Server {
+    public:
+        using CxxServer::Core::Https::Server::Server;
+
+        static std::shared_ptr<SslContext> CreateContext()
+        {
+            auto context = std::make_shared<SslContext>(asio::ssl::context::tlsv12);
+            context->set_password_callback([](size_t max_length, asio::ssl::context::password_purpose purpose) -> std::string { return "qwerty"; });
+            context->use_certificate_chain_file("../certs/server.pem");
+            context->use_private_key_file("../certs/server.pem", asio::ssl::context::pem);
+            context->use_tmp_dh_file("../certs/dh4096.pem");
+            return context;
+        }
+
+    protected:
+        std::shared_ptr<TcpSession> newSession(const std::shared_ptr<TcpServer> &server) override { return std::make_shared<HelloSession<CxxServer::Core::Https::Session>>(server, context()); }
+    };
+
+    // Collects everything received
+    template<typename Base>
+    class CollectClient : public Base {
+    public:
+        using Base::Base;
+        std::atomic<size_t> received = 0;
+
+        std::string data() {
+            std::scoped_lock lock(_lock);
+            return _data;
+        }
+
+    protected:
+        void onReceive(const void *buffer, size_t size) override {
+            std::scoped_lock lock(_lock);
+            _data.append(static_cast<const char*>(buffer), size);
+            received += size;
+        }
+
+    private:
+        std::mutex _lock;
+        std::string _data;
+    };
+
+    // Routes the requests fed to it, collecting the responses without a transport
+    class RoutedConnection : public CxxServer::Core::Http::Connection {
+    public:
+        explicit RoutedConnection(const Router &router) : _router(router) {}
+        std::string sent;
+
+        void feed(std::string_view data) { receiveRequests(data.data(), data.size()); }
+
+    protected:
+        void onRequest(const Request &request) override { _router.route(*this, request); }
+
+        bool transportSend(const void *buffer, size_t size) override {
+            sent.append(static_cast<const char*>(buffer), size);
+            return true;
+        }
+
+        bool transportClose() override { return true; }
+
+    private:
+        const Router &_router;
+    };
+
+    // Serves static files, collecting the responses without a transport & counting how bodies are sent
+    class FileConnection : public CxxServer::Core::Http::Connection {
+    public:
+        explicit FileConnection(StaticFiles &files) : _files(files) {}
+        std::string sent;
+        size_t shared = 0;
+        size_t filed = 0;
+
+        std::string request(std::string_view data) {
+            sent.clear();
+            receiveRequests(data.data(), data.size());
+            return sent;
+        }
+
+    protected:
+        void onRequest(const Request &request) override { _files.serve(*this, request); }
+
+        bool transportSend(const void *buffer, size_t size) override {
+            sent.append(static_cast<const char*>(buffer), size);
+            return true;
+        }
+
+        bool transportSendShared(std::shared_ptr<const void> owner, const void *buffer, size_t size) override {
+            ++shared;
+            return transportSend(buffer, size);
+        }
+
+        bool transportSendFile(std::shared_ptr<const void> owner, int fd, uint64_t offset, size_t size) override {
+            ++filed;
+            return Connection::transportSendFile(std::move(owner), fd, offset, size);
+        }
+
+        bool transportClose() override { return true; }
+
+    private:
+        StaticFiles &_files;
+    };
+
+    // Answers from the static files
+    template<typename Base>
+    class FileSession : public Base {
+    public:
+        using Base::Base;
+        static inline StaticFiles *files = nullptr;
+
+    protected:
+        void onRequest(const Request &request) override { files->serve(*this, request); }
+    };
+
+    class FileServer : public HelloServer {
+    public:
+        using HelloServer::HelloServer;
+
+    protected:
+        std::shared_ptr<TcpSession> newSession(const std::shared_ptr<TcpServer> &server) override { return std::make_shared<FileSession<CxxServer::Core::Http::Session>>(server); }
+    };
+
+    class FileSslServer : public HelloSslServer {
+    public:
+        using HelloSslServer::HelloSslServer;
+
+    protected:
+        std::shared_ptr<TcpSession> newSession(const std::shared_ptr<TcpServer> &server) override { return std::make_shared<FileSession<CxxServer::Core::Https::Session>>(server, context()); }
+    };
+
+    // Writes a file of a test directory
+    void writeFile(const std::filesystem::path &path, std::string_view data) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), data.size());
+    }
+
+    std::string randomData(size_t size) {
+        std::mt19937 random(size);
+        std::string data(size, '\0');
+        for (auto &c : data)
+            c = static_cast<char>(random());
+        return data;
+    }
+
+    RequestParser::Result parseAll(RequestParser &parser, std::string_view data, Request &request, size_t &consumed) {
+        parser.reset();
+        request.clear();
+        return parser.parse(data.data(), data.size(), request, consumed);
+    }
+
+    TEST_CASE("HTTP request parser test", "[CxxServer][HTTP]") {
+        RequestParser parser;
+        Request request;
+        size_t consumed = 0;
+
+        const std::string get = "GET /hello?name=world HTTP/1.1\r\nHost: localhost\r\nX-Test:  padded value \t\r\n\r\n";
+        REQUIRE(parseAll(parser, get, request, consumed) == RequestParser::Result::Complete);
+        REQUIRE(consumed == get.size());
+        REQUIRE(request.method() == "GET");
+        REQUIRE(request.target() == "/hello?name=world");
+        REQUIRE(request.path() == "/hello");
+        REQUIRE(request.query() == "name=world");
+        REQUIRE(request.minorVersion() == 1);
+        REQUIRE(request.headers().size() == 2);
+        REQUIRE(request.header("host") == "localhost");
+        REQUIRE(request.header("x-test") == "padded value");
+        REQUIRE(request.header("missing").empty());
+        REQUIRE(request.keepAlive());
+        REQUIRE(request.body().empty());
+
+        // fed one byte at a time, the same start each time
+        const std::string post = "POST /submit HTTP/1.0\r\nConnection: keep-alive\r\nContent-Length: 5\r\n\r\nhello";
+        parser.reset();
+        request.clear();
+        for (size_t i = 1; i < post.size(); ++i)
+            REQUIRE(parser.parse(post.data(), i, request, consumed) == RequestParser::Result::Incomplete);
+        REQUIRE(parser.parse(post.data(), post.size(), request, consumed) == RequestParser::Result::Complete);
+        REQUIRE(consumed == post.size());
+        REQUIRE(request.minorVersion() == 0);
+        REQUIRE(request.keepAlive());
+        REQUIRE(request.body() == "hello");
+
+        // pipelined requests are parsed one at a time
+        const std::string pipelined = get + "GET /close HTTP/1.1\r\nConnection: close\r\n\r\n";
+        REQUIRE(parseAll(parser, pipelined, request, consumed) == RequestParser::Result::Complete);
+        REQUIRE(consumed == get.size());
+        REQUIRE(parseAll(parser, std::string_view(pipelined).substr(consumed), request, consumed) == RequestParser::Result::Complete);
+        REQUIRE(request.path() == "/close");
+        REQUIRE(!request.keepAlive());
+
+        // chunked bodies are dechunked, split anywhere
+        const std::string chunked = "POST /c HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5;ext=1\r\nhello\r\n6\r\n world\r\n0\r\nTrailer: x\r\n\r\n";
+        parser.reset();
+        request.clear();
+        for (size_t i = 1; i < chunked.size(); ++i)
+            REQUIRE(parser.parse(chunked.data(), i, request, consumed) == RequestParser::Result::Incomplete);
+        REQUIRE(parser.parse(chunked.data(), chunked.size(), request, consumed) == RequestParser::Result::Complete);
+        REQUIRE(consumed == chunked.size());
+        REQUIRE(request.isChunked());
+        REQUIRE(request.body() == "hello world");
+
+        // invalid requests
+        const std::pair<std::string, int> invalid[] = {
+            { "GET / HTTP/2.0\r\n\r\n", 505 },
+            { "GET /\r\n\r\n", 400 },
+            { "G(T / HTTP/1.1\r\n\r\n", 400 },
+            { "GET / HTTP/1.1\r\nBad Name: x\r\n\r\n", 400 },
+            { "GET / HTTP/1.1\r\nA: x\r\n folded\r\n\r\n", 400 },
+            { "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", 400 },
+            { "POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", 400 },
+            { "POST / HTTP/1.1\r\nContent-Length: 1\r\nTransfer-Encoding: chunked\r\n\r\n", 400 },
+            { "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", 501 },
+            { "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 400 },
+            { "POST / HTTP/1.1\r\nContent-Length: 99999999999\r\n\r\n", 413 }
+        };
+
+        for (const auto &[data, status] : invalid) {
+            INFO(data);
+            REQUIRE(parseAll(parser, data, request, consumed) == RequestParser::Result::Error);
+            REQUIRE(parser.errorStatus() == status);
+        }
+
+        parser.limits().max_header_size = 64;
+        REQUIRE(parseAll(parser, "GET / HTTP/1.1\r\nX-Long: " + std::string(64, 'x'), request, consumed) == RequestParser::Result::Error);
+        REQUIRE(parser.errorStatus() == 431);
+    }
+
+    TEST_CASE("HTTP vectorized scan test", "[CxxServer][HTTP]") {
+        namespace Scan = CxxServer::Core::Http::Scan;
+
+        std::mt19937 random(1234);
+        const std::string alphabet = "\r\n:aZ9-_ \t(\x80\xff";
+
+        // every instruction set the CPU supports agrees with the scalar scans, on all lengths & alignments
+        for (auto isa : { Scan::Isa::SSE42, Scan::Isa::AVX2 }) {
+            if (!Scan::useIsa(Scan::Isa::Scalar) || static_cast<int>(isa) > static_cast<int>(Scan::bestIsa()))
+                continue;
+
+            INFO(Scan::name(isa));
+            for (size_t iteration = 0; iteration < 2000; ++iteration) {
+                std::string data(random() % 130, 'a');
+                for (auto &c : data) {
+                    // mostly token chars so the scans reach the end
+                    if (random() % 8 == 0)
+                        c = alphabet[random() % alphabet.size()];
+                }
+
+                size_t offset = random() % (data.size() + 1);
+                const char *start = data.data() + offset;
+                size_t size = data.size() - offset;
+
+                REQUIRE(Scan::useIsa(Scan::Isa::Scalar));
+                size_t end = Scan::findHeaderEnd(start, size);
+                size_t cr = Scan::findChar(start, size, '\r');
+                size_t colon = Scan::findChar(start, size, ':');
+                size_t token = Scan::tokenLength(start, size);
+
+                REQUIRE(Scan::useIsa(isa));
+                REQUIRE(Scan::isa() == isa);
+                REQUIRE(Scan::findHeaderEnd(start, size) == end);
+                REQUIRE(Scan::findChar(start, size, '\r') == cr);
+                REQUIRE(Scan::findChar(start, size, ':') == colon);
+                REQUIRE(Scan::tokenLength(start, size) == token);
+            }
+
+            // terminators & bad token chars at every position of a long buffer
+            for (size_t i = 0; i < 100; ++i) {
+                std::string data(100, 'x');
+                REQUIRE(Scan::isToken(data));
+                data.replace(i, std::min<size_t>(4, 100 - i), std::string("\r\n\r\n").substr(0, 100 - i));
+                REQUIRE(Scan::findHeaderEnd(data.data(), data.size()) == (i + 4 <= 100 ? i : Scan::npos));
+                REQUIRE(Scan::findChar(data.data(), data.size(), '\r') == i);
+                REQUIRE(Scan::tokenLength(data.data(), data.size()) == i);
+            }
+        }
+
+        REQUIRE(Scan::useIsa(Scan::bestIsa()));
+        REQUIRE(Scan::isToken("Content-Length"));
+        REQUIRE(!Scan::isToken(""));
+        REQUIRE(!Scan::isToken("Bad Name"));
+    }
+
+    TEST_CASE("HTTP server test", "[CxxServer][HTTP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1140;
+
+        auto service = std::make_shared<CxxServer::Core::Service>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<HelloServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<CollectClient<TcpClient>>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isConnected() || server->connections != 1)
+            std::this_thread::yield();
+
+        // pipelined requests, the second split over two sends
+        client->sendAsync("GET /a HTTP/1.1\r\nHost: x\r\n\r\nPOST /b HTTP/1.1\r\nContent-Le");
+        client->sendAsync("ngth: 3\r\n\r\nabcGET /chunked HTTP/1.1\r\n\r\n");
+
+        const std::string expected =
+            "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 3\r\n\r\n/a:"
+            "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 6\r\n\r\n/b:abc"
+            "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nTransfer-Encoding: chunked\r\n\r\n6\r\nhello \r\n5\r\nworld\r\n0\r\n\r\n";
+
+        while (client->received < expected.size())
+            std::this_thread::yield();
+        REQUIRE(client->data() == expected);
+        REQUIRE(client->isConnected());
+
+        // the last request closes the connection once answered
+        client->sendAsync("GET /bye HTTP/1.1\r\nConnection: close\r\n\r\n");
+        while (client->isConnected() || server->connections != 0)
+            std::this_thread::yield();
+        REQUIRE(client->data() == expected + "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nConnection: close\r\nContent-Length: 5\r\n\r\n/bye:");
+
+        // invalid requests are answered & close the connection
+        auto invalid = std::make_shared<CollectClient<TcpClient>>(service, address, port);
+        REQUIRE(invalid->connectAsync());
+        while (!invalid->isConnected())
+            std::this_thread::yield();
+        invalid->sendAsync("GET / HTTP/1.1\r\nContent-Length: x\r\n\r\n");
+        while (invalid->isConnected() || server->connections != 0)
+            std::this_thread::yield();
+        REQUIRE(invalid->data() == "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("HTTP response cache test", "[CxxServer][HTTP]") {
+        Response response;
+        response.header("Content-Type", "text/plain").body("hello");
+
+        // every entry takes the key & the serialized response, 3 fit in the cache
+        const size_t entry = 2 + response.head().size() + std::string_view("Content-Length: 5\r\n\r\nhello").size();
+        ResponseCache cache(3 * entry);
+
+        REQUIRE(cache.find("/a") == nullptr);
+        auto a = cache.insert("/a", response);
+        REQUIRE(a != nullptr);
+        REQUIRE(a->key() == "/a");
+        REQUIRE(a->data() == "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 5\r\n\r\nhello");
+        REQUIRE(std::string(a->head()) + std::string(a->rest()) == a->data());
+        REQUIRE(cache.insert("/b", response) != nullptr);
+        REQUIRE(cache.insert("/c", response) != nullptr);
+        REQUIRE(cache.bytes() == 3 * entry);
+
+        // looking up /a makes /b the least recently used, evicted by /d
+        REQUIRE(cache.find("/a") == a);
+        REQUIRE(cache.insert("/d", response) != nullptr);
+        REQUIRE(cache.size() == 3);
+        REQUIRE(cache.numEvictions() == 1);
+        REQUIRE(cache.find("/b") == nullptr);
+        REQUIRE(cache.find(std::string("/a")) == a);
+
+        // replacing keeps a single entry, the replaced response stays valid for whoever holds it
+        response.body("howdy");
+        auto replaced = cache.insert("/a", response);
+        REQUIRE(cache.size() == 3);
+        REQUIRE(cache.find("/a") == replaced);
+        REQUIRE(a->data().substr(a->data().size() - 5) == "hello");
+
+        REQUIRE(cache.invalidate("/a"));
+        REQUIRE(!cache.invalidate("/a"));
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.numHits() == 3);
+        REQUIRE(cache.numMisses() == 2);
+
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.bytes() == 0);
+
+        response.chunked();
+        REQUIRE(cache.insert("/chunked", response) == nullptr);
+
+        // bounded by # of entries
+        ResponseCache entries(1024 * 1024, 2);
+        response.clear();
+        REQUIRE(entries.insert("/dir/1", response) != nullptr);
+        REQUIRE(entries.insert("/dir/2", response) != nullptr);
+        REQUIRE(entries.insert("/other", response) != nullptr);
+        REQUIRE(entries.size() == 2);
+        REQUIRE(entries.numEvictions() == 1);
+        REQUIRE(entries.invalidatePrefix("/dir/") == 1);
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries.find("/other") != nullptr);
+    }
+
+    TEST_CASE("HTTP cached response send test", "[CxxServer][HTTP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1142;
+
+        auto service = std::make_shared<CxxServer::Core::Service>(2);
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<CachedServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        const std::string response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 9\r\n\r\ncached /x";
+        const size_t num_requests = 100;
+
+        // many connections are sent the same cached buffer
+        std::vector<std::shared_ptr<CollectClient<TcpClient>>> clients;
+        for (size_t i = 0; i < 4; ++i) {
+            clients.push_back(std::make_shared<CollectClient<TcpClient>>(service, address, port));
+            REQUIRE(clients.back()->connectAsync());
+        }
+
+        for (auto &client : clients) {
+            while (!client->isConnected())
+                std::this_thread::yield();
+
+            std::string requests;
+            for (size_t i = 0; i < num_requests; ++i)
+                requests.append("GET /x HTTP/1.1\r\n\r\n");
+            client->sendAsync(requests);
+        }
+
+        for (auto &client : clients) {
+            while (client->received < num_requests * response.size())
+                std::this_thread::yield();
+
+            std::string expected;
+            for (size_t i = 0; i < num_requests; ++i)
+                expected.append(response);
+            REQUIRE(client->data() == expected);
+        }
+
+        REQUIRE(CachedSession::cache.size() == 1);
+        REQUIRE(CachedSession::cache.numHits() + CachedSession::cache.numMisses() == clients.size() * num_requests);
+
+        // the Connection header is spliced into the cached response
+        auto closing = std::make_shared<CollectClient<TcpClient>>(service, address, port);
+        REQUIRE(closing->connectAsync());
+        while (!closing->isConnected())
+            std::this_thread::yield();
+
+        closing->sendAsync("GET /x HTTP/1.0\r\n\r\n");
+        while (closing->isConnected())
+            std::this_thread::yield();
+        REQUIRE(closing->data() == "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 9\r\nConnection: close\r\n\r\ncached /x");
+
+        for (auto &client : clients)
+            REQUIRE(client->disconnectAsync());
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        CachedSession::cache.clear();
+    }
+
+    TEST_CASE("HTTP date header test", "[CxxServer][HTTP]") {
+        char buf[Date::size];
+        REQUIRE(Date::format(784111777, buf) == "Sun, 06 Nov 1994 08:49:37 GMT");
+        REQUIRE(Date::format(951782400, buf) == "Tue, 29 Feb 2000 00:00:00 GMT");
+
+        auto header = Date::header();
+        REQUIRE(header.size() == 6 + Date::size + 2);
+        REQUIRE(header.substr(0, 6) == "Date: ");
+        REQUIRE(header.substr(header.size() - 2) == "\r\n");
+        REQUIRE(Date::header().data() == header.data());
+
+        REQUIRE(Response::statusLine(200) == "HTTP/1.1 200 OK\r\n");
+        REQUIRE(Response::statusLine(404) == "HTTP/1.1 404 Not Found\r\n");
+        REQUIRE(Response::statusLine(299).empty());
+        REQUIRE(Response::statusLine(-1).empty());
+        REQUIRE(Response().status(299).head() == "HTTP/1.1 299 Unknown\r\n");
+        REQUIRE(Response().status(200, "Fine").head() == "HTTP/1.1 200 Fine\r\n");
+
+        auto service = std::make_shared<CxxServer::Core::Service>(1);
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        // the timer publishes the second instead of reading the clock
+        auto timer = std::make_shared<DateTimer>(service);
+        REQUIRE(timer->start());
+        REQUIRE(!timer->start());
+        REQUIRE(timer->isStarted());
+
+        auto start = std::time(nullptr);
+        while (std::time(nullptr) < start + 2)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        REQUIRE(Date::now() >= start + 2);
+        REQUIRE(Date::now() <= std::time(nullptr));
+
+        std::time_t now = Date::now();
+        REQUIRE(Date::header().substr(6, Date::size) == Date::format(now, buf));
+
+        REQUIRE(timer->stop());
+        REQUIRE(!timer->stop());
+
+        // a timer still ticking as its service stops, or started on a stopped one, doesn't freeze the date
+        REQUIRE(timer->start());
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        auto stale = std::make_shared<DateTimer>(service);
+        REQUIRE(stale->start());
+
+        start = std::time(nullptr);
+        while (std::time(nullptr) < start + 2)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        REQUIRE(Date::now() >= start + 2);
+        REQUIRE(Date::header().substr(6, Date::size) == Date::format(Date::now(), buf));
+    }
+
+    TEST_CASE("HTTP header block & date test", "[CxxServer][HTTP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1143;
+
+        auto service = std::make_shared<CxxServer::Core::Service>(2);
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<DatedServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<CollectClient<TcpClient>>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isConnected())
+            std::this_thread::yield();
+
+        client->sendAsync("GET / HTTP/1.1\r\n\r\nGET /cached HTTP/1.1\r\n\r\nGET /cached HTTP/1.1\r\nConnection: close\r\n\r\n");
+        while (client->isConnected())
+            std::this_thread::yield();
+
+        // the date may tick between responses, it is checked & cut out of each response
+        const std::string head = "HTTP/1.1 200 OK\r\nServer: CxxServer\r\nContent-Type: text/plain\r\nContent-Length: 5\r\n";
+        std::string data = client->data();
+        for (std::string expected : { head + "\r\ndated", head + "\r\ndated", head + "Connection: close\r\n\r\ndated" }) {
+            size_t date = data.find("Date: ");
+            REQUIRE(date < data.find("\r\n\r\n"));
+            REQUIRE(data.substr(date + 6 + Date::size - 4, 6) == " GMT\r\n");
+            data.erase(date, 6 + Date::size + 2);
+
+            REQUIRE(data.substr(0, expected.size()) == expected);
+            data.erase(0, expected.size());
+        }
+        REQUIRE(data.empty());
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("HTTP router test", "[CxxServer][HTTP]") {
+        Router router;
+        std::string called;
+        auto handler = [&called](std::string name) {
+            return [&called, name](CxxServer::Core::Http::Connection &connection, const Request &, const RouteParams &params) {
+                called = name;
+                for (size_t i = 0; i < params.size(); ++i)
+                    called.append(" ").append(params.name(i)).append("=").append(params.value(i));
+
+                Response response;
+                connection.sendResponse(response.body(called));
+            };
+        };
+
+        REQUIRE(router.add("GET", "/", handler("root")));
+        REQUIRE(router.add("GET", "/users", handler("users")));
+        REQUIRE(router.add("GET", "/users/new", handler("new")));
+        REQUIRE(router.add("GET", "/users/:id", handler("user")));
+        REQUIRE(router.add("DELETE", "/users/:id", handler("delete")));
+        REQUIRE(router.add("GET", "/users/:id/posts/:post", handler("post")));
+        REQUIRE(router.add("GET", "/user", handler("user singular")));
+        REQUIRE(router.add("GET", "/files/*path", handler("files")));
+        REQUIRE(router.add("GET", "/files/readme", handler("readme")));
+        REQUIRE(router.size() == 9);
+
+        REQUIRE(!router.add("GET", "/users/:id", handler("again")));
+        REQUIRE(!router.add("GET", "/users/:name/likes", handler("renamed")));
+        REQUIRE(!router.add("GET", "users", handler("relative")));
+        REQUIRE(!router.add("GET", "/a:b", handler("partial")));
+        REQUIRE(!router.add("GET", "/:", handler("unnamed")));
+        REQUIRE(!router.add("GET", "/*rest/more", handler("not last")));
+        REQUIRE(!router.add("GET", "/:a/:b/:c/:d/:e/:f/:g/:h/:i", handler("too many")));
+        REQUIRE(router.size() == 9);
+
+        auto find = [&router, &called](std::string_view method, std::string_view path) -> std::string {
+            RouteParams params;
+            auto found = router.find(method, path, params);
+            if (found == nullptr)
+                return "none";
+
+            RoutedConnection connection(router);
+            (*found)(connection, Request(), params);
+            return called;
+        };
+
+        REQUIRE(find("GET", "/") == "root");
+        REQUIRE(find("GET", "/users") == "users");
+        REQUIRE(find("GET", "/user") == "user singular");
+        REQUIRE(find("GET", "/users/new") == "new");
+        REQUIRE(find("GET", "/users/newer") == "user id=newer");
+        REQUIRE(find("GET", "/users/42") == "user id=42");
+        REQUIRE(find("DELETE", "/users/42") == "delete id=42");
+        REQUIRE(find("GET", "/users/42/posts/7") == "post id=42 post=7");
+        REQUIRE(find("GET", "/users/42/posts") == "none");
+        REQUIRE(find("GET", "/users/") == "none");
+        REQUIRE(find("GET", "/files/readme") == "readme");
+        REQUIRE(find("GET", "/files/docs/a b.txt") == "files path=docs/a b.txt");
+        REQUIRE(find("GET", "/files/") == "files path=");
+        REQUIRE(find("GET", "/files") == "none");
+        REQUIRE(find("POST", "/users") == "none");
+        REQUIRE(find("GET", "relative") == "none");
+
+        REQUIRE(router.allowed("/users/42") == "GET, DELETE");
+        REQUIRE(router.allowed("/nowhere").empty());
+
+        // params are views of the path
+        std::string path = "/users/42/posts/7";
+        RouteParams params;
+        REQUIRE(router.find("GET", path, params) != nullptr);
+        REQUIRE(params["post"] == "7");
+        REQUIRE(params["post"].data() == path.data() + 16);
+        REQUIRE(params["missing"].empty());
+
+        RoutedConnection connection(router);
+        connection.feed("GET /users/42 HTTP/1.1\r\n\r\nPUT /users/42 HTTP/1.1\r\n\r\nGET /nowhere HTTP/1.1\r\n\r\n");
+        REQUIRE(connection.sent ==
+            "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nuser id=42"
+            "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET, DELETE\r\nContent-Length: 0\r\n\r\n"
+            "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    }
+
+    TEST_CASE("HTTP route table test", "[CxxServer][HTTP]") {
+        static constexpr RouteSpec routes[] = {
+            { "GET", "/" },
+            { "GET", "/users" },
+            { "GET", "/users/new" },
+            { "GET", "/users/:id" },
+            { "DELETE", "/users/:id" },
+            { "GET", "/users/:id/posts/:post" },
+            { "GET", "/files/*path" },
+            { "GET", "/files/readme" }
+        };
+        static constexpr RouteTable table(routes);
+
+        // matched at compile time too
+        static_assert([] {
+            RouteParams params;
+            return table.find("GET", "/users/42/posts/7", params) == table.index("GET", "/users/:id/posts/:post") && params["post"] == "7";
+        }());
+
+        RouteParams params;
+        auto find = [&params](std::string_view method, std::string_view path) {
+            size_t route = table.find(method, path, params);
+            return route == table.npos ? std::string("none") : std::string(table[route].method) + " " + std::string(table[route].pattern);
+        };
+
+        REQUIRE(find("GET", "/") == "GET /");
+        REQUIRE(find("GET", "/users") == "GET /users");
+        REQUIRE(find("GET", "/users/new") == "GET /users/new");
+        REQUIRE(find("GET", "/users/newer") == "GET /users/:id");
+        REQUIRE(params["id"] == "newer");
+        REQUIRE(find("DELETE", "/users/42") == "DELETE /users/:id");
+        REQUIRE(find("GET", "/users/42/posts/7") == "GET /users/:id/posts/:post");
+        REQUIRE(params.size() == 2);
+        REQUIRE(find("GET", "/users/42/posts") == "none");
+        REQUIRE(find("GET", "/users/") == "none");
+        REQUIRE(find("GET", "/files/readme") == "GET /files/readme");
+        REQUIRE(find("GET", "/files/docs/a.txt") == "GET /files/*path");
+        REQUIRE(params["path"] == "docs/a.txt");
+        REQUIRE(find("GET", "/files/") == "GET /files/*path");
+        REQUIRE(find("POST", "/users") == "none");
+
+        switch (table.find("DELETE", "/users/7", params)) {
+            case table.index("DELETE", "/users/:id"):
+                REQUIRE(params["id"] == "7");
+                break;
+            default:
+                FAIL("Wrong route");
+        }
+    }
+
+    TEST_CASE("HTTPS server test", "[CxxServer][HTTP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1141;
+
+        auto service = std::make_shared<CxxServer::Core::Service>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<HelloSslServer>(service, HelloSslServer::CreateContext(), address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client_context = std::make_shared<SslContext>(asio::ssl::context::tlsv12);
+        client_context->set_default_verify_paths();
+        client_context->set_verify_mode(asio::ssl::verify_peer | asio::ssl::verify_fail_if_no_peer_cert);
+        client_context->load_verify_file("../certs/ca.pem");
+
+        auto client = std::make_shared<CollectClient<SslClient>>(service, client_context, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isReady())
+            std::this_thread::yield();
+
+        client->sendAsync("GET /secure HTTP/1.0\r\nConnection: keep-alive\r\n\r\nGET /bye HTTP/1.0\r\n\r\n");
+
+        const std::string expected =
+            "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nConnection: keep-alive\r\nContent-Length: 8\r\n\r\n/secure:"
+            "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nConnection: close\r\nContent-Length: 5\r\n\r\n/bye:";
+
+        while (client->isConnected())
+            std::this_thread::yield();
+        REQUIRE(client->data() == expected);
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("HTTP static files test", "[CxxServer][HTTP]") {
+        auto root = std::filesystem::temp_directory_path() / "cxxserver_static_files_test";
+        std::filesystem::remove_all(root);
+
+        const std::string index = "<h1>hello</h1>";
+        const std::string big = randomData(300 * 1024);
+        writeFile(root / "index.html", index);
+        writeFile(root / "big.bin", big);
+        writeFile(root / "dir" / "a b.txt", "spaced");
+        writeFile(root / "empty.txt", "");
+
+        StaticFiles files(root.string(), 256 * 1024, 64 * 1024 * 1024, 1024, std::chrono::hours(1));
+        FileConnection connection(files);
+
+        auto file = files.open("/index.html");
+        REQUIRE(file != nullptr);
+        REQUIRE(file->isBuffered());
+        REQUIRE(file->size() == index.size());
+        REQUIRE(file->contentType() == "text/html; charset=utf-8");
+        REQUIRE(file->etag().front() == '"');
+        REQUIRE(file->lastModified().size() == CxxServer::Core::Http::Date::size);
+        auto etag = std::string(file->etag());
+        auto modified = std::string(file->lastModified());
+        auto validators = "ETag: " + etag + "\r\nLast-Modified: " + modified + "\r\n";
+
+        // small files are sent from their copy in memory, the body of a response to HEAD is left out
+        const std::string head = "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\n" + validators + "Accept-Ranges: bytes\r\nContent-Length: 14\r\n\r\n";
+        REQUIRE(connection.request("GET /index.html HTTP/1.1\r\n\r\n") == head + index);
+        REQUIRE(connection.shared == 1);
+        REQUIRE(connection.request("HEAD /index.html HTTP/1.1\r\n\r\n") == head);
+        REQUIRE(connection.shared == 1);
+
+        // conditional requests
+        const std::string not_modified = "HTTP/1.1 304 Not Modified\r\n" + validators + "\r\n";
+        REQUIRE(connection.request("GET /index.html HTTP/1.1\r\nIf-None-Match: \"x\", W/" + etag + "\r\n\r\n") == not_modified);
+        REQUIRE(connection.request("GET /index.html HTTP/1.1\r\nIf-Modified-Since: " + modified + "\r\n\r\n") == not_modified);
+        REQUIRE(connection.request("GET /index.html HTTP/1.1\r\nIf-None-Match: \"x\"\r\nIf-Modified-Since: " + modified + "\r\n\r\n") == head + index);
+
+        // large files are sent from the descriptor, ranges included
+        auto bin = files.open("big.bin");
+        REQUIRE(!bin->isBuffered());
+        auto response = connection.request("GET /big.bin HTTP/1.1\r\n\r\n");
+        REQUIRE(response.substr(0, 17) == "HTTP/1.1 200 OK\r\n");
+        REQUIRE(response.find("Content-Type: application/octet-stream\r\n") != std::string::npos);
+        REQUIRE(response.substr(response.size() - big.size()) == big);
+        REQUIRE(connection.filed == 1);
+
+        auto ranged = [&](const std::string &range) {
+            return connection.request("GET /big.bin HTTP/1.1\r\nRange: " + range + "\r\n\r\n");
+        };
+
+        response = ranged("bytes=4-6");
+        REQUIRE(response.substr(0, 28) == "HTTP/1.1 206 Partial Content");
+        REQUIRE(response.find("Content-Range: bytes 4-6/307200\r\nContent-Length: 3\r\n\r\n") != std::string::npos);
+        REQUIRE(response.substr(response.size() - 3) == big.substr(4, 3));
+
+        response = ranged("bytes=-10");
+        REQUIRE(response.find("Content-Range: bytes 307190-307199/307200\r\n") != std::string::npos);
+        REQUIRE(response.substr(response.size() - 10) == big.substr(big.size() - 10));
+
+        response = ranged("bytes=307000-999999");
+        REQUIRE(response.find("Content-Range: bytes 307000-307199/307200\r\nContent-Length: 200\r\n") != std::string::npos);
+
+        REQUIRE(ranged("bytes=307200-") == "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */307200\r\nContent-Length: 0\r\n\r\n");
+        REQUIRE(ranged("bytes=0-1,5-6").substr(0, 17) == "HTTP/1.1 200 OK\r\n");
+        REQUIRE(ranged("bytes=6-4").substr(0, 17) == "HTTP/1.1 200 OK\r\n");
+        REQUIRE(connection.request("GET /big.bin HTTP/1.1\r\nRange: bytes=0-0\r\nIf-Range: \"old\"\r\n\r\n").substr(0, 17) == "HTTP/1.1 200 OK\r\n");
+        REQUIRE(connection.request("GET /big.bin HTTP/1.1\r\nRange: bytes=0-0\r\nIf-Range: " + std::string(bin->etag()) + "\r\n\r\n").substr(0, 12) == "HTTP/1.1 206");
+
+        response = connection.request("GET /dir/a%20b.txt HTTP/1.1\r\n\r\n");
+        REQUIRE(response.find("Content-Type: text/plain; charset=utf-8\r\n") != std::string::npos);
+        REQUIRE(response.substr(response.size() - 6) == "spaced");
+        REQUIRE(connection.request("GET /empty.txt HTTP/1.1\r\n\r\n").find("Content-Length: 0\r\n\r\n") != std::string::npos);
+
+        // nothing outside the root, no directories
+        const std::string not_found = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        for (auto path : { "/missing", "/dir", "/", "/../cxxserver_static_files_test/index.html", "/dir/%2e%2e/index.html", "/index.html%00", "/%zz" })
+            REQUIRE(connection.request("GET " + std::string(path) + " HTTP/1.1\r\n\r\n") == not_found);
+
+        REQUIRE(connection.request("POST /index.html HTTP/1.1\r\n\r\n") == "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET, HEAD\r\nContent-Length: 0\r\n\r\n");
+
+        REQUIRE(files.size() == 4);
+        REQUIRE(files.bufferedBytes() == index.size() + 6);
+        REQUIRE(files.numMisses() == 6);
+        REQUIRE(files.numHits() > 10);
+
+        // replaced files are noticed once the cached ones are checked again
+        StaticFiles checked(root.string(), 256 * 1024, 64 * 1024 * 1024, 2, std::chrono::nanoseconds(0));
+        REQUIRE(checked.open("index.html")->size() == index.size());
+        writeFile(root / "index.tmp", "<h1>replaced</h1>");
+        std::filesystem::rename(root / "index.tmp", root / "index.html");
+        REQUIRE(checked.open("index.html")->size() == 17);
+        REQUIRE(checked.numMisses() == 2);
+        REQUIRE(checked.open("index.html")->size() == 17);
+        REQUIRE(checked.numHits() == 1);
+
+        // bounded by # of files, evicted files stay valid
+        auto evicted = checked.open("index.html");
+        REQUIRE(checked.open("big.bin") != nullptr);
+        REQUIRE(checked.open("empty.txt") != nullptr);
+        REQUIRE(checked.size() == 2);
+        REQUIRE(std::string_view(static_cast<const char*>(evicted->data()), evicted->size()) == "<h1>replaced</h1>");
+
+        std::filesystem::remove(root / "empty.txt");
+        REQUIRE(checked.open("empty.txt") == nullptr);
+        REQUIRE(checked.size() == 1);
+
+        // files truncated in place are served as cached until checked again, then as they are now
+        const std::string kept = "<p>kept</p>";
+        writeFile(root / "kept.html", kept);
+        auto kept_head = [&](StaticFiles &cache, size_t size) {
+            auto kept_file = cache.open("kept.html");
+            return "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nETag: " + std::string(kept_file->etag()) + "\r\nLast-Modified: " +
+                   std::string(kept_file->lastModified()) + "\r\nAccept-Ranges: bytes\r\nContent-Length: " + std::to_string(size) + "\r\n\r\n";
+        };
+
+        REQUIRE(connection.request("GET /kept.html HTTP/1.1\r\n\r\n") == kept_head(files, kept.size()) + kept);
+        std::filesystem::resize_file(root / "kept.html", 0);
+        REQUIRE(connection.request("GET /kept.html HTTP/1.1\r\n\r\n") == kept_head(files, kept.size()) + kept);
+        REQUIRE(connection.request("GET /kept.html HTTP/1.1\r\nRange: bytes=3-6\r\n\r\n").substr(0, 12) == "HTTP/1.1 206");
+
+        FileConnection checked_connection(checked);
+        REQUIRE(checked_connection.request("GET /kept.html HTTP/1.1\r\n\r\n") == kept_head(checked, 0));
+
+        std::filesystem::remove_all(root);
+    }
+
+    TEST_CASE("HTTP static files send test", "[CxxServer][HTTP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1144;
+        const unsigned int ssl_port = 1145;
+
+        auto root = std::filesystem::temp_directory_path() / "cxxserver_static_files_send_test";
+        std::filesystem::remove_all(root);
+
+        const std::string small = "small file";
+        const std::string big = randomData(5 * 1024 * 1024 + 123);
+        writeFile(root / "small.txt", small);
+        writeFile(root / "big.bin", big);
+
+        StaticFiles files(root.string());
+        FileSession<CxxServer::Core::Http::Session>::files = &files;
+        FileSession<CxxServer::Core::Https::Session>::files = &files;
+
+        auto expected = [&](std::string_view path, std::string_view type, const std::string &body, std::string_view extra) {
+            auto file = files.open(path);
+            return "HTTP/1.1 200 OK\r\nContent-Type: " + std::string(type) + "\r\nETag: " + std::string(file->etag()) + "\r\nLast-Modified: " +
+                   std::string(file->lastModified()) + "\r\nAccept-Ranges: bytes\r\n" + std::string(extra) + "Content-Length: " + std::to_string(body.size()) +
+                   "\r\n\r\n" + body;
+        };
+
+        // a file held in memory, a file sent from its descriptor & a range of it, in order
+        const std::string requests = "GET /small.txt HTTP/1.1\r\n\r\nGET /big.bin HTTP/1.1\r\n\r\nGET /big.bin HTTP/1.1\r\nRange: bytes=1000000-\r\nConnection: close\r\n\r\n";
+        auto range = expected("big.bin", "application/octet-stream", big.substr(1000000), "Content-Range: bytes 1000000-5243002/5243003\r\nConnection: close\r\n");
+        range.replace(9, 6, "206 Partial Content");
+        const std::string responses = expected("small.txt", "text/plain; charset=utf-8", small, "") + expected("big.bin", "application/octet-stream", big, "") + range;
+
+        auto service = std::make_shared<CxxServer::Core::Service>(2);
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<FileServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto ssl_server = std::make_shared<FileSslServer>(service, HelloSslServer::CreateContext(), address, ssl_port);
+        ssl_server->reuseAddress() = true;
+        REQUIRE(ssl_server->start());
+        while (!ssl_server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<CollectClient<TcpClient>>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isConnected())
+            std::this_thread::yield();
+
+        client->sendAsync(requests);
+        while (client->isConnected())
+            std::this_thread::yield();
+        REQUIRE(client->data() == responses);
+
+        // over SSL the file is read through the session's buffer
+        auto client_context = std::make_shared<SslContext>(asio::ssl::context::tlsv12);
+        client_context->set_default_verify_paths();
+        client_context->set_verify_mode(asio::ssl::verify_peer | asio::ssl::verify_fail_if_no_peer_cert);
+        client_context->load_verify_file("../certs/ca.pem");
+
+        auto ssl_client = std::make_shared<CollectClient<SslClient>>(service, client_context, address, ssl_port);
+        REQUIRE(ssl_client->connectAsync());
+        while (!ssl_client->isReady())
+            std::this_thread::yield();
+
+        ssl_client->sendAsync(requests);
+        while (ssl_client->isConnected())
+            std::this_thread::yield();
+        REQUIRE(ssl_client->data() == responses);
+
+        REQUIRE(server->stop());
+        REQUIRE(ssl_server->stop());
+        while (server->isStarted() || ssl_server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        std::filesystem::remove_all(root);
+    }
+}
@@ -1,18 +1,40 @@
 #include "catch2/catch.hpp"
 
 #include "core/service.hxx"
+#include "core/task.hxx"
+#include "core/timer.hxx"
+#include "core/tcp/awaitable.hxx"
+#include "core/tcp/client_group.hxx"
+#include "core/tcp/client_pool.hxx"
+#include "core/tcp/request_client.hxx"
+#include "core/tcp/request_hedger.hxx"
 #include "core/tcp/tcp_client.hxx"
+#include "core/tcp/tcp_proxy.hxx"
 #include "core/tcp/tcp_session.hxx"
 #include "core/tcp/tcp_server.hxx"
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
 #include <chrono>
 #include <cstddef>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 namespace {
 
     using SslSession = CxxServer::Core::Tcp::Session;
@@ -86,6 +108,430 @@ namespace {
         void onErr(int error, const std::string &category, const std::string &message) override { errors = true; }
     };
 
+    class ReconnectClient : public EchoClient {
+    public:
+        using EchoClient::EchoClient;
+        std::atomic<size_t> connects = 0;
+        std::atomic<bool> gave_up = false;
+
+    protected:
+        void onConnect() override { EchoClient::onConnect(); ++connects; }
+        void onReconnectFailed() override { gave_up = true; }
+    };
+
+    // collects what it receives, slow to handle its connect so sends from other threads land in between
+    class CollectClient : public ReconnectClient {
+    public:
+        using ReconnectClient::ReconnectClient;
+
+        std::string data() {
+            std::scoped_lock lock(_lock);
+            return _data;
+        }
+
+    protected:
+        void onConnect() override {
+            ReconnectClient::onConnect();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        void onReceive(const void *buffer, size_t size) override {
+            std::scoped_lock lock(_lock);
+            _data.append(static_cast<const char*>(buffer), size);
+        }
+
+    private:
+        std::mutex _lock;
+        std::string _data;
+    };
+
+    // counts its errors
+    class CountingServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+            std::atomic<size_t> num_errors = 0;
+
+        protected:
+            void onErr(int error, const std::string &category, const std::string &message) override { ++num_errors; }
+    };
+
+    // # of local sockets still connecting to a port, from the kernel's IPv4 TCP table
+    size_t numConnecting(unsigned int port) {
+        std::ifstream table("/proc/net/tcp");
+        std::string line;
+        std::getline(table, line);
+
+        size_t count = 0;
+        while (std::getline(table, line)) {
+            unsigned int remote_port = 0;
+            unsigned int state = 0;
+            // SYN_SENT is state 2
+            if (std::sscanf(line.c_str(), " %*u: %*x:%*x %*x:%x %x", &remote_port, &state) == 2 && remote_port == port && state == 2)
+                ++count;
+        }
+
+        return count;
+    }
+
+    // Loopback listener whose accept queue is full & never drained, the kernel drops further SYNs so connects hang
+    class HangingListener {
+    public:
+        explicit HangingListener(unsigned int port) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            int reuse = 1;
+            _listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (_listener < 0 || ::setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+                ::bind(_listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(_listener, 0) != 0)
+                return;
+
+            // a backlog of 0 holds a single connection
+            _queued = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (_queued >= 0 && ::connect(_queued, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+                _hanging = true;
+        }
+
+        ~HangingListener() {
+            if (_queued >= 0)
+                ::close(_queued);
+            if (_listener >= 0)
+                ::close(_listener);
+        }
+
+        bool isHanging() const noexcept { return _hanging; }
+
+    private:
+        int _listener = -1;
+        int _queued = -1;
+        bool _hanging = false;
+    };
+
+    class SilentSession : public SslSession {
+    public:
+        using Session::Session;
+    };
+
+    class SilentServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<SilentSession>(server); }
+    };
+
+    // echoes every fifth receive late, a replica with a slow tail
+    class TailSession : public SslSession {
+    public:
+        using Session::Session;
+        static constexpr std::chrono::milliseconds delay = std::chrono::milliseconds(50);
+
+    protected:
+        void onReceive(const void *data, size_t size) override {
+            if (++_received % 5 != 0) {
+                sendAsync(data, size);
+                return;
+            }
+
+            auto bytes = static_cast<const uint8_t*>(data);
+            auto payload = std::make_shared<std::vector<uint8_t>>(bytes, bytes + size);
+            auto timer = std::make_shared<asio::system_timer>(*io(), delay);
+            auto self = shared_from_this();
+            timer->async_wait([self, timer, payload](std::error_code err) { self->sendAsync(payload->data(), payload->size()); });
+        }
+
+    private:
+        std::atomic<size_t> _received = 0;
+    };
+
+    class TailServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<TailSession>(server); }
+    };
+
+    using CoroutineClient = CxxServer::Core::Tcp::Awaitable<SslClient>;
+
+    // answers each length prefixed message with itself, written as one coroutine per session
+    class CoroutineSession : public CxxServer::Core::Tcp::Awaitable<SslSession> {
+    public:
+        using Awaitable::Awaitable;
+
+    protected:
+        void onConnect() override {
+            Awaitable::onConnect();
+            serve().detach();
+        }
+
+    private:
+        CxxServer::Core::Task<> serve() {
+            // the frame keeps the session alive until the coroutine ends
+            auto self = shared_from_this();
+
+            uint8_t header[4];
+            while (co_await readExactly(header, sizeof(header)) == sizeof(header)) {
+                uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t>(header[3]) << 24);
+                std::vector<uint8_t> message(sizeof(header) + length);
+                std::copy(header, header + sizeof(header), message.begin());
+
+                if (co_await readExactly(message.data() + sizeof(header), length) != length)
+                    break;
+
+                if (!co_await write(message.data(), message.size()))
+                    break;
+            }
+        }
+    };
+
+    class CoroutineServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<CoroutineSession>(server); }
+    };
+
+    // sends one length prefixed message & awaits its echo
+    CxxServer::Core::Task<std::string> roundTrip(std::shared_ptr<CoroutineClient> client, std::string message) {
+        std::vector<uint8_t> frame(4 + message.size());
+        for (size_t i = 0; i < 4; ++i)
+            frame[i] = static_cast<uint8_t>(message.size() >> (8 * i));
+        std::copy(message.begin(), message.end(), frame.begin() + 4);
+
+        if (!co_await client->write(frame.data(), frame.size()))
+            co_return std::string();
+
+        if (co_await client->readExactly(frame.data(), frame.size()) != frame.size())
+            co_return std::string();
+
+        co_return std::string(frame.begin() + 4, frame.end());
+    }
+
+    class BulkSession : public SslSession {
+    public:
+        using Session::Session;
+        static constexpr size_t payload_size = 4 * 1024 * 1024;
+
+    protected:
+        void onConnect() override {
+            std::vector<uint8_t> payload(payload_size, 'x');
+            sendAsync(payload.data(), payload.size());
+        }
+    };
+
+    class DrainServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+            std::atomic<bool> drained = false;
+            std::atomic<uint64_t> dropped_bytes = 0;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<BulkSession>(server); }
+
+            void onDrained(uint64_t dropped_sessions, uint64_t dropped) override { dropped_bytes = dropped; drained = true; }
+    };
+
+    class SlowConsumerSession : public SslSession {
+    public:
+        using Session::Session;
+        static inline std::atomic<uint64_t> disconnects = 0;
+        static inline std::atomic<uint64_t> age_triggers = 0;
+
+    protected:
+        void onDisconnect() override {
+            auto stats = slowConsumerStats();
+            disconnects += stats.disconnects;
+            age_triggers += stats.age_triggers;
+        }
+    };
+
+    class SlowConsumerServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<SlowConsumerSession>(server); }
+    };
+
+    class ConflateSession : public SslSession {
+    public:
+        using Session::Session;
+        static constexpr size_t num_updates = 1000;
+        static constexpr size_t num_keys = 10;
+        static inline std::atomic<uint64_t> conflated = 0;
+
+    protected:
+        void onConnect() override {
+            // the first update starts sending straight away, the rest queue up behind it & conflate per key
+            char update[9];
+            for (size_t i = 0; i < num_updates; ++i) {
+                std::snprintf(update, sizeof(update), "%08zu", i);
+                sendConflated(i % num_keys, std::string_view(update, 8));
+            }
+
+            conflated = numConflated();
+        }
+    };
+
+    class ConflateServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<ConflateSession>(server); }
+    };
+
+    class PrioritySession : public SslSession {
+    public:
+        using Session::Session;
+        static constexpr size_t bulk_size = 64 * 1024;
+        static constexpr size_t num_bulk = 64;
+        static constexpr size_t urgent_size = 16;
+
+    protected:
+        void onConnect() override {
+            // the urgent message is queued behind megabytes of bulk data
+            std::vector<uint8_t> bulk(bulk_size, 'b');
+            for (size_t i = 0; i < num_bulk; ++i)
+                sendAsync(bulk.data(), bulk.size());
+
+            std::vector<uint8_t> urgent(urgent_size, 'u');
+            sendAsync(urgent.data(), urgent.size(), CxxServer::Core::Tcp::SendPriority::High);
+        }
+    };
+
+    class SharedSession : public SslSession {
+    public:
+        using Session::Session;
+        static constexpr size_t shared_size = 64 * 1024;
+        static constexpr size_t num_messages = 64;
+        static constexpr size_t urgent_size = 16;
+        static inline std::vector<std::shared_ptr<std::string>> buffers;
+
+        static std::string expected() {
+            std::string stream;
+            char copied[9];
+            for (size_t i = 0; i < num_messages; ++i) {
+                if (i % 2 == 0) {
+                    std::snprintf(copied, sizeof(copied), "%08zu", i);
+                    stream.append(copied, 8);
+                }
+                else
+                    stream.append(*buffers[i / 2]);
+            }
+
+            return stream;
+        }
+
+    protected:
+        void onConnect() override {
+            // copied & shared messages alternate, the shared ones are far larger than a socket write
+            char copied[9];
+            for (size_t i = 0; i < num_messages; ++i) {
+                if (i % 2 == 0) {
+                    std::snprintf(copied, sizeof(copied), "%08zu", i);
+                    sendAsync(copied, 8);
+                }
+                else
+                    sendShared(buffers[i / 2], buffers[i / 2]->data(), shared_size);
+            }
+
+            std::string urgent(urgent_size, '#');
+            sendAsync(urgent.data(), urgent.size(), CxxServer::Core::Tcp::SendPriority::High);
+        }
+    };
+
+    class SharedServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<SharedSession>(server); }
+    };
+
+    class PriorityServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<PrioritySession>(server); }
+    };
+
+    class StreamSession : public SslSession {
+    public:
+        using Session::Session;
+        static constexpr size_t stream_size = 16 * 1024 * 1024;
+        static constexpr size_t chunk_size = 64 * 1024;
+        static inline std::atomic<size_t> max_unsent = 0;
+        static inline std::atomic<bool> ended = false;
+
+    protected:
+        void onConnect() override {
+            auto produced = std::make_shared<size_t>(0);
+            sendStream([this, produced](void *buffer, size_t size) {
+                // the producer is only asked for more once most of the stream produced so far was written
+                max_unsent = std::max<size_t>(max_unsent, *produced - bytesSent());
+
+                size = std::min(size, stream_size - *produced);
+                auto bytes = static_cast<uint8_t*>(buffer);
+                for (size_t i = 0; i < size; ++i)
+                    bytes[i] = static_cast<uint8_t>((*produced + i) % 251);
+
+                *produced += size;
+                return size;
+            }, chunk_size, chunk_size);
+        }
+
+        void onStreamEnd() override { ended = true; }
+    };
+
+    class StreamServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<StreamSession>(server); }
+    };
+
+    class FileSession : public SslSession {
+    public:
+        using Session::Session;
+        static constexpr size_t file_size = 4 * 1024 * 1024;
+        static inline std::FILE *file = nullptr;
+        static inline std::atomic<bool> switched = false;
+        static inline std::atomic<bool> done = false;
+        static inline std::atomic<bool> failed = false;
+        static inline std::atomic<uint64_t> spliced = 0;
+        static inline std::atomic<size_t> tail = 0;
+
+    protected:
+        void onReceive(const void *data, size_t size) override {
+            if (switched) {
+                tail += size;
+                return;
+            }
+
+            // the header switches the session to receive the body into the file
+            switched = receiveToFile(fileno(file), file_size, [](std::error_code err, uint64_t received) {
+                failed = static_cast<bool>(err);
+                spliced = received;
+                done = true;
+            });
+        }
+    };
+
+    class FileServer : public EchoServer {
+        public:
+            using EchoServer::EchoServer;
+
+        protected:
+            std::shared_ptr<SslSession> newSession(const std::shared_ptr<Server> &server) override { return std::make_shared<FileSession>(server); }
+    };
+
     TEST_CASE("TCP server test", "[CxxServer][TCP]") {
         const std::string address = "127.0.0.1";
         const unsigned int port = 1111;
@@ -340,4 +786,1504 @@ namespace {
         REQUIRE(!server->errors);
     }
 
-}
\ No newline at end of file
+
+    TEST_CASE("TCP graceful drain test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1113;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<DrainServer>(service, address, port);
+        // the server closes first during the drain, leaving the port in TIME_WAIT for later runs
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<EchoClient>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isReady() || server->connections != 1)
+            std::this_thread::yield();
+
+        // the session queued its whole payload on connect, draining must flush it before closing
+        REQUIRE(server->stop(std::chrono::seconds(10)));
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        while (!client->disconnected)
+            std::this_thread::yield();
+
+        REQUIRE(service->stop(std::chrono::seconds(1)));
+
+        REQUIRE(server->drained);
+        REQUIRE(server->stopped);
+        REQUIRE(server->dropped_bytes == 0);
+        REQUIRE(server->numDrainDroppedSessions() == 0);
+        REQUIRE(client->numBytesReceived() == BulkSession::payload_size);
+        REQUIRE(service->numDrainDropped() == 0);
+        REQUIRE(!client->errors);
+    }
+
+    TEST_CASE("TCP admission control test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1114;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        server->maxConnections() = 1;
+        server->rejectResponse() = "busy";
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto admitted = std::make_shared<EchoClient>(service, address, port);
+        REQUIRE(admitted->connectAsync());
+        while (!admitted->isReady() || server->connections != 1)
+            std::this_thread::yield();
+
+        // over the limit, the server answers with its canned response & closes without making a session
+        auto rejected = std::make_shared<EchoClient>(service, address, port);
+        REQUIRE(rejected->connectAsync());
+        while (!rejected->disconnected)
+            std::this_thread::yield();
+
+        REQUIRE(rejected->numBytesReceived() == 4);
+        REQUIRE(server->numRejectedConnections() == 1);
+        REQUIRE(server->numConnectedSessions() == 1);
+
+        REQUIRE(admitted->disconnectAsync());
+        while (admitted->isReady() || server->connections != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(!server->errors);
+        REQUIRE(!admitted->errors);
+    }
+
+    TEST_CASE("TCP accept back off test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1127;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<CountingServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        int peer = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        REQUIRE(peer >= 0);
+
+        // use up every descriptor so accepting fails with EMFILE, the connection stays queued
+        rlimit limit;
+        REQUIRE(::getrlimit(RLIMIT_NOFILE, &limit) == 0);
+        rlimit lowered = limit;
+        lowered.rlim_cur = std::min<rlim_t>(limit.rlim_cur, 1024);
+        REQUIRE(::setrlimit(RLIMIT_NOFILE, &lowered) == 0);
+
+        std::vector<int> fillers;
+        for (int fd = ::dup(peer); fd >= 0; fd = ::dup(peer))
+            fillers.push_back(fd);
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        REQUIRE(::connect(peer, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+
+        // the listener stays readable, the server backs off instead of spinning on it
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        size_t errors = server->num_errors;
+
+        for (int fd : fillers)
+            ::close(fd);
+        REQUIRE(::setrlimit(RLIMIT_NOFILE, &limit) == 0);
+
+        REQUIRE(errors > 0);
+        REQUIRE(errors < 20);
+
+        // accepted once descriptors free up
+        while (server->connections != 1)
+            std::this_thread::yield();
+
+        ::close(peer);
+        while (server->connections != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP address quota test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1115;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        server->addressLimits().max_connections = 1;
+        server->addressLimits().bytes_rate = 4096;
+        server->addressLimits().bytes_burst = 1024;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<EchoClient>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isReady() || server->connections != 1)
+            std::this_thread::yield();
+
+        REQUIRE(server->numTrackedAddresses() == 1);
+
+        // a second connection from the same address is over quota
+        auto rejected = std::make_shared<EchoClient>(service, address, port);
+        REQUIRE(rejected->connectAsync());
+        while (!rejected->disconnected)
+            std::this_thread::yield();
+
+        REQUIRE(server->numRejectedConnections() == 1);
+
+        // overdrawing the byte rate pauses reading on the session rather than disconnecting it
+        std::vector<uint8_t> payload(4096, 'x');
+        client->sendAsync(payload.data(), payload.size());
+        while (client->numBytesReceived() != payload.size())
+            std::this_thread::yield();
+
+        client->sendAsync("test");
+        while (client->numBytesReceived() != payload.size() + 4)
+            std::this_thread::yield();
+
+        REQUIRE(server->numThrottledReads() > 0);
+        REQUIRE(client->isReady());
+
+        REQUIRE(client->disconnectAsync());
+        while (client->isReady() || server->connections != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->numTrackedAddresses() == 0);
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(!server->errors);
+        REQUIRE(!client->errors);
+    }
+
+    TEST_CASE("TCP slow consumer test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1116;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<SlowConsumerServer>(service, address, port);
+        server->reuseAddress() = true;
+        server->slowConsumerPolicy().max_age = std::chrono::milliseconds(100);
+        server->slowConsumerPolicy().action = CxxServer::Core::Tcp::SlowConsumerPolicy::Action::Disconnect;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        // a peer which connects but never reads
+        asio::io_service io;
+        asio::ip::tcp::socket peer(io);
+        peer.open(asio::ip::tcp::v4());
+        peer.set_option(asio::socket_base::receive_buffer_size(4096));
+        peer.connect(asio::ip::tcp::endpoint(asio::ip::make_address(address), port));
+        while (server->connections != 1)
+            std::this_thread::yield();
+
+        std::vector<uint8_t> payload(1024 * 1024, 'x');
+        while (server->connections != 0) {
+            server->multicast(payload.data(), payload.size());
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        REQUIRE(SlowConsumerSession::disconnects == 1);
+        REQUIRE(SlowConsumerSession::age_triggers >= 1);
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(!server->errors);
+    }
+
+    TEST_CASE("TCP conflated send test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1117;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<ConflateServer>(service, address, port);
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<EchoClient>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isReady() || server->connections != 1)
+            std::this_thread::yield();
+
+        // the first update plus the latest value of every key
+        const size_t expected = (1 + ConflateSession::num_keys) * 8;
+        while (client->numBytesReceived() < expected)
+            std::this_thread::yield();
+
+        REQUIRE(ConflateSession::conflated == ConflateSession::num_updates - 1 - ConflateSession::num_keys);
+
+        REQUIRE(client->disconnectAsync());
+        while (client->isReady() || server->connections != 0)
+            std::this_thread::yield();
+
+        REQUIRE(client->numBytesReceived() == expected);
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(!server->errors);
+        REQUIRE(!client->errors);
+    }
+
+    TEST_CASE("TCP send priority test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1118;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<PriorityServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        asio::io_service io;
+        asio::ip::tcp::socket peer(io);
+        peer.connect(asio::ip::tcp::endpoint(asio::ip::make_address(address), port));
+
+        const size_t bulk_total = PrioritySession::bulk_size * PrioritySession::num_bulk;
+        std::vector<uint8_t> received(bulk_total + PrioritySession::urgent_size);
+        REQUIRE(asio::read(peer, asio::buffer(received)) == received.size());
+
+        // the urgent message overtook the bulk data without splitting a bulk message
+        auto urgent = std::find(received.begin(), received.end(), 'u') - received.begin();
+        REQUIRE(static_cast<size_t>(urgent) < bulk_total);
+        REQUIRE(urgent % PrioritySession::bulk_size == 0);
+        REQUIRE(std::count(received.begin() + urgent, received.begin() + urgent + PrioritySession::urgent_size, 'u') == PrioritySession::urgent_size);
+
+        peer.close();
+        while (server->connections != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(!server->errors);
+    }
+
+    TEST_CASE("TCP shared send test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1135;
+
+        for (size_t i = 0; i < SharedSession::num_messages / 2; ++i)
+            SharedSession::buffers.push_back(std::make_shared<std::string>(SharedSession::shared_size, static_cast<char>('a' + i % 26)));
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<SharedServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        asio::io_service io;
+        asio::ip::tcp::socket peer(io);
+        peer.connect(asio::ip::tcp::endpoint(asio::ip::make_address(address), port));
+
+        const std::string expected = SharedSession::expected();
+        std::string received(expected.size() + SharedSession::urgent_size, '\0');
+        REQUIRE(asio::read(peer, asio::buffer(received)) == received.size());
+
+        // the urgent message overtook queued data without splitting a shared buffer, the rest kept its order
+        size_t urgent = received.find('#');
+        REQUIRE(urgent != std::string::npos);
+        REQUIRE(received.substr(urgent, SharedSession::urgent_size) == std::string(SharedSession::urgent_size, '#'));
+        REQUIRE((urgent == 0 || urgent + SharedSession::urgent_size == received.size() ||
+                 received[urgent - 1] != received[urgent + SharedSession::urgent_size] || std::isdigit(received[urgent - 1])));
+
+        received.erase(urgent, SharedSession::urgent_size);
+        REQUIRE(received == expected);
+
+        // written buffers are released by the session
+        for (const auto &buffer : SharedSession::buffers)
+            while (buffer.use_count() != 1)
+                std::this_thread::yield();
+
+        peer.close();
+        while (server->connections != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(!server->errors);
+        SharedSession::buffers.clear();
+    }
+
+    TEST_CASE("TCP stream producer test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1119;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<StreamServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        asio::io_service io;
+        asio::ip::tcp::socket peer(io);
+        peer.connect(asio::ip::tcp::endpoint(asio::ip::make_address(address), port));
+
+        std::vector<uint8_t> received(StreamSession::stream_size);
+        REQUIRE(asio::read(peer, asio::buffer(received)) == received.size());
+
+        bool intact = true;
+        for (size_t i = 0; i < received.size(); ++i)
+            intact = intact && received[i] == static_cast<uint8_t>(i % 251);
+
+        REQUIRE(intact);
+
+        // the producer is asked for the end of the stream once the last chunk is being written
+        while (!StreamSession::ended)
+            std::this_thread::yield();
+
+        REQUIRE(StreamSession::max_unsent < 2 * StreamSession::chunk_size);
+
+        peer.close();
+        while (server->connections != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(!server->errors);
+    }
+
+    TEST_CASE("TCP receive to file test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1120;
+
+        FileSession::file = std::tmpfile();
+        REQUIRE(FileSession::file != nullptr);
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<FileServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<EchoClient>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isReady() || server->connections != 1)
+            std::this_thread::yield();
+
+        REQUIRE(client->sendAsync("FILE"));
+        while (!FileSession::switched)
+            std::this_thread::yield();
+
+        std::vector<uint8_t> body(FileSession::file_size);
+        for (size_t i = 0; i < body.size(); ++i)
+            body[i] = static_cast<uint8_t>(i % 251);
+
+        // data past the budget is received as usual
+        REQUIRE(client->sendAsync(body.data(), body.size()));
+        REQUIRE(client->sendAsync("tail"));
+        while (!FileSession::done || FileSession::tail != 4)
+            std::this_thread::yield();
+
+        REQUIRE(!FileSession::failed);
+        REQUIRE(FileSession::spliced == FileSession::file_size);
+        REQUIRE(server->numBytesReceived() == 4 + FileSession::file_size + 4);
+
+        std::vector<uint8_t> written(FileSession::file_size);
+        REQUIRE(::pread(fileno(FileSession::file), written.data(), written.size(), 0) == static_cast<ssize_t>(written.size()));
+        REQUIRE(written == body);
+
+        REQUIRE(client->disconnectAsync());
+        while (client->isReady() || server->connections != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+
+        std::fclose(FileSession::file);
+
+        REQUIRE(!server->errors);
+        REQUIRE(!client->errors);
+    }
+
+    TEST_CASE("TCP proxy test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1121;
+        const unsigned int backend_port = 1122;
+        const size_t payload_size = 4 * 1024 * 1024;
+
+        auto pattern = [](size_t size, size_t seed) {
+            std::vector<uint8_t> data(size);
+            for (size_t i = 0; i < size; ++i)
+                data[i] = static_cast<uint8_t>((i + seed) % 251);
+
+            return data;
+        };
+
+        auto upload = pattern(payload_size, 0);
+        auto download = pattern(payload_size, 7);
+
+        // the backend reads until the forwarded FIN, then answers over its still open write half
+        asio::io_service io;
+        asio::ip::tcp::acceptor acceptor(io, asio::ip::tcp::endpoint(asio::ip::make_address(address), backend_port));
+
+        std::vector<uint8_t> backend_received;
+        std::thread backend([&]() {
+            asio::ip::tcp::socket socket(io);
+            acceptor.accept(socket);
+
+            asio::error_code err;
+            std::vector<uint8_t> chunk(64 * 1024);
+            for (size_t read; (read = socket.read_some(asio::buffer(chunk), err)) > 0 || !err;)
+                backend_received.insert(backend_received.end(), chunk.begin(), chunk.begin() + read);
+
+            asio::write(socket, asio::buffer(download));
+        });
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<CxxServer::Core::Tcp::ProxyServer>(service, address, port, address, backend_port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        asio::ip::tcp::socket peer(io);
+        peer.connect(asio::ip::tcp::endpoint(asio::ip::make_address(address), port));
+        REQUIRE(asio::write(peer, asio::buffer(upload)) == upload.size());
+        peer.shutdown(asio::ip::tcp::socket::shutdown_send);
+
+        asio::error_code err;
+        std::vector<uint8_t> received;
+        std::vector<uint8_t> chunk(64 * 1024);
+        for (size_t read; (read = peer.read_some(asio::buffer(chunk), err)) > 0 || !err;)
+            received.insert(received.end(), chunk.begin(), chunk.begin() + read);
+
+        backend.join();
+
+        REQUIRE(err == asio::error::eof);
+        REQUIRE(backend_received == upload);
+        REQUIRE(received == download);
+        REQUIRE(server->numBytesReceived() == payload_size);
+        REQUIRE(server->numBytesSent() == payload_size);
+
+        while (server->numConnectedSessions() != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP client pool test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1123;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        using Pool = CxxServer::Core::Tcp::ClientPool;
+        auto pool = std::make_shared<Pool>(service, [&](const Pool::Key &key) {
+            return std::make_shared<EchoClient>(service, key.addr, key.port);
+        });
+
+        pool->limits().min_connections = 1;
+        pool->limits().max_connections = 2;
+        pool->limits().idle_timeout = std::chrono::milliseconds(200);
+        pool->limits().check_interval = std::chrono::milliseconds(20);
+
+        const Pool::Key key{address, port, ""};
+
+        std::mutex lock;
+        std::vector<std::shared_ptr<SslClient>> clients;
+        std::atomic<size_t> failures = 0;
+        auto handler = [&](std::shared_ptr<SslClient> client, std::error_code err) {
+            if (err) {
+                ++failures;
+                return;
+            }
+
+            std::scoped_lock locker(lock);
+            clients.push_back(client);
+        };
+
+        auto checkedOut = [&]() {
+            std::scoped_lock locker(lock);
+            return clients.size();
+        };
+
+        REQUIRE(!pool->checkout(key, handler));
+        REQUIRE(pool->start());
+
+        // reserved connections are kept warm
+        pool->reserve(key);
+        while (pool->numIdle() != 1)
+            std::this_thread::yield();
+
+        REQUIRE(pool->numCreated() == 1);
+
+        REQUIRE(pool->checkout(key, handler));
+        REQUIRE(pool->checkout(key, handler));
+        while (checkedOut() != 2)
+            std::this_thread::yield();
+
+        REQUIRE(pool->numReused() == 1);
+        REQUIRE(pool->numCreated() == 2);
+        REQUIRE(clients[0] != clients[1]);
+
+        // past the max a checkout waits for a returned client
+        REQUIRE(pool->checkout(key, handler));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE(checkedOut() == 2);
+        REQUIRE(pool->numConnections() == 2);
+
+        pool->release(key, clients[0]);
+        while (checkedOut() != 3)
+            std::this_thread::yield();
+
+        REQUIRE(clients[2] == clients[0]);
+        REQUIRE(pool->numReused() == 2);
+
+        pool->release(key, clients[1]);
+        pool->release(key, clients[2]);
+        REQUIRE(pool->numIdle() == 2);
+
+        // idle connections above the minimum are closed
+        while (pool->numConnections() != 1)
+            std::this_thread::yield();
+
+        REQUIRE(pool->numIdle() == 1);
+        REQUIRE(pool->numEvicted() == 1);
+
+        // connections closed by the upstream aren't handed out
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        while (pool->numEvicted() != 2)
+            std::this_thread::yield();
+
+        REQUIRE(pool->checkout(key, handler));
+        while (failures == 0)
+            std::this_thread::yield();
+
+        REQUIRE(checkedOut() == 3);
+        REQUIRE(pool->numCreated() == 2);
+
+        REQUIRE(pool->stop());
+        REQUIRE(!pool->isStarted());
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP host name resolve test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1124;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto cache = std::make_shared<CxxServer::Core::Tcp::DnsCache>(std::chrono::seconds(60));
+
+        // localhost may resolve to ::1 first, the connect falls through to 127.0.0.1
+        auto client = std::make_shared<EchoClient>(service, "localhost", port);
+        client->dnsCache() = cache;
+        REQUIRE(client->connectAsync());
+        while (!client->isReady())
+            std::this_thread::yield();
+
+        REQUIRE(client->endpoint().address().to_string() == address);
+        REQUIRE(cache->numMisses() == 1);
+        REQUIRE(cache->numHits() == 0);
+        REQUIRE(cache->size() == 1);
+
+        REQUIRE(client->disconnectAsync());
+        while (client->isConnected())
+            std::this_thread::yield();
+
+        // reconnects are served from the cache
+        REQUIRE(client->connectAsync());
+        while (!client->isReady())
+            std::this_thread::yield();
+
+        REQUIRE(cache->numHits() == 1);
+        REQUIRE(cache->numMisses() == 1);
+
+        REQUIRE(client->disconnect());
+        REQUIRE(client->connect());
+        REQUIRE(cache->numHits() == 2);
+
+        // expired entries resolve again
+        cache->ttl() = std::chrono::nanoseconds(0);
+        cache->clear();
+        REQUIRE(client->disconnect());
+        REQUIRE(client->connect());
+        REQUIRE(client->disconnect());
+        REQUIRE(client->connect());
+        REQUIRE(cache->numMisses() == 3);
+        REQUIRE(!client->errors);
+
+        REQUIRE(client->disconnect());
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP connect race test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1125;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        // the first endpoint never answers
+        const unsigned int hanging_port = 1132;
+        HangingListener hanging(hanging_port);
+        REQUIRE(hanging.isHanging());
+
+        auto cache = std::make_shared<CxxServer::Core::Tcp::DnsCache>(std::chrono::seconds(60));
+        cache->store("race.test", std::to_string(port), {
+            asio::ip::tcp::endpoint(asio::ip::make_address(address), hanging_port),
+            asio::ip::tcp::endpoint(asio::ip::make_address(address), port)
+        });
+
+        auto client = std::make_shared<EchoClient>(service, "race.test", port);
+        client->dnsCache() = cache;
+        client->connectAttemptDelay() = std::chrono::milliseconds(50);
+
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(client->connectAsync());
+        while (!client->isReady())
+            std::this_thread::yield();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        // the second attempt only started once the first was given its head start, which lost & was closed
+        REQUIRE(elapsed >= client->connectAttemptDelay());
+        REQUIRE(elapsed < std::chrono::seconds(1));
+        REQUIRE(client->endpoint().port() == port);
+        REQUIRE(numConnecting(hanging_port) == 0);
+        REQUIRE(!client->errors);
+
+        const std::string message = "race";
+        REQUIRE(client->send(message.data(), message.size()) == message.size());
+        while (client->numBytesReceived() != message.size())
+            std::this_thread::yield();
+
+        REQUIRE(client->disconnect());
+
+        // the connect fails once every address has failed
+        cache->store("refused.test", std::to_string(port + 1), {
+            asio::ip::tcp::endpoint(asio::ip::make_address(address), port + 1),
+            asio::ip::tcp::endpoint(asio::ip::make_address("::1"), port + 1)
+        });
+
+        auto refused = std::make_shared<EchoClient>(service, "refused.test", port + 1);
+        refused->dnsCache() = cache;
+        REQUIRE(refused->connectAsync());
+        while (!refused->disconnected)
+            std::this_thread::yield();
+
+        REQUIRE(!refused->isConnected());
+        REQUIRE(!refused->connected);
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP reconnect test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1126;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<ReconnectClient>(service, address, port);
+        client->reconnectPolicy().on_connect_failure = true;
+        client->reconnectPolicy().on_disconnect = true;
+        client->reconnectPolicy().initial_delay = std::chrono::milliseconds(10);
+        client->reconnectPolicy().max_delay = std::chrono::milliseconds(50);
+        client->reconnectPolicy().buffer_limit = 8;
+
+        // nothing listens yet, the client backs off & retries, sends are buffered meanwhile
+        REQUIRE(client->connectAsync());
+        while (client->numReconnectAttempts() < 3)
+            std::this_thread::yield();
+
+        REQUIRE(client->isReconnecting());
+        REQUIRE(client->sendAsync("hello"));
+        REQUIRE(!client->sendAsync("world"));
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        while (client->numBytesReceived() != 5)
+            std::this_thread::yield();
+
+        REQUIRE(client->connects == 1);
+        REQUIRE(!client->isReconnecting());
+        REQUIRE(client->numReconnectAttempts() == 0);
+
+        // a lost connection reconnects
+        REQUIRE(server->disconnectAll());
+        while (client->connects != 2 || !client->isReady())
+            std::this_thread::yield();
+
+        // reconnecting by hand connects again once disconnected
+        REQUIRE(client->reconnectAsync());
+        while (client->connects != 3 || !client->isReady())
+            std::this_thread::yield();
+
+        // a disconnect asked for doesn't reconnect
+        REQUIRE(client->disconnect());
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        REQUIRE(!client->isConnected());
+        REQUIRE(!client->isReconnecting());
+        REQUIRE(client->connects == 3);
+
+        // reconnecting gives up after the max attempts
+        auto refused = std::make_shared<ReconnectClient>(service, address, port + 1);
+        refused->reconnectPolicy().on_connect_failure = true;
+        refused->reconnectPolicy().initial_delay = std::chrono::milliseconds(1);
+        refused->reconnectPolicy().max_attempts = 3;
+        REQUIRE(refused->connectAsync());
+        while (!refused->gave_up)
+            std::this_thread::yield();
+
+        REQUIRE(!refused->isReconnecting());
+        REQUIRE(refused->connects == 0);
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP reconnect order test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1128;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<CollectClient>(service, address, port);
+        client->reconnectPolicy().on_connect_failure = true;
+        client->reconnectPolicy().initial_delay = std::chrono::milliseconds(5);
+        client->reconnectPolicy().max_delay = std::chrono::milliseconds(5);
+        client->reconnectPolicy().buffer_limit = 1024 * 1024;
+
+        REQUIRE(client->connectAsync());
+        while (!client->isReconnecting())
+            std::this_thread::yield();
+
+        auto record = [](size_t i) {
+            auto number = std::to_string(i);
+            return std::string(8 - number.size(), '0').append(number);
+        };
+
+        // numbered records sent from another thread before, during & after the reconnect
+        std::atomic<size_t> sent = 0;
+        std::thread sender([&]() {
+            size_t after = 0;
+            for (size_t i = 0; after < 1000; ++i) {
+                while (!client->sendAsync(record(i)))
+                    std::this_thread::yield();
+
+                ++sent;
+                if (client->isReady()) {
+                    ++after;
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+        });
+
+        while (sent < 100)
+            std::this_thread::yield();
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+
+        sender.join();
+        while (client->data().size() != sent * 8)
+            std::this_thread::yield();
+
+        // what was buffered offline is sent before anything sent after it
+        std::string expected;
+        for (size_t i = 0; i < sent; ++i)
+            expected.append(record(i));
+
+        REQUIRE(client->data() == expected);
+        REQUIRE(client->connects == 1);
+
+        REQUIRE(client->disconnect());
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP timed send & receive test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1129;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<EchoClient>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isReady())
+            std::this_thread::yield();
+
+        // timing out cancels the socket, aborting the background read, which must carry on after
+        char buffer[16];
+        REQUIRE(client->receive(buffer, sizeof(buffer), std::chrono::milliseconds(20)) == 0);
+        REQUIRE(client->isReady());
+
+        REQUIRE(client->sendAsync("ping"));
+        while (client->numBytesReceived() != 4)
+            std::this_thread::yield();
+
+        // so does a timed send completing
+        REQUIRE(client->send("pong", 4, std::chrono::seconds(1)) == 4);
+        while (client->numBytesReceived() != 8)
+            std::this_thread::yield();
+
+        REQUIRE(client->sendAsync("again"));
+        while (client->numBytesReceived() != 13)
+            std::this_thread::yield();
+
+        REQUIRE(client->isReady());
+        REQUIRE(!client->errors);
+        REQUIRE(client->disconnect());
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP client group test", "[CxxServer][TCP]") {
+        const std::string address = "127.0.0.1";
+        const std::vector<unsigned int> ports = {1127, 1128, 1129};
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        std::vector<std::shared_ptr<EchoServer>> servers;
+        std::vector<CxxServer::Core::Tcp::ClientGroup::Endpoint> endpoints;
+        for (auto port : ports) {
+            servers.push_back(std::make_shared<EchoServer>(service, address, port));
+            servers.back()->reuseAddress() = true;
+            REQUIRE(servers.back()->start());
+            while (!servers.back()->isStarted())
+                std::this_thread::yield();
+
+            endpoints.push_back({address, port});
+        }
+
+        using Group = CxxServer::Core::Tcp::ClientGroup;
+        auto makeGroup = [&](Group::Balance balance) {
+            auto group = std::make_shared<Group>(service, endpoints, [&](const Group::Endpoint &endpoint) {
+                return std::make_shared<EchoClient>(service, endpoint.addr, endpoint.port);
+            }, balance);
+
+            group->health().failure_threshold = 2;
+            group->health().eject_time = std::chrono::milliseconds(100);
+            group->health().check_interval = std::chrono::milliseconds(10);
+            REQUIRE(group->start());
+            while (group->numHealthy() != endpoints.size())
+                std::this_thread::yield();
+
+            return group;
+        };
+
+        // round robin visits every endpoint in turn
+        auto group = makeGroup(Group::Balance::RoundRobin);
+        std::map<std::shared_ptr<SslClient>, size_t> picks;
+        for (size_t i = 0; i < 3 * endpoints.size(); ++i) {
+            auto client = group->acquire();
+            REQUIRE(client);
+            ++picks[client];
+            group->release(client);
+        }
+
+        REQUIRE(picks.size() == endpoints.size());
+        for (auto &[client, count] : picks)
+            REQUIRE(count == 3);
+
+        // failing requests eject an endpoint until it reconnects
+        auto failing = group->acquire();
+        group->release(failing);
+        group->acquire();
+        group->release(failing, false);
+        group->release(failing, false);
+        REQUIRE(group->numEjected() == 1);
+        REQUIRE(group->numHealthy() == endpoints.size() - 1);
+
+        for (size_t i = 0; i < 2 * endpoints.size(); ++i) {
+            auto client = group->acquire();
+            REQUIRE(client != failing);
+            group->release(client);
+        }
+
+        while (group->numHealthy() != endpoints.size())
+            std::this_thread::yield();
+
+        // an endpoint going down is ejected & restored once it is back
+        REQUIRE(servers[2]->stop());
+        while (group->numHealthy() != endpoints.size() - 1)
+            std::this_thread::yield();
+
+        for (size_t i = 0; i < 2 * endpoints.size(); ++i) {
+            auto client = group->acquire();
+            REQUIRE(client);
+            REQUIRE(client->port() != ports[2]);
+            group->release(client);
+        }
+
+        REQUIRE(servers[2]->start());
+        while (group->numHealthy() != endpoints.size())
+            std::this_thread::yield();
+
+        REQUIRE(group->stop());
+
+        // least outstanding picks the endpoint with the fewest requests in flight
+        auto least = makeGroup(Group::Balance::LeastOutstanding);
+        auto first = least->acquire();
+        auto second = least->acquire();
+        auto third = least->acquire();
+        REQUIRE(first != second);
+        REQUIRE(second != third);
+        REQUIRE(first != third);
+
+        least->release(second);
+        REQUIRE(least->acquire() == second);
+        REQUIRE(least->numOutstanding(second) == 1);
+        REQUIRE(least->stop());
+
+        // consistent hashing keeps keys on their endpoint, only the keys of an ejected endpoint move
+        auto hashed = makeGroup(Group::Balance::ConsistentHash);
+        std::vector<std::shared_ptr<SslClient>> mapped;
+        for (size_t i = 0; i < 100; ++i) {
+            auto client = hashed->acquire("key" + std::to_string(i));
+            mapped.push_back(client);
+            hashed->release(client);
+            REQUIRE(hashed->acquire("key" + std::to_string(i)) == client);
+            hashed->release(client);
+        }
+
+        auto ejected = mapped[0];
+        hashed->release(hashed->acquire("key0"), false);
+        hashed->release(hashed->acquire("key0"), false);
+        REQUIRE(hashed->numHealthy() == endpoints.size() - 1);
+
+        for (size_t i = 0; i < 100; ++i) {
+            auto client = hashed->acquire("key" + std::to_string(i));
+            if (mapped[i] == ejected)
+                REQUIRE(client != ejected);
+            else
+                REQUIRE(client == mapped[i]);
+
+            hashed->release(client);
+        }
+
+        REQUIRE(hashed->stop());
+
+        // a member already connecting, e.g. reconnecting on its own, is waited on rather than failed: its connect
+        // first waits out an endpoint which never answers
+        const unsigned int hanging_port = 1133;
+        HangingListener hanging(hanging_port);
+        REQUIRE(hanging.isHanging());
+
+        auto cache = std::make_shared<CxxServer::Core::Tcp::DnsCache>(std::chrono::seconds(60));
+        cache->store("slow.test", std::to_string(ports[0]), {
+            asio::ip::tcp::endpoint(asio::ip::make_address(address), hanging_port),
+            asio::ip::tcp::endpoint(asio::ip::make_address(address), ports[0])
+        });
+
+        auto connecting = std::make_shared<Group>(service, std::vector<Group::Endpoint>{ {"slow.test", ports[0]} }, [&](const Group::Endpoint &endpoint) {
+            auto client = std::make_shared<EchoClient>(service, endpoint.addr, endpoint.port);
+            client->dnsCache() = cache;
+            client->connectAttemptDelay() = std::chrono::milliseconds(100);
+            client->connectAsync();
+            return client;
+        });
+
+        connecting->health().eject_time = std::chrono::hours(1);
+        REQUIRE(connecting->start());
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (connecting->numHealthy() != 1 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+
+        REQUIRE(connecting->numHealthy() == 1);
+        REQUIRE(connecting->stop());
+
+        for (auto &server : servers) {
+            REQUIRE(server->stop());
+            while (server->isStarted())
+                std::this_thread::yield();
+        }
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP request client test", "[CxxServer][TCP]") {
+        using RequestClient = CxxServer::Core::Tcp::RequestClient;
+
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1130;
+        const unsigned int silent_port = 1131;
+        const size_t num_requests = 1000;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        // echoed requests are valid responses to themselves
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        auto silent = std::make_shared<SilentServer>(service, address, silent_port);
+        silent->reuseAddress() = true;
+        REQUIRE(silent->start());
+        while (!server->isStarted() || !silent->isStarted())
+            std::this_thread::yield();
+
+        for (auto correlation : {RequestClient::Correlation::Id, RequestClient::Correlation::Fifo}) {
+            auto client = std::make_shared<RequestClient>(service, address, port, correlation);
+            REQUIRE(client->connectAsync());
+            while (!client->isReady())
+                std::this_thread::yield();
+
+            // every request is in flight at once, each gets its own response
+            std::atomic<size_t> matched = 0;
+            for (size_t i = 0; i < num_requests; ++i) {
+                auto payload = std::to_string(i);
+                REQUIRE(client->request(payload.data(), payload.size(), [&matched, payload](std::error_code err, const void *response, size_t size) {
+                    if (!err && std::string(static_cast<const char*>(response), size) == payload)
+                        ++matched;
+                }) != 0);
+            }
+
+            while (client->numCompleted() != num_requests)
+                std::this_thread::yield();
+
+            REQUIRE(matched == num_requests);
+            REQUIRE(client->numPending() == 0);
+
+            const std::string payload = "future";
+            auto response = client->request(payload.data(), payload.size(), std::chrono::seconds(5)).get();
+            REQUIRE(std::string(response.begin(), response.end()) == payload);
+
+            REQUIRE(client->disconnect());
+        }
+
+        auto client = std::make_shared<RequestClient>(service, address, silent_port);
+        REQUIRE(client->connectAsync());
+        while (!client->isReady())
+            std::this_thread::yield();
+
+        // unanswered requests time out at their deadline, the earliest first
+        std::vector<std::error_code> errors(3);
+        std::atomic<size_t> finished = 0;
+        auto handler = [&](size_t index) {
+            return [&, index](std::error_code err, const void *response, size_t size) {
+                errors[index] = err;
+                ++finished;
+            };
+        };
+
+        const std::string payload = "unanswered";
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(client->request(payload.data(), payload.size(), handler(0), std::chrono::milliseconds(200)) != 0);
+        REQUIRE(client->request(payload.data(), payload.size(), handler(1), std::chrono::milliseconds(20)) != 0);
+        auto cancelled = client->request(payload.data(), payload.size(), handler(2));
+        REQUIRE(cancelled != 0);
+
+        while (finished != 1)
+            std::this_thread::yield();
+
+        REQUIRE(errors[1] == asio::error::timed_out);
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200));
+
+        REQUIRE(client->cancel(cancelled));
+        REQUIRE(!client->cancel(cancelled));
+        REQUIRE(errors[2] == asio::error::operation_aborted);
+
+        while (finished != 3)
+            std::this_thread::yield();
+
+        REQUIRE(errors[0] == asio::error::timed_out);
+        REQUIRE(client->numTimedOut() == 2);
+        REQUIRE(client->numCancelled() == 1);
+
+        auto errorOf = [](std::future<std::vector<uint8_t>> &future) {
+            try {
+                future.get();
+            }
+            catch (const std::system_error &e) {
+                return e.code();
+            }
+
+            return std::error_code();
+        };
+
+        // a disconnect aborts whatever is still pending, nothing can be sent once disconnected
+        auto pending = client->request(payload.data(), payload.size());
+        REQUIRE(client->disconnect());
+        REQUIRE(errorOf(pending) == asio::error::connection_aborted);
+        REQUIRE(client->numPending() == 0);
+
+        auto unsent = client->request(payload.data(), payload.size());
+        REQUIRE(errorOf(unsent) == asio::error::not_connected);
+
+        REQUIRE(server->stop());
+        REQUIRE(silent->stop());
+        while (server->isStarted() || silent->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP request hedging test", "[CxxServer][TCP]") {
+        using ClientGroup = CxxServer::Core::Tcp::ClientGroup;
+        using RequestClient = CxxServer::Core::Tcp::RequestClient;
+        using RequestHedger = CxxServer::Core::Tcp::RequestHedger;
+
+        const std::string address = "127.0.0.1";
+        const std::vector<unsigned int> ports = {1132, 1133};
+        const size_t num_requests = 300;
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        // only the second replica has a slow tail, so hedges always find a fast replica
+        std::vector<std::shared_ptr<EchoServer>> servers;
+        std::vector<ClientGroup::Endpoint> endpoints;
+        for (auto port : ports) {
+            auto server = servers.empty() ? std::make_shared<EchoServer>(service, address, port) : std::make_shared<TailServer>(service, address, port);
+            server->reuseAddress() = true;
+            server->noDelay() = true;
+            REQUIRE(server->start());
+            while (!server->isStarted())
+                std::this_thread::yield();
+
+            servers.push_back(server);
+            endpoints.push_back({address, port});
+        }
+
+        // without no delay a request queued behind a late response waits on a delayed ack
+        auto group = std::make_shared<ClientGroup>(service, endpoints, [&](const ClientGroup::Endpoint &endpoint) {
+            auto client = std::make_shared<RequestClient>(service, endpoint.addr, endpoint.port);
+            client->isNoDelay() = true;
+            return client;
+        });
+        REQUIRE(group->start());
+        while (group->numHealthy() != endpoints.size())
+            std::this_thread::yield();
+
+        auto hedger = std::make_shared<RequestHedger>(service, group);
+        hedger->settings().percentile = 0.5;
+        hedger->settings().min_delay = std::chrono::milliseconds(2);
+        hedger->settings().warmup = 16;
+        hedger->settings().max_hedge_ratio = 1.0;
+
+        // one request at a time, about a tenth of the first attempts land on the slow tail
+        for (size_t i = 0; i < num_requests; ++i) {
+            auto payload = std::to_string(i);
+            std::atomic<bool> finished = false;
+            std::atomic<bool> matched = false;
+            REQUIRE(hedger->request(payload.data(), payload.size(), [&finished, &matched, payload](std::error_code err, const void *response, size_t size) {
+                matched = !err && std::string(static_cast<const char*>(response), size) == payload;
+                finished = true;
+            }, std::chrono::seconds(5)));
+
+            while (!finished)
+                std::this_thread::yield();
+
+            REQUIRE(matched);
+        }
+
+        REQUIRE(hedger->numRequests() == num_requests);
+        REQUIRE(hedger->hedgeDelay() >= std::chrono::milliseconds(2));
+        REQUIRE(hedger->hedgeDelay() < TailSession::delay);
+        REQUIRE(hedger->numHedged() > 0);
+        REQUIRE(hedger->numHedgeWins() > 0);
+        REQUIRE(hedger->hedgeRate() < 0.5);
+
+        // let the late first attempts arrive so the tail without hedging is known
+        for (auto &client : group->clients())
+            while (group->numOutstanding(client) != 0)
+                std::this_thread::yield();
+
+        REQUIRE(hedger->primaryLatency(0.95) >= TailSession::delay);
+        REQUIRE(hedger->latency(0.95) < TailSession::delay);
+
+        REQUIRE(group->stop());
+        for (auto &server : servers) {
+            REQUIRE(server->stop());
+            while (server->isStarted())
+                std::this_thread::yield();
+        }
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("TCP coroutine test", "[CxxServer][TCP]") {
+        using FrameMemory = CxxServer::Core::FrameMemory;
+        using Timer = CxxServer::Core::Timer;
+
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1134;
+        const size_t num_messages = 100;
+
+        // freed frames are handed back out to the next frame of their size class
+        void *frame = FrameMemory::alloc(200);
+        FrameMemory::free(frame, 200);
+        REQUIRE(FrameMemory::alloc(250) == frame);
+        FrameMemory::free(frame, 250);
+
+        auto service = std::make_shared<EchoService>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<CoroutineServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        while (!server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<CoroutineClient>(service, address, port);
+        auto timer = std::make_shared<Timer>(service);
+
+        std::atomic<bool> connected = false;
+        std::atomic<size_t> matched = 0;
+        std::atomic<bool> expired = false;
+        std::atomic<bool> done = false;
+
+        auto run = [&]() -> CxxServer::Core::Task<> {
+            connected = co_await client->connectAwait();
+
+            // messages of every size, split & coalesced however the stream delivers them
+            for (size_t i = 0; i < num_messages; ++i) {
+                std::string message(i * 97 + 1, static_cast<char>('a' + i % 26));
+                if (co_await roundTrip(client, message) == message)
+                    ++matched;
+            }
+
+            timer->setup(std::chrono::milliseconds(10));
+            expired = co_await timer->wait();
+            done = true;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        run().detach();
+        while (!done)
+            std::this_thread::yield();
+
+        REQUIRE(connected);
+        REQUIRE(matched == num_messages);
+        REQUIRE(expired);
+        REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10));
+
+        // a read waiting when the connection drops resumes with what it got
+        std::atomic<size_t> read = 1;
+        auto wait = [&]() -> CxxServer::Core::Task<> {
+            uint8_t byte;
+            read = co_await client->read(&byte, sizeof(byte));
+        };
+
+        wait().detach();
+        REQUIRE(client->disconnect());
+        while (read != 0)
+            std::this_thread::yield();
+
+        REQUIRE(server->stop());
+        while (server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+}
@@ -0,0 +1,97 @@
+#include "catch2/catch.hpp"
+
+#include "core/util.hxx"
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    namespace Utils = CxxServer::Core::Utils;
+
+    std::string toChars(uint64_t value, int base) {
+        char buf[32];
+        auto result = std::to_chars(buf, buf + sizeof(buf), value, base);
+        return std::string(buf, result.ptr);
+    }
+
+    TEST_CASE("Utils number formatting test", "[CxxServer][Utils]") {
+        std::mt19937_64 random(42);
+        char buf[32];
+
+        std::vector<uint64_t> values = { 0, 1, 9, 10, 99, 100, std::numeric_limits<uint64_t>::max() };
+        // every digit count & both sides of each power of ten
+        for (uint64_t power = 10; power <= 1000000000000000000ULL; power *= 10) {
+            values.push_back(power - 1);
+            values.push_back(power);
+        }
+        for (int i = 0; i < 10000; ++i)
+            values.push_back(random() >> (random() % 64));
+
+        for (uint64_t value : values) {
+            auto decimal = toChars(value, 10);
+            REQUIRE(Utils::decimalDigits(value) == decimal.size());
+            REQUIRE(std::string_view(buf, Utils::formatDecimal(value, buf)) == decimal);
+            REQUIRE(Utils::fastItoa(value, buf, sizeof(buf)) == decimal);
+
+            auto hex = toChars(value, 16);
+            REQUIRE(std::string_view(buf, Utils::formatHex(value, buf)) == hex);
+            REQUIRE(std::string_view(buf, Utils::formatHex16(value, buf)) == std::string(16 - hex.size(), '0') + hex);
+
+            uint64_t parsed = 0;
+            REQUIRE(Utils::parseDecimal(decimal, parsed));
+            REQUIRE(parsed == value);
+            REQUIRE(Utils::parseHex(hex, parsed));
+            REQUIRE(parsed == value);
+        }
+
+        REQUIRE(std::string_view(buf, Utils::formatDecimal(42, buf, 5)) == "00042");
+        REQUIRE(std::string_view(buf, Utils::formatDecimal(123456, buf, 3)) == "456");
+    }
+
+    TEST_CASE("Utils number parsing test", "[CxxServer][Utils]") {
+        uint64_t value = 7;
+
+        REQUIRE(!Utils::parseDecimal("", value));
+        REQUIRE(!Utils::parseDecimal("-1", value));
+        REQUIRE(!Utils::parseDecimal("12 ", value));
+        REQUIRE(!Utils::parseDecimal("1234567a", value));
+        REQUIRE(!Utils::parseDecimal("12345678:", value));
+        REQUIRE(!Utils::parseDecimal("123/5678", value));
+        REQUIRE(value == 7);
+
+        REQUIRE(Utils::parseDecimal("00000000000000000000000042", value));
+        REQUIRE(value == 42);
+        REQUIRE(Utils::parseDecimal("18446744073709551615", value));
+        REQUIRE(value == std::numeric_limits<uint64_t>::max());
+        REQUIRE(!Utils::parseDecimal("18446744073709551616", value));
+        REQUIRE(!Utils::parseDecimal("100000000000000000000", value));
+
+        REQUIRE(Utils::parseHex("DeadBeef", value));
+        REQUIRE(value == 0xdeadbeef);
+        REQUIRE(Utils::parseHex("ffffffffffffffff", value));
+        REQUIRE(value == std::numeric_limits<uint64_t>::max());
+        REQUIRE(!Utils::parseHex("10000000000000000", value));
+        REQUIRE(!Utils::parseHex("0x10", value));
+        REQUIRE(!Utils::parseHex("g", value));
+        REQUIRE(!Utils::parseHex("", value));
+    }
+
+    TEST_CASE("Utils timestamp formatting test", "[CxxServer][Utils]") {
+        using namespace std::chrono;
+        char buf[Utils::timestamp_size];
+
+        auto format = [&](system_clock::time_point time) { return std::string_view(buf, Utils::formatTimestamp(time, buf)); };
+
+        REQUIRE(format(system_clock::time_point()) == "1970-01-01T00:00:00.000000Z");
+        REQUIRE(format(sys_days(2000y / February / 29) + hours(23) + minutes(59) + seconds(59) + microseconds(999999)) == "2000-02-29T23:59:59.999999Z");
+        REQUIRE(format(sys_days(2026y / October / 18) + hours(9) + minutes(30) + seconds(5) + microseconds(123456)) == "2026-10-18T09:30:05.123456Z");
+        REQUIRE(format(sys_days(1969y / December / 31) + hours(12)) == "1969-12-31T12:00:00.000000Z");
+    }
+}
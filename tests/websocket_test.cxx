@@ -0,0 +1,492 @@
+#include "catch2/catch.hpp"
+
+#include "core/service.hxx"
+#include "core/tcp/ssl_client.hxx"
+#include "core/tcp/ssl_context.hxx"
+#include "core/tcp/tcp_client.hxx"
+#include "core/ws/ws_connection.hxx"
+#include "core/ws/ws_frame.hxx"
+#include "core/ws/ws_server.hxx"
+#include "core/ws/ws_session.hxx"
+#include "core/ws/wss_server.hxx"
+#include "core/ws/wss_session.hxx"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+    using Opcode = CxxServer::Core::Ws::Opcode;
+    using CloseCode = CxxServer::Core::Ws::CloseCode;
+    using Request = CxxServer::Core::Http::Request;
+    using Response = CxxServer::Core::Http::Response;
+
+    using TcpSession = CxxServer::Core::Tcp::Session;
+    using TcpServer = CxxServer::Core::Tcp::Server;
+    using TcpClient = CxxServer::Core::Tcp::Client;
+    using SslClient = CxxServer::Core::SSL::Client;
+    using SslContext = CxxServer::Core::SSL::Context;
+
+    using CxxServer::Core::Ws::encodeHeader;
+    using CxxServer::Core::Ws::mask;
+    using CxxServer::Core::Ws::validUtf8;
+    using CxxServer::Core::Ws::acceptKey;
+    using CxxServer::Core::Ws::max_header_size;
+
+    const std::string upgrade_request =
+        "GET /chat HTTP/1.1\r\nHost: server.example.com\r\nUpgrade: websocket\r\nConnection: keep-alive, Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+
+    const std::string upgrade_response =
+        "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n";
+
+    // Frame as a client sends it, masked
+    std::string clientFrame(Opcode opcode, std::string_view payload, bool fin = true) {
+        const uint8_t key[4] = { 0x37, 0xfa, 0x21, 0x3d };
+        uint8_t header[max_header_size];
+        size_t size = encodeHeader(header, opcode, fin, payload.size(), key);
+
+        std::string frame(reinterpret_cast<const char*>(header), size);
+        frame.resize(size + payload.size());
+        mask(frame.data() + size, payload.data(), payload.size(), key);
+        return frame;
+    }
+
+    // Frame as the server sends it, unmasked
+    std::string serverFrame(Opcode opcode, std::string_view payload) {
+        uint8_t header[max_header_size];
+        size_t size = encodeHeader(header, opcode, true, payload.size());
+        return std::string(reinterpret_cast<const char*>(header), size).append(payload);
+    }
+
+    std::string closePayload(uint16_t code) {
+        std::string payload;
+        payload.push_back(static_cast<char>(code >> 8));
+        payload.push_back(static_cast<char>(code));
+        return payload;
+    }
+
+    // Resident memory of the process in bytes
+    size_t residentBytes() {
+        std::ifstream statm("/proc/self/statm");
+        size_t pages = 0;
+        size_t resident = 0;
+        statm >> pages >> resident;
+        return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    // Byte by byte UTF-8 check to compare against
+    bool referenceUtf8(const uint8_t *data, size_t size) {
+        size_t i = 0;
+        while (i < size) {
+            uint8_t byte = data[i];
+            size_t length;
+            uint32_t min;
+            uint32_t code;
+
+            if (byte < 0x80) {
+                ++i;
+                continue;
+            }
+            else if ((byte & 0xe0) == 0xc0) {
+                length = 2;
+                min = 0x80;
+                code = byte & 0x1f;
+            }
+            else if ((byte & 0xf0) == 0xe0) {
+                length = 3;
+                min = 0x800;
+                code = byte & 0x0f;
+            }
+            else if ((byte & 0xf8) == 0xf0) {
+                length = 4;
+                min = 0x10000;
+                code = byte & 0x07;
+            }
+            else
+                return false;
+
+            if (i + length > size)
+                return false;
+
+            for (size_t j = 1; j < length; ++j) {
+                if ((data[i + j] & 0xc0) != 0x80)
+                    return false;
+                code = (code << 6) | (data[i + j] & 0x3f);
+            }
+
+            if (code < min || code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff))
+                return false;
+
+            i += length;
+        }
+
+        return true;
+    }
+
+    // Echoes messages, recording what happens without a transport
+    class EchoConnection : public CxxServer::Core::Ws::Connection {
+    public:
+        std::string sent;
+        std::vector<std::string> events;
+        bool disconnected = false;
+
+        void feed(std::string_view data) { receiveData(data.data(), data.size()); }
+        void lost() { transportDisconnected(); }
+
+    protected:
+        bool onUpgrade(const Request &request, Response &response) override {
+            response.header("Sec-WebSocket-Protocol", "chat");
+            return request.path() != "/forbidden";
+        }
+
+        void onOpen() override { events.emplace_back("open"); }
+
+        void onMessage(const void *data, size_t size, bool text) override {
+            std::string message(static_cast<const char*>(data), size);
+            events.push_back(std::string(text ? "text:" : "binary:").append(message));
+            if (text)
+                sendText(message);
+            else
+                sendBinary(data, size);
+        }
+
+        void onPing(const void *data, size_t size) override { events.push_back(std::string("ping:").append(static_cast<const char*>(data), size)); }
+        void onPong(const void *data, size_t size) override { events.push_back(std::string("pong:").append(static_cast<const char*>(data), size)); }
+        void onClose(uint16_t code, std::string_view reason) override { events.push_back(std::string("close:").append(std::to_string(code)).append(":").append(reason)); }
+
+        bool transportSend(const void *buffer, size_t size) override {
+            sent.append(static_cast<const char*>(buffer), size);
+            return true;
+        }
+
+        bool transportClose() override {
+            disconnected = true;
+            return true;
+        }
+    };
+
+    // Echoes messages, closing on "bye"
+    template<typename Base>
+    class EchoSession : public Base {
+    public:
+        using Base::Base;
+
+    protected:
+        void onMessage(const void *data, size_t size, bool text) override {
+            std::string_view message(static_cast<const char*>(data), size);
+            if (text && message == "bye")
+                this->sendClose(CloseCode::Normal, "bye");
+            else if (text)
+                this->sendText(message);
+            else
+                this->sendBinary(data, size);
+        }
+    };
+
+    class EchoServer : public CxxServer::Core::Ws::Server {
+    public:
+        using CxxServer::Core::Ws::Server::Server;
+
+    protected:
+        std::shared_ptr<TcpSession> newSession(const std::shared_ptr<TcpServer> &server) override { return std::make_shared<EchoSession<CxxServer::Core::Ws::Session>>(server); }
+    };
+
+    class EchoSslServer : public CxxServer::Core::Wss::Server {
+    public:
+        using CxxServer::Core::Wss::Server::Server;
+
+        static std::shared_ptr<SslContext> CreateContext()
+        {
+            auto context = std::make_shared<SslContext>(asio::ssl::context::tlsv12);
+            context->set_password_callback([](size_t max_length, asio::ssl::context::password_purpose purpose) -> std::string { return "qwerty"; });
+            context->use_certificate_chain_file("../certs/server.pem");
+            context->use_private_key_file("../certs/server.pem", asio::ssl::context::pem);
+            context->use_tmp_dh_file("../certs/dh4096.pem");
+            return context;
+        }
+
+    protected:
+        std::shared_ptr<TcpSession> newSession(const std::shared_ptr<TcpServer> &server) override { return std::make_shared<EchoSession<CxxServer::Core::Wss::Session>>(server, context()); }
+    };
+
+    template<typename Base>
+    class CollectClient : public Base {
+    public:
+        using Base::Base;
+        std::atomic<size_t> received = 0;
+
+        std::string data() {
+            std::scoped_lock lock(_lock);
+            return _data;
+        }
+
+    protected:
+        void onReceive(const void *buffer, size_t size) override {
+            std::scoped_lock lock(_lock);
+            _data.append(static_cast<const char*>(buffer), size);
+            received += size;
+        }
+
+    private:
+        std::mutex _lock;
+        std::string _data;
+    };
+
+    // Upgrade, echo a fragmented text & a binary message, then have the server close
+    template<typename Client>
+    void echoExchange(Client &client) {
+        std::string binary(70000, '\0');
+        for (size_t i = 0; i < binary.size(); ++i)
+            binary[i] = static_cast<char>(i * 7);
+
+        client.sendAsync(upgrade_request);
+        client.sendAsync(clientFrame(Opcode::Text, "frag", false) + clientFrame(Opcode::Ping, "p") + clientFrame(Opcode::Continuation, "mented"));
+        client.sendAsync(clientFrame(Opcode::Binary, binary));
+        client.sendAsync(clientFrame(Opcode::Text, "bye"));
+
+        std::string payload = closePayload(1000);
+        payload.append("bye");
+        const std::string expected = upgrade_response + serverFrame(Opcode::Pong, "p") + serverFrame(Opcode::Text, "fragmented") + serverFrame(Opcode::Binary, binary) + serverFrame(Opcode::Close, payload);
+
+        while (client.received < expected.size())
+            std::this_thread::yield();
+        REQUIRE(client.data() == expected);
+
+        // answering the close ends the connection
+        client.sendAsync(clientFrame(Opcode::Close, closePayload(1000)));
+        while (client.isConnected())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("WebSocket frame test", "[CxxServer][WebSocket]") {
+        uint8_t header[max_header_size];
+
+        REQUIRE(encodeHeader(header, Opcode::Text, true, 125) == 2);
+        REQUIRE((header[0] == 0x81 && header[1] == 125));
+        REQUIRE(encodeHeader(header, Opcode::Binary, false, 126) == 4);
+        REQUIRE((header[0] == 0x02 && header[1] == 126 && header[2] == 0 && header[3] == 126));
+        REQUIRE(encodeHeader(header, Opcode::Continuation, true, 65536) == 10);
+        REQUIRE((header[0] == 0x80 && header[1] == 127 && header[7] == 1 && header[8] == 0 && header[9] == 0));
+
+        // the masked "Hello" of RFC 6455
+        REQUIRE(clientFrame(Opcode::Text, "Hello") == std::string("\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58", 11));
+
+        // vectorized masking matches masking byte by byte at any size & offset, in place too
+        const uint8_t key[4] = { 0xa1, 0x02, 0xff, 0x5c };
+        std::mt19937 random(7);
+        std::vector<uint8_t> data(300);
+        for (auto &byte : data)
+            byte = static_cast<uint8_t>(random());
+
+        for (size_t size = 0; size <= data.size(); ++size) {
+            for (uint64_t offset = 0; offset < 4; ++offset) {
+                std::vector<uint8_t> expected(size);
+                for (size_t i = 0; i < size; ++i)
+                    expected[i] = data[i] ^ key[(offset + i) % 4];
+
+                std::vector<uint8_t> masked(size);
+                mask(masked.data(), data.data(), size, key, offset);
+                REQUIRE(masked == expected);
+
+                std::vector<uint8_t> inplace(data.begin(), data.begin() + size);
+                mask(inplace.data(), inplace.data(), size, key, offset);
+                REQUIRE(inplace == expected);
+            }
+        }
+
+        REQUIRE(acceptKey("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+    }
+
+    TEST_CASE("WebSocket UTF-8 validation test", "[CxxServer][WebSocket]") {
+        REQUIRE(validUtf8(""));
+        REQUIRE(validUtf8("plain ascii text which is long enough to skip a few blocks of 32 bytes"));
+        REQUIRE(validUtf8("\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xf0\x9f\x98\x80 \xef\xbf\xbf \xf4\x8f\xbf\xbf"));
+
+        REQUIRE(!validUtf8("\xc0\xaf"));
+        REQUIRE(!validUtf8("\xe0\x80\xaf"));
+        REQUIRE(!validUtf8("\xed\xa0\x80"));
+        REQUIRE(!validUtf8("\xf4\x90\x80\x80"));
+        REQUIRE(!validUtf8("\xff"));
+        REQUIRE(!validUtf8("\x80"));
+        REQUIRE(!validUtf8("truncated at the end of the data \xe2\x82"));
+        REQUIRE(!validUtf8("a long run of ascii text followed by an invalid byte \xc3\x28 and more"));
+
+        // random mixes of valid & invalid sequences at every alignment
+        const char *pieces[] = { "a", "bc", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xc3", "\x80", "\xed\xbf\xbf", "0123456789abcdef0123456789abcdef" };
+        std::mt19937 random(11);
+        for (size_t round = 0; round < 20000; ++round) {
+            std::string text;
+            size_t count = random() % 40;
+            for (size_t i = 0; i < count; ++i)
+                text.append(pieces[random() % (round % 2 ? 5 : 9)]);
+
+            REQUIRE(validUtf8(text) == referenceUtf8(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+        }
+    }
+
+    TEST_CASE("WebSocket connection test", "[CxxServer][WebSocket]") {
+        // handshake split over two reads, with a frame right behind it
+        EchoConnection connection;
+        connection.feed(upgrade_request.substr(0, 40));
+        REQUIRE(connection.sent.empty());
+        connection.feed(upgrade_request.substr(40) + clientFrame(Opcode::Text, "hi"));
+
+        std::string expected = upgrade_response;
+        expected.insert(expected.size() - 2, "Sec-WebSocket-Protocol: chat\r\n");
+        expected.append(serverFrame(Opcode::Text, "hi"));
+        REQUIRE(connection.sent == expected);
+        REQUIRE(connection.isOpen());
+
+        // fragments with a ping in between, fed a byte at a time
+        std::string frames = clientFrame(Opcode::Binary, "ab", false) + clientFrame(Opcode::Ping, "x") + clientFrame(Opcode::Continuation, "cd", false) +
+            clientFrame(Opcode::Continuation, "", true) + clientFrame(Opcode::Pong, "y");
+        for (char byte : frames)
+            connection.feed(std::string_view(&byte, 1));
+
+        expected.append(serverFrame(Opcode::Pong, "x")).append(serverFrame(Opcode::Binary, "abcd"));
+        REQUIRE(connection.sent == expected);
+        REQUIRE(connection.numMessages() == 2);
+
+        // a close is answered with the same code & ends the connection
+        std::string payload = closePayload(1001);
+        payload.append("away");
+        connection.feed(clientFrame(Opcode::Close, payload) + clientFrame(Opcode::Text, "ignored"));
+        expected.append(serverFrame(Opcode::Close, closePayload(1001)));
+        REQUIRE(connection.sent == expected);
+        REQUIRE(connection.disconnected);
+        REQUIRE(!connection.isOpen());
+        REQUIRE(!connection.sendText("late"));
+        connection.lost();
+
+        REQUIRE(connection.events == std::vector<std::string>{ "open", "text:hi", "ping:x", "binary:abcd", "pong:y", "close:1001:away" });
+
+        // protocol errors fail the connection with their close code
+        auto failed = [](const std::string &frame, uint16_t code) {
+            EchoConnection failing;
+            failing.maxMessageSize() = 1000;
+            failing.feed(upgrade_request);
+            failing.feed(frame);
+            REQUIRE(failing.disconnected);
+            REQUIRE(failing.events.back() == std::string("close:").append(std::to_string(code)).append(":"));
+            return failing.sent.substr(failing.sent.find("\r\n\r\n") + 4);
+        };
+
+        std::string unmasked = serverFrame(Opcode::Text, "x");
+        REQUIRE(failed(unmasked, 1002) == serverFrame(Opcode::Close, closePayload(1002)));
+        failed(clientFrame(Opcode::Continuation, "x"), 1002);
+        failed(clientFrame(Opcode::Text, "a", false) + clientFrame(Opcode::Text, "b"), 1002);
+        failed(clientFrame(Opcode::Ping, "x", false), 1002);
+        failed(clientFrame(Opcode::Ping, std::string(126, 'x')), 1002);
+        failed(clientFrame(static_cast<Opcode>(3), "x"), 1002);
+        failed(clientFrame(Opcode::Close, "x"), 1002);
+        failed(clientFrame(Opcode::Close, closePayload(1005)), 1002);
+        failed(clientFrame(Opcode::Binary, std::string(600, 'x'), false) + clientFrame(Opcode::Continuation, std::string(600, 'x')), 1009);
+        REQUIRE(failed(clientFrame(Opcode::Text, "\xc3", false) + clientFrame(Opcode::Continuation, "\x28"), 1007) == serverFrame(Opcode::Close, closePayload(1007)));
+
+        // a text message split inside a character is valid once joined
+        EchoConnection joined;
+        joined.feed(upgrade_request);
+        joined.feed(clientFrame(Opcode::Text, "\xe2\x82", false) + clientFrame(Opcode::Continuation, "\xac"));
+        REQUIRE(joined.events.back() == "text:\xe2\x82\xac");
+
+        // a close we start waits for the answer
+        joined.sendClose(CloseCode::GoingAway, "restart");
+        REQUIRE(!joined.disconnected);
+        REQUIRE(!joined.sendPing());
+        joined.feed(clientFrame(Opcode::Close, closePayload(1001)));
+        REQUIRE(joined.disconnected);
+        REQUIRE(joined.events.back() == "close:1001:");
+
+        // frames declaring a large payload only take memory as it arrives
+        const uint8_t key[4] = { 0x01, 0x02, 0x03, 0x04 };
+        uint8_t header[max_header_size];
+        size_t header_size = encodeHeader(header, Opcode::Binary, true, 16 * 1024 * 1024 - 1, key);
+        std::string declared = std::string(reinterpret_cast<const char*>(header), header_size).append("ab");
+
+        std::vector<std::unique_ptr<EchoConnection>> idle(16);
+        for (auto &idle_connection : idle) {
+            idle_connection = std::make_unique<EchoConnection>();
+            idle_connection->feed(upgrade_request);
+        }
+
+        size_t resident = residentBytes();
+        for (auto &idle_connection : idle)
+            idle_connection->feed(declared);
+
+        REQUIRE(residentBytes() < resident + 16 * 1024 * 1024);
+        for (auto &idle_connection : idle)
+            REQUIRE(idle_connection->isOpen());
+
+        // refused upgrades are answered & close
+        EchoConnection forbidden;
+        forbidden.feed("GET /forbidden HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+        REQUIRE(forbidden.sent == "HTTP/1.1 403 Forbidden\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+        REQUIRE(forbidden.disconnected);
+
+        EchoConnection version;
+        version.feed("GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 8\r\n\r\n");
+        REQUIRE(version.sent == "HTTP/1.1 426 Upgrade Required\r\nSec-WebSocket-Version: 13\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+
+        EchoConnection plain;
+        plain.feed("GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+        REQUIRE(plain.sent == "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+        REQUIRE(plain.events.empty());
+    }
+
+    TEST_CASE("WebSocket server test", "[CxxServer][WebSocket]") {
+        const std::string address = "127.0.0.1";
+        const unsigned int port = 1146;
+        const unsigned int ssl_port = 1147;
+
+        auto service = std::make_shared<CxxServer::Core::Service>();
+        REQUIRE(service->start());
+        while (!service->isStarted())
+            std::this_thread::yield();
+
+        auto server = std::make_shared<EchoServer>(service, address, port);
+        server->reuseAddress() = true;
+        REQUIRE(server->start());
+        auto ssl_server = std::make_shared<EchoSslServer>(service, EchoSslServer::CreateContext(), address, ssl_port);
+        ssl_server->reuseAddress() = true;
+        REQUIRE(ssl_server->start());
+        while (!server->isStarted() || !ssl_server->isStarted())
+            std::this_thread::yield();
+
+        auto client = std::make_shared<CollectClient<TcpClient>>(service, address, port);
+        REQUIRE(client->connectAsync());
+        while (!client->isConnected())
+            std::this_thread::yield();
+        echoExchange(*client);
+
+        auto client_context = std::make_shared<SslContext>(asio::ssl::context::tlsv12);
+        client_context->set_default_verify_paths();
+        client_context->set_verify_mode(asio::ssl::verify_peer | asio::ssl::verify_fail_if_no_peer_cert);
+        client_context->load_verify_file("../certs/ca.pem");
+
+        auto ssl_client = std::make_shared<CollectClient<SslClient>>(service, client_context, address, ssl_port);
+        REQUIRE(ssl_client->connectAsync());
+        while (!ssl_client->isReady())
+            std::this_thread::yield();
+        echoExchange(*ssl_client);
+
+        REQUIRE(server->stop());
+        REQUIRE(ssl_server->stop());
+        while (server->isStarted() || ssl_server->isStarted())
+            std::this_thread::yield();
+
+        REQUIRE(service->stop());
+        while (service->isStarted())
+            std::this_thread::yield();
+    }
+}